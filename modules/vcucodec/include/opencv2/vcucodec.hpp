@@ -19,6 +19,9 @@
 
 #include "vcutypes.hpp"
 
+#include <climits>
+#include <future>
+
 /**
   @addtogroup versal_zynq
   @{
@@ -182,6 +185,50 @@ public:
     CV_WRAP virtual void convertTo(CV_OUT Mat& dst, int fourCC) const = 0;
 };
 
+/// @brief One plane of a decoded frame exported as dmabuf, see DmaBufFrame.
+struct CV_EXPORTS_W_SIMPLE DmaBufPlane {
+    CV_PROP_RW int fd = -1;    ///< dmabuf fd of the buffer chunk holding the plane. Owned by the
+                               ///< decoder: do not close it, dup() it to keep it beyond the frame.
+    CV_PROP_RW int offset = 0; ///< Byte offset of the first sample of the plane in the dmabuf,
+                               ///< past the left and top crop of the frame.
+    CV_PROP_RW int pitch = 0;  ///< Row pitch of the plane in bytes.
+};
+
+/// @brief Decoded video frame exported as dmabuf, for zero-copy hand-off to a GPU, a display
+/// or another process.
+///
+/// Returned by Decoder::nextFrameDmaBuf(). The frame describes every plane of the hardware
+/// buffer (fd, offset, pitch) and its DRM format modifier, which is what an EGL, Vulkan or KMS
+/// import needs. The hardware buffer is not reused by the decoder until release() is called or
+/// the last reference to this DmaBufFrame is dropped, so the consumer decides when the memory
+/// may be overwritten. Holding frames too long may stall the decoder pipeline; frames still
+/// held when the decoder is reset or destroyed are released by the decoder.
+class CV_EXPORTS_W DmaBufFrame
+{
+public:
+    virtual ~DmaBufFrame() {}
+
+    /// @brief Get frame metadata (format, dimensions, stride, crop offsets).
+    CV_WRAP virtual const RawInfo& info() const = 0;
+
+    /// @brief Get the planes: index 0 = Y, index 1 = UV (semi-planar) or U (planar),
+    /// index 2 = V (planar only). Planes in the same buffer chunk share its fd.
+    CV_WRAP virtual std::vector<DmaBufPlane> planes() const = 0;
+
+    /// @brief Get the DRM format modifier of the planes: 0 (DRM_FORMAT_MOD_LINEAR) for raster
+    /// formats, 0x00ffffffffffffff (DRM_FORMAT_MOD_INVALID) for the tiled formats, which have
+    /// no DRM modifier.
+    CV_WRAP virtual int64 modifier() const = 0;
+
+    /// @brief Give the buffer back to the decoder. The fds must not be used afterwards.
+    /// A frame passed to Encoder::writeFrameDmaBuf() goes back once the encoder has encoded it,
+    /// so it can be released right after that call.
+    CV_WRAP virtual void release() = 0;
+
+    /// @brief Check whether the buffer went back to the decoder.
+    CV_WRAP virtual bool released() const = 0;
+};
+
 
 // see decoder.dox for documentation of Decoder class
 
@@ -202,6 +249,9 @@ public:
     ) = 0;
 
     /// @brief Decode the next frame from the stream, return fd of the first buffer chunk.
+    /// The buffer goes back to the decoder on return, so the caller relies on
+    /// DecoderInitParams::extraFrames to keep it from being reused while the fd is in use.
+    /// Prefer nextFrameDmaBuf(), which describes all planes and holds the buffer until released.
     /// @return DECODE_FRAME if a frame was decoded, DECODE_TIMEOUT if no frame is available yet,
     ///         or DECODE_EOS when the stream has ended.
     CV_WRAP virtual DecodeStatus nextFrameFd(
@@ -209,6 +259,15 @@ public:
         CV_OUT RawInfo& frameInfo  ///< Output parameter with information about the decoded frame.
     ) = 0;
 
+    /// @brief Decode the next frame from the stream and export it as dmabuf (zero-copy).
+    /// The hardware buffer stays with the caller until DmaBufFrame::release() is called or the
+    /// frame is dropped. Not available on the software device.
+    /// @return DECODE_FRAME if a frame was decoded, DECODE_TIMEOUT if no frame is available yet,
+    ///         or DECODE_EOS when the stream has ended.
+    CV_WRAP virtual DecodeStatus nextFrameDmaBuf(
+        CV_OUT Ptr<DmaBufFrame>& frame ///< Output: the decoded frame as dmabuf planes.
+    ) = 0;
+
     /// Set a property for the decoder.
     /// @return true if the property was set successfully, false otherwise.
     CV_WRAP virtual bool set(
@@ -239,6 +298,16 @@ public:
     /// Returns a string containing: decoding time, frame rate (fps), and concealed frame count.
     CV_WRAP virtual String statistics() const = 0;
 
+    /// @brief Start decoding a new stream on this decoder instance.
+    ///
+    /// The current stream is stopped and frames still held by the application are revoked.
+    /// The device is kept, and so is the decoded picture pool when the new stream has the same
+    /// output format and resolution; only the hardware decoder channel is re-created. The
+    /// DecoderInitParams given at creation still apply. Frame positions restart at 0.
+    CV_WRAP virtual void reset(
+        const String& filename ///< Next input file; ignored when a DecoderCallback feeds the data.
+    ) = 0;
+
     /// Get comma separated list of supported FOURCC codes for decoding.
     static CV_WRAP String getFourCCs();
 };
@@ -305,6 +374,14 @@ struct CV_EXPORTS_W_SIMPLE RCSettings
                                       ///< replace with skip MBs (or CTBs). Default: false.
     CV_PROP_RW int  maxSkip;          ///< Maximum number of skips in a row. Default: unlimited.
     CV_PROP_RW int  lookAhead = 0;    ///< LookAhead depth in frames. 0 disables. Exclusive with TwoPass and subframe latency.
+    CV_PROP_RW int  twoPass = 0;      ///< Offline two-pass encoding: 0 single pass, 1 first pass
+                                      ///< (writes twoPassLog), 2 second pass (reads it).
+                                      ///< See @ref vcucodec_twopass.
+    CV_PROP_RW String twoPassLog;     ///< Two-pass statistics log file. Required when twoPass != 0.
+    CV_PROP_RW bool twoPassGlobal = true; ///< Second pass: allocate the bits over the whole log
+                                      ///< rather than over windows of 1000 frames.
+    CV_PROP_RW int  twoPassDownscale = 1; ///< First pass: encode the input downscaled by 1, 2 or 4
+                                      ///< in each dimension. Default: 1.
 
     CV_WRAP RCSettings(RCMode mode = RCMode::VBR, Entropy entropy = Entropy::CABAC,
         int bitrate = 4000, int maxBitrate = 4000, int cpbSize = 3000, int initialDelay = 1500,
@@ -411,6 +488,34 @@ struct CV_EXPORTS_W_SIMPLE ScalingListSettings
                                 const std::vector<uchar>& dcCoeff = std::vector<uchar>());
 };
 
+/// @brief Struct AbrSettings configures the optional in-module adaptive bitrate controller.
+///
+/// When enabled, the encoder follows a bandwidth estimate: each frame it compares the estimate
+/// with the bitrate actually produced and moves the target bitrate toward
+/// `headroom * estimate` through the dynamic bitrate commands. The estimate comes from
+/// @ref cv::vcucodec::Encoder::setBandwidthEstimate "setBandwidthEstimate()", from datagrams on
+/// a local UDP port and/or from a recorded trace; see @ref vcucodec_abr.
+struct CV_EXPORTS_W_SIMPLE AbrSettings
+{
+    CV_PROP_RW bool   enable = false;        ///< Run the controller. Default: false.
+    CV_PROP_RW int    minBitrate = 100;      ///< Lowest target bitrate in kbits per second.
+    CV_PROP_RW int    maxBitrate = 0;        ///< Highest target bitrate in kbits per second;
+                                             ///< 0 uses RCSettings::maxBitrate.
+    CV_PROP_RW double aggressiveness = 0.3;  ///< Fraction (0, 1] of the gap to the desired
+                                             ///< bitrate closed per update; increases move at
+                                             ///< half this rate. Default: 0.3.
+    CV_PROP_RW double headroom = 0.85;       ///< Fraction (0, 1] of the estimate to target.
+    CV_PROP_RW int    updateInterval = 1;    ///< Frames between two bitrate decisions.
+    CV_PROP_RW int    udpPort = 0;           ///< Local UDP port receiving estimates as ASCII
+                                             ///< kbits per second; 0 disables.
+    CV_PROP_RW String traceFile;             ///< Bandwidth trace to replay: lines of
+                                             ///< "frameIdx kbps"; empty disables.
+    CV_PROP_RW String logFile;               ///< Per-frame log of the controller decisions;
+                                             ///< empty disables.
+
+    CV_WRAP AbrSettings() = default;
+};
+
 /// @brief Initialization parameters for the encoder.
 ///
 /// Passed to @ref cv::vcucodec::createEncoder "createEncoder()" to configure picture settings,
@@ -432,10 +537,54 @@ struct CV_EXPORTS_W_SIMPLE EncoderInitParams
     CV_PROP_RW ColorConfig        colorConfig;        ///< VUI colour description written to the SPS.
                                                       ///< Required for HDR10: the HDR SEIs alone do
                                                       ///< not mark a stream as PQ/BT.2020.
+    CV_PROP_RW int                drainTimeout = 0;   ///< Maximum time in milliseconds that
+                                                      ///< @ref Encoder::eos "eos()" waits for the
+                                                      ///< encoder to drain; 0 waits until done.
+    CV_PROP_RW int                fileReadAhead = 0;  ///< Frames @ref Encoder::writeFile
+                                                      ///< "writeFile()" reads and converts ahead
+                                                      ///< of the encoder on its own thread. Each
+                                                      ///< adds one source buffer; 0 (default)
+                                                      ///< reads inline.
+    CV_PROP_RW AbrSettings        abrSettings;        ///< Adaptive bitrate controller.
 
     CV_WRAP EncoderInitParams() = default;
 };
 
+/// @brief Field value of an EncoderDynamicUpdate.
+enum DynamicUpdateValue {
+    DYNAMIC_UPDATE_KEEP = INT_MIN ///< The parameter is left unchanged (default of every field).
+};
+
+/// @brief A batch of dynamic encoder parameters applied together at one frame.
+///
+/// Set only the fields to change; the others keep their default value
+/// @ref cv::vcucodec::DYNAMIC_UPDATE_KEEP "DYNAMIC_UPDATE_KEEP" and are left unchanged.
+/// Passed to @ref cv::vcucodec::Encoder::setDynamicUpdate "setDynamicUpdate()", the whole batch
+/// is scheduled as a single command, so the new values take effect on the same frame.
+struct CV_EXPORTS_W_SIMPLE EncoderDynamicUpdate
+{
+    CV_PROP_RW int  bitRate = DYNAMIC_UPDATE_KEEP;        ///< Target bitrate, as for
+                                                          ///< Encoder::setBitRate().
+    CV_PROP_RW int  maxBitRate = DYNAMIC_UPDATE_KEEP;     ///< Maximum bitrate; requires bitRate.
+    CV_PROP_RW int  frameRate = DYNAMIC_UPDATE_KEEP;      ///< Frame rate, as for
+                                                          ///< Encoder::setFrameRate().
+    CV_PROP_RW int  clockRatio = DYNAMIC_UPDATE_KEEP;     ///< Clock ratio of frameRate;
+                                                          ///< unchanged means 1000.
+    CV_PROP_RW int  gopLength = DYNAMIC_UPDATE_KEEP;      ///< GOP length.
+    CV_PROP_RW int  numB = DYNAMIC_UPDATE_KEEP;           ///< Number of B-frames.
+    CV_PROP_RW int  freqIDR = DYNAMIC_UPDATE_KEEP;        ///< IDR frequency.
+    CV_PROP_RW int  qp = DYNAMIC_UPDATE_KEEP;             ///< QP, for the constant-QP modes.
+    CV_PROP_RW int  minQP = DYNAMIC_UPDATE_KEEP;          ///< Minimum QP; set together with maxQP.
+    CV_PROP_RW int  maxQP = DYNAMIC_UPDATE_KEEP;          ///< Maximum QP; set together with minQP.
+    CV_PROP_RW int  qpIPDelta = DYNAMIC_UPDATE_KEEP;      ///< QP delta between I and P frames.
+    CV_PROP_RW int  qpPBDelta = DYNAMIC_UPDATE_KEEP;      ///< QP delta between P and B frames.
+    CV_PROP_RW int  maxPictureSize = DYNAMIC_UPDATE_KEEP; ///< Maximum picture size.
+    CV_PROP_RW bool restartGop = false;                   ///< Restart the GOP after the other
+                                                          ///< changes.
+
+    CV_WRAP EncoderDynamicUpdate() = default;
+};
+
 /// @brief Callback interface for feeding encoded data to the decoder (C++ only).
 ///
 /// Implement this interface and pass it to @ref cv::vcucodec::createDecoder "createDecoder()"
@@ -471,7 +620,8 @@ public:
     /// Called each time the encoder produces encoded data (one or more NAL units).
     virtual void onEncoded(std::vector<std::string_view>& encodedData) = 0;
     /// Called once when the encoder has finished processing all frames after
-    ///@ref cv::vcucodec::Encoder::eos "eos()".
+    ///@ref cv::vcucodec::Encoder::eos "eos()" or
+    ///@ref cv::vcucodec::Encoder::eosAsync "eosAsync()".
     virtual void onFinished() = 0;
 };
 
@@ -512,6 +662,30 @@ public:
 };
 
 
+/// @brief A QP-table buffer taken straight from the encoder's QP-table pool.
+/// Obtained from @ref cv::vcucodec::Encoder::acquireQpTableBuffer "acquireQpTableBuffer()";
+/// the table is written in place and handed to the encoder without being copied.
+class CV_EXPORTS QpTableBuffer
+{
+public:
+    /// Virtual destructor. Returns the buffer to the pool unless it was committed. The buffer may
+    /// outlive @ref cv::vcucodec::Encoder::reset "reset()" and the encoder itself.
+    virtual ~QpTableBuffer() {}
+
+    /// The table bytes: a 1-row CV_8UC1 Mat of @ref cv::vcucodec::Encoder::qpTableBufferSize
+    /// "qpTableBufferSize()" bytes, zero-initialized, that maps the buffer the hardware reads.
+    /// The layout is the one of @ref cv::vcucodec::Encoder::setQpTable "setQpTable".
+    virtual Mat data() = 0;
+
+    /// Schedule the table for encoded frames from @p frameIdx onward, like
+    /// @ref cv::vcucodec::Encoder::setQpTable "setQpTable". The buffer belongs to the encoder
+    /// afterwards: @ref data must not be written any more and commit() cannot be called again.
+    /// Does nothing when the encoder was @ref cv::vcucodec::Encoder::reset "reset" since the
+    /// buffer was acquired: the table was sized for the previous session.
+    virtual void commit(int32_t frameIdx) = 0;
+};
+
+
 // see encoder.dox for documentation of Encoder class
 
 /// @brief Class Encoder is the interface for encoding video frames to a stream.
@@ -537,12 +711,51 @@ public:
     ) = 0;
 
     /// Encode a video frame from fd of the first buffer chunk.
+    /// Nothing tells the decoder when the encoder is done with the buffer; prefer
+    /// writeFrameDmaBuf().
     CV_WRAP virtual void writeFrameFd(int fd) = 0;
 
+    /// Encode a decoded frame from its DMA buffer, without a copy.
+    /// The encoder holds the decoder buffer until it releases the source of the picture (which
+    /// can be after the picture is output with lookahead or B-frames) and gives it back then,
+    /// whether or not the caller has released the frame in the meantime. The frame must
+    /// be in a single buffer chunk, in the layout of the encoder source buffers: a frame whose
+    /// plane offsets or pitches differ from theirs raises StsBadArg.
+    CV_WRAP virtual void writeFrameDmaBuf(
+        const Ptr<DmaBufFrame>& frame ///< Frame from @ref cv::vcucodec::Decoder::nextFrameDmaBuf
+                                      ///< "Decoder::nextFrameDmaBuf()".
+    ) = 0;
+
     /// Signal the end of the stream to the encoder and wait until final frame is encoded.
+    /// The wait is bounded by @ref EncoderInitParams::drainTimeout "drainTimeout".
     /// @return true if encoding completed successfully, false if timeout or error occurred.
     CV_WRAP virtual bool eos() = 0;
 
+    /// @brief Signal the end of the stream without blocking the caller (C++ only).
+    /// The encoder drains in the background; @ref EncoderCallback::onFinished "onFinished()"
+    /// is invoked once the final frame is encoded. Calling eos() afterwards waits on the same
+    /// flush instead of starting a new one.
+    /// @return A future holding the result eos() would have returned.
+    virtual std::shared_future<bool> eosAsync() = 0;
+
+    /// @brief Start a new encoding session on this encoder instance.
+    ///
+    /// The current stream is finished first (as by eos() when it was not called yet). The
+    /// hardware device is kept, and so are the buffer pools when @p params keeps the resolution,
+    /// input format, GOP buffering and lookahead; only the encoder channel is re-created.
+    /// This avoids most of the session setup cost of creating a new encoder.
+    /// Scheduled dynamic commands are dropped and ROI handles of the previous session become
+    /// inactive. Frame indices restart at 0.
+    /// Throws when the previous stream does not finish within
+    /// @ref EncoderInitParams::drainTimeout "drainTimeout"; nothing is torn down in that case
+    /// and reset() can be called again.
+    CV_WRAP virtual void reset(
+        const EncoderInitParams& params, ///< Encoder parameters of the new session.
+        const String& filename = String() ///< New output file; empty keeps the current one,
+                                          ///< which is rewritten. Ignored when a callback was
+                                          ///< given at creation.
+    ) = 0;
+
 
     /// @brief Get the current settings of the encoder as a human-readable multi-line string.
     /// Returns picture settings (codec, fourcc, resolution, framerate), rate control
@@ -552,7 +765,8 @@ public:
 
     /// @brief Get the statistics of the encoding session.
     /// Returns a string containing: number of pictures encoded and average frame rate (fps).
-    /// Available after encoding has started.
+    /// Available after encoding has started. After eos(), a downscaled two-pass first pass whose
+    /// log does not hold one record per submitted frame adds a "First pass log mismatch" line.
     CV_WRAP virtual String statistics() const = 0;
 
     /// @brief Set a property for the encoder.
@@ -719,6 +933,17 @@ public:
     CV_WRAP virtual void setAutoQPThresholdQPAndDeltaQP(int32_t frameIdx, bool bEnableUserAutoQPValues,
             std::vector<int> thresholdQP, std::vector<int> deltaQP) = 0;
 
+    /// @brief Apply a batch of dynamic parameters as one unit at frame @p frameIdx.
+    /// Equivalent to the individual set*() calls for the fields of @p update that are not
+    /// DYNAMIC_UPDATE_KEEP, but scheduled as a single command so that, for instance, a
+    /// bitrate, QP-bounds and GOP-length change all take effect on the same frame.
+    CV_WRAP virtual void setDynamicUpdate(int32_t frameIdx, const EncoderDynamicUpdate& update) = 0;
+
+    /// @brief Feed the adaptive bitrate controller a bandwidth estimate in kbits per second.
+    /// The estimate holds until the next one; it is used from the next frame submitted.
+    /// Requires AbrSettings::enable.
+    CV_WRAP virtual void setBandwidthEstimate(int kbps) = 0;
+
     //
     // Region of interest (ROI)
     //
@@ -749,6 +974,15 @@ public:
     CV_WRAP virtual Ptr<RegionOfInterest> createROIBackgroundByValue(int deltaQP,
             ROIOrder order = ROIOrder::QUALITY) = 0;
 
+    /// @brief Set the regions of interest of the single frame @p frameIdx, e.g. the boxes of an
+    /// object detector. Region @p regions[i] gets the relative QP delta @p deltaQP[i].
+    /// The regions replace those previously set for the same frame and are combined with the
+    /// enabled @ref RegionOfInterest handles, the background and the overlap order of that frame.
+    /// They are dropped once the frame is encoded, so nothing accumulates from frame to frame.
+    /// Boxes are clipped to the picture; empty ones are ignored.
+    CV_WRAP virtual void setRegions(int32_t frameIdx, const std::vector<Rect>& regions,
+            const std::vector<int>& deltaQP) = 0;
+
     //
     // QP table (per-block quantization control)
     //
@@ -789,6 +1023,35 @@ public:
     CV_WRAP virtual void setQpTable(int32_t frameIdx, InputArray qpTable,
             QpTableMode mode = QpTableMode::RELATIVE) = 0;
 
+    /// @brief Build the QP table from an importance (saliency) map and apply it to encoded
+    ///        frames from @p frameIdx onward, like @ref setQpTable.
+    ///
+    /// The map is area-averaged to the LCU grid, then each LCU gets a relative QP delta
+    /// proportional to how far its importance lies from the mean: the most important LCU ends
+    /// up @p qpSpread QP below the least important one, and the average delta stays near 0 so
+    /// the rate-control target is preserved. Deltas are clamped to [-32, 31].
+    ///
+    /// @param frameIdx Frame index from which the table takes effect.
+    /// @param saliency Single-channel map of any size and depth (typically CV_32F), covering the
+    ///                 whole picture; larger values mean more important.
+    /// @param qpSpread QP difference between the most and the least important LCU, in [0, 51].
+    ///
+    /// @note Requires the RELATIVE QP-table mode (@ref EncoderInitParams::qpTableMode).
+    /// @see @ref vcucodec_qptable
+    CV_WRAP virtual void setQpTableFromSaliency(int32_t frameIdx, InputArray saliency,
+            int qpSpread) = 0;
+
+    /// @brief Take a buffer from the encoder's QP-table pool to write a table into in place,
+    ///        then schedule it with @ref QpTableBuffer::commit. Unlike @ref setQpTable, the table
+    ///        is never copied.
+    ///
+    /// The pool is small and shared with Region-Of-Interest: release or commit buffers promptly.
+    /// A table stays in use while it is in effect and returns to the pool once a later table
+    /// supersedes it. Throws when no buffer is free; @ref setQpTable then still works.
+    /// @note Uses the create-time QP-table mode (@ref EncoderInitParams::qpTableMode).
+    ///       C++ only; from Python use @ref setQpTable.
+    virtual Ptr<QpTableBuffer> acquireQpTableBuffer() = 0;
+
     //
     // static functions
     //
@@ -828,6 +1091,156 @@ public:
     static CV_WRAP String getLevels(Codec codec);
 };
 
+/// @brief Struct SimulcastRendition describes one output of a
+/// @ref cv::vcucodec::SimulcastEncoder "SimulcastEncoder".
+///
+/// All other encoder settings, including the GOP structure, come from the EncoderInitParams
+/// passed to @ref cv::vcucodec::createSimulcastEncoder "createSimulcastEncoder()".
+struct CV_EXPORTS_W_SIMPLE SimulcastRendition
+{
+    CV_PROP_RW String filename; ///< Output file name; unused when the rendition has a callback.
+    CV_PROP_RW int width;       ///< Encoded width, at most the input width; even for 4:2:0
+                                ///< and 4:2:2 input.
+    CV_PROP_RW int height;      ///< Encoded height, at most the input height; even for 4:2:0
+                                ///< input.
+    CV_PROP_RW int bitrate;     ///< Target bitrate in kbits per second; 0 keeps the base one.
+    CV_PROP_RW int maxBitrate;  ///< Maximum bitrate in kbits per second; 0 scales the base
+                                ///< maxBitrate by the same factor as the bitrate.
+
+    CV_WRAP SimulcastRendition(const String& filename = String(), int width = 0, int height = 0,
+                               int bitrate = 0, int maxBitrate = 0);
+};
+
+// see encoder.dox for documentation of SimulcastEncoder class
+
+/// @brief Class SimulcastEncoder encodes one input into several renditions (an ABR ladder).
+///
+/// Each input frame is downscaled once into all rendition sizes and fed to one encoder per
+/// rendition. All renditions share the GOP structure of the base parameters, and GOP commands
+/// issued here are applied to all of them on the same frame, so their IDR pictures stay aligned
+/// for segmenting.
+class CV_EXPORTS_W SimulcastEncoder
+{
+public:
+    /// Virtual destructor for the SimulcastEncoder interface.
+    virtual ~SimulcastEncoder() {}
+
+    /// Encode a video frame, given at the input resolution of the base parameters, in the same
+    /// layout as @ref cv::vcucodec::Encoder::write "Encoder::write()".
+    CV_WRAP virtual void write(InputArray frame) = 0;
+
+    /// Encode a video frame from a DMA buffer fd. Renditions at the input resolution encode
+    /// from the buffer without a copy; the others are scaled from it. The luma plane starts at
+    /// the beginning of the buffer with a pitch of `frameInfo.stride`; the chroma plane starts at
+    /// @p chromaOffset with a pitch of `frameInfo.strideChroma` (for planar formats, the V plane
+    /// follows the U plane). A frame from
+    /// @ref cv::vcucodec::Decoder::nextFrameDmaBuf "Decoder::nextFrameDmaBuf()" is better passed
+    /// to writeFrameDmaBuf(), which takes the layout from the frame.
+    CV_WRAP virtual void writeFrameFd(
+        int fd,                    ///< DMA buffer fd holding all planes.
+        const RawInfo& frameInfo,  ///< Format, size and pitches of the picture.
+        int chromaOffset           ///< Byte offset of the first chroma plane in the buffer;
+                                   ///< ignored for 4:0:0.
+    ) = 0;
+
+    /// Encode a decoded frame from its DMA buffer, e.g. from
+    /// @ref cv::vcucodec::Decoder::nextFrameDmaBuf "Decoder::nextFrameDmaBuf()". Renditions at
+    /// the input resolution encode from the buffer without a copy and hold it until encoded, as
+    /// @ref cv::vcucodec::Encoder::writeFrameDmaBuf "Encoder::writeFrameDmaBuf()"; the others are
+    /// scaled from it, reading the planes at the offsets of the frame.
+    CV_WRAP virtual void writeFrameDmaBuf(const Ptr<DmaBufFrame>& frame) = 0;
+
+    /// Signal end of stream to all renditions and wait until they are drained.
+    /// @return true when all renditions completed.
+    CV_WRAP virtual bool eos() = 0;
+
+    /// Number of renditions.
+    CV_WRAP virtual int numRenditions() const = 0;
+
+    /// The encoder of rendition @p index, e.g. for per-rendition rate-control commands.
+    /// Feed frames and GOP commands through the SimulcastEncoder instead.
+    CV_WRAP virtual Ptr<Encoder> rendition(int index) const = 0;
+
+    /// Restart the GOP of all renditions at @p frameIdx.
+    CV_WRAP virtual void restartGop(int32_t frameIdx) = 0;
+
+    /// Change the GOP length of all renditions at @p frameIdx.
+    CV_WRAP virtual void setGopLength(int32_t frameIdx, int32_t gopLength) = 0;
+
+    /// Change the IDR frequency of all renditions at @p frameIdx.
+    CV_WRAP virtual void setFreqIDR(int32_t frameIdx, int32_t freqIDR) = 0;
+
+    /// Signal a scene change to all renditions at @p frameIdx.
+    CV_WRAP virtual void setSceneChange(int32_t frameIdx, int32_t lookAhead) = 0;
+
+    /// @brief Get the statistics of all renditions, one line per rendition.
+    CV_WRAP virtual String statistics() const = 0;
+};
+
+/// @brief Struct TranscoderParams configures the pipeline of a
+/// @ref cv::vcucodec::Transcoder "Transcoder".
+struct CV_EXPORTS_W_SIMPLE TranscoderParams
+{
+    CV_PROP_RW int  scaleThreads = 2; ///< Worker threads of the scale stage. Range 1-16.
+    CV_PROP_RW int  queueDepth = 4;   ///< Maximum frames waiting in front of the scale stage and
+                                      ///< in front of the encode stage. Range 1-32.
+    CV_PROP_RW bool zeroCopy = false; ///< Hand the decoded DMA buffers to the encoder instead of
+                                      ///< copying them. Requires the encoder size to match the
+                                      ///< stream; no scale stage is run. Each buffer goes back
+                                      ///< to the decoder once its picture is encoded.
+
+    CV_WRAP TranscoderParams() = default;
+};
+
+/// @brief Struct TranscoderStats reports the progress and the queue depths of a
+/// @ref cv::vcucodec::Transcoder "Transcoder".
+///
+/// The queue depths are sampled each time a frame enters the queue. A scale queue that stays
+/// full points at the scale stage (add threads), an encode queue that stays full at the encoder.
+struct CV_EXPORTS_W_SIMPLE TranscoderStats
+{
+    CV_PROP_RW int    framesDecoded = 0;       ///< Frames taken from the decoder.
+    CV_PROP_RW int    framesScaled = 0;        ///< Frames through the scale stage.
+    CV_PROP_RW int    framesEncoded = 0;       ///< Frames passed to the encoder.
+    CV_PROP_RW int    scaleQueueDepth = 0;     ///< Frames currently waiting for the scale stage.
+    CV_PROP_RW int    scaleQueueMaxDepth = 0;  ///< Highest scale queue depth seen.
+    CV_PROP_RW double scaleQueueAvgDepth = 0;  ///< Average scale queue depth.
+    CV_PROP_RW int    encodeQueueDepth = 0;    ///< Frames currently waiting for the encoder.
+    CV_PROP_RW int    encodeQueueMaxDepth = 0; ///< Highest encode queue depth seen.
+    CV_PROP_RW double encodeQueueAvgDepth = 0; ///< Average encode queue depth.
+
+    CV_WRAP TranscoderStats() = default;
+};
+
+// see encoder.dox for documentation of Transcoder class
+
+/// @brief Class Transcoder decodes a stream and re-encodes it, optionally at another resolution.
+///
+/// Decoding, scaling and encoding run as a pipeline on their own threads, so the three overlap
+/// and no per-frame work is left to the application.
+class CV_EXPORTS_W Transcoder
+{
+public:
+    /// Virtual destructor for the Transcoder interface.
+    virtual ~Transcoder() {}
+
+    /// @brief Transcode the whole input; returns once the encoder has drained.
+    /// @return true when the encoder completed (see @ref cv::vcucodec::Encoder::eos "eos()").
+    CV_WRAP virtual bool run() = 0;
+
+    /// @brief Get the progress and queue depths of the pipeline; may be called during run().
+    CV_WRAP virtual TranscoderStats stats() const = 0;
+
+    /// @brief Get the decoder and encoder statistics and a summary of the pipeline.
+    CV_WRAP virtual String statistics() const = 0;
+
+    /// The decoder feeding the pipeline.
+    CV_WRAP virtual Ptr<Decoder> decoder() const = 0;
+
+    /// The encoder at the end of the pipeline, e.g. for dynamic commands.
+    CV_WRAP virtual Ptr<Encoder> encoder() const = 0;
+};
+
 /// @brief Create a decoder instance for the given input file or stream.
 ///
 /// Opens the input and initializes the VCU decoder hardware with the specified parameters.
@@ -866,6 +1279,60 @@ CV_EXPORTS_W Ptr<Encoder> createEncoder(
                                 ///< is called when encoding completes. Not available from Python.
 );
 
+/// @brief Create a simulcast encoder producing one stream per rendition from a single input.
+///
+/// @p params describes the input (fourcc, width, height, framerate) and the settings shared by
+/// all renditions. The GOP mode must not be adaptive and lookahead must be disabled, since both
+/// let each rendition place its own I-frames.
+///
+/// Example:
+/// @code{.py}
+///     params = cv2.vcucodec.EncoderInitParams()
+///     params.pictureEncSettings.width = 1920
+///     params.pictureEncSettings.height = 1080
+///     ladder = [cv2.vcucodec.SimulcastRendition("1080p.h265", 1920, 1080, 6000),
+///               cv2.vcucodec.SimulcastRendition("720p.h265", 1280, 720, 3000),
+///               cv2.vcucodec.SimulcastRendition("360p.h265", 640, 360, 800)]
+///     encoder = cv2.vcucodec.createSimulcastEncoder(params, ladder)
+/// @endcode
+CV_EXPORTS_W Ptr<SimulcastEncoder> createSimulcastEncoder(
+    const EncoderInitParams& params,                   ///< Input and shared encoder parameters.
+    const std::vector<SimulcastRendition>& renditions  ///< Output renditions.
+);
+
+/// @brief Create a simulcast encoder with per-rendition callbacks (C++ only).
+///
+/// Like createSimulcastEncoder(params, renditions), with @p callbacks[i] receiving the encoded
+/// data of rendition i. A null entry writes that rendition to its file instead.
+CV_EXPORTS Ptr<SimulcastEncoder> createSimulcastEncoder(
+    const EncoderInitParams& params,                     ///< Input and shared encoder parameters.
+    const std::vector<SimulcastRendition>& renditions,   ///< Output renditions.
+    const std::vector<Ptr<EncoderCallback>>& callbacks   ///< One callback per rendition.
+);
+
+/// @brief Create a transcoder from an input stream to an output stream.
+///
+/// The output resolution is the one of @p encoderParams; frames of another size are scaled.
+/// The decoder output format must have the same plane layout as the encoder input format
+/// (e.g. NV12 to NV12). The decoder gets extra frame buffers for the frames held by the pipeline.
+///
+/// Example:
+/// @code{.py}
+///     decParams = cv2.vcucodec.DecoderInitParams(codec=cv2.vcucodec.CODEC_HEVC)
+///     encParams = cv2.vcucodec.EncoderInitParams()
+///     encParams.pictureEncSettings.width = 1280
+///     encParams.pictureEncSettings.height = 720
+///     transcoder = cv2.vcucodec.createTranscoder("in.h265", decParams, "out.h265", encParams)
+///     transcoder.run()
+/// @endcode
+CV_EXPORTS_W Ptr<Transcoder> createTranscoder(
+    const String& input,                    ///< Input video file name.
+    const DecoderInitParams& decoderParams, ///< Decoder initialization parameters.
+    const String& output,                   ///< Output video file name.
+    const EncoderInitParams& encoderParams, ///< Encoder initialization parameters.
+    const TranscoderParams& params = TranscoderParams() ///< Pipeline parameters.
+);
+
 //! @}
 
 ////////////////////
@@ -919,6 +1386,11 @@ inline ScalingListSettings::ScalingListSettings(ScalingListMode _mode,
                                                 const std::vector<uchar>& _dcCoeff)
     : mode(_mode), matrices(_matrices), dcCoeff(_dcCoeff) {}
 
+inline SimulcastRendition::SimulcastRendition(const String& _filename, int _width, int _height,
+                                              int _bitrate, int _maxBitrate)
+    : filename(_filename), width(_width), height(_height), bitrate(_bitrate),
+      maxBitrate(_maxBitrate) {}
+
 //! @endcond
 
 }  // namespace vcucodec
@@ -0,0 +1,67 @@
+/*
+   Copyright (c) 2025-2026  Advanced Micro Devices, Inc. (AMD)
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+*/
+#include "perf_precomp.hpp"
+#include "vcucommand.hpp"
+
+namespace opencv_test { namespace {
+
+class CountingExecutor : public CommandExecutor
+{
+public:
+    void executeCommand(const Command& cmd) override
+    {
+        ++count;
+        sum += cmd.arg[0];
+    }
+
+    int64 count = 0;
+    int64 sum = 0;
+};
+
+typedef tuple<int, int> CommandsFrames;
+typedef perf::TestBaseWithParam<CommandsFrames> CommandQueue_throughput;
+
+// Commands pushed ahead of time and run as the frames are submitted, the way the dynamic
+// encoder controls go through the queue.
+PERF_TEST_P(CommandQueue_throughput, commands,
+            testing::Combine(testing::Values(100, 1000, 10000), testing::Values(1, 300)))
+{
+    const int numCommands = get<0>(GetParam());
+    const int numFrames = get<1>(GetParam());
+    CommandQueue queue;
+    CountingExecutor executor;
+
+    TEST_CYCLE()
+    {
+        queue.clear();
+        executor.count = 0;
+        for (int i = 0; i < numCommands; ++i)
+        {
+            Command cmd;
+            cmd.frameIndex = i % numFrames;
+            cmd.type = CommandType::BIT_RATE;
+            cmd.arg[0] = i;
+            queue.push(std::move(cmd));
+        }
+        for (int frame = 0; frame < numFrames; ++frame)
+            queue.execute(frame, executor);
+    }
+
+    ASSERT_EQ(numCommands, executor.count);
+    SANITY_CHECK_NOTHING();
+}
+
+}} // namespace
@@ -0,0 +1,81 @@
+/*
+   Copyright (c) 2025-2026  Advanced Micro Devices, Inc. (AMD)
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+*/
+#include "perf_precomp.hpp"
+
+#if defined(HAVE_VCU_CTRLSW) || defined(HAVE_VCU2_CTRLSW)
+
+#include "vcudata.hpp"
+
+#include <cstring>
+
+extern "C" {
+#include "config.h"
+#include "lib_common/Allocator.h"
+#include "lib_common/BufferAPI.h"
+#include "lib_common/BufferStreamMeta.h"
+}
+
+namespace opencv_test { namespace {
+
+typedef tuple<int, int> SizeSections;
+typedef perf::TestBaseWithParam<SizeSections> Data_walkBuffers;
+
+// Copy of an encoded stream buffer out of its sections, as the encoder output callback does.
+PERF_TEST_P(Data_walkBuffers, sections,
+            testing::Combine(testing::Values(64 * 1024, 4 * 1024 * 1024), testing::Values(1, 16, 64)))
+{
+    const int streamSize = get<0>(GetParam());
+    const int numSections = get<1>(GetParam());
+    const int framesPerBuffer = 4;
+
+    AL_TBuffer* pStream = AL_Buffer_Create_And_Allocate(AL_GetDefaultAllocator(), streamSize,
+                                                        AL_Buffer_Destroy);
+    ASSERT_TRUE(pStream != nullptr);
+    AL_Buffer_Ref(pStream);
+    AL_TStreamMetaData* pMeta = AL_StreamMetaData_Create(numSections);
+    ASSERT_TRUE(AL_Buffer_AddMetaData(pStream, (AL_TMetaData*)pMeta));
+
+    int sectionSize = streamSize / numSections;
+    for (int i = 0; i < numSections; ++i)
+    {
+        bool endOfFrame = (i + 1) % std::max(1, numSections / framesPerBuffer) == 0;
+        AL_StreamMetaData_AddSection(pMeta, i * sectionSize, sectionSize,
+                                     endOfFrame ? AL_SECTION_END_FRAME_FLAG : AL_SECTION_NO_FLAG);
+    }
+    std::memset(AL_Buffer_GetData(pStream), 0x5a, streamSize);
+
+    Ptr<Data> data = Data::create(pStream, nullptr);
+    std::vector<uint8_t> out(streamSize);
+    size_t copied = 0;
+
+    TEST_CYCLE()
+    {
+        copied = 0;
+        data->walkBuffers([&](size_t size, uint8_t* pData) {
+            std::memcpy(out.data() + copied, pData, size);
+            copied += size;
+        });
+    }
+
+    data.release();
+    AL_Buffer_Unref(pStream);
+    ASSERT_EQ((size_t)(sectionSize * numSections), copied);
+    SANITY_CHECK_NOTHING();
+}
+
+}} // namespace
+
+#endif
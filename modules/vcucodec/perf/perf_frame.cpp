@@ -0,0 +1,105 @@
+/*
+   Copyright (c) 2025-2026  Advanced Micro Devices, Inc. (AMD)
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+*/
+#include "perf_precomp.hpp"
+#include "vcuframe.hpp"
+#include "vcuutils.hpp"
+
+#include <thread>
+
+extern "C" {
+#include "lib_common/BufferAPI.h"
+}
+
+namespace opencv_test { namespace {
+
+int fourccOf(const std::string& name)
+{
+    return name[0] | (name[1] << 8) | (name[2] << 16) | (name[3] << 24);
+}
+
+/// Source buffer format the encoder copies a @p input picture into.
+int sourceFourcc(const std::string& input)
+{
+    if (input == "I420") return fourccOf("NV12");
+    if (input == "I422") return fourccOf("NV16");
+    if (input == "I0AL") return toEncoderFourCC(fourccOf("P0AL"));
+    return toEncoderFourCC(fourccOf(input));
+}
+
+/// Rows of a packed @p formatInfo picture as VCUEncoder::write() receives it: the planes
+/// follow each other with the luma pitch.
+int packedRows(const FormatInfo& formatInfo, int height)
+{
+    bool planar = AL_GetPlaneMode(toEncoderFourCC(formatInfo.fourcc)) == AL_PLANE_MODE_PLANAR;
+    switch (formatInfo.format.eChromaMode)
+    {
+    case AL_CHROMA_4_2_0: return height + (planar ? height : height / 2);
+    case AL_CHROMA_4_2_2: return height + (planar ? 2 * height : height);
+    default: return height;
+    }
+}
+
+typedef tuple<std::string, Size> FourccSize;
+typedef perf::TestBaseWithParam<FourccSize> Frame_createFromMat;
+
+// The copy of a write() picture into the encoder source buffer, per input format.
+PERF_TEST_P(Frame_createFromMat, fourcc,
+            testing::Combine(testing::Values("Y800", "NV12", "I420", "NV16", "I422", "P0AL", "I0AL"),
+                             testing::Values(sz1080p, sz2160p)))
+{
+    const std::string input = get<0>(GetParam());
+    const Size size = get<1>(GetParam());
+    FormatInfo formatInfo(fourccOf(input));
+    int bytesPerSample = formatInfo.format.uBitDepth > 8 ? 2 : 1;
+
+    Mat mat(packedRows(formatInfo, size.height), size.width * bytesPerSample, CV_8UC1);
+    randu(mat, 0, 256);
+    Ptr<Frame> source = Frame::createYuvIO(size, sourceFourcc(input));
+    std::shared_ptr<AL_TBuffer> buffer = source->getSharedBuffer();
+    AL_TDimension dimension = { size.width, size.height };
+
+    TEST_CYCLE() Frame::createFromMat(buffer, mat, dimension, formatInfo);
+
+    SANITY_CHECK_NOTHING();
+}
+
+typedef perf::TestBaseWithParam<int> FrameQueue_handoff;
+
+// Decoder output handoff: frames enqueued by the decoder callback thread, dequeued by the caller.
+PERF_TEST_P(FrameQueue_handoff, frames, testing::Values(1, 16, 256))
+{
+    const int numFrames = GetParam();
+    Ptr<Frame> frame = Frame::createYuvIO(Size(64, 64), fourccOf("NV12"));
+    FrameQueue queue;
+
+    TEST_CYCLE()
+    {
+        std::thread producer([&] {
+            for (int i = 0; i < numFrames; ++i)
+                queue.enqueue(frame);
+        });
+        int received = 0;
+        for (int i = 0; i < numFrames; ++i)
+            if (!queue.dequeue(std::chrono::milliseconds(1000)).empty())
+                ++received;
+        producer.join();
+        ASSERT_EQ(numFrames, received);
+    }
+
+    SANITY_CHECK_NOTHING();
+}
+
+}} // namespace
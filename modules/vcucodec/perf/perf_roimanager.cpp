@@ -0,0 +1,104 @@
+/*
+   Copyright (c) 2025-2026  Advanced Micro Devices, Inc. (AMD)
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+*/
+#include "perf_precomp.hpp"
+
+#if defined(HAVE_VCU_CTRLSW) || defined(HAVE_VCU2_CTRLSW)
+
+#include "vcuroimanager.hpp"
+
+namespace opencv_test { namespace {
+
+/// QP table layouts: AVC 16x16 (QP table V1) and HEVC 64x64 (V2, 24 QPs per 32-byte LCU).
+enum { AVC_16x16, HEVC_64x64 };
+CV_ENUM(QpTableLayout, AVC_16x16, HEVC_64x64)
+
+struct LayoutDesc
+{
+    AL_EProfile profile;
+    uint8_t log2MaxCuSize;
+    int32_t numQpPerLcu;
+    int32_t numBytesPerLcu;
+    int32_t lcuQpOffset;
+};
+
+const LayoutDesc layouts[] = {
+    { AL_PROFILE_AVC_HIGH, 4, 1, 1, 0 },
+    { AL_PROFILE_HEVC_MAIN, 6, 24, 32, 4 },
+};
+
+std::vector<RoiManager::FrameRegion> randomRegions(Size size, int count, RNG& rng)
+{
+    std::vector<RoiManager::FrameRegion> regions(count);
+    for (auto& r : regions)
+    {
+        r.width = rng.uniform(64, size.width / 6);
+        r.height = rng.uniform(64, size.height / 6);
+        r.posX = rng.uniform(0, size.width - r.width);
+        r.posY = rng.uniform(0, size.height - r.height);
+        r.qualityCode = rng.uniform(-10, 11);
+    }
+    return regions;
+}
+
+/// What changes from one frame to the next: nothing (the cached table is copied), one one-shot
+/// region on top of the persistent ones (its rows are refilled), or every region.
+enum { UPDATE_NONE, UPDATE_ONE, UPDATE_ALL };
+CV_ENUM(RegionUpdate, UPDATE_NONE, UPDATE_ONE, UPDATE_ALL)
+
+typedef tuple<QpTableLayout, Size, int, RegionUpdate> LayoutSizeRegionsUpdate;
+typedef perf::TestBaseWithParam<LayoutSizeRegionsUpdate> RoiManager_fillBuffer;
+
+PERF_TEST_P(RoiManager_fillBuffer, regions,
+            testing::Combine(QpTableLayout::all(), testing::Values(sz1080p, sz2160p, sz4320p),
+                             testing::Values(1, 16, 128), RegionUpdate::all()))
+{
+    const LayoutDesc& layout = layouts[(int)get<0>(GetParam())];
+    const Size size = get<1>(GetParam());
+    const int numRegions = get<2>(GetParam());
+    const int update = get<3>(GetParam());
+
+    RoiManager roi(size.width, size.height, layout.profile, layout.log2MaxCuSize, 0,
+                   RoiOrder::QUALITY);
+    RNG rng(0x5201);
+    std::vector<std::vector<RoiManager::FrameRegion>> frameRegions;
+    for (int i = 0; i < 16; ++i)
+        frameRegions.push_back(randomRegions(size, update == UPDATE_ALL ? numRegions : 1, rng));
+    if (update != UPDATE_ALL)
+    {
+        for (const auto& r : randomRegions(size, numRegions, rng))
+            roi.enableRegion(roi.addRegion(r.posX, r.posY, r.width, r.height, r.qualityCode,
+                                           false), 0);
+    }
+
+    int lcuSize = 1 << layout.log2MaxCuSize;
+    int numLcus = ((size.width + lcuSize - 1) / lcuSize) * ((size.height + lcuSize - 1) / lcuSize);
+    std::vector<uint8_t> table(numLcus * layout.numBytesPerLcu);
+    int32_t frameIdx = 0;
+
+    TEST_CYCLE_MULTIRUN(10)
+    {
+        if (update != UPDATE_NONE)
+            roi.setFrameRegions(frameIdx, frameRegions[frameIdx % frameRegions.size()]);
+        roi.fillBuffer(frameIdx++, layout.numQpPerLcu, layout.numBytesPerLcu, table.data(),
+                       layout.lcuQpOffset);
+    }
+
+    SANITY_CHECK_NOTHING();
+}
+
+}} // namespace
+
+#endif
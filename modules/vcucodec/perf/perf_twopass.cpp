@@ -0,0 +1,91 @@
+/*
+   Copyright (c) 2025-2026  Advanced Micro Devices, Inc. (AMD)
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+*/
+#include "perf_precomp.hpp"
+
+#if defined(HAVE_VCU_CTRLSW) || defined(HAVE_VCU2_CTRLSW)
+
+#include "TwoPassMngr.h"
+
+#include <fstream>
+
+namespace opencv_test { namespace {
+
+/// Writes a pass-1 text log of @p numFrames frames: an intra picture every @p gopSize frames.
+void writeTextLog(const std::string& fileName, int numFrames, int gopSize)
+{
+    RNG rng(0x2b1);
+    std::ofstream log(fileName);
+    for (int i = 0; i < numFrames; ++i)
+    {
+        bool intra = i % gopSize == 0;
+        int size = (intra ? 400000 : 40000) + rng.uniform(-10000, 10000);
+        log << size << " " << (intra ? 100 : rng.uniform(0, 20)) << "\n";
+    }
+}
+
+typedef tuple<bool, int> BinaryFrames;
+typedef perf::TestBaseWithParam<BinaryFrames> TwoPass_readLog;
+
+// Pass 2 of an offline two-pass encode: the log is parsed and the complexities computed.
+PERF_TEST_P(TwoPass_readLog, frames,
+            testing::Combine(testing::Bool(), testing::Values(1000, 10000)))
+{
+    const bool binary = get<0>(GetParam());
+    const int numFrames = get<1>(GetParam());
+    const int gopSize = 30;
+    std::string textLog = cv::tempfile(".txt");
+    std::string binaryLog = cv::tempfile(".bin");
+    writeTextLog(textLog, numFrames, gopSize);
+    ASSERT_EQ(numFrames, AL_TwoPassMngr_ConvertTextLog(textLog, binaryLog));
+    const std::string& logFile = binary ? binaryLog : textLog;
+
+    TEST_CYCLE()
+    {
+        TwoPassMngr mngr(logFile, 2, false, gopSize, 2000, 1500, 30);
+        for (int i = 0; i < numFrames; ++i)
+        {
+            AL_TLookAheadMetaData metaData {};
+            mngr.GetFrame(&metaData);
+        }
+    }
+
+    std::remove(textLog.c_str());
+    std::remove(binaryLog.c_str());
+    SANITY_CHECK_NOTHING();
+}
+
+typedef perf::TestBaseWithParam<int> TwoPass_convertTextLog;
+
+PERF_TEST_P(TwoPass_convertTextLog, frames, testing::Values(1000, 10000))
+{
+    const int numFrames = GetParam();
+    std::string textLog = cv::tempfile(".txt");
+    std::string binaryLog = cv::tempfile(".bin");
+    writeTextLog(textLog, numFrames, 30);
+    int converted = 0;
+
+    TEST_CYCLE() converted = AL_TwoPassMngr_ConvertTextLog(textLog, binaryLog);
+
+    ASSERT_EQ(numFrames, converted);
+    ASSERT_EQ(numFrames, AL_TwoPassMngr_CountLogFrames(binaryLog));
+    std::remove(textLog.c_str());
+    std::remove(binaryLog.c_str());
+    SANITY_CHECK_NOTHING();
+}
+
+}} // namespace
+
+#endif
@@ -0,0 +1,97 @@
+/*
+   Copyright (c) 2025-2026  Advanced Micro Devices, Inc. (AMD)
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+*/
+#include "perf_precomp.hpp"
+#include "vcuvideoframe.hpp"
+
+namespace opencv_test { namespace {
+
+int fourccOf(const std::string& name)
+{
+    return name[0] | (name[1] << 8) | (name[2] << 16) | (name[3] << 24);
+}
+
+/// Planes of a decoded @p fourcc picture, laid out as VCUDecoder::nextFrame() wraps them.
+std::vector<Mat> makePlanes(const std::string& fourcc, Size size)
+{
+    Size szUV420(size.width / 2, size.height / 2);
+    Size szUV422(size.width / 2, size.height);
+    std::vector<Mat> planes;
+    if (fourcc == "Y800")
+        planes = { Mat(size, CV_8UC1) };
+    else if (fourcc == "NV12")
+        planes = { Mat(size, CV_8UC1), Mat(szUV420, CV_8UC2) };
+    else if (fourcc == "NV16")
+        planes = { Mat(size, CV_8UC1), Mat(szUV422, CV_8UC2) };
+    else if (fourcc == "I420")
+        planes = { Mat(size, CV_8UC1), Mat(szUV420, CV_8UC1), Mat(szUV420, CV_8UC1) };
+    else if (fourcc == "P010")
+        planes = { Mat(size, CV_16UC1), Mat(szUV420, CV_16UC2) };
+    else if (fourcc == "I0AL")
+        planes = { Mat(size, CV_16UC1), Mat(szUV420, CV_16UC1), Mat(szUV420, CV_16UC1) };
+    else
+        CV_Error(Error::StsBadArg, "Unknown fourcc " + fourcc);
+
+    for (Mat& plane : planes)
+        randu(plane, 0, plane.depth() == CV_8U ? 256 : 1024);
+    return planes;
+}
+
+Ptr<VideoFrameImpl> makeFrame(const std::string& fourcc, Size size)
+{
+    std::vector<Mat> planes = makePlanes(fourcc, size);
+    RawInfo info = RawInfo();
+    info.fourcc = fourccOf(fourcc);
+    info.bitsPerLuma = info.bitsPerChroma = planes[0].depth() == CV_8U ? 8 : 10;
+    info.width = size.width;
+    info.height = size.height;
+    info.stride = (int)planes[0].step[0];
+    info.strideChroma = planes.size() > 1 ? (int)planes[1].step[0] : 0;
+    return makePtr<VideoFrameImpl>(Ptr<Frame>(), info, planes);
+}
+
+typedef tuple<std::string, Size> FourccSize;
+typedef perf::TestBaseWithParam<FourccSize> VideoFrame_copyTo;
+
+PERF_TEST_P(VideoFrame_copyTo, fourcc,
+            testing::Combine(testing::Values("Y800", "NV12", "NV16", "I420", "P010", "I0AL"),
+                             testing::Values(sz1080p, sz2160p)))
+{
+    Ptr<VideoFrameImpl> frame = makeFrame(get<0>(GetParam()), get<1>(GetParam()));
+    Mat dst;
+
+    TEST_CYCLE() frame->copyTo(dst);
+
+    SANITY_CHECK_NOTHING();
+}
+
+typedef tuple<std::string, std::string, Size> FourccFourccSize;
+typedef perf::TestBaseWithParam<FourccFourccSize> VideoFrame_convertTo;
+
+// Every converter registered by the module, through ColorConverter::find() and convert().
+PERF_TEST_P(VideoFrame_convertTo, fourcc,
+            testing::Combine(testing::Values("Y800", "NV12"), testing::Values("BGR ", "BGRA"),
+                             testing::Values(sz1080p, sz2160p)))
+{
+    Ptr<VideoFrameImpl> frame = makeFrame(get<0>(GetParam()), get<2>(GetParam()));
+    int dstFourcc = fourccOf(get<1>(GetParam()));
+    Mat dst;
+
+    TEST_CYCLE() frame->convertTo(dst, dstFourcc);
+
+    SANITY_CHECK_NOTHING();
+}
+
+}} // namespace
@@ -4,12 +4,28 @@
 
 #include "config.h"
 #include "TwoPassMngr.h"
+#include <climits>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
 #include <stdexcept>
 #include <string>
 #include <algorithm>
 #include <iostream>
 
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+extern "C"
+{
+#include <lib_common/FourCC.h>
+#include <lib_common/PixMapBuffer.h>
+}
+
 #define SEQUENCE_SIZE_MAX 1000
+#define GLOBAL_QCOMP 0.6
 
 using namespace std;
 
@@ -136,12 +152,187 @@ static bool DetectPatternTwoFrames(vector<int> v)
   return ecart_max == 1 && nb_zero >= ((int)v.size() - 1) / 2;
 }
 
+/***************************************************************************/
+/*Binary TwoPass log*/
+/***************************************************************************/
+static char const TWOPASS_LOG_MAGIC[8] = { 'A', 'L', '2', 'P', 'A', 'S', 'S', '\0' };
+
+/***************************************************************************/
+TwoPassBinaryLog::~TwoPassBinaryLog(void)
+{
+  Close();
+}
+
+/***************************************************************************/
+bool TwoPassBinaryLog::IsBinaryLog(std::string const& sFileName)
+{
+  ifstream file(sFileName, ios::binary);
+  char sMagic[sizeof(TWOPASS_LOG_MAGIC)];
+
+  return file.read(sMagic, sizeof(sMagic)) && memcmp(sMagic, TWOPASS_LOG_MAGIC, sizeof(sMagic)) == 0;
+}
+
+/***************************************************************************/
+TwoPassLogRecord TwoPassBinaryLog::ToRecord(AL_TLookAheadMetaData const& tMetaData)
+{
+  TwoPassLogRecord tRecord {};
+  tRecord.iPictureSize = tMetaData.iPictureSize;
+  tRecord.iIPRatio = tMetaData.iIPRatio;
+  tRecord.iComplexity = tMetaData.iComplexity;
+  tRecord.iTargetLevel = tMetaData.iTargetLevel;
+  tRecord.iSceneChange = static_cast<int32_t>(tMetaData.eSceneChange);
+
+  for(int8_t i = 0; i < 5; i++)
+    tRecord.iPercentIntra[i] = static_cast<int8_t>(tMetaData.iPercentIntra[i]);
+
+  return tRecord;
+}
+
+/***************************************************************************/
+void TwoPassBinaryLog::FromRecord(TwoPassLogRecord const& tRecord, AL_TLookAheadMetaData& tMetaData)
+{
+  tMetaData.iPictureSize = tRecord.iPictureSize;
+  tMetaData.iIPRatio = tRecord.iIPRatio;
+  tMetaData.iComplexity = tRecord.iComplexity;
+  tMetaData.iTargetLevel = tRecord.iTargetLevel;
+  tMetaData.eSceneChange = static_cast<decltype(tMetaData.eSceneChange)>(tRecord.iSceneChange);
+
+  for(int8_t i = 0; i < 5; i++)
+    tMetaData.iPercentIntra[i] = tRecord.iPercentIntra[i];
+}
+
+/***************************************************************************/
+void TwoPassBinaryLog::Create(std::string const& sFileName)
+{
+  Close();
+  outputFile.open(sFileName, ios::binary | ios::trunc);
+
+  if(!outputFile.is_open())
+    throw runtime_error("Can't open TwoPass LogFile");
+
+  TwoPassLogHeader tHeader {};
+  memcpy(tHeader.sMagic, TWOPASS_LOG_MAGIC, sizeof(tHeader.sMagic));
+  tHeader.uVersion = VERSION;
+  tHeader.uRecordSize = sizeof(TwoPassLogRecord);
+  outputFile.write(reinterpret_cast<char const*>(&tHeader), sizeof(tHeader));
+}
+
+/***************************************************************************/
+void TwoPassBinaryLog::Append(std::vector<AL_TLookAheadMetaData> const& tFrames)
+{
+  vector<TwoPassLogRecord> tRecords;
+  tRecords.reserve(tFrames.size());
+
+  for(auto const& frame : tFrames)
+    tRecords.push_back(ToRecord(frame));
+
+  outputFile.write(reinterpret_cast<char const*>(tRecords.data()), tRecords.size() * sizeof(TwoPassLogRecord));
+
+  if(!outputFile)
+    throw runtime_error("Can't write TwoPass LogFile");
+}
+
+/***************************************************************************/
+void TwoPassBinaryLog::Map(std::string const& sFileName)
+{
+  Close();
+  int fd = open(sFileName.c_str(), O_RDONLY);
+
+  if(fd < 0)
+    throw runtime_error("Can't open TwoPass LogFile");
+
+  struct stat tStat;
+
+  if(fstat(fd, &tStat) != 0 || tStat.st_size < static_cast<off_t>(sizeof(TwoPassLogHeader)))
+  {
+    close(fd);
+    throw runtime_error("TwoPass LogFile is truncated");
+  }
+
+  zMappingSize = tStat.st_size;
+  pMapping = mmap(nullptr, zMappingSize, PROT_READ, MAP_PRIVATE, fd, 0);
+  close(fd);
+
+  if(pMapping == MAP_FAILED)
+  {
+    pMapping = nullptr;
+    throw runtime_error("Can't map TwoPass LogFile");
+  }
+
+  auto pHeader = static_cast<TwoPassLogHeader const*>(pMapping);
+
+  if(memcmp(pHeader->sMagic, TWOPASS_LOG_MAGIC, sizeof(pHeader->sMagic)) != 0 || pHeader->uVersion != VERSION || pHeader->uRecordSize != sizeof(TwoPassLogRecord))
+  {
+    Close();
+    throw runtime_error("Unsupported TwoPass LogFile version");
+  }
+
+  pRecords = reinterpret_cast<TwoPassLogRecord const*>(pHeader + 1);
+  iNumFrames = static_cast<int>((zMappingSize - sizeof(TwoPassLogHeader)) / sizeof(TwoPassLogRecord));
+  madvise(pMapping, zMappingSize, MADV_SEQUENTIAL);
+}
+
+/***************************************************************************/
+void TwoPassBinaryLog::Close(void)
+{
+  outputFile.close();
+
+  if(pMapping)
+    munmap(pMapping, zMappingSize);
+
+  pMapping = nullptr;
+  zMappingSize = 0;
+  pRecords = nullptr;
+  iNumFrames = 0;
+}
+
+/***************************************************************************/
+int AL_TwoPassMngr_ConvertTextLog(std::string const& sTextFileName, std::string const& sBinaryFileName)
+{
+  ifstream inputFile(sTextFileName);
+
+  if(!inputFile.is_open())
+    throw runtime_error("Can't open TwoPass LogFile");
+
+  TwoPassBinaryLog tBinaryLog;
+  tBinaryLog.Create(sBinaryFileName);
+
+  vector<AL_TLookAheadMetaData> tFrames;
+  AL_TLookAheadMetaData tParams {};
+  tParams.eSceneChange = AL_SC_NONE;
+  tParams.iIPRatio = 1000;
+  int iNumFrames = 0;
+  string sLine;
+
+  while(getline(inputFile, sLine))
+  {
+    int iPictureSize, iPercentIntra;
+
+    if(sscanf(sLine.c_str(), "%d %d", &iPictureSize, &iPercentIntra) != 2)
+      break;
+
+    tParams.iPictureSize = iPictureSize;
+    tParams.iPercentIntra[0] = iPercentIntra;
+    tFrames.push_back(tParams);
+
+    if(static_cast<int>(tFrames.size()) >= SEQUENCE_SIZE_MAX)
+    {
+      tBinaryLog.Append(tFrames);
+      iNumFrames += tFrames.size();
+      tFrames.clear();
+    }
+  }
+
+  tBinaryLog.Append(tFrames);
+  return iNumFrames + tFrames.size();
+}
+
 /***************************************************************************/
 /*Offline TwoPass methods*/
 /***************************************************************************/
-TwoPassMngr::TwoPassMngr(std::string p_FileName, int p_iPass, bool p_bEnabledFirstPassSceneChangeDetection, int p_iGopSize, int p_iCpbLevel, int p_iInitialLevel, int p_iFrameRate) :
+TwoPassMngr::TwoPassMngr(std::string p_FileName, int p_iPass, bool p_bEnabledFirstPassSceneChangeDetection, int p_iGopSize, int p_iCpbLevel, int p_iInitialLevel, int p_iFrameRate, bool p_bBinaryLog, bool p_bGlobalAllocation) :
   iPass(p_iPass), bEnableFirstPassSceneChangeDetection(p_bEnabledFirstPassSceneChangeDetection), iGopSize(p_iGopSize),
-  iCpbLevel(p_iCpbLevel), iInitialLevel(p_iInitialLevel), iFrameRate(p_iFrameRate)
+  iCpbLevel(p_iCpbLevel), iInitialLevel(p_iInitialLevel), iFrameRate(p_iFrameRate), bBinaryLog(p_bBinaryLog), bGlobalAllocation(p_bGlobalAllocation)
 {
   FileName = { p_FileName };
   tFrames.clear();
@@ -157,7 +348,12 @@ TwoPassMngr::~TwoPassMngr(void)
 /***************************************************************************/
 void TwoPassMngr::OpenLog(void)
 {
-  if(iPass == 1)
+  if(iPass == 1 && bBinaryLog)
+  {
+    tBinaryLog.Create(FileName);
+    bBinaryLogOpened = true;
+  }
+  else if(iPass == 1)
   {
     outputFile.open(FileName);
 
@@ -165,7 +361,12 @@ void TwoPassMngr::OpenLog(void)
       throw runtime_error("Can't open TwoPass LogFile");
   }
 
-  if(iPass == 2)
+  if(iPass == 2 && TwoPassBinaryLog::IsBinaryLog(FileName))
+  {
+    tBinaryLog.Map(FileName);
+    bBinaryLogOpened = true;
+  }
+  else if(iPass == 2)
   {
     inputFile.open(FileName);
 
@@ -179,21 +380,53 @@ void TwoPassMngr::CloseLog(void)
 {
   inputFile.close();
   outputFile.close();
+  tBinaryLog.Close();
+  bBinaryLogOpened = false;
 }
 
 /***************************************************************************/
 void TwoPassMngr::EmptyLog(void)
 {
-  if(!inputFile.is_open())
+  if(!inputFile.is_open() && !bBinaryLogOpened)
     OpenLog();
 
   tFrames.clear();
 
+  if(bGlobalAllocation)
+  {
+    if(bGlobalAllocationDone)
+      return;
+
+    ReadLog(INT_MAX);
+    bGlobalAllocationDone = true;
+  }
+  else
+    ReadLog(SEQUENCE_SIZE_MAX);
+
+  ComputeTwoPass();
+}
+
+/***************************************************************************/
+void TwoPassMngr::ReadLog(int iMaxFrames)
+{
+  if(bBinaryLogOpened)
+  {
+    int iEnd = iNextLoggedFrame + min(tBinaryLog.NumFrames() - iNextLoggedFrame, iMaxFrames);
+
+    for(; iNextLoggedFrame < iEnd; iNextLoggedFrame++)
+    {
+      AddNewFrame(0, 0);
+      TwoPassBinaryLog::FromRecord(tBinaryLog.Frame(iNextLoggedFrame), tFrames.back());
+    }
+
+    return;
+  }
+
   char sLine[256];
   bool bFind = true;
   int i = 0;
 
-  while(bFind && !inputFile.eof() && i < SEQUENCE_SIZE_MAX)
+  while(bFind && !inputFile.eof() && i < iMaxFrames)
   {
     inputFile.getline(sLine, 256);
 
@@ -208,18 +441,21 @@ void TwoPassMngr::EmptyLog(void)
     AddNewFrame(atoi(str_PicSize), atoi(str_PercentIntra));
     i++;
   }
-
-  ComputeTwoPass();
 }
 
 /***************************************************************************/
 void TwoPassMngr::FillLog(void)
 {
-  if(!outputFile.is_open())
+  if(!outputFile.is_open() && !bBinaryLogOpened)
     OpenLog();
 
-  for(auto frame: tFrames)
-    outputFile << frame.iPictureSize << " " << static_cast<int>(frame.iPercentIntra[0]) << endl;
+  if(bBinaryLogOpened)
+    tBinaryLog.Append(tFrames);
+  else
+  {
+    for(auto frame: tFrames)
+      outputFile << frame.iPictureSize << " " << static_cast<int>(frame.iPercentIntra[0]) << endl;
+  }
 
   tFrames.clear();
 }
@@ -293,7 +529,10 @@ void TwoPassMngr::ComputeTwoPass(void)
       tFrames[i].iIPRatio = min(tFrames[i].iIPRatio, GetIPRatio(&tFrames[i], &tFrames[k]));
   }
 
-  ComputeComplexity();
+  if(bGlobalAllocation)
+    ComputeGlobalComplexity();
+  else
+    ComputeComplexity();
 }
 
 /***************************************************************************/
@@ -390,6 +629,154 @@ void TwoPassMngr::ComputeComplexity(void)
   }
 }
 
+/***************************************************************************/
+void TwoPassMngr::ComputeGlobalComplexity(void)
+{
+  auto iSequenceSize = static_cast<int>(tFrames.size());
+
+  if(iSequenceSize <= 0)
+    throw runtime_error("iSequenceSize(" + to_string(iSequenceSize) + ") must be higher than 0");
+
+  if(iCpbLevel < iInitialLevel)
+    throw runtime_error("iCpbLevel(" + to_string(iCpbLevel) + ") should be higher or equal than iInitialLevel(" + to_string(iInitialLevel) + ")");
+
+  if(iGopSize == 0)
+    return;
+
+  /* Same GOP split as the windowed allocation, over the whole sequence */
+  vector<int> tGopStarts;
+  vector<double> tGopWeights;
+  double fSumWeights = 0;
+  int iIndex = 0;
+
+  while(iIndex < iSequenceSize)
+  {
+    int iLength = 0;
+    double fSumComp = 0;
+
+    while(iLength < iGopSize && iIndex + iLength < iSequenceSize)
+    {
+      fSumComp += tFrames[iIndex + iLength].iPictureSize;
+      iLength++;
+
+      if(tFrames[iIndex + iLength - 1].eSceneChange == AL_SC_NEXT)
+        break;
+    }
+
+    /* Bits follow complexity^GLOBAL_QCOMP: complex GOPs get more bits, but not in proportion */
+    double fWeight = pow(max(fSumComp / iLength, 1.0), GLOBAL_QCOMP);
+    tGopStarts.push_back(iIndex);
+    tGopWeights.push_back(fWeight);
+    fSumWeights += fWeight * iLength;
+    iIndex += iLength;
+  }
+
+  tGopStarts.push_back(iSequenceSize);
+  double fMeanWeight = fSumWeights / iSequenceSize;
+
+  /*
+  ** The CPB level (in ms) is refilled by 1000 / iFrameRate per frame and must stay within
+  ** [iInitialLevel / 10, iCpbLevel], the lower margin being the one of the windowed allocation.
+  ** Consecutive frames above (below) their average share form a run that drains (fills) the CPB.
+  ** When the whole run would not fit, each frame of the run gets the same fraction of its excess,
+  ** so the buffer is spread over the run and the level reaches the bound at its end.
+  */
+  vector<double> tRunDrain(iSequenceSize);
+
+  for(int iGop = static_cast<int>(tGopWeights.size()) - 1; iGop >= 0; iGop--)
+  {
+    double fDrain = (tGopWeights[iGop] * 1000 / fMeanWeight - 1000) / iFrameRate;
+
+    for(int i = tGopStarts[iGop + 1] - 1; i >= tGopStarts[iGop]; i--)
+    {
+      bool bSameRun = i + 1 < iSequenceSize && ((fDrain > 0) == (tRunDrain[i + 1] > 0));
+      tRunDrain[i] = fDrain + (bSameRun ? tRunDrain[i + 1] : 0);
+    }
+  }
+
+  double fLevelMin = iInitialLevel / 10.0;
+  double fLevelMax = iCpbLevel;
+  double fLevel = iInitialLevel;
+
+  for(int iGop = 0; iGop < static_cast<int>(tGopWeights.size()); iGop++)
+  {
+    double fDrain = (tGopWeights[iGop] * 1000 / fMeanWeight - 1000) / iFrameRate;
+
+    for(int i = tGopStarts[iGop]; i < tGopStarts[iGop + 1]; i++)
+    {
+      double fFrameDrain = fDrain;
+
+      if(tRunDrain[i] > fLevel - fLevelMin)
+        fFrameDrain *= max(fLevel - fLevelMin, 0.0) / tRunDrain[i];
+      else if(-tRunDrain[i] > fLevelMax - fLevel)
+        fFrameDrain *= max(fLevelMax - fLevel, 0.0) / -tRunDrain[i];
+
+      int iComplexityMax = static_cast<int>(floor(1000 + (fLevel - fLevelMin) * iFrameRate));
+      int iComplexityMin = max(0, static_cast<int>(ceil(1000 - (fLevelMax - fLevel) * iFrameRate)));
+      int iComplexity = static_cast<int>(lround(1000 + fFrameDrain * iFrameRate));
+      tFrames[i].iComplexity = min(max(iComplexity, iComplexityMin), iComplexityMax);
+      fLevel -= (tFrames[i].iComplexity - 1000) / static_cast<double>(iFrameRate);
+    }
+
+    for(int i = tGopStarts[iGop]; i < tGopStarts[iGop + 1]; i++)
+      tFrames[i].iTargetLevel = static_cast<int>(fLevel);
+  }
+}
+
+/***************************************************************************/
+int AL_TwoPassMngr_CountLogFrames(std::string const& sFileName)
+{
+  if(TwoPassBinaryLog::IsBinaryLog(sFileName))
+  {
+    TwoPassBinaryLog tBinaryLog;
+    tBinaryLog.Map(sFileName);
+    return tBinaryLog.NumFrames();
+  }
+
+  ifstream inputFile(sFileName);
+
+  if(!inputFile.is_open())
+    throw runtime_error("Can't open TwoPass LogFile");
+
+  int iNumFrames = 0;
+  string sLine;
+
+  for(int iPictureSize, iPercentIntra; getline(inputFile, sLine) && sscanf(sLine.c_str(), "%d %d", &iPictureSize, &iPercentIntra) == 2;)
+    iNumFrames++;
+
+  return iNumFrames;
+}
+
+/***************************************************************************/
+TwoPassCpbReport AL_TwoPassMngr_SimulateCpb(std::string const& sFileName, int iGopSize, int iCpbLevel, int iInitialLevel, int iFrameRate, bool bGlobalAllocation)
+{
+  TwoPassCpbReport tReport;
+  tReport.iNumFrames = AL_TwoPassMngr_CountLogFrames(sFileName);
+  tReport.fMinLevel = tReport.fMaxLevel = iInitialLevel;
+
+  TwoPassMngr tMngr(sFileName, 2, false, iGopSize, iCpbLevel, iInitialLevel, iFrameRate, false, bGlobalAllocation);
+  double fLevel = iInitialLevel;
+
+  for(int i = 0; i < tReport.iNumFrames; i++)
+  {
+    AL_TLookAheadMetaData tMetaData {};
+    tMngr.GetFrame(&tMetaData);
+
+    /* A frame of complexity 1000 drains what one frame period refills */
+    fLevel -= (tMetaData.iComplexity - 1000) / static_cast<double>(iFrameRate);
+    tReport.fMinLevel = min(tReport.fMinLevel, fLevel);
+    tReport.fMaxLevel = max(tReport.fMaxLevel, fLevel);
+
+    if(fLevel < 0)
+      tReport.iNumUnderflows++;
+
+    if(fLevel > iCpbLevel)
+      tReport.iNumOverflows++;
+  }
+
+  return tReport;
+}
+
 /***************************************************************************/
 bool TwoPassMngr::HasPatternTwoFrames(void)
 {
@@ -401,10 +788,90 @@ bool TwoPassMngr::HasPatternTwoFrames(void)
   return DetectPatternTwoFrames(v);
 }
 
+/***************************************************************************/
+/*Luma histogram scene-cut detection*/
+/***************************************************************************/
+void LumaSceneCutDetector::ComputeHistogram(uint8_t const* pLuma, int iPitch, int iWidth, int iHeight, int iBitDepth, THistogram& tHist)
+{
+  memset(tHist, 0, sizeof(THistogram));
+
+  if(iBitDepth <= 8)
+  {
+    for(int y = 0; y < iHeight; y += SUBSAMPLING)
+    {
+      uint8_t const* pLine = pLuma + static_cast<size_t>(y) * iPitch;
+
+      for(int x = 0; x < iWidth; x += SUBSAMPLING)
+        tHist[pLine[x] >> 2]++;
+    }
+
+    return;
+  }
+
+  int iShift = iBitDepth - 6;
+
+  for(int y = 0; y < iHeight; y += SUBSAMPLING)
+  {
+    auto pLine = reinterpret_cast<uint16_t const*>(pLuma + static_cast<size_t>(y) * iPitch);
+
+    for(int x = 0; x < iWidth; x += SUBSAMPLING)
+      tHist[min(pLine[x] >> iShift, HIST_BINS - 1)]++;
+  }
+}
+
+/***************************************************************************/
+bool LumaSceneCutDetector::ComputeHistogram(AL_TBuffer const* pSrc, THistogram& tHist)
+{
+  TFourCC tFourCC = AL_PixMapBuffer_GetFourCC(pSrc);
+  uint8_t const* pLuma = AL_PixMapBuffer_GetPlaneAddress(pSrc, AL_PLANE_Y);
+
+  if(!pLuma || AL_IsTiled(tFourCC))
+    return false;
+
+  AL_TDimension tDim = AL_PixMapBuffer_GetDimension(pSrc);
+  ComputeHistogram(pLuma, AL_PixMapBuffer_GetPlanePitch(pSrc, AL_PLANE_Y), tDim.iWidth, tDim.iHeight, AL_GetBitDepth(tFourCC), tHist);
+  return true;
+}
+
+/***************************************************************************/
+double LumaSceneCutDetector::Distance(THistogram const& tPrev, THistogram const& tCurrent)
+{
+  uint64_t uPrevCount = 0, uCurrentCount = 0;
+
+  for(int i = 0; i < HIST_BINS; i++)
+  {
+    uPrevCount += tPrev[i];
+    uCurrentCount += tCurrent[i];
+  }
+
+  if(!uPrevCount || !uCurrentCount)
+    return 0.0;
+
+  double fDistance = 0.0;
+
+  for(int i = 0; i < HIST_BINS; i++)
+    fDistance += fabs(double(tPrev[i]) / uPrevCount - double(tCurrent[i]) / uCurrentCount);
+
+  return fDistance;
+}
+
+/***************************************************************************/
+bool LumaSceneCutDetector::IsSceneCut(THistogram const& tPrev, THistogram const& tCurrent)
+{
+  double fDistance = Distance(tPrev, tCurrent);
+  bool bCut = fDistance > fThreshold && fDistance > fOutlierRatio * max(fMeanDistance, 0.02);
+
+  /* A cut does not tell anything about the motion level of the scenes around it */
+  if(!bCut)
+    fMeanDistance += (fDistance - fMeanDistance) / 8;
+
+  return bCut;
+}
+
 /***************************************************************************/
 /*LookAhead structures and methods*/
 /***************************************************************************/
-LookAheadMngr::LookAheadMngr(int p_iLookAhead, bool p_bEnableFirstPassSceneChangeDetection) : uLookAheadSize(p_iLookAhead), bEnableFirstPassSceneChangeDetection(p_bEnableFirstPassSceneChangeDetection)
+LookAheadMngr::LookAheadMngr(int p_iLookAhead, bool p_bEnableFirstPassSceneChangeDetection) : uLookAheadSize(p_iLookAhead), bEnableFirstPassSceneChangeDetection(p_bEnableFirstPassSceneChangeDetection), m_fifo(p_iLookAhead + 1), m_pictureSizes(p_iLookAhead + 1), m_sceneChanges(p_iLookAhead + 1)
 {
   iComplexity = 1000;
   iFrameCount = 0;
@@ -424,6 +891,69 @@ LookAheadMngr::~LookAheadMngr(void)
 
 }
 
+/***************************************************************************/
+void LookAheadMngr::Push(AL_TBuffer* pSrc)
+{
+  if(!m_fifo.empty() && DetectSceneChange(m_fifo.back(), pSrc))
+    m_sceneChanges.push_back(uFrontIndex + m_fifo.size() - 1);
+
+  auto pMeta = reinterpret_cast<AL_TLookAheadMetaData*>(AL_Buffer_GetMetaData(pSrc, AL_META_TYPE_LOOKAHEAD));
+  int32_t iPictureSize = pMeta ? pMeta->iPictureSize : 0;
+
+  if(m_fifo.size() < COMPLEXITY_HEAD)
+    iSumHeadPictureSize += iPictureSize;
+  iSumPictureSize += iPictureSize;
+
+  m_pictureSizes.push_back(iPictureSize);
+  m_fifo.push_back(pSrc);
+}
+
+/***************************************************************************/
+void LookAheadMngr::Pop(void)
+{
+  iSumPictureSize -= m_pictureSizes.front();
+  iSumHeadPictureSize -= m_pictureSizes.front();
+
+  if(m_pictureSizes.size() > COMPLEXITY_HEAD)
+    iSumHeadPictureSize += m_pictureSizes[COMPLEXITY_HEAD];
+
+  m_pictureSizes.pop_front();
+  m_fifo.pop_front();
+  uFrontIndex++;
+
+  while(!m_sceneChanges.empty() && m_sceneChanges.front() < uFrontIndex)
+    m_sceneChanges.pop_front();
+}
+
+/***************************************************************************/
+bool LookAheadMngr::DetectSceneChange(AL_TBuffer* pPrevSrc, AL_TBuffer* pCurrentSrc)
+{
+  if(AL_Buffer_GetMetaData(pPrevSrc, AL_META_TYPE_LOOKAHEAD) && AL_Buffer_GetMetaData(pCurrentSrc, AL_META_TYPE_LOOKAHEAD))
+    return ComputeSceneChange(pPrevSrc, pCurrentSrc);
+
+  /* No first pass metadata: compare the luma histograms */
+  uint64_t uPrevIndex = uFrontIndex + m_fifo.size() - 1;
+
+  if(uLastHistIndex != uPrevIndex && !LumaSceneCutDetector::ComputeHistogram(pPrevSrc, tLastHist))
+    return false;
+
+  LumaSceneCutDetector::THistogram tHist;
+
+  if(!LumaSceneCutDetector::ComputeHistogram(pCurrentSrc, tHist))
+    return false;
+
+  bool bCut = tLumaDetector.IsSceneCut(tLastHist, tHist);
+  memcpy(tLastHist, tHist, sizeof(tHist));
+  uLastHistIndex = uPrevIndex + 1;
+  return bCut;
+}
+
+/***************************************************************************/
+bool LookAheadMngr::HasSceneChangeAfterFront(void) const
+{
+  return !m_sceneChanges.empty() && m_sceneChanges.front() == uFrontIndex;
+}
+
 /***************************************************************************/
 bool LookAheadMngr::ComputeSceneChange(AL_TBuffer* pPrevSrc, AL_TBuffer* pCurrentSrc)
 {
@@ -469,15 +999,9 @@ int32_t LookAheadMngr::ComputeIPRatio(AL_TBuffer* pCurrentSrc, AL_TBuffer* pNext
 /***************************************************************************/
 int LookAheadMngr::GetNextSceneChange(void)
 {
-  int iFifoSize = static_cast<int>(m_fifo.size());
-  int iIndex = 0;
-
-  while((iIndex + 1 < iFifoSize) && !ComputeSceneChange(m_fifo[iIndex], m_fifo[iIndex + 1]))
-    iIndex++;
-
-  if(iFifoSize < 2 || iIndex + 1 == iFifoSize)
-    return iFifoSize;
-  return iIndex + 1;
+  if(m_sceneChanges.empty())
+    return static_cast<int>(m_fifo.size());
+  return static_cast<int>(m_sceneChanges.front() - uFrontIndex) + 1;
 }
 
 /***************************************************************************/
@@ -509,7 +1033,7 @@ void LookAheadMngr::ProcessLookAheadParams(void)
   if(iFifoSize < 2)
     return;
 
-  pPictureMetaLA->eSceneChange = ComputeSceneChange(m_fifo[0], m_fifo[1]) ? AL_SC_NEXT : AL_SC_NONE;
+  pPictureMetaLA->eSceneChange = HasSceneChangeAfterFront() ? AL_SC_NEXT : AL_SC_NONE;
 
   if(bEnableFirstPassSceneChangeDetection)
   {
@@ -534,17 +1058,9 @@ void LookAheadMngr::ComputeComplexity(void)
     iFrameCount = 0;
     iComplexity = 1000;
 
-    if(iFifoSize >= 5 && AL_Buffer_GetMetaData(m_fifo.front(), AL_META_TYPE_LOOKAHEAD))
+    if(iFifoSize >= COMPLEXITY_HEAD && iSumPictureSize > 0 && AL_Buffer_GetMetaData(m_fifo.front(), AL_META_TYPE_LOOKAHEAD))
     {
-      intmax_t iComp[2] = { 0, 0 };
-
-      for(int i = 0; i < iFifoSize; i++)
-      {
-        auto pPictureMetaLA = (AL_TLookAheadMetaData*)AL_Buffer_GetMetaData(m_fifo[i], AL_META_TYPE_LOOKAHEAD);
-        iComp[(i < 5) ? 0 : 1] += pPictureMetaLA->iPictureSize;
-      }
-
-      iComplexity = ((1000 * iFifoSize / 5) + iComplexityDiff) * iComp[0] / (iComp[0] + iComp[1]);
+      iComplexity = ((1000 * iFifoSize / COMPLEXITY_HEAD) + iComplexityDiff) * iSumHeadPictureSize / iSumPictureSize;
       iComplexity = min(3000, max(100, iComplexity));
       iComplexityDiff += (1000 - iComplexity);
     }
@@ -552,7 +1068,7 @@ void LookAheadMngr::ComputeComplexity(void)
 
   iFrameCount++;
 
-  if(iFifoSize >= 2 && ComputeSceneChange(m_fifo[0], m_fifo[1]))
+  if(HasSceneChangeAfterFront())
     iFrameCount = 0;
 }
 
@@ -560,10 +1076,11 @@ void LookAheadMngr::ComputeComplexity(void)
 bool LookAheadMngr::HasPatternTwoFrames(void)
 {
   vector<int> v {};
+  v.reserve(m_fifo.size());
 
-  for(auto i = m_fifo.begin(); i < m_fifo.end(); i++)
+  for(size_t i = 0; i < m_fifo.size(); i++)
   {
-    auto pPictureMetaLA = (AL_TLookAheadMetaData*)AL_Buffer_GetMetaData(*i, AL_META_TYPE_LOOKAHEAD);
+    auto pPictureMetaLA = (AL_TLookAheadMetaData*)AL_Buffer_GetMetaData(m_fifo[i], AL_META_TYPE_LOOKAHEAD);
     v.push_back(pPictureMetaLA->iPercentIntra[0]);
   }
 
@@ -4,10 +4,14 @@
 #pragma once
 
 #include <fstream>
+#include <string>
 #include <vector>
 #include <cstring>
-#include <deque>
 #include <memory>
+#include <cstdint>
+#include <stdexcept>
+
+#include "opencv2/core/cvdef.h"
 
 extern "C"
 {
@@ -25,6 +29,86 @@ AL_TLookAheadMetaData* AL_TwoPassMngr_CreateAndAttachTwoPassMetaData(AL_TBuffer*
 /*Offline TwoPass structures and methods*/
 /***************************************************************************/
 
+/*
+** Versioned binary TwoPass log
+** A TwoPassLogHeader followed by one TwoPassLogRecord per frame, little-endian
+** Written with buffered appends, read back through mmap with random access
+*/
+struct TwoPassLogHeader
+{
+  char sMagic[8]; /* "AL2PASS\0" */
+  uint32_t uVersion;
+  uint32_t uRecordSize;
+};
+
+struct TwoPassLogRecord
+{
+  int32_t iPictureSize;
+  int32_t iIPRatio;
+  int32_t iComplexity;
+  int32_t iTargetLevel;
+  int32_t iSceneChange;
+  int8_t iPercentIntra[5];
+  uint8_t uReserved[3];
+};
+
+static_assert(sizeof(TwoPassLogHeader) == 16, "TwoPass log header layout");
+static_assert(sizeof(TwoPassLogRecord) == 28, "TwoPass log record layout");
+
+struct TwoPassBinaryLog
+{
+  static uint32_t const VERSION = 1;
+
+  ~TwoPassBinaryLog();
+
+  static bool IsBinaryLog(std::string const& sFileName);
+  static TwoPassLogRecord ToRecord(AL_TLookAheadMetaData const& tMetaData);
+  static void FromRecord(TwoPassLogRecord const& tRecord, AL_TLookAheadMetaData& tMetaData);
+
+  void Create(std::string const& sFileName);
+  void Append(std::vector<AL_TLookAheadMetaData> const& tFrames);
+
+  void Map(std::string const& sFileName);
+  int NumFrames() const { return iNumFrames; }
+  TwoPassLogRecord const& Frame(int iFrame) const { return pRecords[iFrame]; }
+
+  void Close();
+
+private:
+  std::ofstream outputFile;
+  void* pMapping = nullptr;
+  size_t zMappingSize = 0;
+  TwoPassLogRecord const* pRecords = nullptr;
+  int iNumFrames = 0;
+};
+
+/* Converts a text log ("iPictureSize iPercentIntra" lines) to the binary format, returns the number of frames */
+int AL_TwoPassMngr_ConvertTextLog(std::string const& sTextFileName, std::string const& sBinaryFileName);
+
+/* Number of frames in a pass-1 log, binary or text */
+int AL_TwoPassMngr_CountLogFrames(std::string const& sFileName);
+
+/*
+** CPB compliance of a pass-2 log replay, levels in milliseconds
+** A frame underflows when the buffer level falls below 0 and overflows when it rises above iCpbLevel
+*/
+struct TwoPassCpbReport
+{
+  int iNumFrames = 0;
+  double fMinLevel = 0;
+  double fMaxLevel = 0;
+  int iNumUnderflows = 0;
+  int iNumOverflows = 0;
+
+  bool IsCompliant() const { return iNumUnderflows == 0 && iNumOverflows == 0; }
+};
+
+/*
+** Replays a pass-1 log through pass 2 on the CPU, assuming each frame meets its complexity target,
+** and simulates the CPB fullness frame by frame
+*/
+TwoPassCpbReport AL_TwoPassMngr_SimulateCpb(std::string const& sFileName, int iGopSize, int iCpbLevel, int iInitialLevel, int iFrameRate, bool bGlobalAllocation);
+
 /*
 ** Struct for TwoPass management
 ** Writes First Pass information on the logfile
@@ -32,7 +116,7 @@ AL_TLookAheadMetaData* AL_TwoPassMngr_CreateAndAttachTwoPassMetaData(AL_TBuffer*
 */
 struct TwoPassMngr
 {
-  TwoPassMngr(std::string p_FileName, int p_iPass, bool p_bEnabledFirstPassSceneChangeDetection, int p_iGopSize, int p_iCpbLevel, int p_iInitialLevel, int p_iFrameRate);
+  TwoPassMngr(std::string p_FileName, int p_iPass, bool p_bEnabledFirstPassSceneChangeDetection, int p_iGopSize, int p_iCpbLevel, int p_iInitialLevel, int p_iFrameRate, bool p_bBinaryLog = false, bool p_bGlobalAllocation = false);
   ~TwoPassMngr();
 
   void AddFrame(AL_TLookAheadMetaData* pMetaData);
@@ -46,10 +130,12 @@ private:
   void OpenLog();
   void CloseLog();
   void EmptyLog();
+  void ReadLog(int iMaxFrames);
   void FillLog();
   void AddNewFrame(int iPictureSize, int iPercentIntra);
   void ComputeTwoPass();
   void ComputeComplexity();
+  void ComputeGlobalComplexity();
   bool HasPatternTwoFrames();
 
   std::string FileName;
@@ -62,12 +148,97 @@ private:
   int iCpbLevel;
   int iInitialLevel;
   int iFrameRate;
+
+  /* Binary log: always written when bBinaryLog, detected when reading */
+  bool bBinaryLog;
+  TwoPassBinaryLog tBinaryLog;
+  bool bBinaryLogOpened = false;
+  int iNextLoggedFrame = 0;
+
+  /* Global allocation: the whole log is read and allocated at the first GetFrame */
+  bool bGlobalAllocation;
+  bool bGlobalAllocationDone = false;
 };
 
 /***************************************************************************/
 /*LookAhead structures and methods*/
 /***************************************************************************/
 
+/*
+** Scene-cut detector on downsampled luma histograms
+** Used by the LookAhead when the first pass metadata is missing
+** Works on plain luma planes so it can be fed with synthetic pictures
+*/
+struct LumaSceneCutDetector
+{
+  static int const HIST_BINS = 64;
+  static int const SUBSAMPLING = 4; /* one luma sample out of SUBSAMPLING in each direction */
+
+  typedef uint32_t THistogram[HIST_BINS];
+
+  static void ComputeHistogram(uint8_t const* pLuma, int iPitch, int iWidth, int iHeight, int iBitDepth, THistogram& tHist);
+  static bool ComputeHistogram(AL_TBuffer const* pSrc, THistogram& tHist);
+
+  /* Normalized L1 distance between two histograms, in [0, 2] */
+  static double Distance(THistogram const& tPrev, THistogram const& tCurrent);
+
+  /* A cut is a distance above fThreshold that also stands out of the recent distances */
+  bool IsSceneCut(THistogram const& tPrev, THistogram const& tCurrent);
+
+  double fThreshold = 0.45;
+  double fOutlierRatio = 4.0;
+
+private:
+  double fMeanDistance = 0.0;
+};
+
+/*
+** Fixed-capacity FIFO on a ring of preallocated slots
+** No allocation after construction, pushing into a full ring throws
+*/
+template<typename T>
+struct RingFifo
+{
+  explicit RingFifo(size_t zCapacity) : tSlots(zCapacity) {}
+
+  size_t capacity() const { return tSlots.size(); }
+  size_t size() const { return zSize; }
+  bool empty() const { return zSize == 0; }
+  bool full() const { return zSize == tSlots.size(); }
+
+  T& operator[](size_t i) { return tSlots[(zHead + i) % tSlots.size()]; }
+  T const& operator[](size_t i) const { return tSlots[(zHead + i) % tSlots.size()]; }
+  T& front() { return (*this)[0]; }
+  T const& front() const { return (*this)[0]; }
+  T& back() { return (*this)[zSize - 1]; }
+  T const& back() const { return (*this)[zSize - 1]; }
+
+  void push_back(T const& tValue)
+  {
+    if(full())
+      throw std::runtime_error("RingFifo overflow");
+    tSlots[(zHead + zSize) % tSlots.size()] = tValue;
+    zSize++;
+  }
+
+  void pop_front()
+  {
+    zHead = (zHead + 1) % tSlots.size();
+    zSize--;
+  }
+
+  void clear()
+  {
+    zHead = 0;
+    zSize = 0;
+  }
+
+private:
+  std::vector<T> tSlots;
+  size_t zHead = 0;
+  size_t zSize = 0;
+};
+
 /*
 ** Struct for LookAhead management
 ** Keeps the src buffers between the two pass
@@ -81,8 +252,10 @@ struct LookAheadMngr
   uint16_t uLookAheadSize;
   bool bUseComplexity;
   bool bEnableFirstPassSceneChangeDetection;
-  std::deque<AL_TBuffer*> m_fifo;
+  RingFifo<AL_TBuffer*> m_fifo; /* read only, use Push() and Pop(), holds uLookAheadSize + 1 buffers */
 
+  void Push(AL_TBuffer* pSrc);
+  void Pop();
   void ProcessLookAheadParams();
   void ComputeComplexity();
   bool HasPatternTwoFrames();
@@ -92,8 +265,24 @@ struct LookAheadMngr
   int GetNextSceneChange();
 
 private:
+  static int const COMPLEXITY_HEAD = 5;
+
+  bool DetectSceneChange(AL_TBuffer* pPrevSrc, AL_TBuffer* pCurrentSrc);
+  bool HasSceneChangeAfterFront() const;
+
   int iComplexity;
   int iFrameCount;
   int iComplexityDiff;
   AL_TLookAheadMetaData tPrevMetaData;
+
+  /* Sliding-window statistics of m_fifo, updated by Push() and Pop() */
+  RingFifo<int32_t> m_pictureSizes;
+  intmax_t iSumPictureSize = 0;
+  intmax_t iSumHeadPictureSize = 0; /* first COMPLEXITY_HEAD pictures */
+  uint64_t uFrontIndex = 0; /* position of m_fifo.front() in the stream */
+  RingFifo<uint64_t> m_sceneChanges; /* positions i with a scene change between i and i + 1 */
+
+  LumaSceneCutDetector tLumaDetector;
+  LumaSceneCutDetector::THistogram tLastHist;
+  uint64_t uLastHistIndex = UINT64_MAX;
 };
@@ -0,0 +1,245 @@
+/*
+   Copyright (c) 2025-2026  Advanced Micro Devices, Inc. (AMD)
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+*/
+#include "vcuabrcontroller.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <cstdlib>
+#include <fstream>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <sys/time.h>
+#include <unistd.h>
+
+namespace cv {
+namespace vcucodec {
+
+namespace { // anonymous
+
+// Weight of the newest sample in the measured output bitrate.
+constexpr double MEASURE_SMOOTHING = 0.2;
+// Relative change below which the target is left alone, to avoid a command every frame.
+constexpr double DEADBAND = 0.02;
+// Lowest factor applied to the desired bitrate to correct an encoder overshoot.
+constexpr double MAX_OVERSHOOT_CORRECTION = 0.5;
+
+class AbrControllerImpl : public AbrController
+{
+public:
+    AbrControllerImpl(const AbrSettings& settings, int32_t bitrate, int32_t maxBitrate,
+                      int32_t frameRate, CommandQueue& commands)
+        : settings_(settings), commands_(commands), frameRate_(std::max(frameRate, 1)),
+          target_(bitrate),
+          peakRatio_(bitrate > 0 ? std::max(1.0, double(maxBitrate) / bitrate) : 1.0),
+          minBitrate_(settings.minBitrate),
+          maxBitrate_(settings.maxBitrate > 0 ? settings.maxBitrate : maxBitrate)
+    {
+        if (!settings_.traceFile.empty())
+            loadTrace(settings_.traceFile);
+        if (!settings_.logFile.empty())
+        {
+            log_.open(settings_.logFile);
+            if (!log_)
+                throw std::runtime_error("Cannot open ABR log file " + settings_.logFile);
+            log_ << "# frame estimate_kbps measured_kbps target_kbps\n";
+        }
+        if (settings_.udpPort > 0)
+            openSocket(settings_.udpPort);
+    }
+
+    ~AbrControllerImpl() override
+    {
+        stop_ = true;
+        if (receiver_.joinable())
+            receiver_.join();
+        if (socket_ >= 0)
+            ::close(socket_);
+    }
+
+    void setBandwidthEstimate(int32_t kbps) override
+    {
+        estimate_.store(kbps, std::memory_order_relaxed);
+    }
+
+    void onEncoded(size_t bytes) override
+    {
+        encodedBytes_.fetch_add(bytes, std::memory_order_relaxed);
+    }
+
+    void onFrame(int32_t frameIndex) override
+    {
+        while (traceIdx_ < trace_.size() && trace_[traceIdx_].first <= frameIndex)
+            estimate_.store(trace_[traceIdx_++].second, std::memory_order_relaxed);
+
+        // Output bitrate over the frames submitted since the last call. The encoder output lags
+        // the input by the pipeline depth, which the smoothing absorbs.
+        uint64_t bytes = encodedBytes_.load(std::memory_order_relaxed);
+        if (lastFrame_ >= 0 && frameIndex > lastFrame_)
+        {
+            double kbps = (bytes - lastBytes_) * 8.0 * frameRate_
+                        / (1000.0 * (frameIndex - lastFrame_));
+            measured_ = measured_ > 0 ? measured_ + MEASURE_SMOOTHING * (kbps - measured_) : kbps;
+            expected_ = expected_ > 0 ? expected_ + MEASURE_SMOOTHING * (target_ - expected_)
+                                      : target_;
+        }
+        lastBytes_ = bytes;
+        lastFrame_ = frameIndex;
+
+        int32_t estimate = estimate_.load(std::memory_order_relaxed);
+        if (estimate > 0 && frameIndex - lastUpdate_ >= settings_.updateInterval)
+        {
+            lastUpdate_ = frameIndex;
+            update(frameIndex, estimate);
+        }
+
+        if (log_.is_open())
+            log_ << frameIndex << ' ' << estimate << ' ' << std::lround(measured_) << ' '
+                 << std::lround(target_) << '\n';
+    }
+
+private:
+    void update(int32_t frameIndex, int32_t estimate)
+    {
+        double desired = settings_.headroom * estimate;
+        // The encoder overshooting its own target would overshoot the link as well. The
+        // measurement is compared with the targets smoothed the same way, so that it lagging
+        // behind a lower target is not taken for an overshoot.
+        if (measured_ > expected_)
+            desired *= std::max(MAX_OVERSHOOT_CORRECTION, expected_ / measured_);
+
+        // Back off at the full rate, ramp up at half of it.
+        double gain = desired < target_ ? settings_.aggressiveness
+                                        : settings_.aggressiveness * 0.5;
+        double next = target_ + gain * (desired - target_);
+        next = std::min(std::max(next, double(minBitrate_)), double(maxBitrate_));
+        if (std::abs(next - target_) < DEADBAND * target_)
+            return;
+
+        target_ = next;
+
+        Command cmd;
+        cmd.frameIndex = frameIndex;
+        cmd.type = CommandType::MAX_BIT_RATE;
+        cmd.arg[0] = static_cast<int32_t>(std::lround(target_ * 1000));              // bps
+        cmd.arg[1] = static_cast<int32_t>(std::lround(target_ * peakRatio_ * 1000));
+        commands_.push(std::move(cmd));
+    }
+
+    // One "frameIdx kbps" pair per line; blank lines and lines starting with '#' are skipped.
+    void loadTrace(const std::string& path)
+    {
+        std::ifstream file(path);
+        if (!file)
+            throw std::runtime_error("Cannot open ABR trace file " + path);
+        std::string line;
+        while (std::getline(file, line))
+        {
+            if (line.empty() || line[0] == '#')
+                continue;
+            std::istringstream fields(line);
+            int32_t frame, kbps;
+            if (!(fields >> frame >> kbps))
+                throw std::runtime_error("Malformed line in ABR trace file: " + line);
+            trace_.emplace_back(frame, kbps);
+        }
+        std::stable_sort(trace_.begin(), trace_.end(),
+            [](const auto& a, const auto& b) { return a.first < b.first; });
+    }
+
+    void openSocket(int port)
+    {
+        socket_ = ::socket(AF_INET, SOCK_DGRAM, 0);
+        if (socket_ < 0)
+            throw std::runtime_error("Cannot create ABR UDP socket");
+
+        sockaddr_in addr = {};
+        addr.sin_family = AF_INET;
+        addr.sin_port = htons(static_cast<uint16_t>(port));
+        addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+        if (::bind(socket_, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) < 0)
+        {
+            ::close(socket_);
+            socket_ = -1;
+            throw std::runtime_error("Cannot bind ABR UDP socket to port " + std::to_string(port));
+        }
+
+        // Short receive timeout so the thread notices stop_.
+        timeval timeout = { 0, 100 * 1000 };
+        setsockopt(socket_, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+        receiver_ = std::thread(&AbrControllerImpl::receiveLoop, this);
+    }
+
+    void receiveLoop()
+    {
+        char buf[64];
+        while (!stop_)
+        {
+            ssize_t len = ::recv(socket_, buf, sizeof(buf) - 1, 0);
+            if (len <= 0)
+                continue;
+            buf[len] = '\0';
+            long kbps = std::strtol(buf, nullptr, 10);
+            if (kbps > 0)
+                setBandwidthEstimate(static_cast<int32_t>(kbps));
+        }
+    }
+
+    AbrSettings settings_;
+    CommandQueue& commands_;
+    int32_t frameRate_;
+    std::atomic<int32_t> estimate_{0};
+    std::atomic<uint64_t> encodedBytes_{0};
+
+    // Frame-submitting thread
+    double target_;       // kbits per second
+    double peakRatio_;
+    int32_t minBitrate_;
+    int32_t maxBitrate_;
+    double measured_ = 0; // kbits per second
+    double expected_ = 0; // targets smoothed as measured_, kbits per second
+    uint64_t lastBytes_ = 0;
+    int32_t lastFrame_ = -1;
+    int32_t lastUpdate_ = INT32_MIN / 2;
+    std::vector<std::pair<int32_t, int32_t>> trace_;
+    size_t traceIdx_ = 0;
+    std::ofstream log_;
+
+    // UDP feed
+    int socket_ = -1;
+    std::thread receiver_;
+    std::atomic<bool> stop_{false};
+};
+
+} // anonymous namespace
+
+std::unique_ptr<AbrController> AbrController::create(const AbrSettings& settings,
+        int32_t bitrate, int32_t maxBitrate, int32_t frameRate, CommandQueue& commands)
+{
+    return std::make_unique<AbrControllerImpl>(settings, bitrate, maxBitrate, frameRate,
+                                               commands);
+}
+
+} // namespace vcucodec
+} // namespace cv
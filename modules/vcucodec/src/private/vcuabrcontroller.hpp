@@ -0,0 +1,55 @@
+/*
+   Copyright (c) 2025-2026  Advanced Micro Devices, Inc. (AMD)
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+*/
+#ifndef OPENCV_VCUCODEC_VCUABRCONTROLLER_HPP
+#define OPENCV_VCUCODEC_VCUABRCONTROLLER_HPP
+
+#include <opencv2/core.hpp>
+#include <opencv2/vcucodec.hpp>
+
+#include "vcucommand.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+
+namespace cv {
+namespace vcucodec {
+
+/// Closed-loop adaptive bitrate controller.
+///
+/// Follows a bandwidth estimate (setBandwidthEstimate(), a local UDP socket or a replayed
+/// trace) and the stream bytes the encoder actually produced (onEncoded()), and schedules
+/// MAX_BIT_RATE commands on the encoder's CommandQueue from onFrame(), which the encoder calls
+/// for each frame just before draining that queue.
+class AbrController
+{
+public:
+    virtual ~AbrController() = default;
+    virtual void setBandwidthEstimate(int32_t kbps) = 0; // any thread
+    virtual void onEncoded(size_t bytes) = 0;            // encoder output thread
+    virtual void onFrame(int32_t frameIndex) = 0;        // frame-submitting thread
+
+    /// @p bitrate and @p maxBitrate (kbits per second) are the configured rate-control values;
+    /// their ratio is kept for the peak bitrate of each new target.
+    static std::unique_ptr<AbrController> create(const AbrSettings& settings, int32_t bitrate,
+                                                 int32_t maxBitrate, int32_t frameRate,
+                                                 CommandQueue& commands);
+};
+
+} // namespace vcucodec
+} // namespace cv
+
+#endif // OPENCV_VCUCODEC_VCUABRCONTROLLER_HPP
@@ -15,36 +15,150 @@
 */
 #include "vcucommand.hpp"
 
+#include <algorithm>
+
 namespace cv {
 namespace vcucodec {
 
+static_assert((CommandQueue::CAPACITY & (CommandQueue::CAPACITY - 1)) == 0,
+              "CommandQueue::CAPACITY must be a power of two");
+
+CommandQueue::CommandQueue()
+    : slots_(new Slot[CAPACITY]), enqueuePos_(0), hasOverflow_(false), frames_(WINDOW)
+{
+    for (size_t i = 0; i < CAPACITY; ++i)
+        slots_[i].sequence.store(i, std::memory_order_relaxed);
+    for (auto& bucket : frames_)
+        bucket.reserve(8);
+}
+
+CommandQueue::~CommandQueue() = default;
+
 void CommandQueue::push(Command cmd)
 {
-    std::lock_guard lock(mutex_);
-    commands_.push(cmd);
+    if (tryEnqueue(cmd))
+        return;
+    std::lock_guard lock(overflowMutex_);
+    overflow_.push_back(std::move(cmd));
+    hasOverflow_.store(true, std::memory_order_release);
 }
 
-void CommandQueue::execute(int32_t currentFrame)
+// Slot i is free for the producer claiming position pos when its sequence equals pos, and
+// holds a command for the consumer when it equals pos + 1.
+bool CommandQueue::tryEnqueue(Command& cmd)
 {
-    std::unique_lock lock(mutex_);
-    while (!commands_.empty() && commands_.top().frameIndex <= currentFrame)
+    size_t pos = enqueuePos_.load(std::memory_order_relaxed);
+    for (;;)
     {
-        const Command& cmd = commands_.top();
-        if (!cmd.skipOnMiss || cmd.frameIndex == currentFrame)
+        Slot& slot = slots_[pos & (CAPACITY - 1)];
+        size_t seq = slot.sequence.load(std::memory_order_acquire);
+        intptr_t dif = static_cast<intptr_t>(seq) - static_cast<intptr_t>(pos);
+        if (dif == 0)
+        {
+            if (enqueuePos_.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed))
+            {
+                slot.cmd = std::move(cmd);
+                slot.sequence.store(pos + 1, std::memory_order_release);
+                return true;
+            }
+        }
+        else if (dif < 0)
         {
-            Command execCmd = cmd; // Copy command to execute
-            commands_.pop();
-            lock.unlock(); // Unlock while executing to avoid deadlocks
-            execCmd.execute();
-            lock.lock();
+            return false; // ring full
         }
         else
         {
-            commands_.pop();
+            pos = enqueuePos_.load(std::memory_order_relaxed);
         }
     }
 }
 
+bool CommandQueue::tryDequeue(Command& cmd)
+{
+    Slot& slot = slots_[dequeuePos_ & (CAPACITY - 1)];
+    if (slot.sequence.load(std::memory_order_acquire) != dequeuePos_ + 1)
+        return false;
+    cmd = std::move(slot.cmd);
+    slot.sequence.store(dequeuePos_ + CAPACITY, std::memory_order_release);
+    ++dequeuePos_;
+    return true;
+}
+
+void CommandQueue::dispatch(Command& cmd, int32_t currentFrame, CommandExecutor& executor)
+{
+    if (!cmd.skipOnMiss || cmd.frameIndex == currentFrame)
+        executor.executeCommand(cmd);
+    cmd.payload.reset();
+}
+
+void CommandQueue::schedule(Command cmd, int32_t currentFrame, CommandExecutor& executor)
+{
+    if (cmd.frameIndex < nextFrame_)
+        dispatch(cmd, currentFrame, executor); // frame already passed
+    else if (cmd.frameIndex - nextFrame_ < WINDOW)
+        frames_[cmd.frameIndex % WINDOW].push_back(std::move(cmd));
+    else
+        later_.emplace(cmd.frameIndex, std::move(cmd));
+}
+
+void CommandQueue::execute(int32_t currentFrame, CommandExecutor& executor)
+{
+    Command cmd;
+    while (tryDequeue(cmd))
+        schedule(std::move(cmd), currentFrame, executor);
+    if (hasOverflow_.load(std::memory_order_acquire))
+    {
+        std::vector<Command> overflow;
+        {
+            std::lock_guard lock(overflowMutex_);
+            overflow.swap(overflow_);
+            hasOverflow_.store(false, std::memory_order_relaxed);
+        }
+        for (auto& c : overflow)
+            schedule(std::move(c), currentFrame, executor);
+    }
+
+    if (currentFrame < nextFrame_)
+        return;
+
+    // Run the buckets of the frames reached, at most one pass over the window.
+    int32_t last = std::min(currentFrame, nextFrame_ + WINDOW - 1);
+    for (int32_t frame = nextFrame_; frame <= last; ++frame)
+    {
+        auto& bucket = frames_[frame % WINDOW];
+        for (auto& c : bucket)
+            dispatch(c, currentFrame, executor);
+        bucket.clear();
+    }
+    auto it = later_.begin();
+    for (; it != later_.end() && it->first <= currentFrame; ++it)
+        dispatch(it->second, currentFrame, executor);
+    later_.erase(later_.begin(), it);
+    nextFrame_ = currentFrame + 1;
+
+    // Move the commands that entered the window into their buckets.
+    for (it = later_.begin(); it != later_.end() && it->first - nextFrame_ < WINDOW;)
+    {
+        frames_[it->first % WINDOW].push_back(std::move(it->second));
+        it = later_.erase(it);
+    }
+}
+
+void CommandQueue::clear()
+{
+    Command cmd;
+    while (tryDequeue(cmd))
+        cmd.payload.reset();
+    {
+        std::lock_guard lock(overflowMutex_);
+        overflow_.clear();
+        hasOverflow_.store(false, std::memory_order_relaxed);
+    }
+    for (auto& bucket : frames_)
+        bucket.clear();
+    later_.clear();
+    nextFrame_ = 0;
+}
 
 } // namespace vcucodec
 } // namespace cv
\ No newline at end of file
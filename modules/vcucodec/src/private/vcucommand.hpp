@@ -18,49 +18,123 @@
 
 #include <opencv2/core.hpp>
 
+#include <atomic>
+#include <cstdint>
+#include <map>
+#include <memory>
 #include <mutex>
-#include <queue>
 #include <vector>
-#include <functional>
-#include <cstdint>
-
-extern "C" {
-
-}
 
 namespace cv {
 namespace vcucodec {
 
-struct Command
+/// Dynamic encoder controls. The arguments of each command are listed in Command::arg order.
+enum class CommandType : uint8_t
 {
-    using Func = std::function< void ()>;
+    SCENE_CHANGE,                    ///< lookAhead
+    IS_LONG_TERM,
+    USE_LONG_TERM,
+    IS_SKIP,
+    SAO,                             ///< enabled
+    RESTART_GOP,
+    RESTART_GOP_RECOVERY_POINT,
+    GOP_LENGTH,                      ///< gopLength
+    NUM_B,                           ///< numB
+    FREQ_IDR,                        ///< freqIDR
+    FRAME_RATE,                      ///< frameRate, clockRatio
+    BIT_RATE,                        ///< bitRate
+    MAX_BIT_RATE,                    ///< targetBitRate, maxBitRate
+    QP,                              ///< qp
+    QP_OFFSET,                       ///< qpOffset
+    QP_BOUNDS,                       ///< minQP, maxQP
+    QP_BOUNDS_PER_FRAME_TYPE,        ///< minQP, maxQP, AL_ESliceType
+    QP_IP_DELTA,                     ///< delta
+    QP_PB_DELTA,                     ///< delta
+    LF_MODE,                         ///< mode
+    LF_BETA_OFFSET,                  ///< offset
+    LF_TC_OFFSET,                    ///< offset
+    COST_MODE,                       ///< enabled
+    MAX_PICTURE_SIZE,                ///< size
+    MAX_PICTURE_SIZE_PER_FRAME_TYPE, ///< size, AL_ESliceType
+    QP_CHROMA_OFFSETS,               ///< qp1Offset, qp2Offset
+    AUTO_QP,                         ///< enabled
+    AUTO_QP_THRESHOLD_AND_DELTA,     ///< enabled; thresholds in the payload
+    HDR_SEIS,                        ///< SEIs in the payload
+    DYNAMIC_UPDATE,                  ///< EncoderDynamicUpdate in the payload
+};
 
-    bool operator<(const Command& other) const
-    {                                         // Used in priority_queue:
-        return frameIndex > other.frameIndex; // Lowest frameIndex has highest priority
-    }
+/// Variable-size data of the few commands that do not fit in Command::arg.
+struct CommandPayload
+{
+    virtual ~CommandPayload() = default;
+};
 
-    void operator()() { execute(); }
+/// A typed command record: no closure, and no allocation unless it carries a payload.
+struct Command
+{
+    int32_t frameIndex = 0;      // Frame index to apply the command
+    bool    skipOnMiss = false;  // If true, skip the command if the frame index is missed
+    CommandType type = CommandType::SCENE_CHANGE;
+    int32_t arg[3] = { 0, 0, 0 };
+    std::unique_ptr<CommandPayload> payload;
+};
 
-    int32_t frameIndex; // Frame index to apply the command
-    bool    skipOnMiss; // If true, skip the command if the frame index is missed
-    Func    execute;    // Function to execute the command
+/// Applies the commands that are due (implemented by the encoder).
+class CommandExecutor
+{
+public:
+    virtual ~CommandExecutor() = default;
+    virtual void executeCommand(const Command& cmd) = 0;
 };
 
+/// Frame-scheduled command queue with any number of producers and one consumer.
+///
+/// push() is lock-free: records go through a preallocated ring of CAPACITY slots (a mutex
+/// protected overflow list takes over only when that many commands are pending). execute(),
+/// called by the thread submitting frames, moves them into a ring of WINDOW per-frame buckets
+/// and runs the bucket of each frame reached, so dispatch is O(1) per frame plus the commands
+/// run. Commands of the same frame run in push order; commands for a frame already passed run
+/// at the next execute().
 class CommandQueue
 {
 public:
-    CommandQueue() = default;
-    ~CommandQueue() = default;
+    static constexpr size_t CAPACITY = 1024;
+    static constexpr int32_t WINDOW = 64;
+
+    CommandQueue();
+    ~CommandQueue();
     void push(Command cmd);
-    void execute(int32_t currentFrame);
+    void execute(int32_t currentFrame, CommandExecutor& executor);
+    void clear();
+
 private:
-    std::mutex mutex_;
-    std::priority_queue<Command> commands_;
+    struct Slot
+    {
+        std::atomic<size_t> sequence;
+        Command cmd;
+    };
+
+    bool tryEnqueue(Command& cmd);
+    bool tryDequeue(Command& cmd);
+    void schedule(Command cmd, int32_t currentFrame, CommandExecutor& executor);
+    void dispatch(Command& cmd, int32_t currentFrame, CommandExecutor& executor);
+
+    // Producer side
+    std::unique_ptr<Slot[]> slots_;
+    std::atomic<size_t> enqueuePos_;
+    std::mutex overflowMutex_;
+    std::vector<Command> overflow_;
+    std::atomic<bool> hasOverflow_;
+
+    // Consumer side
+    size_t dequeuePos_ = 0;
+    std::vector<std::vector<Command>> frames_;  // bucket frame % WINDOW, frames [nextFrame_, +WINDOW)
+    std::multimap<int32_t, Command> later_;    // frames beyond the bucket window
+    int32_t nextFrame_ = 0;                    // first frame whose bucket has not run yet
 };
 
 
 } // namespace vcucodec
 } // namespace cv
 
-#endif // OPENCV_VCUCODEC_VCUCOMMAND_HPP
\ No newline at end of file
+#endif // OPENCV_VCUCODEC_VCUCOMMAND_HPP
@@ -63,7 +63,8 @@ Data::Data(AL_TBuffer* data, AL_HEncoder hEnc) : data_(data), hEnc_(hEnc)
 
 Data::~Data()
 {
-    if (data_ != nullptr)
+    // Without an encoder the buffer belongs to the caller (e.g. the perf tests).
+    if (data_ != nullptr && hEnc_ != nullptr)
     {
         bool ret = AL_Encoder_PutStreamBuffer(hEnc_, data_);
         if (!ret)
@@ -39,7 +39,8 @@ class Data
 public:
     ~Data();
 
-    /// Create
+    /// Create. The stream buffer is given back to @p hEnc on destruction; a null @p hEnc leaves
+    /// it to the caller.
     static Ptr<Data> create(AL_TBuffer* data, AL_HEncoder hEnc);
     AL_TBuffer* buf() const { return data_; }
 
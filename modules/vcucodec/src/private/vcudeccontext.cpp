@@ -22,6 +22,7 @@
 #include "vcuframe.hpp"
 #include "vcurawout.hpp"
 #include "vcureader.hpp"
+#include "vcusoftcodec.hpp"
 #include "vcuutils.hpp"
 
 #include "opencv2/vcucodec.hpp"
@@ -58,6 +59,7 @@ extern "C" {
 #include "lib_app/timing.hpp"
 
 #include <condition_variable>
+#include <fstream>
 #include <functional>
 #include <iostream>
 #include <map>
@@ -93,6 +95,7 @@ public:
     void start(WorkerConfig wCfg) override;
     void finish() override;
     void destroyDecoder() override;
+    void reset(Ptr<Config> pConfig, WorkerConfig& wCfg) override;
 
     bool running() const override
     {
@@ -150,6 +153,8 @@ private:
                                               AL_TDecOutputSettings const *pUserOutputSettings_);
     void attachMetaDataToBaseDecoderRecBuffer(AL_TStreamSettings const *pStreamSettings,
                                               AL_TBuffer *pDecPict);
+    void putBaseDecoderPoolBuffers(AL_TStreamSettings const *pStreamSettings, int32_t iNumBuf,
+                                   bool bAttachMetaData);
     void ctrlswDecRun(WorkerConfig wCfg);
 
     mutable std::mutex mutex_;
@@ -169,7 +174,13 @@ private:
     AL_TDecSettings *pDecSettings_;
     int32_t iExtraBuffers_ = 1;
     bool bUsePreAlloc_ = false;
-    PixMapBufPool baseBufPool_;
+    std::unique_ptr<PixMapBufPool> baseBufPool_ = std::make_unique<PixMapBufPool>();
+    // Layout of baseBufPool_, checked by reset() to decide whether the pool can be reused.
+    bool bReusePool_ = false;
+    TFourCC tPoolFourCC_ = FOURCC(NULL);
+    AL_TDimension tPoolDim_ {};
+    int32_t iPoolNumBuf_ = 0;
+    int32_t iPoolBufferSize_ = 0;
     AL_TDecOutputSettings *pUserOutputSettings_;
     std::ofstream seiOutput_;
     std::ofstream seiSyncOutput_;
@@ -462,6 +473,38 @@ void configureInputPool(DecContext::Config const &config, AL_TAllocator *pAlloca
         throw std::runtime_error("Can't create BufPool");
 }
 
+void prepareConfig(DecContext::Config &config)
+{
+    std::set<std::string> const sDecDefaultDevicePath(DECODER_DEVICES);
+    SetDefaultDecOutputSettings(&config.tUserOutputSettings);
+    config.sDecDevicePath = sDecDefaultDevicePath;
+
+    config.tUserOutputSettings.tPicFormat.eStorageMode = AL_FB_RASTER;
+
+    /* Propagate the requested output packing so the decoder emits the packed (XV) format
+       directly, instead of labeling packed 10-bit data as P210 and then corrupting it via a
+       P210->XV20 software re-pack. */
+    if (config.tOutputFourCC != FOURCC(NULL))
+    {
+        AL_TPicFormat tReqFmt;
+        AL_GetPicFormat(config.tOutputFourCC, &tReqFmt);
+        config.tUserOutputSettings.tPicFormat.eSamplePackMode = tReqFmt.eSamplePackMode;
+    }
+#ifdef HAVE_VCU2_CTRLSW
+    config.tUserOutputSettings.bCustomFormat = true;
+#endif
+}
+
+void setTraceParams(AL_HDecoder hDec, DecContext::Config const &config)
+{
+#ifdef HAVE_VCU2_CTRLSW
+    AL_Decoder_SetParam(hDec, "Fpga", config.iTraceIdx, config.iTraceNumber,
+                        config.ipCtrlMode == AL_EIpCtrlMode::AL_IPCTRL_MODE_TRACE, false);
+#else
+    AL_Decoder_SetParam(hDec, "Fpga", config.iTraceIdx, config.iTraceNumber,
+                        config.ipCtrlMode == AL_EIpCtrlMode::AL_IPCTRL_MODE_TRACE);
+#endif
+}
 
 } // namespace anonymous
 
@@ -536,7 +579,7 @@ DecoderContext::computeBaseDecoderRecBufferSizing(AL_TStreamSettings const *pStr
     auto minPitch = AL_Decoder_GetMinPitch(tOutputDim.iWidth, &pUserOutputSettings->tPicFormat);
 
     bool bConfigurePlanarAndSemiplanar = bUsePreAlloc_;
-    iBufferSize = configureDecBufPool(baseBufPool_, pUserOutputSettings->tPicFormat, tOutputDim,
+    iBufferSize = configureDecBufPool(*baseBufPool_, pUserOutputSettings->tPicFormat, tOutputDim,
                                       minPitch, bConfigurePlanarAndSemiplanar);
 
     return iBufferSize;
@@ -565,48 +608,82 @@ AL_ERR DecoderContext::setupBaseDecoderPool(int32_t iBufferNumber,
     if (!AL_Decoder_ConfigureOutputSettings(getBaseDecoderHandle(), pUserOutputSettings_))
         throw std::runtime_error("Could not configure the output settings");
 
-    /* Compute buffer sizing */
-    int32_t iBufferSize = computeBaseDecoderRecBufferSizing(pStreamSettings, pUserOutputSettings_);
-
     AL_TCropInfo pUserCropInfo = *pCropInfo;
 
     AL_TDimension outputDim = pStreamSettings->tDim;
+    TFourCC const tFourCC = getFourCC(pUserOutputSettings_->tPicFormat);
+    int32_t iNumBuf = iBufferNumber + iExtraBuffers_;
+
+    /* First resolution found after reset(): hand the previous stream's pictures to the new
+       decoder when they fit, otherwise start over with a new pool. */
+    if (bReusePool_)
+    {
+        bReusePool_ = false;
+        AL_TDimension tDim = computeBaseDecoderFinalResolution(pStreamSettings);
+        bool const bCompatible = baseBufPool_->IsInit() && tFourCC == tPoolFourCC_ &&
+                                 tDim.iWidth == tPoolDim_.iWidth &&
+                                 tDim.iHeight == tPoolDim_.iHeight && iNumBuf <= iPoolNumBuf_;
+
+        if (bCompatible)
+        {
+            {
+                auto lock = std::lock_guard(mutex_);
+                streamInfo_ = getStreamInfo(iBufferNumber, iPoolBufferSize_,
+                        iExtraBuffers_, pStreamSettings, &pUserCropInfo, tFourCC, outputDim);
+            }
+            putBaseDecoderPoolBuffers(pStreamSettings, iPoolNumBuf_, false);
+            return AL_SUCCESS;
+        }
+        baseBufPool_ = std::make_unique<PixMapBufPool>();
+    }
+
+    /* Compute buffer sizing */
+    int32_t iBufferSize = computeBaseDecoderRecBufferSizing(pStreamSettings, pUserOutputSettings_);
 
     {
         auto lock = std::lock_guard(mutex_);
         streamInfo_ = getStreamInfo(iBufferNumber, iBufferSize,
-                iExtraBuffers_, pStreamSettings, &pUserCropInfo,
-                getFourCC(pUserOutputSettings_->tPicFormat), outputDim);
+                iExtraBuffers_, pStreamSettings, &pUserCropInfo, tFourCC, outputDim);
     }
 
-    if (baseBufPool_.IsInit())
+    if (baseBufPool_->IsInit())
         return AL_SUCCESS;
 
     /* Create the buffers */
-    int32_t iNumBuf = iBufferNumber + iExtraBuffers_;
-
-    if (!baseBufPool_.Init(pAllocator_, iNumBuf, "decoded picture buffer"))
+    if (!baseBufPool_->Init(pAllocator_, iNumBuf, "decoded picture buffer"))
         return AL_ERR_NO_MEMORY;
 
-    // Attach the metas + push to decoder
-    // ----------------------------------
+    tPoolFourCC_ = tFourCC;
+    tPoolDim_ = computeBaseDecoderFinalResolution(pStreamSettings);
+    iPoolNumBuf_ = iNumBuf;
+    iPoolBufferSize_ = iBufferSize;
+
+    putBaseDecoderPoolBuffers(pStreamSettings, iNumBuf, true);
+
+    return AL_SUCCESS;
+}
+
+void DecoderContext::putBaseDecoderPoolBuffers(AL_TStreamSettings const *pStreamSettings,
+                                               int32_t iNumBuf, bool bAttachMetaData)
+{
+    // Attach the metas (new buffers only) + push to decoder
+    // -----------------------------------------------------
     for (int32_t i = 0; i < iNumBuf; ++i)
     {
-        auto pDecPict = baseBufPool_.GetSharedBuffer(AL_EBufMode::AL_BUF_MODE_NONBLOCK);
+        auto pDecPict = baseBufPool_->GetSharedBuffer(AL_EBufMode::AL_BUF_MODE_NONBLOCK);
 
         if (!pDecPict)
             throw std::runtime_error("pDecPict is null");
 
         AL_Buffer_Cleanup(pDecPict.get());
 
-        attachMetaDataToBaseDecoderRecBuffer(pStreamSettings, pDecPict.get());
+        if (bAttachMetaData)
+            attachMetaDataToBaseDecoderRecBuffer(pStreamSettings, pDecPict.get());
         bool const bAdded = AL_Decoder_PutDisplayPicture(getBaseDecoderHandle(), pDecPict.get());
 
         if (!bAdded)
             throw std::runtime_error("bAdded must be true");
     }
-
-    return AL_SUCCESS;
 }
 
 void DecoderContext::receiveBaseDecoderDecodedFrame(AL_TBuffer *pFrame)
@@ -686,6 +763,41 @@ void DecoderContext::destroyDecoder()
     }
 }
 
+void DecoderContext::reset(Ptr<Config> pConfig, WorkerConfig &wCfg)
+{
+    finish();
+    destroyDecoder();
+
+    auto &config = *pConfig;
+    prepareConfig(config);
+    checkAndAdjustChannelConfiguration(config);
+
+    {
+        auto lock = std::lock_guard(mutex_);
+        eos_ = false;
+        await_eos_ = false;
+        exitSignaled_ = false;
+        streamInfo_.clear();
+        stats_.clear();
+    }
+    {
+        auto lock = lockDisplay();
+        bPushBackToDecoder_ = true;
+    }
+    iNumFrameConceal_ = 0;
+    iNumDecodedFrames_ = 0;
+    pDecSettings_ = &config.tDecSettings;
+    pUserOutputSettings_ = &config.tUserOutputSettings;
+    iExtraBuffers_ = config.iExtraBuffers;
+    eExitCondition = config.eExitCondition;
+    rawOutput_->configure(config.tOutputFourCC, config.iOutputBitDepth, config.iMaxFrames);
+    bReusePool_ = true;
+
+    wCfg.pConfig = pConfig;
+    createBaseDecoder(wCfg.device);
+    setTraceParams(getBaseDecoderHandle(), config);
+}
+
 void DecoderContext::receiveFrameToDisplayFrom(Ptr<Frame> pFrame)
 {
     auto lock = lockDisplay();
@@ -861,7 +973,8 @@ void DecoderContext::ctrlswDecRun(WorkerConfig wCfg)
 
     {
         auto lock2 = std::lock_guard(mutex_);
-        stats_ = getStatistics(duration, getNumConcealedFrame(), getNumDecodedFrames());
+        stats_ = getStatistics(duration, getNumConcealedFrame(), getNumDecodedFrames())
+               + wCfg.device->cacheStatistics();
         eos_ = true;
         // running_ stays true until finish() joins this thread
     }
@@ -889,28 +1002,372 @@ void DecoderContext::ctrlswDecRun(WorkerConfig wCfg)
 }
 
 
-/*static*/ Ptr<DecContext>
-DecContext::create(Ptr<Config> pDecConfig, Ptr<RawOutput> rawOutput, WorkerConfig &wCfg)
+/// Decoder context of the software device: reads the SoftCodec container written by the software
+/// encoder and outputs its pictures through the same RawOutput as the hardware decoder.
+class SoftwareDecoderContext : public DecContext
 {
-    Ptr<DecoderContext> pDecodeCtx;
-    std::set<std::string> const sDecDefaultDevicePath(DECODER_DEVICES);
-    SetDefaultDecOutputSettings(&pDecConfig->tUserOutputSettings);
-    pDecConfig->sDecDevicePath = sDecDefaultDevicePath;
+public:
+    SoftwareDecoderContext(Config &config, AL_TAllocator *pAllocator, Ptr<RawOutput> rawOutput);
+    ~SoftwareDecoderContext();
 
-    pDecConfig->tUserOutputSettings.tPicFormat.eStorageMode = AL_FB_RASTER;
+    void start(WorkerConfig wCfg) override;
+    void finish() override;
+    void destroyDecoder() override;
+    void reset(Ptr<Config> pConfig, WorkerConfig& wCfg) override;
 
-    /* Propagate the requested output packing so the decoder emits the packed (XV) format
-       directly, instead of labeling packed 10-bit data as P210 and then corrupting it via a
-       P210->XV20 software re-pack. */
-    if (pDecConfig->tOutputFourCC != FOURCC(NULL))
+    bool running() const override
     {
-        AL_TPicFormat tReqFmt;
-        AL_GetPicFormat(pDecConfig->tOutputFourCC, &tReqFmt);
-        pDecConfig->tUserOutputSettings.tPicFormat.eSamplePackMode = tReqFmt.eSamplePackMode;
+        auto lock = std::lock_guard(mutex_);
+        return running_;
     }
-#ifdef HAVE_VCU2_CTRLSW
-    pDecConfig->tUserOutputSettings.bCustomFormat = true;
-#endif
+
+    bool eos() const override
+    {
+        auto lock = std::lock_guard(mutex_);
+        return eos_;
+    }
+
+    String streamInfo() const override
+    {
+        auto lock = std::lock_guard(mutex_);
+        return streamInfo_;
+    }
+
+    String statistics() const override
+    {
+        auto lock = std::lock_guard(mutex_);
+        return stats_;
+    }
+
+private:
+    /// Pictures decoded ahead of the display, in addition to the extra buffers of the config.
+    static int32_t const iNumDecodingBuffers = 4;
+
+    void setupPool(SoftStreamHeader const &header);
+    void outputPicture(AL_TBuffer *pBuf);
+    void frameDone();
+    void softDecRun(WorkerConfig wCfg);
+
+    mutable std::mutex mutex_;
+    std::condition_variable exitEvent_;
+    bool running_ = false;
+    bool eos_ = false;
+    bool await_eos_ = false;
+    bool exitSignaled_ = false;
+
+    AL_TAllocator *pAllocator_;
+    Ptr<RawOutput> rawOutput_;
+    int32_t iExtraBuffers_ = 1;
+    int32_t iNumDecodedFrames_ = 0;
+    std::unique_ptr<PixMapBufPool> bufPool_;
+    AL_TPicFormat tPicFormat_ {};
+    AL_TDimension tPoolDim_ {};
+    std::thread softThread_;
+    String streamInfo_;
+    String stats_;
+};
+
+SoftwareDecoderContext::SoftwareDecoderContext(Config &config, AL_TAllocator *pAllocator,
+                                               Ptr<RawOutput> rawOutput)
+    : pAllocator_(pAllocator), rawOutput_(rawOutput), iExtraBuffers_(config.iExtraBuffers)
+{
+    rawOutput_->configure(config.tOutputFourCC, config.iOutputBitDepth, config.iMaxFrames);
+}
+
+SoftwareDecoderContext::~SoftwareDecoderContext()
+{
+    {
+        auto lock = std::lock_guard(mutex_);
+        await_eos_ = true;
+        eos_ = true;
+        exitSignaled_ = true;
+    }
+    exitEvent_.notify_all();
+    if (bufPool_)
+        bufPool_->Decommit();
+    if (softThread_.joinable())
+        softThread_.join();
+    destroyDecoder();
+}
+
+void SoftwareDecoderContext::start(WorkerConfig wCfg)
+{
+    auto lock = std::lock_guard(mutex_);
+    if (softThread_.joinable())
+        softThread_.join();
+    softThread_ = std::thread(&SoftwareDecoderContext::softDecRun, this, wCfg);
+    running_ = true;
+}
+
+void SoftwareDecoderContext::finish()
+{
+    rawOutput_->flush();
+    {
+        auto lock = std::lock_guard(mutex_);
+        await_eos_ = true;
+        exitSignaled_ = true;
+    }
+    exitEvent_.notify_all();
+    if (bufPool_)
+        bufPool_->Decommit(); // unblocks a worker waiting for a free picture
+    if (softThread_.joinable())
+        softThread_.join();
+    {
+        auto lock = std::lock_guard(mutex_);
+        running_ = false;
+    }
+}
+
+void SoftwareDecoderContext::destroyDecoder()
+{
+    bufPool_.reset();
+}
+
+void SoftwareDecoderContext::reset(Ptr<Config> pConfig, WorkerConfig &wCfg)
+{
+    finish();
+    destroyDecoder();
+
+    auto &config = *pConfig;
+    prepareConfig(config);
+    checkAndAdjustChannelConfiguration(config);
+
+    {
+        auto lock = std::lock_guard(mutex_);
+        eos_ = false;
+        await_eos_ = false;
+        exitSignaled_ = false;
+        streamInfo_.clear();
+        stats_.clear();
+    }
+    iNumDecodedFrames_ = 0;
+    iExtraBuffers_ = config.iExtraBuffers;
+    rawOutput_->configure(config.tOutputFourCC, config.iOutputBitDepth, config.iMaxFrames);
+
+    wCfg.pConfig = pConfig;
+}
+
+void SoftwareDecoderContext::setupPool(SoftStreamHeader const &header)
+{
+    TFourCC const tFourCC = static_cast<TFourCC>(header.fourcc);
+    AL_GetPicFormat(tFourCC, &tPicFormat_);
+
+    /* Same rounding as the hardware decoder, so that the pictures have the same layout */
+    tPoolDim_ = {roundUp(static_cast<int32_t>(header.width), 64),
+                 roundUp(static_cast<int32_t>(header.height), 64)};
+    auto minPitch = AL_Decoder_GetMinPitch(tPoolDim_.iWidth, &tPicFormat_);
+    int32_t iNumBuf = iNumDecodingBuffers + iExtraBuffers_;
+
+    bufPool_ = std::make_unique<PixMapBufPool>();
+    int32_t iBufferSize = configureDecBufPool(*bufPool_, tPicFormat_, tPoolDim_, minPitch, false);
+
+    if (!bufPool_->Init(pAllocator_, iNumBuf, "decoded picture buffer"))
+        throw std::runtime_error("Can't create the decoded picture pool");
+
+    /* Attach the metadata the hardware decoder pictures carry, for Frame shallow copies */
+    {
+        std::vector<std::shared_ptr<AL_TBuffer>> pictures;
+        for (int32_t i = 0; i < iNumBuf; ++i)
+        {
+            auto pDecPict = bufPool_->GetSharedBuffer(AL_EBufMode::AL_BUF_MODE_NONBLOCK);
+
+            if (!pDecPict)
+                throw std::runtime_error("pDecPict is null");
+            AL_Buffer_AddMetaData(pDecPict.get(), (AL_TMetaData *)AL_PictureDecMetaData_Create());
+            AL_Buffer_AddMetaData(pDecPict.get(), (AL_TMetaData *)AL_DisplayInfoMetaData_Create());
+            pictures.push_back(pDecPict);
+        }
+    }
+
+    std::stringstream ss;
+    ss << "Resolution: " << header.width << "x" << header.height << std::endl;
+    ss << "FourCC: " << AL_FourCCToString(tFourCC).cFourcc << std::endl;
+    ss << "Bitdepth: " << AL_GetBitDepth(tFourCC) << std::endl;
+    ss << "Device: software" << std::endl;
+    ss << "Buffers needed: " << iNumDecodingBuffers << "(+" << iExtraBuffers_ << ") of size "
+       << iBufferSize << std::endl;
+
+    auto lock = std::lock_guard(mutex_);
+    streamInfo_ = ss.str();
+}
+
+void SoftwareDecoderContext::outputPicture(AL_TBuffer *pBuf)
+{
+    AL_TInfoDecode info {};
+    info.tDim = AL_PixMapBuffer_GetDimension(pBuf);
+    info.eChromaMode = tPicFormat_.eChromaMode;
+    info.uBitDepthY = tPicFormat_.uBitDepth;
+    info.uBitDepthC = tPicFormat_.uBitDepth;
+    info.tCrop = {false, 0, 0, 0, 0};
+    info.eFbStorageMode = tPicFormat_.eStorageMode;
+    info.ePicStruct = AL_PS_FRM;
+    info.uCRC = 0;
+    info.eOutputID = AL_OUTPUT_MAIN;
+    info.tPos = {0, 0};
+
+    /* The frame holds a reference to the picture, which returns to the pool when released */
+    Ptr<Frame> frame = Frame::create(pBuf, &info, [this](Frame const &) { frameDone(); });
+    frame->invalidate();
+
+    bool bIsFrameMainDisplay;
+    bool bNumFrameReached;
+    rawOutput_->process(frame, tPicFormat_.uBitDepth, bIsFrameMainDisplay, bNumFrameReached,
+                        true);
+    if (bNumFrameReached)
+    {
+        auto lock = std::lock_guard(mutex_);
+        exitSignaled_ = true;
+    }
+}
+
+void SoftwareDecoderContext::frameDone()
+{
+    {
+        auto lock = std::lock_guard(mutex_);
+        if (!eos_ && await_eos_ && rawOutput_->idle())
+        {
+            eos_ = true;
+            exitSignaled_ = true;
+        }
+    }
+    exitEvent_.notify_all();
+}
+
+void SoftwareDecoderContext::softDecRun(WorkerConfig wCfg)
+{
+  try
+  {
+    auto &config = *wCfg.pConfig;
+    std::ifstream file;
+
+    if (!config.decoderCallback)
+    {
+        file.open(config.sIn, std::ios::binary);
+        if (!file)
+            CV_Error(cv::Error::StsBadArg, "Failed to set input file path");
+    }
+
+    // Read exactly size bytes unless the stream ends, callbacks may return short reads
+    auto read = [&](void *pData, size_t size) -> size_t
+    {
+        uint8_t *pBytes = static_cast<uint8_t *>(pData);
+        size_t zRead = 0;
+        while (zRead < size)
+        {
+            size_t n;
+            if (config.decoderCallback)
+                n = config.decoderCallback->onData(pBytes + zRead, size - zRead);
+            else
+            {
+                file.read(reinterpret_cast<char *>(pBytes + zRead), size - zRead);
+                n = static_cast<size_t>(file.gcount());
+            }
+            if (n == 0)
+                break;
+            zRead += n;
+        }
+        return zRead;
+    };
+
+    auto const uBegin = GetPerfTime();
+
+    SoftStreamHeader header;
+    if (read(&header, sizeof(header)) != sizeof(header) || !SoftCodec::isStreamHeader(header))
+        throw std::runtime_error("Not a software device stream");
+    setupPool(header);
+
+    std::vector<uint8_t> payload;
+    SoftPictureHeader picture;
+    for (;;)
+    {
+        {
+            auto lock = std::lock_guard(mutex_);
+            if (exitSignaled_)
+                break;
+        }
+
+        size_t zRead = read(&picture, sizeof(picture));
+        if (zRead == 0)
+            break;
+        if (zRead != sizeof(picture))
+            throw std::runtime_error("Truncated software device stream");
+
+        if (static_cast<int32_t>(picture.width) > tPoolDim_.iWidth ||
+            static_cast<int32_t>(picture.height) > tPoolDim_.iHeight)
+            throw std::runtime_error("Picture larger than the stream resolution");
+        if (picture.size != SoftCodec::pictureSize(header.fourcc, picture.width, picture.height))
+            throw std::runtime_error("Invalid picture size in software device stream");
+
+        payload.resize(picture.size);
+        if (read(payload.data(), payload.size()) != payload.size())
+            throw std::runtime_error("Truncated software device stream");
+        if (SoftCodec::checksum(payload.data(), payload.size()) != picture.checksum)
+            throw std::runtime_error("Checksum mismatch on picture " +
+                                     std::to_string(picture.index));
+
+        std::shared_ptr<AL_TBuffer> pBuf;
+        try
+        {
+            pBuf = bufPool_->GetSharedBuffer();
+        }
+        catch (bufpool_decommited_error &)
+        {
+            break;
+        }
+
+        AL_TDimension tDim = {static_cast<int32_t>(picture.width),
+                              static_cast<int32_t>(picture.height)};
+        AL_PixMapBuffer_SetDimension(pBuf.get(), tDim);
+        SoftCodec::unpack(payload.data(), pBuf.get());
+        outputPicture(pBuf.get());
+        iNumDecodedFrames_++;
+    }
+
+    if (config.decoderCallback)
+        config.decoderCallback->onFinished();
+
+    // End of stream: done once the display queue is drained
+    {
+        auto lock = std::lock_guard(mutex_);
+        await_eos_ = true;
+        if (rawOutput_->idle())
+            eos_ = true;
+    }
+    {
+        std::unique_lock<std::mutex> lock(mutex_);
+        exitEvent_.wait(lock, [this]{ return exitSignaled_; });
+    }
+
+    auto const uEnd = GetPerfTime();
+
+    if (!iNumDecodedFrames_)
+        throw std::runtime_error("No frame decoded");
+
+    {
+        auto lock = std::lock_guard(mutex_);
+        stats_ = getStatistics((uEnd - uBegin) / 1000.0, 0, iNumDecodedFrames_);
+        eos_ = true;
+        // running_ stays true until finish() joins this thread
+    }
+    exitEvent_.notify_all();
+  }
+  catch (const std::exception& e)
+  {
+    std::cerr << std::endl << "Decoder worker error: " << e.what() << std::endl;
+    auto lock = std::lock_guard(mutex_);
+    eos_ = true;
+    // running_ stays true until finish() joins this thread
+    exitSignaled_ = true;
+    exitEvent_.notify_all();
+  }
+}
+
+/*static*/ Ptr<DecContext>
+DecContext::create(Ptr<Config> pDecConfig, Ptr<RawOutput> rawOutput, WorkerConfig &wCfg)
+{
+    Ptr<DecoderContext> pDecodeCtx;
+    prepareConfig(*pDecConfig);
+
     // Setup of the decoder(s) architecture
 #ifdef HAVE_VCU2_CTRLSW
     AL_Lib_Decoder_Init(AL_LIB_DECODER_ARCH_RISCV);
@@ -923,7 +1380,10 @@ DecContext::create(Ptr<Config> pDecConfig, Ptr<RawOutput> rawOutput, WorkerConfi
 
     try
     {
-        device = Device::create(Device::DECODER);
+        AL_TDecSettings const &tDecSettings = pDecConfig->tDecSettings;
+        double fps = tDecSettings.uClkRatio
+                   ? (double)tDecSettings.uFrameRate / tDecSettings.uClkRatio : 0.0;
+        device = Device::create(Device::DECODER, fps);
     }
     catch (const std::exception &e)
     {
@@ -939,6 +1399,15 @@ DecContext::create(Ptr<Config> pDecConfig, Ptr<RawOutput> rawOutput, WorkerConfi
     // ------------------
     checkAndAdjustChannelConfiguration(config);
 
+    // The software device has no base decoder, it reads the software encoder output
+    // ------------------------------------------------------------------------------
+    if (device->isSoftware())
+    {
+        wCfg.pConfig = pDecConfig;
+        wCfg.device = device;
+        return Ptr<DecContext>(new SoftwareDecoderContext(config, pAllocator, rawOutput));
+    }
+
     // Configure the decoders
     // ----------------------
     pDecodeCtx = Ptr<DecoderContext>(new DecoderContext(config, pAllocator, rawOutput));
@@ -952,14 +1421,7 @@ DecContext::create(Ptr<Config> pDecConfig, Ptr<RawOutput> rawOutput, WorkerConfi
 
     // Parametrization of the base decoder for traces
     // ----------------------------------------------
-    auto hDec = pDecodeCtx->getBaseDecoderHandle();
-#ifdef HAVE_VCU2_CTRLSW
-    AL_Decoder_SetParam(hDec, "Fpga", config.iTraceIdx, config.iTraceNumber,
-                        config.ipCtrlMode == AL_EIpCtrlMode::AL_IPCTRL_MODE_TRACE, false);
-#else
-    AL_Decoder_SetParam(hDec, "Fpga", config.iTraceIdx, config.iTraceNumber,
-                        config.ipCtrlMode == AL_EIpCtrlMode::AL_IPCTRL_MODE_TRACE);
-#endif
+    setTraceParams(pDecodeCtx->getBaseDecoderHandle(), config);
 
     // Parametrization of the lcevc decoder for traces
     // -----------------------------------------------
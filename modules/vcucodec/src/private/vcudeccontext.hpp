@@ -61,6 +61,11 @@ class DecContext
     /// Frame references have been released and after finish().
     virtual void destroyDecoder() = 0;
 
+    /// Re-create the hardware decoder for a new stream described by @p pConfig, keeping the
+    /// device of @p wCfg. The decoded picture pool is reused when the new stream has the same
+    /// output format and resolution. Must be called after finish().
+    virtual void reset(Ptr<Config> pConfig, WorkerConfig& wCfg) = 0;
+
     /// Check if the decoder context is running.
     virtual bool running() const = 0;
 
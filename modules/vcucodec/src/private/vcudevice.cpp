@@ -15,6 +15,7 @@
 */
 
 #include "vcudevice.hpp"
+#include "vcudmacache.hpp"
 
 const char* err = "only one of HAVE_VCU2_CTRLSW, HAVE_VCU_CTRLSW, HAVE_VDU_CTRLSW can be defined";
 #if defined(HAVE_VCU_CTRLSW) && (defined(HAVE_VCU2_CTRLSW) || defined(HAVE_VDU_CTRLSW))
@@ -54,8 +55,13 @@ extern "C" {
 #endif
 }
 
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
 #include <memory>
 #include <sstream>
+#include <stdexcept>
+#include <string>
 #include <string_view>
 
 namespace cv {
@@ -105,10 +111,74 @@ namespace { // anonymous
     return deviceString;
 }
 
+bool softwareRequested()
+{
+    const char* device = std::getenv("OPENCV_VCUCODEC_DEVICE");
+    return device && std::strcmp(device, "software") == 0;
+}
+
 } // namespace anonymous
 
+class SoftwareDevice : public Device
+{
+public:
+    SoftwareDevice() = default;
+
+    SoftwareDevice(SoftwareDevice const &) = delete;
+    SoftwareDevice & operator = (SoftwareDevice const &) = delete;
+
+    void* getScheduler() override { return nullptr; }
+    void* getCtx() override { return nullptr; }
+    AL_TAllocator* getAllocator() override { return AL_GetDefaultAllocator(); }
+    AL_ITimer* getTimer() override { return nullptr; };
+    bool isSoftware() const override { return true; }
+};
+
+#if defined(HAVE_VCU2_CTRLSW) || defined(HAVE_VCU_CTRLSW)
+/// Hardware device: allocates from the DMA allocator of the device through a
+/// CachingDmaAllocator, so that the channels placed on it reuse each other's buffers.
+class DmaDevice : public Device
+{
+public:
+    AL_TAllocator* getAllocator() override { return cache_ ? cache_->get() : allocator_.get(); }
+
+    String cacheStatistics() const override
+    {
+        if (!cache_)
+            return String();
+        auto stats = cache_->stats();
+        std::stringstream ss;
+        ss << "DMA cache: " << stats.hits << " hits, " << stats.misses << " misses, "
+           << (stats.bytesCached >> 20) << " MB cached in " << stats.buffersCached
+           << " buffers (high water " << (stats.highWater >> 20) << " MB)" << std::endl;
+        return ss.str();
+    }
+
+protected:
+    void setAllocator(std::shared_ptr<AL_TAllocator> allocator)
+    {
+        allocator_ = allocator;
+        size_t capacity = CachingDmaAllocator::defaultCapacity();
+        if (capacity && allocator_)
+            cache_.reset(new CachingDmaAllocator(allocator_.get(), capacity));
+    }
+
+    /// Cached buffers first, then the allocator itself
+    void releaseAllocator()
+    {
+        cache_.reset();
+        allocator_.reset();
+    }
+
+    std::shared_ptr<AL_TAllocator> allocator_;
+
+private:
+    std::unique_ptr<CachingDmaAllocator> cache_;
+};
+#endif
+
 #ifdef HAVE_VCU2_CTRLSW
-class VCU2DecDevice : public Device
+class VCU2DecDevice : public DmaDevice
 {
 public:
     ~VCU2DecDevice() override;
@@ -119,11 +189,9 @@ public:
 
     void* getScheduler() override { return nullptr; }
     void* getCtx() override { return ctx_; }
-    AL_TAllocator* getAllocator() override { return allocator_.get(); }
     AL_ITimer* getTimer() override { return nullptr; };
 
 private:
-    std::shared_ptr<AL_TAllocator> allocator_;
     AL_RiscV_Ctx ctx_;
 };
 
@@ -162,16 +230,17 @@ VCU2DecDevice::VCU2DecDevice(Device::ID id)
     if (!allocator)
         throw std::runtime_error("Can't find dma allocator");
 
-    allocator_.reset(allocator, &AL_Allocator_Destroy);
+    setAllocator(std::shared_ptr<AL_TAllocator>(allocator, &AL_Allocator_Destroy));
 }
 
 VCU2DecDevice::~VCU2DecDevice()
 {
+    releaseAllocator();
     if (ctx_)
         AL_Riscv_Decode_DestroyCtx(ctx_);
 }
 
-class VCU2EncDevice : public Device
+class VCU2EncDevice : public DmaDevice
 {
 public:
     ~VCU2EncDevice() override;
@@ -182,11 +251,9 @@ public:
 
     void* getScheduler() override { return nullptr; }
     void* getCtx() override { return ctx_; }
-    AL_TAllocator* getAllocator() override { return allocator_.get(); }
     AL_ITimer* getTimer() override { return nullptr; };
 
 private:
-    std::shared_ptr<AL_TAllocator> allocator_;
     AL_RiscV_Ctx ctx_;
 };
 
@@ -220,11 +287,12 @@ VCU2EncDevice::VCU2EncDevice(Device::ID id)
     AL_TAllocator* allocator = AL_Riscv_Encode_DmaAlloc_Create(ctx_);
     if (!allocator)
         throw std::runtime_error("Can't find dma allocator");
-    allocator_.reset(allocator, &AL_Allocator_Destroy);
+    setAllocator(std::shared_ptr<AL_TAllocator>(allocator, &AL_Allocator_Destroy));
 }
 
 VCU2EncDevice::~VCU2EncDevice()
 {
+    releaseAllocator();
     if (ctx_)
         AL_Riscv_Encode_DestroyCtx(ctx_);
 }
@@ -232,21 +300,19 @@ VCU2EncDevice::~VCU2EncDevice()
 #endif // HAVE_VCU2_CTRLSW
 
 #ifdef HAVE_VCU_CTRLSW
-class VCUDecDevice : public Device
+class VCUDecDevice : public DmaDevice
 {
 public:
     ~VCUDecDevice() override;
     VCUDecDevice(Device::ID);
 
     void* getScheduler() override { return scheduler_; }
-    AL_TAllocator* getAllocator() override { return allocator_.get(); }
 	void* getCtx() override { return nullptr; }
     AL_ITimer* getTimer() override { return nullptr; };
 
 private:
     void configureMcu(AL_ICommunication* driver);
     AL_IDecScheduler* scheduler_ = nullptr;
-    std::shared_ptr<AL_TAllocator> allocator_ = nullptr;
 };
 
 VCUDecDevice::VCUDecDevice(Device::ID)
@@ -258,12 +324,13 @@ VCUDecDevice::~VCUDecDevice()
 {
     if (scheduler_)
         AL_IDecScheduler_Destroy(scheduler_);
+    releaseAllocator();
 }
 
 void VCUDecDevice::configureMcu(AL_ICommunication* driver)
 {
   std::string g_DecDevicePath = "/dev/allegroDecodeIP";
-  allocator_ = CreateBoardAllocator(g_DecDevicePath.c_str(), AL_ETrackDmaMode::AL_TRACK_DMA_MODE_NONE);
+  setAllocator(CreateBoardAllocator(g_DecDevicePath.c_str(), AL_ETrackDmaMode::AL_TRACK_DMA_MODE_NONE));
 
   if(!allocator_)
     throw std::runtime_error("Can't open DMA allocator");
@@ -274,21 +341,19 @@ void VCUDecDevice::configureMcu(AL_ICommunication* driver)
     throw std::runtime_error("Failed to create MCU scheduler");
 }
 
-class VCUEncDevice : public Device
+class VCUEncDevice : public DmaDevice
 {
 public:
     ~VCUEncDevice() override;
     VCUEncDevice(Device::ID);
 
     void* getScheduler() override { return scheduler_; }
-    AL_TAllocator* getAllocator() override { return allocator_.get(); }
 	void* getCtx() override { return nullptr; }
     AL_ITimer* getTimer() override { return nullptr; };
 
 private:
     void configureMcu(AL_ICommunication* driver);
     AL_IEncScheduler* scheduler_ = nullptr;
-    std::shared_ptr<AL_TAllocator> allocator_ = nullptr;
 };
 
 VCUEncDevice::VCUEncDevice(Device::ID)
@@ -300,12 +365,13 @@ VCUEncDevice::~VCUEncDevice()
 {
     if (scheduler_)
         AL_IEncScheduler_Destroy(scheduler_);
+    releaseAllocator();
 }
 
 void VCUEncDevice::configureMcu([[maybe_unused]] AL_ICommunication* driver)
 {
   std::string g_EncDevicePath = "/dev/allegroIP";
-  allocator_ = CreateBoardAllocator(g_EncDevicePath.c_str(), AL_ETrackDmaMode::AL_TRACK_DMA_MODE_NONE);
+  setAllocator(CreateBoardAllocator(g_EncDevicePath.c_str(), AL_ETrackDmaMode::AL_TRACK_DMA_MODE_NONE));
 
   if(!allocator_)
     throw std::runtime_error("Can't open DMA allocator");
@@ -318,39 +384,170 @@ void VCUEncDevice::configureMcu([[maybe_unused]] AL_ICommunication* driver)
 }
 #endif // HAVE_VCU_CTRLSW
 
-/*static*/ Ptr<Device> Device::create(Device::ID id)
+namespace { // anonymous
+
+[[maybe_unused]] void addCore(std::vector<DeviceRegistry::Core>& table, Device::ID id,
+                              DeviceRegistry::Factory factory)
 {
+    if (!deviceID(id).empty())
+        table.push_back(DeviceRegistry::Core{id, factory});
+}
+
+std::vector<DeviceRegistry::Core> hardwareCores()
+{
+    std::vector<DeviceRegistry::Core> table;
 #ifdef HAVE_VCU2_CTRLSW
-    switch (id)
-    {
-    case DECODER0:
-    case DECODER1:
-    case DECODER:
-        return Ptr<Device>(new VCU2DecDevice(id));
-    case ENCODER0:
-    case ENCODER1:
-    case ENCODER:
-        return Ptr<Device>(new VCU2EncDevice(id));
-    }
+    auto decoder = [](Device::ID id) { return Ptr<Device>(new VCU2DecDevice(id)); };
+    auto encoder = [](Device::ID id) { return Ptr<Device>(new VCU2EncDevice(id)); };
+    addCore(table, Device::DECODER0, decoder);
+    addCore(table, Device::DECODER1, decoder);
+    addCore(table, Device::ENCODER0, encoder);
+    addCore(table, Device::ENCODER1, encoder);
 #endif
 #ifdef HAVE_VCU_CTRLSW
-    switch (id)
+    // One MCU per direction, its scheduler shares the cores between the channels.
+    table.push_back({Device::DECODER0, [](Device::ID id) { return Ptr<Device>(new VCUDecDevice(id)); }});
+    table.push_back({Device::ENCODER0, [](Device::ID id) { return Ptr<Device>(new VCUEncDevice(id)); }});
+#endif
+    return table;
+}
+
+} // namespace anonymous
+
+/// Device of a channel: forwards to the shared device of its core and gives the load back
+/// when released.
+class DeviceRegistry::Channel : public Device
+{
+public:
+    Channel(std::shared_ptr<State> state, size_t index, std::shared_ptr<Device> device,
+            double load)
+        : state_(state), index_(index), device_(device), load_(load) {}
+
+    ~Channel() override
     {
-    case DECODER0:
-    case DECODER1:
-    case DECODER:
-        return Ptr<Device>(new VCUDecDevice(id));
-    case ENCODER0:
-    case ENCODER1:
-    case ENCODER:
-        return Ptr<Device>(new VCUEncDevice(id));
+        state_->release(index_, load_, std::move(device_));
     }
-#endif
-#ifdef HAVE_VDU_CTRLSW
-#endif
-    return Ptr<Device>(nullptr);
+
+    Channel(Channel const &) = delete;
+    Channel & operator = (Channel const &) = delete;
+
+    void* getScheduler() override { return device_->getScheduler(); }
+    void* getCtx() override { return device_->getCtx(); }
+    AL_TAllocator* getAllocator() override { return device_->getAllocator(); }
+    AL_ITimer* getTimer() override { return device_->getTimer(); }
+    bool isSoftware() const override { return device_->isSoftware(); }
+    String cacheStatistics() const override { return device_->cacheStatistics(); }
+
+private:
+    std::shared_ptr<State> state_;
+    size_t index_;
+    std::shared_ptr<Device> device_;
+    double load_;
+};
+
+DeviceRegistry::DeviceRegistry(std::vector<Core> table)
+    : state_(std::make_shared<State>())
+{
+    for (auto& core : table)
+    {
+        Entry entry;
+        entry.core = core;
+        state_->entries.push_back(entry);
+    }
+}
+
+/*static*/ DeviceRegistry& DeviceRegistry::instance()
+{
+    static DeviceRegistry registry(hardwareCores());
+    return registry;
+}
+
+Ptr<Device> DeviceRegistry::acquire(Device::ID mask, double load)
+{
+    std::lock_guard<std::mutex> lock(state_->mutex);
+    auto& entries = state_->entries;
+
+    std::vector<size_t> candidates;
+    for (size_t i = 0; i < entries.size(); ++i)
+        if (entries[i].core.id & mask)
+            candidates.push_back(i);
+    if (candidates.empty())
+        throw std::runtime_error("Device not found");
+
+    std::stable_sort(candidates.begin(), candidates.end(), [&entries](size_t a, size_t b) {
+        if (entries[a].load != entries[b].load)
+            return entries[a].load < entries[b].load;
+        return entries[a].channels < entries[b].channels;
+    });
+
+    std::string errors;
+    for (size_t index : candidates)
+    {
+        Entry& entry = entries[index];
+        std::shared_ptr<Device> device = entry.device.lock();
+        if (!device)
+        {
+            try
+            {
+                device = entry.core.factory(entry.core.id);
+            }
+            catch (const std::exception& e)
+            {
+                errors += std::string(errors.empty() ? "" : "; ") + e.what();
+                continue;
+            }
+            if (!device)
+                continue;
+            entry.device = device;
+        }
+        entry.load += load;
+        entry.channels++;
+        return Ptr<Device>(new Channel(state_, index, device, load));
+    }
+    throw std::runtime_error(errors.empty() ? "Device not found" : errors);
 }
 
+double DeviceRegistry::load(Device::ID core) const
+{
+    std::lock_guard<std::mutex> lock(state_->mutex);
+    for (auto const& entry : state_->entries)
+        if (entry.core.id == core)
+            return entry.load;
+    return 0.0;
+}
+
+int DeviceRegistry::channels(Device::ID core) const
+{
+    std::lock_guard<std::mutex> lock(state_->mutex);
+    for (auto const& entry : state_->entries)
+        if (entry.core.id == core)
+            return entry.channels;
+    return 0;
+}
+
+void DeviceRegistry::State::release(size_t index, double load, std::shared_ptr<Device> device)
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    Entry& entry = entries[index];
+    entry.channels--;
+    entry.load = entry.channels ? entry.load - load : 0.0;
+    // the last channel of the core destroys its device, and the cached buffers, here
+}
+
+/*static*/ Ptr<Device> Device::create(Device::ID id, [[maybe_unused]] double load)
+{
+    if ((id & SOFTWARE) || softwareRequested())
+        return Ptr<Device>(new SoftwareDevice());
+
+#if !defined(HAVE_VCU2_CTRLSW) && !defined(HAVE_VCU_CTRLSW) && !defined(HAVE_VDU_CTRLSW)
+    return Ptr<Device>(new SoftwareDevice());
+#elif defined(HAVE_VDU_CTRLSW)
+    // There is no VDU device yet, so no VDU core in hardwareCores()
+    return Ptr<Device>(nullptr);
+#else
+    return DeviceRegistry::instance().acquire(id, load);
+#endif
+}
 
 } // namespace vcucodec
 } // namespace cv
@@ -18,7 +18,10 @@
 
 #include <opencv2/core.hpp>
 
+#include <functional>
 #include <memory>
+#include <mutex>
+#include <vector>
 
 extern "C" {
 typedef struct AL_TAllocator AL_TAllocator;
@@ -37,7 +40,8 @@ public:
         DECODER  = DECODER0 | DECODER1,
         ENCODER0 = 4,
         ENCODER1 = 8,
-        ENCODER  = ENCODER0 | ENCODER1
+        ENCODER  = ENCODER0 | ENCODER1,
+        SOFTWARE = 16  ///< CPU emulation, combined with DECODER or ENCODER
     };
 
     virtual ~Device() = default;
@@ -46,7 +50,73 @@ public:
     virtual AL_TAllocator* getAllocator() = 0;
     virtual AL_ITimer* getTimer() = 0;
 
-    static Ptr<Device> create(ID);
+    /// True for the CPU emulation: no scheduler nor context, system memory allocator. The
+    /// codec contexts then run their software sinks instead of the ctrl-sw encoder/decoder.
+    virtual bool isSoftware() const { return false; }
+
+    /// Hits, misses and cached bytes of the allocator cache, empty without a cache.
+    virtual String cacheStatistics() const { return String(); }
+
+    /// Returns the software device when @p id has SOFTWARE set, when the
+    /// OPENCV_VCUCODEC_DEVICE environment variable is "software", or when no ctrl-sw backend
+    /// is compiled in. Otherwise returns a channel on the least-loaded core of @p id from
+    /// DeviceRegistry::instance(), counting @p load frames per second on it while the returned
+    /// device is alive. Returns nullptr in HAVE_VDU_CTRLSW builds, which have no VDU device.
+    static Ptr<Device> create(ID, double load = 0.0);
+};
+
+/// Process-wide table of the codec cores.
+///
+/// The channels placed on a core share one Device (context or scheduler, and DMA allocator):
+/// it is created for the first channel and destroyed with the last one. A new channel goes to
+/// the core with the lowest load, then the fewest channels, then the lowest ID; when the device
+/// of that core cannot be created the next core is tried. The buffers cached by the allocator of
+/// a device are thus reused by the channels open at the same time and by the channels reset in
+/// place, and go back to the kernel with the last channel.
+class DeviceRegistry
+{
+public:
+    using Factory = std::function<Ptr<Device>(Device::ID)>;
+
+    struct Core
+    {
+        Device::ID id;    ///< single core: DECODER0, DECODER1, ENCODER0 or ENCODER1
+        Factory factory;  ///< creates the device of the core
+    };
+
+    /// A registry over @p table, e.g. fake devices for testing. The cores of the process are in
+    /// instance().
+    explicit DeviceRegistry(std::vector<Core> table);
+
+    static DeviceRegistry& instance();
+
+    /// Place a channel of @p load frames per second on a core of @p mask.
+    Ptr<Device> acquire(Device::ID mask, double load);
+
+    /// Load and number of channels currently placed on @p core.
+    double load(Device::ID core) const;
+    int channels(Device::ID core) const;
+
+private:
+    struct Entry
+    {
+        Core core;
+        std::weak_ptr<Device> device;
+        double load = 0.0;
+        int channels = 0;
+    };
+
+    struct State
+    {
+        std::mutex mutex;
+        std::vector<Entry> entries;
+
+        void release(size_t index, double load, std::shared_ptr<Device> device);
+    };
+
+    class Channel;
+
+    std::shared_ptr<State> state_;  // shared with the channels, which may outlive the registry
 };
 
 } // namespace vcucodec
@@ -0,0 +1,212 @@
+/*
+   Copyright (c) 2025-2026  Advanced Micro Devices, Inc. (AMD)
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+*/
+#include "vcudmacache.hpp"
+
+#include <cstdlib>
+#include <string>
+
+namespace cv {
+namespace vcucodec {
+
+/*static*/ size_t CachingDmaAllocator::defaultCapacity()
+{
+    const char* megabytes = std::getenv("OPENCV_VCUCODEC_DMA_CACHE_MB");
+    if (megabytes && *megabytes)
+        return static_cast<size_t>(std::strtoul(megabytes, nullptr, 10)) << 20;
+    return size_t(256) << 20;
+}
+
+/*static*/ size_t CachingDmaAllocator::sizeClass(size_t zSize)
+{
+    size_t const page = 4096;
+    if (zSize <= page)
+        return page;
+    size_t power = page;
+    while (power * 2 < zSize)
+        power <<= 1;
+    size_t const step = power / 8 > page ? power / 8 : page;
+    return (zSize + step - 1) / step * step;
+}
+
+CachingDmaAllocator::CachingDmaAllocator(AL_TAllocator* pInner, size_t capacity)
+    : pInner_(pInner), capacity_(capacity)
+{
+    // Start from the device vtable so that every entry is set, then route them all here.
+    vtable_ = *reinterpret_cast<AL_TLinuxDmaAllocator*>(pInner)->vtable;
+    vtable_.base.pfnDestroy = &CachingDmaAllocator::destroy;
+    vtable_.base.pfnAlloc = &CachingDmaAllocator::allocate;
+    vtable_.base.pfnFree = &CachingDmaAllocator::release;
+    vtable_.base.pfnGetVirtualAddr = &CachingDmaAllocator::getVirtualAddr;
+    vtable_.base.pfnGetPhysicalAddr = &CachingDmaAllocator::getPhysicalAddr;
+    vtable_.base.pfnAllocNamed = &CachingDmaAllocator::allocateNamed;
+#ifdef HAVE_VCU2_CTRLSW
+    vtable_.base.pfnSyncForCpu = &CachingDmaAllocator::syncForCpu;
+    vtable_.base.pfnSyncForDevice = &CachingDmaAllocator::syncForDevice;
+#endif
+    vtable_.pfnGetFd = &CachingDmaAllocator::getFd;
+    vtable_.pfnImportFromFd = &CachingDmaAllocator::importFromFd;
+
+    handle_.base.vtable = &vtable_;
+    handle_.self = this;
+}
+
+CachingDmaAllocator::~CachingDmaAllocator()
+{
+    trim();
+}
+
+CachingDmaAllocator::Stats CachingDmaAllocator::stats() const
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    return stats_;
+}
+
+void CachingDmaAllocator::trim()
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    for (auto& freeList : freeLists_)
+    {
+        for (AL_HANDLE hBuf : freeList.second)
+        {
+            sizes_.erase(hBuf);
+            AL_Allocator_Free(pInner_, hBuf);
+        }
+    }
+    freeLists_.clear();
+    stats_.bytesCached = 0;
+    stats_.buffersCached = 0;
+}
+
+AL_HANDLE CachingDmaAllocator::alloc(size_t zSize, char const* name)
+{
+    size_t const zClass = sizeClass(zSize);
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        auto it = freeLists_.find(zClass);
+        if (it != freeLists_.end() && !it->second.empty())
+        {
+            AL_HANDLE hBuf = it->second.back();
+            it->second.pop_back();
+            stats_.hits++;
+            stats_.bytesCached -= zClass;
+            stats_.buffersCached--;
+            return hBuf;
+        }
+        stats_.misses++;
+    }
+
+    AL_HANDLE hBuf = name ? AL_Allocator_AllocNamed(pInner_, zClass, name)
+                          : AL_Allocator_Alloc(pInner_, zClass);
+    if (hBuf)
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        sizes_[hBuf] = zClass;
+    }
+    return hBuf;
+}
+
+bool CachingDmaAllocator::free(AL_HANDLE hBuf)
+{
+    if (!hBuf)
+        return true;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        auto it = sizes_.find(hBuf);
+        if (it != sizes_.end())
+        {
+            size_t const zClass = it->second;
+            if (stats_.bytesCached + zClass <= capacity_)
+            {
+                freeLists_[zClass].push_back(hBuf);
+                stats_.bytesCached += zClass;
+                stats_.buffersCached++;
+                if (stats_.bytesCached > stats_.highWater)
+                    stats_.highWater = stats_.bytesCached;
+                return true;
+            }
+            sizes_.erase(it);
+        }
+    }
+    return AL_Allocator_Free(pInner_, hBuf);
+}
+
+/*static*/ CachingDmaAllocator* CachingDmaAllocator::self(AL_TAllocator* pAllocator)
+{
+    return reinterpret_cast<Handle*>(pAllocator)->self;
+}
+
+/*static*/ bool CachingDmaAllocator::destroy(AL_TAllocator*)
+{
+    // Owned by its C++ object, see ~CachingDmaAllocator()
+    return true;
+}
+
+/*static*/ AL_HANDLE CachingDmaAllocator::allocate(AL_TAllocator* pAllocator, size_t zSize)
+{
+    return self(pAllocator)->alloc(zSize, nullptr);
+}
+
+/*static*/ AL_HANDLE CachingDmaAllocator::allocateNamed(AL_TAllocator* pAllocator, size_t zSize,
+                                                        char const* name)
+{
+    return self(pAllocator)->alloc(zSize, name);
+}
+
+/*static*/ bool CachingDmaAllocator::release(AL_TAllocator* pAllocator, AL_HANDLE hBuf)
+{
+    return self(pAllocator)->free(hBuf);
+}
+
+/*static*/ AL_VADDR CachingDmaAllocator::getVirtualAddr(AL_TAllocator* pAllocator, AL_HANDLE hBuf)
+{
+    return AL_Allocator_GetVirtualAddr(self(pAllocator)->pInner_, hBuf);
+}
+
+/*static*/ AL_PADDR CachingDmaAllocator::getPhysicalAddr(AL_TAllocator* pAllocator,
+                                                         AL_HANDLE hBuf)
+{
+    return AL_Allocator_GetPhysicalAddr(self(pAllocator)->pInner_, hBuf);
+}
+
+#ifdef HAVE_VCU2_CTRLSW
+/*static*/ void CachingDmaAllocator::syncForCpu(AL_TAllocator* pAllocator, AL_VADDR pVirtualAddr,
+                                                size_t zSize)
+{
+    AL_Allocator_SyncForCpu(self(pAllocator)->pInner_, pVirtualAddr, zSize);
+}
+
+/*static*/ void CachingDmaAllocator::syncForDevice(AL_TAllocator* pAllocator,
+                                                   AL_VADDR pVirtualAddr, size_t zSize)
+{
+    AL_Allocator_SyncForDevice(self(pAllocator)->pInner_, pVirtualAddr, zSize);
+}
+#endif
+
+/*static*/ int CachingDmaAllocator::getFd(AL_TLinuxDmaAllocator* pAllocator, AL_HANDLE hBuf)
+{
+    auto pInner = self(reinterpret_cast<AL_TAllocator*>(pAllocator))->pInner_;
+    return AL_LinuxDmaAllocator_GetFd(reinterpret_cast<AL_TLinuxDmaAllocator*>(pInner), hBuf);
+}
+
+/*static*/ AL_HANDLE CachingDmaAllocator::importFromFd(AL_TLinuxDmaAllocator* pAllocator, int fd)
+{
+    // Not recorded in sizes_: imported dmabufs go back to the device when freed
+    auto pInner = self(reinterpret_cast<AL_TAllocator*>(pAllocator))->pInner_;
+    return AL_LinuxDmaAllocator_ImportFromFd(reinterpret_cast<AL_TLinuxDmaAllocator*>(pInner), fd);
+}
+
+} // namespace vcucodec
+} // namespace cv
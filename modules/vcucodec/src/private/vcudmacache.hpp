@@ -0,0 +1,116 @@
+/*
+   Copyright (c) 2025-2026  Advanced Micro Devices, Inc. (AMD)
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+*/
+#ifndef OPENCV_VCUCODEC_VCUDMACACHE_HPP
+#define OPENCV_VCUCODEC_VCUDMACACHE_HPP
+
+extern "C" {
+#include "lib_common/Allocator.h"
+#include "lib_fpga/DmaAllocLinux.h"
+}
+
+#include "opencv2/core/cvdef.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <map>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+
+namespace cv {
+namespace vcucodec {
+
+/// Caching wrapper of a Linux DMA allocator.
+///
+/// Freed buffers are kept in free lists per size class instead of being returned to the
+/// device, and the next allocation of the same class reuses one of them without a new CMA
+/// allocation and mapping. Requests are rounded up to their size class: 8 classes per power of
+/// two, at least one page. Once the cached bytes would exceed the capacity, freed buffers go
+/// back to the device. Imported dmabufs are never cached.
+///
+/// get() is a drop-in AL_TLinuxDmaAllocator: buffers allocated from it can be exported with
+/// AL_LinuxDmaAllocator_GetFd() and dmabufs imported with AL_LinuxDmaAllocator_ImportFromFd().
+class CachingDmaAllocator
+{
+public:
+    struct Stats
+    {
+        uint64_t hits = 0;          ///< allocations served from the cache
+        uint64_t misses = 0;        ///< allocations forwarded to the device
+        size_t bytesCached = 0;     ///< bytes held in the free lists
+        size_t buffersCached = 0;   ///< buffers held in the free lists
+        size_t highWater = 0;       ///< highest bytesCached so far
+    };
+
+    /// Capacity used by the devices, from OPENCV_VCUCODEC_DMA_CACHE_MB (default 256 MB,
+    /// 0 disables the cache).
+    static size_t defaultCapacity();
+
+    /// Wrap @p pInner, which must outlive this object.
+    CachingDmaAllocator(AL_TAllocator* pInner, size_t capacity);
+    ~CachingDmaAllocator(); ///< returns the cached buffers to the device
+
+    CachingDmaAllocator(CachingDmaAllocator const&) = delete;
+    CachingDmaAllocator& operator=(CachingDmaAllocator const&) = delete;
+
+    AL_TAllocator* get() { return reinterpret_cast<AL_TAllocator*>(&handle_); }
+
+    Stats stats() const;
+
+    /// Return all the cached buffers to the device.
+    void trim();
+
+    static size_t sizeClass(size_t zSize);
+
+private:
+    struct Handle
+    {
+        AL_TLinuxDmaAllocator base;
+        CachingDmaAllocator* self;
+    };
+
+    AL_HANDLE alloc(size_t zSize, char const* name);
+    bool free(AL_HANDLE hBuf);
+
+    static CachingDmaAllocator* self(AL_TAllocator* pAllocator);
+    static bool destroy(AL_TAllocator* pAllocator);
+    static AL_HANDLE allocate(AL_TAllocator* pAllocator, size_t zSize);
+    static AL_HANDLE allocateNamed(AL_TAllocator* pAllocator, size_t zSize, char const* name);
+    static bool release(AL_TAllocator* pAllocator, AL_HANDLE hBuf);
+    static AL_VADDR getVirtualAddr(AL_TAllocator* pAllocator, AL_HANDLE hBuf);
+    static AL_PADDR getPhysicalAddr(AL_TAllocator* pAllocator, AL_HANDLE hBuf);
+#ifdef HAVE_VCU2_CTRLSW
+    static void syncForCpu(AL_TAllocator* pAllocator, AL_VADDR pVirtualAddr, size_t zSize);
+    static void syncForDevice(AL_TAllocator* pAllocator, AL_VADDR pVirtualAddr, size_t zSize);
+#endif
+    static int getFd(AL_TLinuxDmaAllocator* pAllocator, AL_HANDLE hBuf);
+    static AL_HANDLE importFromFd(AL_TLinuxDmaAllocator* pAllocator, int fd);
+
+    Handle handle_;
+    AL_DmaAllocLinuxVtable vtable_;
+    AL_TAllocator* pInner_;
+    size_t capacity_;
+
+    mutable std::mutex mutex_;
+    std::map<size_t, std::vector<AL_HANDLE>> freeLists_;  // size class -> cached buffers
+    std::unordered_map<AL_HANDLE, size_t> sizes_;         // size class of the cacheable buffers
+    Stats stats_;
+};
+
+} // namespace vcucodec
+} // namespace cv
+
+#endif // OPENCV_VCUCODEC_VCUDMACACHE_HPP
@@ -43,6 +43,7 @@ extern "C" {
 #include "vcudevice.hpp"
 #include "vcuenccontext.hpp"
 #include "vcuroimanager.hpp"
+#include "vcusoftcodec.hpp"
 #include "vcuutils.hpp"
 #include "vcuframe.hpp"
 
@@ -50,6 +51,7 @@ extern "C" {
 #include <algorithm>
 #include <condition_variable>
 #include <cstring>
+#include <deque>
 #include <iostream>
 #include <map>
 #include <mutex>
@@ -58,6 +60,9 @@ extern "C" {
 #include <thread>
 #include <vector>
 
+#include <fcntl.h>
+#include <unistd.h>
+
 #include "TwoPassMngr.h"
 
 namespace cv {
@@ -73,6 +78,7 @@ namespace { // anonymous
 
 using DataCallback = std::function<void (std::vector<std::string_view>&)>;
 using ChangeSourceCallback = std::function<void(int, int)>;
+using SourceReleasedCallback = std::function<void(AL_TBuffer const*)>;
 
 
 static std::string PictTypeToString(AL_ESliceType type)
@@ -227,10 +233,20 @@ struct EncoderSink
         m_changeSourceCB = changeSourceCB;
     }
 
-    bool waitForCompletion(void)
+    void SetSourceReleasedCallback(SourceReleasedCallback sourceReleasedCB)
+    {
+        m_sourceReleasedCB = sourceReleasedCB;
+    }
+
+    bool waitForCompletion(std::chrono::milliseconds timeout)
     {
         std::unique_lock<std::mutex> lock(encoding_complete_mutex);
-        return encoding_complete_cv.wait_for (lock, std::chrono::seconds(1),
+        if (timeout.count() <= 0)
+        {
+            encoding_complete_cv.wait(lock, [this] { return encoding_finished; });
+            return true;
+        }
+        return encoding_complete_cv.wait_for(lock, timeout,
                                              [this] { return encoding_finished; });
     }
 
@@ -259,6 +275,15 @@ struct EncoderSink
 
         CheckSourceResolutionChanged(Src);
 
+        // TwoPass: pass 1 gets the statistics back in this metadata, pass 2 hands them over.
+        if (twoPassMngr)
+        {
+            auto pPictureMetaTP = AL_TwoPassMngr_CreateAndAttachTwoPassMetaData(Src);
+
+            if (twoPassMngr->iPass == 2)
+                twoPassMngr->GetFrame(pPictureMetaTP);
+        }
+
         if (pSettings->hRcPluginDmaContext != NULL)
             RCPlugin_SetNextFrameQP(pSettings, this->pAllocator);
 
@@ -286,13 +311,47 @@ struct EncoderSink
         m_roiMngr = std::move(roiManager);
     }
 
-    // Supply a raw per-LCU QP table effective from @p frameIdx onward; it takes precedence
-    // over the ROI manager for the frames it covers.
-    void setQpTable(int32_t frameIdx, std::vector<uint8_t> table)
+    // Take a zeroed buffer from the QP-table pool for the caller to write a table into, or
+    // nullptr when the pool is dry: it is shared with the ROI path, so it never blocks. The
+    // buffer keeps the pool alive, so it may be dropped after this sink is gone.
+    std::shared_ptr<AL_TBuffer> getQpTableBuffer()
     {
         ensureQpRoi();
+        if (!m_qpTableRequired)
+            return nullptr;
+
+        std::shared_ptr<AL_TBuffer> pQpBuf =
+            m_qpBufPool->GetSharedBuffer(AL_EBufMode::AL_BUF_MODE_NONBLOCK);
+        if (!pQpBuf)
+            return nullptr;
+
+        std::memset(AL_Buffer_GetData(pQpBuf.get()) + EP2_BUF_QP_BY_MB.Offset, 0,
+                    AL_RoundUp(m_iNumLCUs * m_iNumBytesPerLCU, 128));
+
+        std::shared_ptr<BufPool> pool = m_qpBufPool;
+        return std::shared_ptr<AL_TBuffer>(pQpBuf.get(),
+            [pQpBuf, pool](AL_TBuffer*) mutable
+            {
+                pQpBuf.reset(); // back to the pool first, then the pool may go
+                pool.reset();
+            });
+    }
+
+    // Make @p table the raw per-LCU QP table in effect from @p frameIdx onward; it takes
+    // precedence over the ROI manager for the frames it covers.
+    void commitQpTable(int32_t frameIdx, std::shared_ptr<AL_TBuffer> table)
+    {
+        std::lock_guard<std::mutex> lock(m_qpTableMutex);
+        m_qpTables[frameIdx] = QpTable { std::move(table), {} };
+    }
+
+    // Same as commitQpTable() for a table held in memory, copied into a pool buffer for each
+    // frame it covers. Used when no pool buffer is free, so any number can be scheduled.
+    void setQpTable(int32_t frameIdx, std::vector<uint8_t> table)
+    {
         std::lock_guard<std::mutex> lock(m_qpTableMutex);
-        m_qpTables[frameIdx] = std::move(table);
+        m_qpTables[frameIdx] = QpTable { nullptr,
+            std::make_shared<std::vector<uint8_t> const>(std::move(table)) };
     }
 
     AL_ERR GetLastError(void)
@@ -304,6 +363,7 @@ struct EncoderSink
 
     std::unique_ptr<IFrameSink> RecOutput[MAX_NUM_REC_OUTPUT];
     DataCallback dataCallback_;
+    std::unique_ptr<TwoPassMngr> twoPassMngr;
     AL_HEncoder hEnc;
     bool shouldAddDummySei = false;
 
@@ -325,6 +385,7 @@ private:
     AL_TAllocator* pAllocator;
     AL_TEncSettings const* pSettings;
     ChangeSourceCallback m_changeSourceCB;
+    SourceReleasedCallback m_sourceReleasedCB;
     AL_TDimension tLastEncodedDim;
     AL_ERR m_EncoderLastError = AL_SUCCESS;
 
@@ -332,10 +393,17 @@ private:
     std::once_flag m_qpOnce;
     std::mutex m_roiMutex;
     bool m_qpTableRequired = false;
-    BufPool m_qpBufPool;
+    std::shared_ptr<BufPool> m_qpBufPool = std::make_shared<BufPool>(); ///< shared with the user's buffers
     std::shared_ptr<RoiManager> m_roiMngr;   ///< owned by VCUEncoder, shared here
-    std::mutex m_qpTableMutex;                            ///< guards m_qpTables
-    std::map<int32_t, std::vector<uint8_t>> m_qpTables;   ///< frame-scheduled raw QP tables (precede ROI)
+
+    // A scheduled user QP table: a pool buffer filled in place, or a copy of the table.
+    struct QpTable
+    {
+        std::shared_ptr<AL_TBuffer> buffer;
+        std::shared_ptr<std::vector<uint8_t> const> copy;
+    };
+    std::mutex m_qpTableMutex;                  ///< guards m_qpTables
+    std::map<int32_t, QpTable> m_qpTables;      ///< frame-scheduled raw QP tables (precede ROI)
     int m_iNumQPPerLCU = 1;
     int m_iNumBytesPerLCU = 1;
     int32_t m_iLcuQpOffset = 0;
@@ -358,10 +426,11 @@ private:
         AL_TDimension tDim { chn.uEncWidth, chn.uEncHeight };
         auto eCodec = static_cast<AL_ECodec>(AL_GET_CODEC(chn.eProfile));
 
-        int32_t bufCount = 2 /* g_defaultMinBuffers */ + GetNumBufForGop(*pSettings);
-        if (!m_qpBufPool.Init(pAllocator, bufCount,
-                              AL_GetAllocSizeEP2(tDim, eCodec, chn.uLog2MaxCuSize),
-                              nullptr, "qp-ext"))
+        int32_t bufCount = 2 /* g_defaultMinBuffers */ + GetNumBufForGop(*pSettings)
+                         + 4 /* user tables in effect, scheduled or being written */;
+        if (!m_qpBufPool->Init(pAllocator, bufCount,
+                               AL_GetAllocSizeEP2(tDim, eCodec, chn.uLog2MaxCuSize),
+                               nullptr, "qp-ext"))
             throw std::runtime_error("Failed to allocate QP-table buffer pool");
 
         // QP-table geometry (mirrors the reference GetQPBufferParameters).
@@ -395,33 +464,50 @@ private:
         }
 
         // A user-supplied QP table takes precedence over the ROI manager for the frames it
-        // covers (latest table scheduled at frame <= frameIdx). Hold the lock across the copy.
-        std::lock_guard<std::mutex> qpLock(m_qpTableMutex);
-        const std::vector<uint8_t>* pUserTable = nullptr;
-        for (auto const& kv : m_qpTables)
+        // covers (latest table scheduled at frame <= frameIdx). A pool buffer is attached as
+        // is, a copy is copied into a fresh one; the tables scheduled before it can no longer
+        // apply and are dropped.
+        QpTable userTable;
         {
-            if (kv.first <= frameIdx)
-                pUserTable = &kv.second;
-            else
-                break;
+            std::lock_guard<std::mutex> qpLock(m_qpTableMutex);
+            auto it = m_qpTables.upper_bound(frameIdx);
+            if (it != m_qpTables.begin())
+            {
+                --it;
+                userTable = it->second;
+                m_qpTables.erase(m_qpTables.begin(), it);
+            }
         }
 
-        if (!pUserTable && !roiMngr)
+        if (userTable.buffer)
+        {
+            AL_Buffer_Ref(userTable.buffer.get());
+            return userTable.buffer.get();
+        }
+
+        if (!userTable.copy && !roiMngr)
             return nullptr;
 
-        AL_TBuffer* pQpBuf = m_qpBufPool.GetBuffer();
+        AL_TBuffer* pQpBuf = m_qpBufPool->GetBuffer();
         if (!pQpBuf)
             throw std::runtime_error("Invalid QP-table buffer");
 
         uint8_t* pQPs = AL_Buffer_GetData(pQpBuf) + EP2_BUF_QP_BY_MB.Offset;
-        int32_t iSize = AL_RoundUp(m_iNumLCUs * m_iNumBytesPerLCU, 128);
-        std::memset(pQPs, 0, iSize);
+        int32_t iTableSize = m_iNumLCUs * m_iNumBytesPerLCU;
+        int32_t iSize = AL_RoundUp(iTableSize, 128);
 
-        if (pUserTable)
-            std::memcpy(pQPs, pUserTable->data(),
-                        std::min(static_cast<size_t>(iSize), pUserTable->size()));
+        if (userTable.copy)
+        {
+            std::memset(pQPs, 0, iSize);
+            std::memcpy(pQPs, userTable.copy->data(),
+                        std::min(static_cast<size_t>(iSize), userTable.copy->size()));
+        }
         else
+        {
+            // fillBuffer() writes the whole table; only the alignment padding needs clearing.
+            std::memset(pQPs + iTableSize, 0, iSize - iTableSize);
             roiMngr->fillBuffer(frameIdx, m_iNumQPPerLCU, m_iNumBytesPerLCU, pQPs, m_iLcuQpOffset);
+        }
 
         return pQpBuf;
     }
@@ -446,13 +532,44 @@ private:
     {
         auto pThis = (EncoderSink*)userParam;
 
-        if (isStreamReleased(pStream, pSrc) || isSourceReleased(pStream, pSrc))
+        // The encoder dropped its last reference to the source: only now can its memory be
+        // reused. With lookahead, two-pass or B-frames this comes after the stream is ready.
+        if (isSourceReleased(pStream, pSrc))
+        {
+            if (pThis->m_sourceReleasedCB)
+                pThis->m_sourceReleasedCB(pSrc);
+            return;
+        }
+
+        if (isStreamReleased(pStream, pSrc))
             return;
 
+        if (pThis->twoPassMngr && pThis->twoPassMngr->iPass == 1)
+            pThis->AddFirstPassFrame(pStream, pSrc);
+
         Ptr<Data> data = Data::create(pStream, pThis->hEnc);
         pThis->processOutput(data);
     }
 
+    // Log the first-pass statistics of an encoded frame; the end of stream flushes the log.
+    void AddFirstPassFrame(AL_TBuffer* pStream, AL_TBuffer const* pSrc)
+    {
+        if (pStream == EndOfStream)
+        {
+            twoPassMngr->Flush();
+            return;
+        }
+
+        auto pPicMeta = (AL_TPictureMetaData*)AL_Buffer_GetMetaData(pStream, AL_META_TYPE_PICTURE);
+
+        if (pPicMeta && pPicMeta->eType == AL_SLICE_REPEAT)
+            return;
+
+        auto pPictureMetaTP = (AL_TLookAheadMetaData*)AL_Buffer_GetMetaData(pSrc,
+                                                                            AL_META_TYPE_LOOKAHEAD);
+        twoPassMngr->AddFrame(pPictureMetaTP);
+    }
+
     void ComputeQualityMeasure(AL_TRateCtrlMetaData* pMeta)
     {
         if (!pMeta->bFilled)
@@ -652,8 +769,183 @@ private:
     }
 };
 
+// Stands in for EncoderSink on the software device (Device::isSoftware()). Each source picture
+// is written to the SoftCodec container by a worker thread, which plays the part of the
+// encoder callback thread, and goes back to its pool once written; the output goes through
+// the same DataCallback. A first pass logs the payload size of every picture, so the two-pass
+// plumbing runs without hardware. Nothing of EncoderSink runs here: no stream buffer pool,
+// ROI or QP table, dynamic command or source-released hook.
+struct SoftwareEncoderSink
+{
+    SoftwareEncoderSink(EncContext::Config const& cfg, DataCallback dataCallback)
+        : dataCallback_(dataCallback)
+    {
+        auto const& rc = cfg.Settings.tChParam[0].tRCParam;
+        fpsNum_ = rc.uFrameRate * 1000;
+        fpsDen_ = rc.uClkRatio;
+        if (cfg.Settings.TwoPass == 1)
+            twoPassMngr_.reset(new TwoPassMngr(cfg.sTwoPassFileName, 1, false,
+                cfg.Settings.tChParam[0].tGopParam.uGopLength, rc.uCPBSize / 90,
+                rc.uInitialRemDelay / 90, cfg.MainInput.FileInfo.FrameRate, true /* binary log */));
+        worker_ = std::thread(&SoftwareEncoderSink::run, this);
+    }
+
+    ~SoftwareEncoderSink()
+    {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            stop_ = true;
+        }
+        cv_.notify_all();
+        if (worker_.joinable())
+            worker_.join();
+        for (AL_TBuffer* pSrc : pending_)
+            if (pSrc)
+                AL_Buffer_Unref(pSrc);
+    }
+
+    void PreprocessFrame() {}
+
+    // Src == nullptr is the end of stream.
+    void ProcessFrame(AL_TBuffer* Src)
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (error_)
+            std::rethrow_exception(error_);
+        if (nrFrames_ == 0 && !startTime_)
+            startTime_ = GetPerfTime();
+        if (Src)
+        {
+            AL_Buffer_Ref(Src); // released once written, as the encoder does
+            nrFrames_++;
+        }
+        pending_.push_back(Src);
+        cv_.notify_all();
+    }
+
+    bool waitForCompletion(std::chrono::milliseconds timeout)
+    {
+        std::unique_lock<std::mutex> lock(mutex_);
+        if (timeout.count() <= 0)
+        {
+            cv_.wait(lock, [this] { return finished_; });
+            return true;
+        }
+        return cv_.wait_for(lock, timeout, [this] { return finished_; });
+    }
+
+    int fps() { return fps_; }
+    int nrFrames() { return nrFrames_; }
+
+private:
+    void run()
+    {
+        std::string picture;
+        uint32_t index = 0;
+
+        for (;;)
+        {
+            AL_TBuffer* pSrc = nullptr;
+            {
+                std::unique_lock<std::mutex> lock(mutex_);
+                cv_.wait(lock, [this] { return stop_ || !pending_.empty(); });
+                if (stop_)
+                    return;
+                pSrc = pending_.front();
+                pending_.pop_front();
+            }
+
+            if (!pSrc)
+            {
+                try
+                {
+                    if (twoPassMngr_)
+                        twoPassMngr_->Flush();
+                }
+                catch (...)
+                {
+                    std::lock_guard<std::mutex> lock(mutex_);
+                    error_ = std::current_exception();
+                }
+                break;
+            }
+
+            try
+            {
+                AL_TDimension const tDim = AL_PixMapBuffer_GetDimension(pSrc);
+                std::string_view streamHeader;
+                if (index == 0)
+                {
+                    header_ = SoftCodec::streamHeader(AL_PixMapBuffer_GetFourCC(pSrc),
+                        tDim.iWidth, tDim.iHeight, fpsNum_, fpsDen_);
+                    streamHeader = { (char const*)&header_, sizeof(header_) };
+                }
+
+                picture.clear();
+                SoftPictureHeader pictureHeader {};
+                picture.append((char const*)&pictureHeader, sizeof(pictureHeader));
+                pictureHeader.checksum = SoftCodec::pack(pSrc, picture);
+                pictureHeader.size = uint32_t(picture.size() - sizeof(pictureHeader));
+                pictureHeader.index = index++;
+                pictureHeader.width = tDim.iWidth;
+                pictureHeader.height = tDim.iHeight;
+                std::memcpy(&picture[0], &pictureHeader, sizeof(pictureHeader));
+                AL_Buffer_Unref(pSrc);
+
+                if (twoPassMngr_)
+                {
+                    AL_TLookAheadMetaData tMeta {};
+                    tMeta.iPictureSize = int32_t(pictureHeader.size);
+                    tMeta.iPercentIntra[0] = 100; // no picture references another one
+                    tMeta.eSceneChange = AL_SC_NONE;
+                    tMeta.iIPRatio = 1000;
+                    twoPassMngr_->AddFrame(&tMeta);
+                }
+
+                std::vector<std::string_view> vec;
+                if (!streamHeader.empty())
+                    vec.push_back(streamHeader);
+                vec.push_back(picture);
+                dataCallback_(vec);
+            }
+            catch (...)
+            {
+                std::lock_guard<std::mutex> lock(mutex_);
+                error_ = std::current_exception();
+                break;
+            }
+        }
+
+        std::lock_guard<std::mutex> lock(mutex_);
+        uint64_t const timeDiff = GetPerfTime() - startTime_;
+        fps_ = timeDiff > 0 ? static_cast<int>((nrFrames_ * 1000.0) / timeDiff) : 0;
+        finished_ = true;
+        cv_.notify_all();
+    }
+
+    DataCallback dataCallback_;
+    int fpsNum_;
+    int fpsDen_;
+    SoftStreamHeader header_ {};
+    std::unique_ptr<TwoPassMngr> twoPassMngr_; // first pass only, used by the worker thread
+
+    std::mutex mutex_;
+    std::condition_variable cv_;
+    std::deque<AL_TBuffer*> pending_; // nullptr marks the end of stream
+    bool stop_ = false;
+    bool finished_ = false;
+    std::exception_ptr error_;
+    int nrFrames_ = 0;
+    int fps_ = 0;
+    uint64_t startTime_ = 0;
+    std::thread worker_;
+};
+
 using Config = EncContext::Config;
 
+// Defined later in this file; the LookAhead sink sizes its pending FIFO to the source pool.
+int32_t GetSrcBufferCount(Config const& cfg);
+
 #include "vcuenclookahead.hpp"
 
 /*****************************************************************************/
@@ -685,6 +977,9 @@ struct LayerResources
     void Init(Config& cfg, AL_TEncoderInfo tEncInfo, int32_t iLayerID,
               AL_TAllocator* pAllocator, int32_t chanId);
 
+    // Source side only (inputs, conversion, source pool); Init() ends with it.
+    void InitSource(Config& cfg, int32_t iLayerID, AL_TAllocator* pAllocator);
+
     void PushResources(Config& cfg, EncoderSink* enc, EncoderLookAheadSink* encLA = nullptr);
 
     void OpenEncoderInput(Config& cfg, AL_HEncoder hEnc);
@@ -704,6 +999,8 @@ struct LayerResources
 
     void ChangeInput(Config& cfg, int32_t iInputIdx, AL_HEncoder hEnc);
 
+    void Rebind(Config& cfg);
+
     BufPool StreamBufPool;
     PixMapBufPool SrcBufPool;
 
@@ -768,6 +1065,26 @@ void ValidateConfig(Config& cfg)
     }
 }
 
+void PrepareConfig(Config& cfg)
+{
+    auto& Settings = cfg.Settings;
+
+    // Note: AL_Settings_SetDefaultParam, SetMoreDefaults, and eSrcMode settings
+    // are now called in vcuenc.cpp VCUEncoder constructor before creating EncoderContext
+
+    if (!cfg.RecFileName.empty())
+    {
+        Settings.tChParam[0].eEncOptions = (AL_EChEncOption)(Settings.tChParam[0].eEncOptions
+                                           | AL_OPT_FORCE_REC);
+    }
+
+    // TwoPass first pass: constant-QP, P-only statistics encode; its stream is not the output.
+    if (Settings.TwoPass == 1)
+        AL_TwoPassMngr_SetPass1Settings(Settings);
+
+    ValidateConfig(cfg);
+}
+
 /*****************************************************************************/
 std::shared_ptr<AL_TBuffer> AllocateConversionBuffer(int32_t iWidth, int32_t iHeight,
                                                             TFourCC tFourCC)
@@ -968,6 +1285,111 @@ uint8_t GetNumBufForGop(AL_TEncSettings Settings)
     return uNumFields * Settings.tChParam[0].tGopParam.uNumB + uAdditionalBuf;
 }
 
+/*****************************************************************************/
+int32_t GetSrcBufferCount(Config const& cfg)
+{
+    AL_TEncSettings const& Settings = cfg.Settings;
+    int32_t srcBuffersCount = g_defaultMinBuffers + GetNumBufForGop(Settings);
+
+    if (Settings.LookAhead > 0)
+    {
+        srcBuffersCount += Settings.LookAhead + GetNumBufForGop(Settings) * 2;
+        if (AL_IS_AVC(Settings.tChParam[0].eProfile))
+            srcBuffersCount += 1;
+    }
+
+    // Room for the frames writeFile() reads ahead of the encoder.
+    return srcBuffersCount + cfg.iFileReadAhead;
+}
+
+/*****************************************************************************/
+// True when the stream and source pools built for cur can serve next unchanged: same
+// dimensions, formats, buffer counts and per-buffer metadata.
+bool IsPoolCompatible(Config const& cur, Config const& next)
+{
+    AL_TEncChanParam const& a = cur.Settings.tChParam[0];
+    AL_TEncChanParam const& b = next.Settings.tChParam[0];
+
+    return a.uSrcWidth == b.uSrcWidth && a.uSrcHeight == b.uSrcHeight
+        && a.uEncWidth == b.uEncWidth && a.uEncHeight == b.uEncHeight
+        && a.ePicFormat == b.ePicFormat && a.uSrcBitDepth == b.uSrcBitDepth
+        && a.eSrcMode == b.eSrcMode
+        && a.eProfile == b.eProfile && a.uLevel == b.uLevel
+        && a.uLog2MaxCuSize == b.uLog2MaxCuSize
+        && a.bSubframeLatency == b.bSubframeLatency && a.uNumSlices == b.uNumSlices
+        && GetNumBufForGop(cur.Settings) == GetNumBufForGop(next.Settings)
+        && cur.Settings.LookAhead == next.Settings.LookAhead
+        && cur.Settings.TwoPass == next.Settings.TwoPass
+        && cur.iForceStreamBufSize == next.iForceStreamBufSize
+        && cur.iFileReadAhead == next.iFileReadAhead
+        && cur.MainInput.FileInfo.FourCC == next.MainInput.FileInfo.FourCC
+        && cur.eSrcFormat == next.eSrcFormat
+        && cur.RunInfo.printPictureType == next.RunInfo.printPictureType
+        && cur.RunInfo.rateCtrlStat == next.RunInfo.rateCtrlStat;
+}
+
+/*****************************************************************************/
+// Asks the kernel to page in the next frames of a raw YUV file ahead of the frame reader, so
+// writeFile() reads are served from the page cache instead of waiting on the disk.
+class YuvFileReadAhead
+{
+public:
+    YuvFileReadAhead(std::string const& sFileName, AL_TYUVFileInfo const& FileInfo,
+                     int32_t iDepth)
+        : iDepth(iDepth)
+    {
+        AL_TPicFormat tPicFmt;
+        AL_GetPicFormat(FileInfo.FourCC, &tPicFmt);
+
+        // Planar/semi-planar size; packed formats are slightly overestimated, which is fine
+        // for a hint.
+        int64_t iSampleSize = tPicFmt.uBitDepth > 8 ? 2 : 1;
+        int64_t iLumaSize = int64_t(FileInfo.PictWidth) * FileInfo.PictHeight * iSampleSize;
+        switch (tPicFmt.eChromaMode)
+        {
+        case AL_CHROMA_4_0_0: iFrameSize = iLumaSize; break;
+        case AL_CHROMA_4_2_0: iFrameSize = iLumaSize + iLumaSize / 2; break;
+        case AL_CHROMA_4_2_2: iFrameSize = iLumaSize * 2; break;
+        default:              iFrameSize = iLumaSize * 3; break;
+        }
+
+        if (iDepth > 0 && iFrameSize > 0)
+            iFd = open(sFileName.c_str(), O_RDONLY | O_CLOEXEC);
+
+        if (iFd >= 0)
+            posix_fadvise(iFd, 0, 0, POSIX_FADV_SEQUENTIAL);
+    }
+
+    ~YuvFileReadAhead()
+    {
+        if (iFd >= 0)
+            close(iFd);
+    }
+
+    // Called before reading iFrame; hints frames [iFrame, iFrame + iDepth] not hinted yet.
+    void Advance(int64_t iFrame)
+    {
+        if (iFd < 0)
+            return;
+
+        int64_t iFirst = std::max(iFrame, iNextHint);
+        int64_t iEnd = iFrame + iDepth + 1;
+
+        if (iFirst >= iEnd)
+            return;
+
+        posix_fadvise(iFd, iFirst * iFrameSize, (iEnd - iFirst) * iFrameSize,
+                      POSIX_FADV_WILLNEED);
+        iNextHint = iEnd;
+    }
+
+private:
+    int iFd = -1;
+    int32_t iDepth;
+    int64_t iFrameSize = 0;
+    int64_t iNextHint = 0;
+};
+
 /*****************************************************************************/
 bool InitStreamBufPool(BufPool& pool, AL_TEncSettings& Settings, int32_t iLayerID,
     uint8_t uNumCore, int32_t iForcedStreamBufferSize, AL_TAllocator* pAllocator)
@@ -1058,15 +1480,8 @@ void LayerResources::Init(Config& cfg, AL_TEncoderInfo tEncInfo, int32_t iLayerI
                           AL_TAllocator* pAllocator, int32_t chanId)
 {
     AL_TEncSettings& Settings = cfg.Settings;
-    auto const eSrcMode = Settings.tChParam[iLayerID].eSrcMode;
 
     (void)chanId;
-    this->iLayerID = iLayerID;
-
-    {
-        layerInputs.push_back(cfg.MainInput);
-        layerInputs.insert(layerInputs.end(), cfg.DynamicInputs.begin(), cfg.DynamicInputs.end());
-    }
 
     // --------------------------------------------------------------------------------
     // Stream Buffers
@@ -1081,6 +1496,7 @@ void LayerResources::Init(Config& cfg, AL_TEncoderInfo tEncInfo, int32_t iLayerI
     bool bUsePictureMeta = false;
     bUsePictureMeta |= cfg.RunInfo.printPictureType;
     bUsePictureMeta |= (Settings.LookAhead > 0);
+    bUsePictureMeta |= (Settings.TwoPass == 1);
 
     if (iLayerID == 0 && bUsePictureMeta)
     {
@@ -1111,6 +1527,22 @@ void LayerResources::Init(Config& cfg, AL_TEncoderInfo tEncInfo, int32_t iLayerI
         AL_MetaData_Destroy(pMeta);
     }
 
+    InitSource(cfg, iLayerID, pAllocator);
+}
+
+/*****************************************************************************/
+void LayerResources::InitSource(Config& cfg, int32_t iLayerID, AL_TAllocator* pAllocator)
+{
+    AL_TEncSettings& Settings = cfg.Settings;
+    auto const eSrcMode = Settings.tChParam[iLayerID].eSrcMode;
+
+    this->iLayerID = iLayerID;
+
+    {
+        layerInputs.push_back(cfg.MainInput);
+        layerInputs.insert(layerInputs.end(), cfg.DynamicInputs.begin(), cfg.DynamicInputs.end());
+    }
+
     // --------------------------------------------------------------------------------
     // Application Input/Output Format conversion
     // --------------------------------------------------------------------------------
@@ -1132,14 +1564,7 @@ void LayerResources::Init(Config& cfg, AL_TEncoderInfo tEncInfo, int32_t iLayerI
     // --------------------------------------------------------------------------------
     // Source Buffers
     // --------------------------------------------------------------------------------
-    int32_t srcBuffersCount = g_defaultMinBuffers + GetNumBufForGop(Settings);
-
-    if (Settings.LookAhead > 0)
-    {
-        srcBuffersCount += Settings.LookAhead + GetNumBufForGop(Settings) * 2;
-        if (AL_IS_AVC(Settings.tChParam[0].eProfile))
-            srcBuffersCount += 1;
-    }
+    int32_t srcBuffersCount = GetSrcBufferCount(cfg);
 
     InitSrcBufPool(SrcBufPool, pAllocator, tSrcFrameInfo, eSrcMode, srcBuffersCount,
                    static_cast<AL_ECodec>(AL_GET_CODEC(Settings.tChParam[0].eProfile)));
@@ -1187,6 +1612,22 @@ void LayerResources::PushResources(Config& cfg, EncoderSink* enc, EncoderLookAhe
     }
 }
 
+void LayerResources::Rebind(Config& cfg)
+{
+    // Keep the pools and converter; only the per-session input state starts over.
+    layerInputs.clear();
+    layerInputs.push_back(cfg.MainInput);
+    layerInputs.insert(layerInputs.end(), cfg.DynamicInputs.begin(), cfg.DynamicInputs.end());
+
+    frameReader.reset();
+    YuvFile.close();
+    MapFile.close();
+
+    iInputIdx = 0;
+    iPictCount = 0;
+    iReadCount = 0;
+}
+
 [[maybe_unused]] void LayerResources::OpenEncoderInput(Config& cfg, AL_HEncoder hEnc)
 {
     ChangeInput(cfg, iInputIdx, hEnc);
@@ -1297,27 +1738,62 @@ public:
     virtual void writeBuf(AL_TBuffer* pBuf) override;
     virtual void eos() override;
     virtual std::shared_ptr<AL_TBuffer> getSharedBuffer() override;
-    virtual bool waitForCompletion() override;
+    virtual bool waitForCompletion(std::chrono::milliseconds timeout) override;
     virtual void notifyGMV(int32_t frameIndex, int32_t gmVectorX, int32_t gmVectorY) override;
     virtual int setHDRSEIs(const HDRSEIs& hdrSeis) override;
     virtual String statistics() const override;
-    virtual AL_HEncoder hEnc() override { return enc_->hEnc; }
+    virtual AL_HEncoder hEnc() override { return enc_ ? enc_->hEnc : nullptr; }
 
     virtual void setRoiManager(std::shared_ptr<RoiManager> roiManager) override
     {
         if (enc_) enc_->setRoiManager(std::move(roiManager));
     }
 
+    virtual std::shared_ptr<AL_TBuffer> getQpTableBuffer() override
+    {
+        std::shared_ptr<AL_TBuffer> table = enc_ ? enc_->getQpTableBuffer() : nullptr;
+        if (!table)
+            return nullptr;
+
+        // The table keeps its pool alive; keep the device that allocated the pool as well.
+        Ptr<Device> device = device_;
+        return std::shared_ptr<AL_TBuffer>(table.get(),
+            [table, device](AL_TBuffer*) mutable
+            {
+                table.reset();
+                device.reset();
+            });
+    }
+
+    virtual void commitQpTable(int32_t frameIdx, std::shared_ptr<AL_TBuffer> table) override
+    {
+        if (enc_) enc_->commitQpTable(frameIdx, std::move(table));
+    }
+
     virtual void setQpTable(int32_t frameIdx, std::vector<uint8_t> table) override
     {
         if (enc_) enc_->setQpTable(frameIdx, std::move(table));
     }
 
+    virtual uint64_t channelGeneration() const override { return generation_; }
+
     virtual void setFrameCommandHook(FrameCommandHook hook) override
     {
         frameCommandHook_ = std::move(hook);
     }
 
+    virtual void setFileFrameReader(FileFrameReader reader) override
+    {
+        fileFrameReader_ = std::move(reader);
+    }
+
+    virtual void setSourceReleasedHook(SourceReleasedHook hook) override
+    {
+        sourceReleasedHook_ = std::move(hook);
+    }
+
+    virtual void reset(Ptr<Config> cfg) override;
+
 private:
     class EncLibInitter
     {
@@ -1360,10 +1836,25 @@ private:
 
     std::unique_ptr<EncoderSink> channelMain(Config& cfg,
         std::vector<std::unique_ptr<LayerResources>>& pLayerResources,
-        Ptr<Device> device, int32_t chanId, DataCallback dataCallback);
+        Ptr<Device> device, int32_t chanId, DataCallback dataCallback, bool bReusePools = false);
+
+    // Software device: only the source pool is allocated, pictures go to softEnc_.
+    void channelSoftware(Config& cfg, Ptr<Device> device);
 
     // File queue processing
     void processFileQueue();
+    void stopFileWorker();
+
+    // A frame read (and converted) by the file worker, waiting to be submitted in order.
+    struct PrefetchedFrame {
+        std::shared_ptr<AL_TBuffer> buffer; // nullptr marks the end of the file queue
+        AL_TDimension tDim;                 // source dimension of the file it was read from
+        bool bFirstOfFile;
+    };
+
+    bool pushPrefetched(PrefetchedFrame frame);
+    void submitPrefetched();
+    void submitFileFrame(PrefetchedFrame const& frame);
 
     // File request structure for queuing
     struct FileRequest {
@@ -1374,13 +1865,20 @@ private:
     };
 
     std::shared_ptr<EncLibInitter> libInit_;
+    Ptr<Config> cfg_;          // referenced by the sinks, kept alive until the channel is gone
+    Ptr<Device> device_;
+    DataCallback dataCallback_;
     std::unique_ptr<EncoderSink> enc_;
     std::unique_ptr<EncoderLookAheadSink> encLA_;
+    std::unique_ptr<SoftwareEncoderSink> softEnc_;
     std::vector<std::unique_ptr<LayerResources>> layerResources_;
+    std::atomic<uint64_t> generation_{0};   // bumped by reset(), see channelGeneration()
 
     void submitFrame(AL_TBuffer* Src)
     {
-        if (encLA_)
+        if (softEnc_)
+            softEnc_->ProcessFrame(Src);
+        else if (encLA_)
             encLA_->ProcessFrame(Src);
         else
             enc_->ProcessFrame(Src);
@@ -1391,6 +1889,12 @@ private:
     FrameCommandHook frameCommandHook_;
     int32_t fileFrameIndex_ = 0;
 
+    // File frame reader (see EncContext::setFileFrameReader), called by the file worker.
+    FileFrameReader fileFrameReader_;
+
+    // Source release hook (see EncContext::setSourceReleasedHook), called by enc_.
+    SourceReleasedHook sourceReleasedHook_;
+
     // File queue members
     std::queue<FileRequest> fileQueue_;
     std::mutex fileQueueMutex_;
@@ -1399,38 +1903,49 @@ private:
     std::atomic<bool> stopProcessing_{false};
     std::atomic<bool> fileWorkerStarted_{false};
     std::exception_ptr fileWorkerException_;
+
+    // Read-ahead between the file worker (disk read + conversion) and the submit thread
+    // (encoder); bounded by Config::iFileReadAhead. Unused when read-ahead is 0.
+    std::deque<PrefetchedFrame> prefetchQueue_;
+    std::mutex prefetchMutex_;
+    std::condition_variable prefetchCV_;
+    bool prefetchAbort_ = false;
+    std::exception_ptr submitException_;
 };
 
 
 EncoderContext::EncoderContext(Ptr<Config> cfg, Ptr<Device>& device, DataCallback dataCallback)
+    : cfg_(cfg), dataCallback_(dataCallback)
 {
     layerResources_.emplace_back(std::make_unique<LayerResources>());
 
     InitializePlateform();
 
-    {
-        auto& Settings = cfg->Settings;
-        auto& RecFileName = cfg->RecFileName;
-
-        // Note: AL_Settings_SetDefaultParam, SetMoreDefaults, and eSrcMode settings
-        // are now called in vcuenc.cpp VCUEncoder constructor before creating EncoderContext
-
-        if (!RecFileName.empty())
-        {
-            Settings.tChParam[0].eEncOptions = (AL_EChEncOption)(Settings.tChParam[0].eEncOptions
-                                               | AL_OPT_FORCE_REC);
-        }
-
-        ValidateConfig(*cfg);
-    }
+    PrepareConfig(*cfg);
 
     libInit_ = EncLibInitter::getInstance();
 
-    device = Device::create(Device::ENCODER);
-    enc_ = channelMain(*cfg, layerResources_, device, 0, dataCallback);
+    AL_TRCParam const& tRCParam = cfg->Settings.tChParam[0].tRCParam;
+    double fps = tRCParam.uClkRatio ? tRCParam.uFrameRate * 1000.0 / tRCParam.uClkRatio : 0.0;
+    device = Device::create(Device::ENCODER, fps);
+    device_ = device;
+    if (device->isSoftware())
+        channelSoftware(*cfg, device);
+    else
+        enc_ = channelMain(*cfg, layerResources_, device, 0, dataCallback);
 }
 
 EncoderContext::~EncoderContext()
+{
+    stopFileWorker();
+
+    enc_.reset();
+    encLA_.reset();   // destroy the LookAhead first-pass encoder before its buffer pools
+    softEnc_.reset();
+    layerResources_[0].reset();
+}
+
+void EncoderContext::stopFileWorker()
 {
     // Stop file worker thread if running
     if (fileWorkerStarted_.load()) {
@@ -1443,10 +1958,42 @@ EncoderContext::~EncoderContext()
             fileWorkerThread_.join();
         }
     }
+}
+
+void EncoderContext::reset(Ptr<Config> cfg)
+{
+    stopFileWorker();
+    {
+        std::lock_guard<std::mutex> lock(fileQueueMutex_);
+        fileQueue_ = std::queue<FileRequest>();
+        stopProcessing_.store(false);
+    }
+    fileWorkerStarted_.store(false);
+    fileWorkerException_ = nullptr;
+    fileFrameIndex_ = 0;
+    prefetchQueue_.clear();
+    prefetchAbort_ = false;
+    submitException_ = nullptr;
+
+    PrepareConfig(*cfg);
 
+    bool bReusePools = IsPoolCompatible(*cfg_, *cfg);
+
+    // Only the channel is re-created: the device and library stay up, and the pools too when
+    // the new session can use them as they are. Encoders go first, they hold pool buffers.
     enc_.reset();
-    encLA_.reset();   // destroy the LookAhead first-pass encoder before its buffer pools
-    layerResources_[0].reset();
+    encLA_.reset();
+    softEnc_.reset();
+    generation_++;
+
+    if (!bReusePools || device_->isSoftware())
+        layerResources_[0] = std::make_unique<LayerResources>();
+
+    cfg_ = cfg;
+    if (device_->isSoftware())
+        channelSoftware(*cfg_, device_);
+    else
+        enc_ = channelMain(*cfg_, layerResources_, device_, 0, dataCallback_, bReusePools);
 }
 
 void EncoderContext::writeFrame(Ptr<Frame> frame)
@@ -1516,10 +2063,28 @@ void EncoderContext::eos()
 
 void EncoderContext::processFileQueue()
 {
+    int32_t const iReadAhead = cfg_->iFileReadAhead;
+
+    // With read-ahead, frames are handed to a submit thread so that disk read and conversion
+    // of the next frames overlap the encoding of the current one. When the read-ahead depth
+    // is 0 (the default), this thread reads and submits each frame.
+    std::thread submitThread;
+    if (iReadAhead > 0)
+        submitThread = std::thread(&EncoderContext::submitPrefetched, this);
+
+    auto emit = [&](PrefetchedFrame frame)
+    {
+        if (iReadAhead > 0)
+            return pushPrefetched(std::move(frame));
+        submitFileFrame(frame);
+        return true;
+    };
+
     try {
         LayerResources& layer = *layerResources_[0];
+        bool bAborted = false;
 
-        while (true) {
+        while (!bAborted) {
             FileRequest request;
 
             // Wait for work or stop signal
@@ -1553,16 +2118,6 @@ void EncoderContext::processFileQueue()
             fileInfo.PictHeight = pic.height;
             fileInfo.FrameRate = pic.framerate;
 
-            // Notify the encoder only on an actual resolution change. An unconditional
-            // SetInputResolution triggers a GOP restart, which the library rejects for GOP
-            // modes that disallow it (e.g. ADAPTIVE_GOP -> AL_ERR_CMD_NOT_ALLOWED, "Command is
-            // not allowed", printed once per frame). The channel is already configured at this
-            // resolution, so skip the redundant call when the dimensions are unchanged.
-            AL_TDimension tNewDim = { fileInfo.PictWidth, fileInfo.PictHeight };
-            AL_TDimension tCurDim = enc_->currentSrcDim();
-            if (tNewDim.iWidth != tCurDim.iWidth || tNewDim.iHeight != tCurDim.iHeight)
-                AL_Encoder_SetInputResolution(enc_->hEnc, tNewDim);
-
             // Open the YUV file
             std::ifstream yuvFile;
             OpenInput(yuvFile, request.filename);
@@ -1571,12 +2126,14 @@ void EncoderContext::processFileQueue()
                 throw std::runtime_error("Failed to open input file: " + request.filename);
             }
 
-            // Create frame reader using the file's format
+            YuvFileReadAhead readAhead(request.filename, fileInfo, iReadAhead);
+
+            // Create frame reader using the file's format; a file frame reader seeks itself.
             std::unique_ptr<FrameReader> frameReader(
                 new UnCompFrameReader(yuvFile, fileInfo, false /* no loop */));
 
             // Seek to start frame if specified
-            if (request.startFrame > 0) {
+            if (request.startFrame > 0 && !fileFrameReader_) {
                 frameReader->SeekAbsolute(request.startFrame);
             }
 
@@ -1599,15 +2156,22 @@ void EncoderContext::processFileQueue()
 
             std::unique_ptr<IConvSrc> pSrcConv;
             std::shared_ptr<AL_TBuffer> srcYuv;
-            if (IsConversionNeeded(tSrcConverterParams)) {
+            if (IsConversionNeeded(tSrcConverterParams) && !fileFrameReader_) {
                 pSrcConv = AllocateSrcConverter(tSrcConverterParams, srcYuv);
             }
 
+            // A file frame reader fills the source buffers at the dimensions of the pool.
             AL_TDimension tUpdatedDim = { fileInfo.PictWidth, fileInfo.PictHeight };
+            if (fileFrameReader_) {
+                tUpdatedDim = { AL_GetSrcWidth(cfg_->Settings.tChParam[0]),
+                                AL_GetSrcHeight(cfg_->Settings.tChParam[0]) };
+            }
 
             // Process frames from this file
             int framesProcessed = 0;
             while (framesProcessed < framesToProcess) {
+                readAhead.Advance(int64_t(request.startFrame) + framesProcessed);
+
                 // Get source buffer from pool
                 std::shared_ptr<AL_TBuffer> sourceBuffer = layer.SrcBufPool.GetSharedBuffer();
                 if (!sourceBuffer) {
@@ -1615,30 +2179,26 @@ void EncoderContext::processFileQueue()
                 }
 
                 // Read frame
-                bool frameRead = ReadSourceFrameBuffer(
-                    sourceBuffer.get(),
-                    srcYuv.get(),
-                    frameReader,
-                    tUpdatedDim,
-                    pSrcConv.get());
+                bool frameRead = fileFrameReader_
+                    ? fileFrameReader_(yuvFile, pic, int64_t(request.startFrame) + framesProcessed,
+                                       sourceBuffer)
+                    : ReadSourceFrameBuffer(
+                        sourceBuffer.get(),
+                        srcYuv.get(),
+                        frameReader,
+                        tUpdatedDim,
+                        pSrcConv.get());
 
                 if (!frameRead) {
                     // End of file reached
                     break;
                 }
 
-                // Apply any dynamic commands (HDR SEIs, QP, scene change, ...) scheduled for
-                // this encode-order frame before submitting it. Frame mode (write()) drains the
-                // command queue itself; the file worker must do it here since it pulls frames
-                // straight from the YUV file.
-                if (frameCommandHook_) {
-                    frameCommandHook_(fileFrameIndex_);
+                if (!emit({ std::move(sourceBuffer), tUpdatedDim, framesProcessed == 0 })) {
+                    bAborted = true;  // the submit thread failed; its error is reported below
+                    break;
                 }
-
-                // Send frame to encoder (via LookAhead first pass when enabled).
-                submitFrame(sourceBuffer.get());
                 framesProcessed++;
-                fileFrameIndex_++;
             }
 
             yuvFile.close();
@@ -1646,6 +2206,91 @@ void EncoderContext::processFileQueue()
     } catch (...) {
         fileWorkerException_ = std::current_exception();
     }
+
+    if (submitThread.joinable()) {
+        {
+            // The end marker is always accepted, whatever the queue depth.
+            std::lock_guard<std::mutex> lock(prefetchMutex_);
+            prefetchQueue_.push_back({ nullptr, {}, false });
+        }
+        prefetchCV_.notify_all();
+        submitThread.join();
+
+        if (!fileWorkerException_)
+            fileWorkerException_ = submitException_;
+    }
+}
+
+bool EncoderContext::pushPrefetched(PrefetchedFrame frame)
+{
+    std::unique_lock<std::mutex> lock(prefetchMutex_);
+    prefetchCV_.wait(lock, [this] {
+        return prefetchAbort_ || (int)prefetchQueue_.size() < cfg_->iFileReadAhead;
+    });
+
+    if (prefetchAbort_)
+        return false;
+
+    prefetchQueue_.push_back(std::move(frame));
+    lock.unlock();
+    prefetchCV_.notify_all();
+    return true;
+}
+
+void EncoderContext::submitPrefetched()
+{
+    try {
+        while (true) {
+            PrefetchedFrame frame;
+            {
+                std::unique_lock<std::mutex> lock(prefetchMutex_);
+                prefetchCV_.wait(lock, [this] { return !prefetchQueue_.empty(); });
+                frame = std::move(prefetchQueue_.front());
+                prefetchQueue_.pop_front();
+            }
+            prefetchCV_.notify_all();
+
+            if (!frame.buffer)
+                return;
+
+            submitFileFrame(frame);
+        }
+    } catch (...) {
+        // Stop the reader and hand the prefetched buffers back to the pool it may wait on.
+        {
+            std::lock_guard<std::mutex> lock(prefetchMutex_);
+            submitException_ = std::current_exception();
+            prefetchAbort_ = true;
+            prefetchQueue_.clear();
+        }
+        prefetchCV_.notify_all();
+    }
+}
+
+void EncoderContext::submitFileFrame(PrefetchedFrame const& frame)
+{
+    // Notify the encoder only on an actual resolution change. An unconditional
+    // SetInputResolution triggers a GOP restart, which the library rejects for GOP
+    // modes that disallow it (e.g. ADAPTIVE_GOP -> AL_ERR_CMD_NOT_ALLOWED, "Command is
+    // not allowed", printed once per frame). The channel is already configured at this
+    // resolution, so skip the redundant call when the dimensions are unchanged.
+    if (frame.bFirstOfFile && enc_) {
+        AL_TDimension tCurDim = enc_->currentSrcDim();
+        if (frame.tDim.iWidth != tCurDim.iWidth || frame.tDim.iHeight != tCurDim.iHeight)
+            AL_Encoder_SetInputResolution(enc_->hEnc, frame.tDim);
+    }
+
+    // Apply any dynamic commands (HDR SEIs, QP, scene change, ...) scheduled for
+    // this encode-order frame before submitting it. Frame mode (write()) drains the
+    // command queue itself; the file worker must do it here since it pulls frames
+    // straight from the YUV file.
+    if (frameCommandHook_) {
+        frameCommandHook_(fileFrameIndex_);
+    }
+
+    // Send frame to encoder (via LookAhead first pass when enabled).
+    submitFrame(frame.buffer.get());
+    fileFrameIndex_++;
 }
 
 std::shared_ptr<AL_TBuffer> EncoderContext::getSharedBuffer()
@@ -1653,15 +2298,18 @@ std::shared_ptr<AL_TBuffer> EncoderContext::getSharedBuffer()
     return layerResources_[0]->SrcBufPool.GetSharedBuffer();
 }
 
-bool EncoderContext::waitForCompletion()
+bool EncoderContext::waitForCompletion(std::chrono::milliseconds timeout)
 {
-    return enc_->waitForCompletion();
+    if (softEnc_)
+        return softEnc_->waitForCompletion(timeout);
+    return enc_->waitForCompletion(timeout);
 }
 
 void EncoderContext::notifyGMV(int32_t frameIndex, int32_t gmVectorX, int32_t gmVectorY)
 {
 #ifdef HAVE_VCU2_CTRLSW
-    AL_Encoder_NotifyGMV(enc_->hEnc, frameIndex, gmVectorX, gmVectorY);
+    if (enc_)
+        AL_Encoder_NotifyGMV(enc_->hEnc, frameIndex, gmVectorX, gmVectorY);
 #else
     (void)frameIndex;
     (void)gmVectorX;
@@ -1671,6 +2319,8 @@ void EncoderContext::notifyGMV(int32_t frameIndex, int32_t gmVectorX, int32_t gm
 
 int EncoderContext::setHDRSEIs(const HDRSEIs& hdrSeis)
 {
+    if (!enc_)
+        return 0;
     AL_THDRSEIs tHDRSEIs = {};
     convert(tHDRSEIs, hdrSeis);
     return AL_Encoder_SetHDRSEIs(enc_->hEnc, &tHDRSEIs);
@@ -1683,12 +2333,24 @@ String EncoderContext::statistics() const
         stats += std::to_string(enc_->nrFrames()) + " pictures encoded\n";
         stats += "Average FrameRate = " + std::to_string(enc_->fps()) + " Fps\n";
     }
+    else if (softEnc_) {
+        stats += std::to_string(softEnc_->nrFrames()) + " pictures encoded (software)\n";
+        stats += "Average FrameRate = " + std::to_string(softEnc_->fps()) + " Fps\n";
+    }
+    if (device_)
+        stats += device_->cacheStatistics();
     return stats;
 }
 
+void EncoderContext::channelSoftware(Config& cfg, Ptr<Device> device)
+{
+    layerResources_[0]->InitSource(cfg, 0, device->getAllocator());
+    softEnc_.reset(new SoftwareEncoderSink(cfg, dataCallback_));
+}
+
 std::unique_ptr<EncoderSink> EncoderContext::channelMain(Config& cfg,
         std::vector<std::unique_ptr<LayerResources>>& pLayerResources,
-        Ptr<Device> device, int32_t chanId, DataCallback dataCallback)
+        Ptr<Device> device, int32_t chanId, DataCallback dataCallback, bool bReusePools)
 {
     [[maybe_unused]] auto& Settings = cfg.Settings;
 
@@ -1726,6 +2388,15 @@ std::unique_ptr<EncoderSink> EncoderContext::channelMain(Config& cfg,
 
     EncoderSink* pFirstEncoderSink = enc.get();
 
+    if (Settings.TwoPass > 0)
+    {
+        auto const& chn = Settings.tChParam[0];
+        enc->twoPassMngr.reset(new TwoPassMngr(cfg.sTwoPassFileName, Settings.TwoPass,
+            Settings.bEnableFirstPassSceneChangeDetection, chn.tGopParam.uGopLength,
+            chn.tRCParam.uCPBSize / 90, chn.tRCParam.uInitialRemDelay / 90,
+            cfg.MainInput.FileInfo.FrameRate, true /* binary log */, cfg.bTwoPassGlobal));
+    }
+
     if (cfg.Settings.LookAhead > 0)
     {
 #ifdef HAVE_VCU2_CTRLSW
@@ -1744,7 +2415,10 @@ std::unique_ptr<EncoderSink> EncoderContext::channelMain(Config& cfg,
     for (size_t i = 0; i < pLayerResources.size(); i++)
     {
         auto multisinkRec = std::unique_ptr<MultiSink>(new MultiSink);
-        pLayerResources[i]->Init(cfg, tEncInfo, i, pAllocator, chanId);
+        if (bReusePools)
+            pLayerResources[i]->Rebind(cfg);
+        else
+            pLayerResources[i]->Init(cfg, tEncInfo, i, pAllocator, chanId);
         pLayerResources[i]->PushResources(cfg, enc.get(), encLA_.get());
 
         // Rec file creation
@@ -1783,6 +2457,11 @@ std::unique_ptr<EncoderSink> EncoderContext::channelMain(Config& cfg,
                            {
                                 pLayerResources[iLayerID]->ChangeInput(cfg, iInputIdx, enc->hEnc);
                            });
+    enc->SetSourceReleasedCallback([this](AL_TBuffer const* pSrc)
+                           {
+                                if (sourceReleasedHook_)
+                                    sourceReleasedHook_(pSrc);
+                           });
 
     OnScopeExit.release();
     return enc;
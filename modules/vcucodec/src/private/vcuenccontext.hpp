@@ -36,6 +36,8 @@ extern "C"
 #include "lib_common_enc/RateCtrlMeta.h"
 }
 
+#include <chrono>
+#include <istream>
 #include <memory>
 #include <vector>
 
@@ -63,7 +65,8 @@ public:
     virtual void writeBuf(AL_TBuffer* pBuf) = 0;
     virtual void eos() = 0;  // Signal end of stream for file mode
     virtual std::shared_ptr<AL_TBuffer> getSharedBuffer() = 0;
-    virtual bool waitForCompletion() = 0;
+    // Wait until the encoder has drained after EOS; a zero timeout waits indefinitely.
+    virtual bool waitForCompletion(std::chrono::milliseconds timeout) = 0;
     virtual void notifyGMV(int32_t frameIndex, int32_t gmVectorX, int32_t gmVectorY) = 0;
     virtual int setHDRSEIs(const HDRSEIs& hdrSeis) = 0;
     virtual String statistics() const = 0;
@@ -73,9 +76,18 @@ public:
     // per-frame relative QP-table attached to each encoded frame. Pass nullptr to disable.
     virtual void setRoiManager(std::shared_ptr<RoiManager> roiManager) = 0;
 
-    // QP table: supply a raw per-LCU QP table effective from frameIdx onward. It takes
-    // precedence over ROI for the frames it covers; bytes follow the EP2 QP-by-MB layout.
+    // QP table: get a zeroed buffer from the QP-table pool for the caller to fill in place
+    // (bytes at EP2_BUF_QP_BY_MB.Offset, EP2 QP-by-MB layout), then commit it as the table in
+    // effect from frameIdx onward. It takes precedence over ROI for the frames it covers and
+    // is attached to them as is, without copies; it must not be modified once committed.
+    // getQpTableBuffer() returns nullptr when there is no QP-table path or no free buffer;
+    // setQpTable() then schedules a copy instead, which needs no buffer until it applies.
+    // A buffer may outlive the channel, but is committed only to the channel it came from,
+    // identified by channelGeneration().
+    virtual std::shared_ptr<AL_TBuffer> getQpTableBuffer() = 0;
+    virtual void commitQpTable(int32_t frameIdx, std::shared_ptr<AL_TBuffer> table) = 0;
     virtual void setQpTable(int32_t frameIdx, std::vector<uint8_t> table) = 0;
+    virtual uint64_t channelGeneration() const = 0;
 
     // Per-frame command hook: invoked by the file worker (writeFile mode) with the 0-based
     // encode-order index just before each frame is submitted, so scheduled dynamic commands
@@ -84,6 +96,29 @@ public:
     using FrameCommandHook = std::function<void(int32_t frameIndex)>;
     virtual void setFrameCommandHook(FrameCommandHook hook) = 0;
 
+    // File frame reader: when set, the file worker reads the frames of writeFile() requests
+    // through it rather than through the ctrl-sw frame reader, e.g. to scale them first. It
+    // fills dst with frame frameIdx of the raw file pic describes and returns false past the
+    // end of the file. dst has the dimensions of the source pool; read-ahead still applies.
+    using FileFrameReader = std::function<bool(std::istream& file, PictureEncSettings const& pic,
+                                               int64_t frameIdx,
+                                               std::shared_ptr<AL_TBuffer> const& dst)>;
+    virtual void setFileFrameReader(FileFrameReader reader) = 0;
+
+    // Source release hook: invoked from the encoder callback thread with each source buffer
+    // the encoder has dropped (the source-released EndEncoding event, which can come well after
+    // the stream of its picture), so that memory lent to the buffer
+    // (VCUEncoder::writeFrameDmaBuf) goes back to its owner right then. Set it before the first
+    // frame; it is never called on the software device.
+    using SourceReleasedHook = std::function<void(AL_TBuffer const* pSrc)>;
+    virtual void setSourceReleasedHook(SourceReleasedHook hook) = 0;
+
+    // Re-create the encoder channel for a new session with cfg, keeping the device, and bump
+    // channelGeneration(). The buffer pools are kept as well when cfg needs the same
+    // resolution, formats and buffer counts.
+    // The current stream must have been drained (eos) before calling this.
+    virtual void reset(Ptr<Config> cfg) = 0;
+
     static Ptr<EncContext> create(Ptr<Config> cfg, Ptr<Device>& device, DataCallback dataCallback);
 };
 
@@ -146,6 +181,9 @@ struct EncContext::Config
     AL_TEncSettings Settings; ///< Rate control and other encoder settings
     ConfigRunInfo RunInfo;    ///< Runtime information
     int32_t iForceStreamBufSize = 0; ///< Force stream buffer size (0 = automatic)
+    int32_t iFileReadAhead = 0; ///< Frames read and converted ahead of the encoder in file mode
+    std::string sTwoPassFileName; ///< TwoPass log: written by pass 1, read by pass 2
+    bool bTwoPassGlobal = true; ///< Pass 2 allocates over the whole log instead of windows
 };
 
 } // namespace vcucodec
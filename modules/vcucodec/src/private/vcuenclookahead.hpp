@@ -1,7 +1,10 @@
 #pragma once
 
-#include <deque>
+#include <condition_variable>
+#include <exception>
+#include <mutex>
 #include <stdexcept>
+#include <thread>
 
 #include "TwoPassMngr.h"
 
@@ -9,11 +12,18 @@
 // gather look-ahead metadata (scene change, complexity, intra ratio), keeps the source
 // frames in a FIFO, then forwards them - metadata attached - to the second-pass
 // EncoderSink referenced by next. Mirrors the reference exe_encoder EncoderLookAheadSink.
+//
+// The LookAhead stage runs on its own thread: the first-pass EndEncoding callback only
+// queues the finished source frame, so a second-pass submission that waits for encoder
+// resources never holds up the first-pass encoder. Both FIFOs are fixed-capacity rings
+// sized at creation: the pending one to the source pool, the LookAhead one to
+// LookAhead + 1 frames.
 struct EncoderLookAheadSink
 {
 #ifdef HAVE_VCU2_CTRLSW
     EncoderLookAheadSink(EncContext::Config const& cfg, AL_RiscV_Ctx ctx, AL_TAllocator* pAllocator)
-        : lookAheadMngr(cfg.Settings.LookAhead, cfg.Settings.bEnableFirstPassSceneChangeDetection)
+        : lookAheadMngr(cfg.Settings.LookAhead, cfg.Settings.bEnableFirstPassSceneChangeDetection),
+          pending(GetSrcBufferCount(cfg))
     {
         m_Settings = cfg.Settings;
         AL_TwoPassMngr_SetPass1Settings(m_Settings);
@@ -23,11 +33,13 @@ struct EncoderLookAheadSink
         if (AL_IS_ERROR_CODE(err))
             throw en_codec_error(AL_Codec_ErrorToString(err), err);
         EOSFinished = Rtos_CreateEvent(false);
+        stageThread = std::thread(&EncoderLookAheadSink::StageLoop, this);
     }
 #endif
 
     EncoderLookAheadSink(EncContext::Config const& cfg, AL_IEncScheduler* pScheduler, AL_TAllocator* pAllocator)
-        : lookAheadMngr(cfg.Settings.LookAhead, cfg.Settings.bEnableFirstPassSceneChangeDetection)
+        : lookAheadMngr(cfg.Settings.LookAhead, cfg.Settings.bEnableFirstPassSceneChangeDetection),
+          pending(GetSrcBufferCount(cfg))
     {
         m_Settings = cfg.Settings;
         AL_TwoPassMngr_SetPass1Settings(m_Settings);
@@ -37,17 +49,31 @@ struct EncoderLookAheadSink
         if (AL_IS_ERROR_CODE(err))
             throw en_codec_error(AL_Codec_ErrorToString(err), err);
         EOSFinished = Rtos_CreateEvent(false);
+        stageThread = std::thread(&EncoderLookAheadSink::StageLoop, this);
     }
 
     ~EncoderLookAheadSink(void)
     {
-        // Release any source buffers still queued in the FIFO before the pools are gone.
-        while (lookAheadMngr.m_fifo.size() > 0)
         {
-            AL_Buffer_Unref(lookAheadMngr.m_fifo.front());
-            lookAheadMngr.m_fifo.pop_front();
+            std::lock_guard<std::mutex> lock(mutex);
+            bStop = true;
         }
+        cv.notify_one();
+        if (stageThread.joinable())
+            stageThread.join();
         AL_Encoder_Destroy(hEnc);
+
+        // Release the source buffers still queued in either FIFO before the pools are gone.
+        while (!pending.empty())
+        {
+            AL_Buffer_Unref(pending.front());
+            pending.pop_front();
+        }
+        while (!lookAheadMngr.m_fifo.empty())
+        {
+            AL_Buffer_Unref(lookAheadMngr.m_fifo.front());
+            lookAheadMngr.Pop();
+        }
         Rtos_DeleteEvent(EOSFinished);
     }
 
@@ -55,6 +81,7 @@ struct EncoderLookAheadSink
 
     void ProcessFrame(AL_TBuffer* Src)
     {
+        rethrowStageError();
         if (Src)
         {
             auto pMetaLA = (AL_TLookAheadMetaData*)AL_Buffer_GetMetaData(Src, AL_META_TYPE_LOOKAHEAD);
@@ -72,8 +99,9 @@ struct EncoderLookAheadSink
         {
             if (AL_Encoder_Process(hEnc, NULL, NULL) == false)
                 throw std::runtime_error("Failed LookAhead flush");
+            // Set by the stage thread once the FIFO is drained and EOS forwarded to next.
             Rtos_WaitEvent(EOSFinished, AL_WAIT_FOREVER);
-            ProcessFifo(true);
+            rethrowStageError();
         }
     }
 
@@ -82,9 +110,17 @@ struct EncoderLookAheadSink
 
 private:
     AL_TEncSettings m_Settings;
-    LookAheadMngr lookAheadMngr;
+    LookAheadMngr lookAheadMngr; // stage thread only
     AL_EVENT EOSFinished;
-    int iNumFrameEnded = 0;
+
+    // First-pass callback -> stage thread handoff, guarded by mutex.
+    RingFifo<AL_TBuffer*> pending;
+    bool bEndOfStream = false;
+    bool bStop = false;
+    std::mutex mutex;
+    std::condition_variable cv;
+    std::exception_ptr stageError;
+    std::thread stageThread;
 
     static bool isStreamReleased(AL_TBuffer* pStream, AL_TBuffer const* pSrc) { return pStream && (pSrc == NULL); }
     static bool isSourceReleased(AL_TBuffer* pStream, AL_TBuffer const* pSrc) { return (pStream == NULL) && pSrc; }
@@ -110,43 +146,95 @@ private:
             AL_Encoder_ReleaseRecPicture(hEnc, &RecPic);
     }
 
+    // First-pass callback thread: queue the frame for the stage thread and return.
     void AddFifo(AL_TBuffer* pSrc, AL_TBuffer* pStream)
     {
-        if (pSrc == NULL)
+        if (pSrc)
         {
-            Rtos_SetEvent(EOSFinished);
-            return;
+            if (pStream == NULL)
+                return;
+            auto pPicMeta = (AL_TPictureMetaData*)AL_Buffer_GetMetaData(pStream, AL_META_TYPE_PICTURE);
+            if (pPicMeta && pPicMeta->eType == AL_SLICE_REPEAT)
+                return;
         }
-        if (pStream == NULL)
-            return;
-        auto pPicMeta = (AL_TPictureMetaData*)AL_Buffer_GetMetaData(pStream, AL_META_TYPE_PICTURE);
-        if (pPicMeta && pPicMeta->eType == AL_SLICE_REPEAT)
-            return;
-        AL_Buffer_Ref(pSrc);
-        lookAheadMngr.m_fifo.push_back(pSrc);
-        ProcessFifo(false);
-        ++iNumFrameEnded;
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            if (stageError)
+                return; // the stage has stopped, ProcessFrame() reports its error
+            if (pSrc)
+            {
+                // The encoder drops its reference once this callback returns; this one is
+                // kept until the frame is handed to the second pass.
+                AL_Buffer_Ref(pSrc);
+                pending.push_back(pSrc);
+            }
+            else
+                bEndOfStream = true;
+        }
+        cv.notify_one();
     }
 
-    void ProcessFifo(bool isEOS)
+    void StageLoop()
     {
-        int iLASize = lookAheadMngr.uLookAheadSize;
-        if (isEOS && lookAheadMngr.m_fifo.size() == 0)
+        try
         {
-            next->PreprocessFrame();
-            next->ProcessFrame(NULL);
+            for (;;)
+            {
+                AL_TBuffer* pSrc = NULL;
+                {
+                    std::unique_lock<std::mutex> lock(mutex);
+                    cv.wait(lock, [this] { return bStop || bEndOfStream || !pending.empty(); });
+                    if (bStop)
+                        return;
+                    if (!pending.empty())
+                    {
+                        pSrc = pending.front();
+                        pending.pop_front();
+                    }
+                }
+
+                if (pSrc == NULL)
+                {
+                    Drain();
+                    break;
+                }
+
+                lookAheadMngr.Push(pSrc);
+                if (lookAheadMngr.m_fifo.size() > lookAheadMngr.uLookAheadSize)
+                    ForwardFront();
+            }
         }
-        else if ((lookAheadMngr.m_fifo.size() > 0) && (isEOS || iNumFrameEnded == iLASize))
+        catch (...)
         {
-            iNumFrameEnded--;
-            lookAheadMngr.ProcessLookAheadParams();
-            AL_TBuffer* pSrc = lookAheadMngr.m_fifo.front();
-            lookAheadMngr.m_fifo.pop_front();
-            next->PreprocessFrame();
-            next->ProcessFrame(pSrc);
-            AL_Buffer_Unref(pSrc);
-            if (isEOS)
-                ProcessFifo(isEOS);
+            std::lock_guard<std::mutex> lock(mutex);
+            stageError = std::current_exception();
         }
+        Rtos_SetEvent(EOSFinished);
+    }
+
+    // End of stream: forward every remaining frame, then EOS.
+    void Drain()
+    {
+        while (!lookAheadMngr.m_fifo.empty())
+            ForwardFront();
+        next->PreprocessFrame();
+        next->ProcessFrame(NULL);
+    }
+
+    void ForwardFront()
+    {
+        lookAheadMngr.ProcessLookAheadParams();
+        AL_TBuffer* pSrc = lookAheadMngr.m_fifo.front();
+        lookAheadMngr.Pop();
+        next->PreprocessFrame();
+        next->ProcessFrame(pSrc);
+        AL_Buffer_Unref(pSrc);
+    }
+
+    void rethrowStageError()
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        if (stageError)
+            std::rethrow_exception(stageError);
     }
 };
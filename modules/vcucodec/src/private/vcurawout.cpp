@@ -95,6 +95,7 @@ void RawOutputImpl::configure(int fourcc, unsigned int bitDepth, int max_frames)
 
     iBitDepth = bitDepth;
     uMaxFrames = max_frames;
+    uNumFrames = 0;
 }
 
 
@@ -8,8 +8,13 @@
 #include "vcuroimanager.hpp"
 
 #include <algorithm>
-#include <list>
+#include <cstring>
+#include <iterator>
 #include <stdexcept>
+#include <unordered_set>
+
+#include "opencv2/core/hal/intrin.hpp"
+#include "opencv2/core/utility.hpp"
 
 extern "C" {
 #include "lib_common/SliceConsts.h"
@@ -121,6 +126,111 @@ inline void setLCUQuality(T* pLCUQP, uint16_t uROIQP)
     }
 }
 
+/****************************************************************************/
+// setLCUQuality() as a bitwise select: *pLCUQP = (*pLCUQP & keep) | set.
+template<typename T>
+inline void getLCUQualityMask(uint16_t uROIQP, T& keep, T& set)
+{
+    if(uROIQP & MASK_FORCE_INTRA)
+    {
+        keep = (T)MASK_QP;
+        set = (T)MASK_FORCE_INTRA;
+    }
+    else if(uROIQP & MASK_FORCE_MV0)
+    {
+        keep = 0;
+        set = (T)uROIQP;
+    }
+    else
+    {
+        keep = (T)MASK_FORCE_INTRA;
+        set = (T)uROIQP;
+    }
+}
+
+/****************************************************************************/
+// Byte masks for a run of LCUs, repeated every iNumBytesPerLCU bytes over SPAN_PATTERN_BYTES.
+constexpr int32_t SPAN_PATTERN_BYTES = 64;
+
+struct SpanMask
+{
+    alignas(16) uint8_t keep[SPAN_PATTERN_BYTES];
+    alignas(16) uint8_t set[SPAN_PATTERN_BYTES];
+};
+
+/****************************************************************************/
+// @p iNumEntries entries of type T at the start of each LCU get the quality, the other bytes
+// are left untouched.
+template<typename T>
+void initSpanMask(SpanMask& tMask, uint16_t uROIQP, int32_t iNumBytesPerLCU, int32_t iNumEntries)
+{
+    T keep, set;
+    getLCUQualityMask<T>(uROIQP, keep, set);
+
+    std::memset(tMask.keep, 0xFF, sizeof(tMask.keep));
+    std::memset(tMask.set, 0, sizeof(tMask.set));
+
+    for(int32_t iOffset = 0; iOffset < SPAN_PATTERN_BYTES; iOffset += iNumBytesPerLCU)
+    {
+        for(int32_t i = 0; i < iNumEntries; ++i)
+        {
+            std::memcpy(&tMask.keep[iOffset + i * sizeof(T)], &keep, sizeof(T));
+            std::memcpy(&tMask.set[iOffset + i * sizeof(T)], &set, sizeof(T));
+        }
+    }
+}
+
+/****************************************************************************/
+// Apply the quality of @p tMask to @p iNumLCUs consecutive LCUs. BYTES_PER_LCU is a power of
+// two dividing SPAN_PATTERN_BYTES, so a vector at a multiple of max(BYTES_PER_LCU, 16) bytes
+// always sees the same part of the pattern.
+template<int32_t BYTES_PER_LCU>
+void fillSpan(uint8_t* pLCU, int32_t iNumLCUs, const SpanMask& tMask)
+{
+    static_assert(SPAN_PATTERN_BYTES % BYTES_PER_LCU == 0, "LCU size must divide the pattern");
+
+    size_t uSize = static_cast<size_t>(iNumLCUs) * BYTES_PER_LCU;
+    size_t i = 0;
+
+#if CV_SIMD128
+    constexpr size_t PERIOD = BYTES_PER_LCU > 16 ? BYTES_PER_LCU : 16;
+
+    for(; i + PERIOD <= uSize; i += PERIOD)
+    {
+        for(size_t j = 0; j < PERIOD; j += 16)
+        {
+            v_uint8x16 v = v_load(pLCU + i + j);
+            v = (v & v_load(tMask.keep + j)) | v_load(tMask.set + j);
+            v_store(pLCU + i + j, v);
+        }
+    }
+#endif
+
+    for(; i < uSize; ++i)
+    {
+        size_t j = i % SPAN_PATTERN_BYTES;
+        pLCU[i] = (pLCU[i] & tMask.keep[j]) | tMask.set[j];
+    }
+}
+
+/****************************************************************************/
+typedef void (*FillSpanFunc)(uint8_t* pLCU, int32_t iNumLCUs, const SpanMask& tMask);
+
+// Kernels for the QP table layouts of AVC / HEVC 16x16 (1 or 4 bytes per LCU), HEVC 32x32
+// (8 bytes) and HEVC 64x64 (32 bytes). Other layouts, and cv::setUseOptimized(false),
+// use the generic loop of computeROI().
+FillSpanFunc getFillSpanFunc(int32_t iNumBytesPerLCU)
+{
+    switch(iNumBytesPerLCU)
+    {
+    case 1: return fillSpan<1>;
+    case 4: return fillSpan<4>;
+    case 8: return fillSpan<8>;
+    case 32: return fillSpan<32>;
+    default: return nullptr;
+    }
+}
+
 } // anonymous namespace
 
 /****************************************************************************/
@@ -152,10 +262,8 @@ RoiManager::~RoiManager()
 /****************************************************************************/
 RoiManager::RegionDef* RoiManager::find(int32_t id)
 {
-    for(auto& r : regions_)
-        if(r.id == id)
-            return &r;
-    return nullptr;
+    auto it = regions_.find(id);
+    return it == regions_.end() ? nullptr : &it->second;
 }
 
 /****************************************************************************/
@@ -164,6 +272,72 @@ bool RoiManager::activeAt(const RegionDef& region, int32_t frameIdx) const
     return frameIdx >= region.enableFrame && frameIdx < region.disableFrame;
 }
 
+/****************************************************************************/
+// Bring the active set up to date with @p region at currentFrame_ and queue its future
+// boundaries. Boundaries left behind by earlier schedules are harmless: advance() re-evaluates
+// the region against its current window when they are reached.
+void RoiManager::schedule(const RegionDef& region)
+{
+    if(activeAt(region, currentFrame_))
+        active_.insert(region.id);
+    else
+        active_.erase(region.id);
+
+    if(region.enableFrame > currentFrame_ && region.enableFrame != INT32_MAX)
+        events_.emplace(region.enableFrame, region.id);
+    if(region.disableFrame > currentFrame_ && region.disableFrame != INT32_MAX)
+        events_.emplace(region.disableFrame, region.id);
+}
+
+/****************************************************************************/
+// Move currentFrame_ to @p frameIdx, updating the active set from the boundaries crossed and
+// dropping what can no longer apply: expired one-shot regions and superseded order changes.
+void RoiManager::advance(int32_t frameIdx)
+{
+    if(frameIdx < currentFrame_)
+        rebuildActive(frameIdx);
+
+    currentFrame_ = frameIdx;
+
+    while(!events_.empty() && events_.begin()->first <= frameIdx)
+    {
+        int32_t id = events_.begin()->second;
+        events_.erase(events_.begin());
+        if(RegionDef* r = find(id))
+        {
+            if(activeAt(*r, frameIdx))
+                active_.insert(id);
+            else
+                active_.erase(id);
+        }
+    }
+
+    while(!frameRegions_.empty() && frameRegions_.begin()->first < frameIdx)
+    {
+        for(int32_t id : frameRegions_.begin()->second)
+        {
+            regions_.erase(id);
+            active_.erase(id);
+        }
+        frameRegions_.erase(frameRegions_.begin());
+    }
+
+    auto it = orderChanges_.upper_bound(frameIdx);
+    if(it != orderChanges_.begin())
+        orderChanges_.erase(orderChanges_.begin(), std::prev(it));
+}
+
+/****************************************************************************/
+// Frames normally only move forward; going back re-derives the active set from scratch.
+void RoiManager::rebuildActive(int32_t frameIdx)
+{
+    currentFrame_ = frameIdx;
+    active_.clear();
+    events_.clear();
+    for(auto const& entry : regions_)
+        schedule(entry.second);
+}
+
 /****************************************************************************/
 RoiManager::Node RoiManager::toNode(const RegionDef& region) const
 {
@@ -196,10 +370,49 @@ int32_t RoiManager::addRegion(int32_t posX, int32_t posY, int32_t width, int32_t
     region.background = background;
     region.enableFrame = INT32_MAX;   // starts disabled
     region.disableFrame = INT32_MAX;
-    regions_.push_back(region);
+    region.oneShot = false;
+    regions_.emplace(region.id, region);
     return region.id;
 }
 
+/****************************************************************************/
+void RoiManager::setFrameRegions(int32_t frameIdx, const std::vector<FrameRegion>& regions)
+{
+    std::lock_guard<std::mutex> lock(mtx_);
+    std::vector<int32_t>& ids = frameRegions_[frameIdx];
+    for(int32_t id : ids)
+    {
+        regions_.erase(id);
+        active_.erase(id);
+    }
+    ids.clear();
+
+    // Nothing to keep for a frame that was already filled.
+    if(frameIdx < currentFrame_)
+    {
+        frameRegions_.erase(frameIdx);
+        return;
+    }
+
+    for(auto const& fr : regions)
+    {
+        RegionDef region;
+        region.id = nextId_++;
+        region.posX = fr.posX;
+        region.posY = fr.posY;
+        region.width = fr.width;
+        region.height = fr.height;
+        region.qualityCode = fr.qualityCode;
+        region.background = false;
+        region.enableFrame = frameIdx;
+        region.disableFrame = frameIdx + 1;
+        region.oneShot = true;
+        regions_.emplace(region.id, region);
+        ids.push_back(region.id);
+        schedule(region);
+    }
+}
+
 /****************************************************************************/
 void RoiManager::enableRegion(int32_t id, int32_t frameIdx)
 {
@@ -208,6 +421,7 @@ void RoiManager::enableRegion(int32_t id, int32_t frameIdx)
     {
         r->enableFrame = frameIdx;
         r->disableFrame = INT32_MAX;
+        schedule(*r);
     }
 }
 
@@ -216,24 +430,32 @@ void RoiManager::disableRegion(int32_t id, int32_t frameIdx)
 {
     std::lock_guard<std::mutex> lock(mtx_);
     if(RegionDef* r = find(id))
+    {
         r->disableFrame = frameIdx;
+        schedule(*r);
+    }
+}
+
+/****************************************************************************/
+void RoiManager::removeRegion(int32_t id)
+{
+    std::lock_guard<std::mutex> lock(mtx_);
+    regions_.erase(id);
+    active_.erase(id);
 }
 
 /****************************************************************************/
 void RoiManager::setOrder(int32_t frameIdx, RoiOrder order)
 {
     std::lock_guard<std::mutex> lock(mtx_);
-    orderChanges_.emplace_back(frameIdx, order);
+    orderChanges_[frameIdx] = order;
 }
 
 /****************************************************************************/
 bool RoiManager::isActive(int32_t id) const
 {
     std::lock_guard<std::mutex> lock(mtx_);
-    for(auto const& r : regions_)
-        if(r.id == id)
-            return currentFrame_ >= r.enableFrame && currentFrame_ < r.disableFrame;
-    return false;
+    return active_.count(id) != 0;
 }
 
 /****************************************************************************/
@@ -312,33 +534,58 @@ void RoiManager::computeROI(int32_t iNumQPPerLCU, int32_t iNumBytesPerLCU, uint8
     if(bIsAOM && !(region.iDeltaQP & MASK_FORCE))
         uDeltaQPOrSegId = getSegmentId(pDeltaQpSegments, region.iDeltaQP);
 
-    /* Fill ROI */
-    for(int32_t h = 0; h < region.iHeight; ++h)
+    /* Fill ROI, cv::setUseOptimized(false) keeps the generic loop as a reference */
+    FillSpanFunc fillSpanFunc = nullptr;
+
+    if(!bIsAOM && cv::useOptimized() && (iLcuQpOffset || iNumQPPerLCU <= iNumBytesPerLCU))
+        fillSpanFunc = getFillSpanFunc(iNumBytesPerLCU);
+
+    if(fillSpanFunc)
     {
-        for(int32_t w = 0; w < region.iWidth; ++w)
+        SpanMask tMask;
+
+        if(iLcuQpOffset)
+            initSpanMask<uint16_t>(tMask, region.iDeltaQP, iNumBytesPerLCU, 1);
+        else
+            initSpanMask<uint8_t>(tMask, ((MASK_FORCE & region.iDeltaQP) >> (MASK_QP_NUMBITS - 6))
+                                  | region.iDeltaQP, iNumBytesPerLCU, iNumQPPerLCU);
+
+        for(int32_t h = 0; h < region.iHeight; ++h)
         {
-            if(iLcuQpOffset)
+            fillSpanFunc(pLCU, region.iWidth, tMask);
+            pLCU += iNumBytesPerLCU * iLcuPicWidth;
+        }
+    }
+    else
+    {
+        for(int32_t h = 0; h < region.iHeight; ++h)
+        {
+            for(int32_t w = 0; w < region.iWidth; ++w)
             {
-                uint16_t uQPOrSegIdAndFlags = region.iDeltaQP;
+                if(iLcuQpOffset)
+                {
+                    uint16_t uQPOrSegIdAndFlags = region.iDeltaQP;
 
-                if(bIsAOM)
-                    uQPOrSegIdAndFlags = region.iDeltaQP & MASK_FORCE;
-                setLCUQuality<uint16_t>((uint16_t*)(pLCU + w * iNumBytesPerLCU), uQPOrSegIdAndFlags);
-            }
+                    if(bIsAOM)
+                        uQPOrSegIdAndFlags = region.iDeltaQP & MASK_FORCE;
+                    setLCUQuality<uint16_t>((uint16_t*)(pLCU + w * iNumBytesPerLCU),
+                                            uQPOrSegIdAndFlags);
+                }
 
-            if(!iLcuQpOffset || bIsAOM)
-            {
-                for(int32_t i = 0; i < iNumQPPerLCU - iLcuQpOffset; ++i)
+                if(!iLcuQpOffset || bIsAOM)
                 {
-                    uDeltaQPOrSegId = ((MASK_FORCE & region.iDeltaQP) >> (MASK_QP_NUMBITS - 6))
-                                      | uDeltaQPOrSegId;
-                    setLCUQuality<uint8_t>(pLCU + w * iNumBytesPerLCU + iLcuQpOffset + i,
-                                           uDeltaQPOrSegId);
+                    for(int32_t i = 0; i < iNumQPPerLCU - iLcuQpOffset; ++i)
+                    {
+                        uDeltaQPOrSegId = ((MASK_FORCE & region.iDeltaQP) >> (MASK_QP_NUMBITS - 6))
+                                          | uDeltaQPOrSegId;
+                        setLCUQuality<uint8_t>(pLCU + w * iNumBytesPerLCU + iLcuQpOffset + i,
+                                               uDeltaQPOrSegId);
+                    }
                 }
             }
-        }
 
-        pLCU += iNumBytesPerLCU * iLcuPicWidth;
+            pLCU += iNumBytesPerLCU * iLcuPicWidth;
+        }
     }
 
     if(!(region.iDeltaQP & MASK_FORCE))
@@ -402,6 +649,113 @@ void RoiManager::computeROI(int32_t iNumQPPerLCU, int32_t iNumBytesPerLCU, uint8
     }
 }
 
+/****************************************************************************/
+void RoiManager::fillBackground(int32_t iNumQPPerLCU, int32_t iNumBytesPerLCU, uint8_t* pQPs,
+                                int32_t iLcuQpOffset, uint16_t uDeltaQP, uint16_t uBkgQPOrSegId,
+                                int32_t iRowBegin, int32_t iRowEnd)
+{
+    if(iRowBegin >= iRowEnd)
+        return;
+
+    /* All background LCUs are identical: build the first one, then replicate it. */
+    uint8_t* pFirst = pQPs + static_cast<size_t>(iRowBegin) * iLcuPicWidth * iNumBytesPerLCU;
+    size_t uSize = static_cast<size_t>(iRowEnd - iRowBegin) * iLcuPicWidth * iNumBytesPerLCU;
+
+    /* Bytes not written below (reserved fields, unused sub-blocks) must read as 0. */
+    std::memset(pFirst, 0, iNumBytesPerLCU);
+
+    /* iLcuQpOffset distinguishes QP Table V1 (0) from V2 (4). */
+    if(iLcuQpOffset)
+    {
+        /* For HEVC & AVC, fill only the info of the macro-block, reused for all sub-blocks. */
+        if(!bIsAOM)
+            pFirst[0] = uBkgQPOrSegId & MASK_QP;
+        pFirst[1] = (uDeltaQP & MASK_FORCE) >> 8;
+        pFirst[3] = DEFAULT_LAMBDA_FACT;
+    }
+
+    if(!iLcuQpOffset || bIsAOM)
+    {
+        for(int32_t iQP = iLcuQpOffset; iQP < iNumQPPerLCU; ++iQP)
+            pFirst[iQP] = ((MASK_FORCE & uDeltaQP) >> (MASK_QP_NUMBITS - 6)) | uBkgQPOrSegId;
+    }
+
+    for(size_t uDone = iNumBytesPerLCU; uDone < uSize;)
+    {
+        size_t uCopy = std::min(uDone, uSize - uDone);
+        std::memcpy(pFirst + uDone, pFirst, uCopy);
+        uDone += uCopy;
+    }
+}
+
+/****************************************************************************/
+// Rows a region reads or writes: its own rows plus the two rows of transition above and
+// below it (see computeROI() and updateTransitionHorz()).
+void RoiManager::markRows(const Node& node, std::vector<bool>& rows) const
+{
+    int32_t iBegin = std::max(0, node.iPosY - 2);
+    int32_t iEnd = std::min<int32_t>(iLcuPicHeight, node.iPosY + node.iHeight + 2);
+    for(int32_t iRow = iBegin; iRow < iEnd; ++iRow)
+        rows[iRow] = true;
+}
+
+/****************************************************************************/
+bool RoiManager::touchesRows(const Node& node, const std::vector<bool>& rows) const
+{
+    int32_t iBegin = std::max(0, node.iPosY - 2);
+    int32_t iEnd = std::min<int32_t>(iLcuPicHeight, node.iPosY + node.iHeight + 2);
+    for(int32_t iRow = iBegin; iRow < iEnd; ++iRow)
+        if(rows[iRow])
+            return true;
+    return false;
+}
+
+/****************************************************************************/
+// Compute the LCU rows to regenerate when going from the cached region list to @p ids.
+// Starts from the rows of the added and removed regions and grows until no remaining region
+// straddles the border, so that every region is either refilled entirely (in fill order) or
+// not at all, which keeps the result identical to a full regeneration. Returns false when a
+// full regeneration is needed because the fill order of the kept regions changed.
+bool RoiManager::findDirtyRows(const std::vector<int32_t>& ids, const std::vector<Node>& nodes,
+                               std::vector<bool>& rows) const
+{
+    std::unordered_set<int32_t> oldIds(cache_.ids.begin(), cache_.ids.end());
+    std::unordered_set<int32_t> newIds(ids.begin(), ids.end());
+
+    std::vector<int32_t> oldKept;
+    std::vector<int32_t> newKept;
+    for(int32_t id : cache_.ids)
+        if(newIds.count(id))
+            oldKept.push_back(id);
+    for(int32_t id : ids)
+        if(oldIds.count(id))
+            newKept.push_back(id);
+    if(oldKept != newKept)
+        return false;
+
+    rows.assign(iLcuPicHeight, false);
+    for(size_t i = 0; i < cache_.ids.size(); ++i)
+        if(!newIds.count(cache_.ids[i]))
+            markRows(cache_.nodes[i], rows);
+    for(size_t i = 0; i < ids.size(); ++i)
+        if(!oldIds.count(ids[i]))
+            markRows(nodes[i], rows);
+
+    std::vector<bool> included(nodes.size(), false);
+    for(bool bGrown = true; bGrown;)
+    {
+        bGrown = false;
+        for(size_t i = 0; i < nodes.size(); ++i)
+            if(!included[i] && touchesRows(nodes[i], rows))
+            {
+                markRows(nodes[i], rows);
+                included[i] = true;
+                bGrown = true;
+            }
+    }
+    return true;
+}
+
 /****************************************************************************/
 // Per-LCU QP-table entry layout written below. Each LCU occupies iNumBytesPerLCU
 // bytes; the first 32-bit word holds:
@@ -422,99 +776,134 @@ void RoiManager::fillBuffer(int32_t frameIdx, int32_t iNumQPPerLCU, int32_t iNum
         throw std::runtime_error("pQPs buffer must exist");
 
     std::lock_guard<std::mutex> lock(mtx_);
-    currentFrame_ = frameIdx;
+    advance(frameIdx);
 
     // Resolve the overlap order scheduled for this frame (latest change with frame <= frameIdx).
     RoiOrder order = eDefaultOrder;
-    int32_t bestOrderFrame = -1;
-    for(auto const& oc : orderChanges_)
-        if(oc.first <= frameIdx && oc.first >= bestOrderFrame)
-        {
-            bestOrderFrame = oc.first;
-            order = oc.second;
-        }
+    auto orderIt = orderChanges_.upper_bound(frameIdx);
+    if(orderIt != orderChanges_.begin())
+        order = std::prev(orderIt)->second;
 
     // Resolve the background: the most-recently-enabled active background wins, else default.
     int bkgCode = eDefaultBkgQuality;
-    int32_t bestBkgFrame = -1;
-    for(auto const& r : regions_)
-        if(r.background && activeAt(r, frameIdx) && r.enableFrame >= bestBkgFrame)
+    int32_t bestBkgFrame = INT32_MIN;
+    for(int32_t id : active_)
+    {
+        const RegionDef& r = regions_.at(id);
+        if(r.background && r.enableFrame >= bestBkgFrame)
         {
             bestBkgFrame = r.enableFrame;
             bkgCode = r.qualityCode;
         }
+    }
 
     // Build the ordered list of active foreground regions (snapped to the LCU grid).
-    std::list<Node> nodes;
-    for(auto const& r : regions_)
+    std::vector<int32_t> ids;
+    std::vector<Node> nodes;
+    for(int32_t id : active_)
     {
-        if(r.background || !activeAt(r, frameIdx))
+        const RegionDef& r = regions_.at(id);
+        if(r.background)
             continue;
         if(r.posX >= iPicWidth || r.posY >= iPicHeight)
             continue;
 
         Node node = toNode(r);
+        size_t pos = nodes.size();
         if(order == RoiOrder::QUALITY)
         {
             // Keep higher-quality (lower-QP) regions ahead so they win on overlap.
             auto it = std::find_if(nodes.begin(), nodes.end(),
                     [&](const Node& c) { return !shouldInsertAfter(c.iDeltaQP, node.iDeltaQP); });
-            nodes.insert(it, node);
+            pos = it - nodes.begin();
         }
-        else
-            nodes.push_back(node);
+        nodes.insert(nodes.begin() + pos, node);
+        ids.insert(ids.begin() + pos, r.id);
     }
 
     uint16_t uDeltaQP = getNewDeltaQP(bkgCode);
     uint16_t uBkgQPOrSegId = uDeltaQP;
+    size_t tableSize = static_cast<size_t>(iNumLCUs) * iNumBytesPerLCU;
 
-    if(bIsAOM)
+    // The AOM segment table lives in front of pQPs and is rescaled in place below, so AOM
+    // tables are always generated from scratch.
+    bool bReusable = !bIsAOM && cache_.valid && cache_.numQpPerLcu == iNumQPPerLCU &&
+                     cache_.numBytesPerLcu == iNumBytesPerLCU &&
+                     cache_.lcuQpOffset == iLcuQpOffset && cache_.order == order &&
+                     cache_.bkgQualityCode == bkgCode;
+
+    if(bReusable && cache_.ids == ids)
     {
-        pDeltaQpSegments = (int16_t*)(pQPs - EP2_BUF_SEG_CTRL.Size);
-        pDeltaQpSegments[0] = Q_HIGH;
-        pDeltaQpSegments[1] = -3;
-        pDeltaQpSegments[2] = Q_MEDIUM;
-        pDeltaQpSegments[3] = 3;
-        pDeltaQpSegments[4] = Q_LOW;
-        pDeltaQpSegments[5] = 10;
-        pDeltaQpSegments[6] = 15;
-        pDeltaQpSegments[7] = Q_DONT_CARE;
-
-        uBkgQPOrSegId = getSegmentId(pDeltaQpSegments, uDeltaQP);
+        std::memcpy(pQPs, cache_.table.data(), tableSize);
+        return;
     }
 
-    /* Fill background */
-    for(int32_t iLCU = 0; iLCU < iNumLCUs; iLCU++)
+    std::vector<bool> dirtyRows;
+    if(bReusable && findDirtyRows(ids, nodes, dirtyRows))
     {
-        int32_t iFirst = iLCU * iNumBytesPerLCU;
-
-        /* iLcuQpOffset distinguishes QP Table V1 (0) from V2 (4). */
-        if(iLcuQpOffset)
-        {
-            /* For HEVC & AVC, fill only the info of the macro-block, reused for all sub-blocks. */
-            if(!bIsAOM)
-                pQPs[iFirst] = uBkgQPOrSegId & MASK_QP;
-            pQPs[iFirst + 1] = (uDeltaQP & MASK_FORCE) >> 8;
-            pQPs[iFirst + 3] = DEFAULT_LAMBDA_FACT;
-        }
-
-        if(!iLcuQpOffset || bIsAOM)
+        /* Refill only the dirty rows, with the regions lying in them, on top of the cache. */
+        std::memcpy(pQPs, cache_.table.data(), tableSize);
+        for(int32_t iRow = 0; iRow < iLcuPicHeight;)
         {
-            for(int32_t iQP = iLcuQpOffset; iQP < iNumQPPerLCU; ++iQP)
+            if(!dirtyRows[iRow])
             {
-                pQPs[iFirst + iQP] = ((MASK_FORCE & uDeltaQP) >> (MASK_QP_NUMBITS - 6))
-                                     | uBkgQPOrSegId;
+                ++iRow;
+                continue;
             }
+            int32_t iRowEnd = iRow;
+            while(iRowEnd < iLcuPicHeight && dirtyRows[iRowEnd])
+                ++iRowEnd;
+            fillBackground(iNumQPPerLCU, iNumBytesPerLCU, pQPs, iLcuQpOffset, uDeltaQP,
+                           uBkgQPOrSegId, iRow, iRowEnd);
+            iRow = iRowEnd;
         }
+
+        for(const Node& node : nodes)
+            if(touchesRows(node, dirtyRows))
+                computeROI(iNumQPPerLCU, iNumBytesPerLCU, pQPs, iLcuQpOffset, node);
     }
+    else
+    {
+        if(bIsAOM)
+        {
+            pDeltaQpSegments = (int16_t*)(pQPs - EP2_BUF_SEG_CTRL.Size);
+            pDeltaQpSegments[0] = Q_HIGH;
+            pDeltaQpSegments[1] = -3;
+            pDeltaQpSegments[2] = Q_MEDIUM;
+            pDeltaQpSegments[3] = 3;
+            pDeltaQpSegments[4] = Q_LOW;
+            pDeltaQpSegments[5] = 10;
+            pDeltaQpSegments[6] = 15;
+            pDeltaQpSegments[7] = Q_DONT_CARE;
+
+            uBkgQPOrSegId = getSegmentId(pDeltaQpSegments, uDeltaQP);
+        }
 
-    /* Fill ROIs */
-    for(const Node& node : nodes)
-        computeROI(iNumQPPerLCU, iNumBytesPerLCU, pQPs, iLcuQpOffset, node);
+        fillBackground(iNumQPPerLCU, iNumBytesPerLCU, pQPs, iLcuQpOffset, uDeltaQP,
+                       uBkgQPOrSegId, 0, iLcuPicHeight);
+
+        /* Fill ROIs */
+        for(const Node& node : nodes)
+            computeROI(iNumQPPerLCU, iNumBytesPerLCU, pQPs, iLcuQpOffset, node);
+    }
 
     if(bIsAOM)
+    {
         for(int32_t i = 0; i < AL_QPTABLE_NUM_SEGMENTS; ++i)
             pDeltaQpSegments[i] *= 5;
+        cache_.valid = false;
+        return;
+    }
+
+    cache_.valid = true;
+    cache_.numQpPerLcu = iNumQPPerLCU;
+    cache_.numBytesPerLcu = iNumBytesPerLCU;
+    cache_.lcuQpOffset = iLcuQpOffset;
+    cache_.order = order;
+    cache_.bkgQualityCode = bkgCode;
+    cache_.ids = std::move(ids);
+    cache_.nodes = std::move(nodes);
+    cache_.table.assign(pQPs, pQPs + tableSize);
 }
 
 } // namespace vcucodec
@@ -13,10 +13,14 @@
 #define OPENCV_VCUCODEC_VCUROIMANAGER_HPP
 
 #include <cstdint>
+#include <map>
 #include <mutex>
-#include <utility>
+#include <set>
+#include <unordered_map>
 #include <vector>
 
+#include "opencv2/core/cvdef.h"
+
 extern "C" {
 #include "config.h"
 #include "lib_common_enc/EncBuffers.h"
@@ -54,6 +58,16 @@ namespace roiquality {
 class RoiManager
 {
 public:
+    /// A region that applies to a single frame only (raw pixel coordinates).
+    struct FrameRegion
+    {
+        int32_t posX;
+        int32_t posY;
+        int32_t width;
+        int32_t height;
+        int     qualityCode;   ///< signed relative QP delta or a force sentinel
+    };
+
     /// @param picWidth,picHeight   Encoded picture size in pixels.
     /// @param profile              Encoder profile (selects QP range / AOM handling).
     /// @param log2MaxCuSize        log2 of the max coding-unit (LCU) size.
@@ -78,6 +92,13 @@ public:
     /// Deactivate region @p id from @p frameIdx onwards.
     void disableRegion(int32_t id, int32_t frameIdx);
 
+    /// Forget region @p id (its handle was released).
+    void removeRegion(int32_t id);
+
+    /// Replace the one-shot regions of frame @p frameIdx. They have no id, are active for
+    /// that frame only and are removed from the region set once a later frame is filled.
+    void setFrameRegions(int32_t frameIdx, const std::vector<FrameRegion>& regions);
+
     /// Schedule a global overlap-order change effective from @p frameIdx.
     void setOrder(int32_t frameIdx, RoiOrder order);
 
@@ -85,7 +106,10 @@ public:
     bool isActive(int32_t id) const;
 
     /// Fill @p pQPs with the relative QP table for @p frameIdx. Selects the active
-    /// regions and resolves the background/order scheduled for that frame.
+    /// regions and resolves the background/order scheduled for that frame. Every byte of
+    /// the iNumLCUs * numBytesPerLcu table is written. The last table is cached: an
+    /// unchanged region set is copied from it, and a changed one only recomputes the LCU
+    /// rows that the added or removed regions (and the regions overlapping them) touch.
     void fillBuffer(int32_t frameIdx, int32_t numQpPerLcu, int32_t numBytesPerLcu,
                     uint8_t* pQPs, int32_t lcuQpOffset);
 
@@ -102,6 +126,7 @@ private:
         bool    background;
         int32_t enableFrame;   ///< active when frame in [enableFrame, disableFrame)
         int32_t disableFrame;
+        bool    oneShot;       ///< set by setFrameRegions(), removed once expired
     };
 
     /// A region snapped to the LCU grid, used while filling the QP table.
@@ -114,9 +139,26 @@ private:
         int16_t iDeltaQP;
     };
 
+    /// The last generated table and the inputs it was generated from.
+    struct TableCache
+    {
+        bool valid = false;
+        int32_t numQpPerLcu = 0;
+        int32_t numBytesPerLcu = 0;
+        int32_t lcuQpOffset = 0;
+        RoiOrder order = RoiOrder::QUALITY;
+        int bkgQualityCode = 0;
+        std::vector<int32_t> ids;   ///< active foreground regions, in fill order
+        std::vector<Node> nodes;    ///< their LCU-snapped nodes
+        std::vector<uint8_t> table;
+    };
+
     Node toNode(const RegionDef& region) const;
     bool activeAt(const RegionDef& region, int32_t frameIdx) const;
     RegionDef* find(int32_t id);
+    void schedule(const RegionDef& region);
+    void advance(int32_t frameIdx);
+    void rebuildActive(int32_t frameIdx);
 
     uint32_t getNodePosInBuf(uint32_t uLcuX, uint32_t uLcuY, int32_t iNumBytesPerLCU) const;
     void meanQuality(uint8_t* pTargetQP, uint8_t* iDQp1, uint8_t iDQp2, int32_t iNumQPPerLCU,
@@ -129,6 +171,13 @@ private:
             int32_t iLcuQpOffset);
     void computeROI(int32_t iNumQPPerLCU, int32_t iNumBytesPerLCU, uint8_t* pQPs,
                     int32_t iLcuQpOffset, const Node& node);
+    void fillBackground(int32_t iNumQPPerLCU, int32_t iNumBytesPerLCU, uint8_t* pQPs,
+                        int32_t iLcuQpOffset, uint16_t uDeltaQP, uint16_t uBkgQPOrSegId,
+                        int32_t iRowBegin, int32_t iRowEnd);
+    void markRows(const Node& node, std::vector<bool>& rows) const;
+    bool touchesRows(const Node& node, const std::vector<bool>& rows) const;
+    bool findDirtyRows(const std::vector<int32_t>& ids, const std::vector<Node>& nodes,
+                       std::vector<bool>& rows) const;
 
     mutable std::mutex mtx_;
     int32_t iPicWidth;
@@ -142,8 +191,12 @@ private:
     bool    bIsAOM;
     int      eDefaultBkgQuality;   ///< background quality code when no background is active
     RoiOrder eDefaultOrder;
-    std::vector<RegionDef> regions_;
-    std::vector<std::pair<int32_t, RoiOrder>> orderChanges_;  ///< scheduled order changes
+    std::unordered_map<int32_t, RegionDef> regions_;    ///< all regions, by id
+    std::set<int32_t> active_;             ///< regions active at currentFrame_, in fill order
+    std::multimap<int32_t, int32_t> events_;  ///< frame -> id of a future enable/disable boundary
+    std::map<int32_t, std::vector<int32_t>> frameRegions_;  ///< one-shot region ids, by frame
+    std::map<int32_t, RoiOrder> orderChanges_;  ///< scheduled order changes, by frame
+    TableCache cache_;
     int32_t nextId_;
     int32_t currentFrame_;
     int16_t* pDeltaQpSegments;
@@ -0,0 +1,167 @@
+/*
+   Copyright (c) 2025-2026  Advanced Micro Devices, Inc. (AMD)
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+*/
+#include "vcuscaler.hpp"
+#include "vcuutils.hpp"
+
+#include "opencv2/imgproc.hpp"
+
+#include <algorithm>
+#include <stdexcept>
+
+namespace cv {
+namespace vcucodec {
+
+namespace {
+
+// Area averaging when shrinking (OpenCV has vectorized fast paths for the integer 2x and 4x
+// ratios), bilinear otherwise.
+int interpolation(Size from, Size to)
+{
+    return (to.width <= from.width && to.height <= from.height) ? INTER_AREA : INTER_LINEAR;
+}
+
+} // anonymous namespace
+
+bool YuvScaler::supported(int fourcc)
+{
+    try
+    {
+        FormatInfo formatInfo(fourcc);
+        const AL_TPicFormat& tPicFormat = formatInfo.format;
+#ifdef HAVE_VCU_CTRLSW
+        if (fourcc == FOURCC(XV15) || fourcc == FOURCC(XV20))
+            return false;
+#endif
+        if (tPicFormat.eStorageMode != AL_FB_RASTER)
+            return false;
+        if (tPicFormat.eChromaMode == AL_CHROMA_MONO)
+            return true;
+        AL_EPlaneMode planeMode = AL_GetPlaneMode(toEncoderFourCC(fourcc));
+        return planeMode == AL_PLANE_MODE_SEMIPLANAR || planeMode == AL_PLANE_MODE_PLANAR;
+    }
+    catch (const std::exception&)
+    {
+        return false;
+    }
+}
+
+YuvScaler::YuvScaler(int fourcc)
+{
+    if (!supported(fourcc))
+        throw std::invalid_argument("Scaling is not supported for this input FourCC");
+
+    FormatInfo formatInfo(fourcc);
+    const AL_TPicFormat& tPicFormat = formatInfo.format;
+    depth_ = tPicFormat.uBitDepth > 8 ? CV_16U : CV_8U;
+    mono_ = tPicFormat.eChromaMode == AL_CHROMA_MONO;
+    planar_ = !mono_ && AL_GetPlaneMode(toEncoderFourCC(fourcc)) == AL_PLANE_MODE_PLANAR;
+    chromaShiftX_ = (tPicFormat.eChromaMode == AL_CHROMA_4_2_0 ||
+                     tPicFormat.eChromaMode == AL_CHROMA_4_2_2) ? 1 : 0;
+    chromaShiftY_ = (tPicFormat.eChromaMode == AL_CHROMA_4_2_0) ? 1 : 0;
+}
+
+Size YuvScaler::alignment() const
+{
+    return Size(1 << chromaShiftX_, 1 << chromaShiftY_);
+}
+
+Size YuvScaler::chromaSize(Size size) const
+{
+    return Size((size.width + (1 << chromaShiftX_) - 1) >> chromaShiftX_,
+                (size.height + (1 << chromaShiftY_) - 1) >> chromaShiftY_);
+}
+
+int YuvScaler::stackedRows(Size size) const
+{
+    if (mono_)
+        return size.height;
+    int chromaRows = chromaSize(size).height;
+    return size.height + (planar_ ? 2 * chromaRows : chromaRows);
+}
+
+Mat YuvScaler::createStacked(Size size) const
+{
+    return Mat(stackedRows(size), size.width, CV_MAKETYPE(depth_, 1));
+}
+
+void YuvScaler::planes(const Mat& stacked, Size size, std::vector<Mat>& planes) const
+{
+    size_t pitch = stacked.step[0];
+    size_t rowBytes = (size_t)size.width * CV_ELEM_SIZE1(depth_);
+    if (stacked.empty() || stacked.rows < stackedRows(size) || pitch < rowBytes)
+        throw std::invalid_argument("Picture is smaller than its YUV planes");
+
+    this->planes(const_cast<uint8_t*>(stacked.ptr<uint8_t>()), size, pitch,
+                 (size_t)size.height * pitch, pitch, planes);
+}
+
+void YuvScaler::planes(uint8_t* data, Size size, size_t pitch, size_t chromaOffset,
+                       size_t chromaPitch, std::vector<Mat>& planes) const
+{
+    planes.clear();
+    planes.emplace_back(size, CV_MAKETYPE(depth_, 1), data, pitch);
+    if (mono_)
+        return;
+
+    Size cSize = chromaSize(size);
+    if (planar_)
+    {
+        planes.emplace_back(cSize, CV_MAKETYPE(depth_, 1), data + chromaOffset, chromaPitch);
+        planes.emplace_back(cSize, CV_MAKETYPE(depth_, 1),
+                            data + chromaOffset + (size_t)cSize.height * chromaPitch, chromaPitch);
+    }
+    else
+    {
+        planes.emplace_back(cSize, CV_MAKETYPE(depth_, 2), data + chromaOffset, chromaPitch);
+    }
+}
+
+void YuvScaler::scale(const std::vector<Mat>& src, std::vector<Mat>& dst) const
+{
+    if (src.size() != dst.size())
+        throw std::invalid_argument("Source and destination pictures have different plane counts");
+
+    for (size_t i = 0; i < src.size(); ++i)
+    {
+        Mat out = dst[i]; // header copy: resize must write into the caller's memory
+        resize(src[i], out, dst[i].size(), 0, 0, interpolation(src[i].size(), dst[i].size()));
+        if (out.data != dst[i].data)
+            throw std::runtime_error("Destination plane has the wrong size or type");
+    }
+}
+
+void YuvScaler::scale(const std::vector<Mat>& src, const std::vector<Size>& sizes,
+                      std::vector<Mat>& dst) const
+{
+    dst.resize(sizes.size());
+
+    std::vector<Mat> dstPlanes;
+    for (size_t idx = 0; idx < sizes.size(); ++idx)
+    {
+        Size size = sizes[idx];
+        if (dst[idx].rows != stackedRows(size) || dst[idx].cols != size.width ||
+            dst[idx].depth() != depth_)
+            dst[idx] = createStacked(size);
+
+        // Always from the source: deriving a small size from a larger output would filter the
+        // picture twice and add the rounding of every step down the ladder.
+        planes(dst[idx], size, dstPlanes);
+        scale(src, dstPlanes);
+    }
+}
+
+} // namespace vcucodec
+} // namespace cv
@@ -0,0 +1,83 @@
+/*
+   Copyright (c) 2025-2026  Advanced Micro Devices, Inc. (AMD)
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+*/
+#ifndef OPENCV_VCUCODEC_VCUSCALER_HPP
+#define OPENCV_VCUCODEC_VCUSCALER_HPP
+
+#include <opencv2/core.hpp>
+
+#include <cstdint>
+#include <vector>
+
+namespace cv {
+namespace vcucodec {
+
+/// Class YuvScaler resizes raster YUV pictures plane by plane.
+///
+/// Pictures are described as a list of plane Mats (Y, then UV for semi-planar or U and V for
+/// planar formats), with 16-bit samples for 10/12-bit formats and two channels for an
+/// interleaved UV plane. A "stacked" picture is the single Mat that Encoder::write() takes:
+/// the luma rows followed by the chroma rows, all at the same row pitch.
+class YuvScaler
+{
+public:
+    /// Construct a scaler for the given (encoder input) FourCC; throws when not supported.
+    explicit YuvScaler(int fourcc);
+
+    /// Whether pictures of @p fourcc can be scaled: raster formats, not the packed 10-bit ones.
+    static bool supported(int fourcc);
+
+    /// Size granularity of the chroma subsampling: (2, 2) for 4:2:0, (2, 1) for 4:2:2,
+    /// (1, 1) otherwise.
+    Size alignment() const;
+
+    /// Number of rows of a stacked picture of the given size.
+    int stackedRows(Size size) const;
+
+    /// Allocate a tightly packed stacked picture of the given size.
+    Mat createStacked(Size size) const;
+
+    /// Wrap the planes of a stacked picture (no copy).
+    void planes(const Mat& stacked, Size size, std::vector<Mat>& planes) const;
+
+    /// Wrap the planes of a picture at @p data; the first chroma plane starts at @p chromaOffset
+    /// bytes and, for planar formats, the second one right after it (no copy).
+    void planes(uint8_t* data, Size size, size_t pitch, size_t chromaOffset, size_t chromaPitch,
+                std::vector<Mat>& planes) const;
+
+    /// Scale the planes of @p src into the (already allocated) planes of @p dst.
+    void scale(const std::vector<Mat>& src, std::vector<Mat>& dst) const;
+
+    /// Produce every size in @p sizes from @p src and store them as stacked pictures in @p dst
+    /// (reused when already allocated). Each output is scaled from @p src, not from a larger
+    /// output: a ladder like 1080p/720p/360p reads the input once per size, but 360p carries
+    /// no error from the 720p step.
+    void scale(const std::vector<Mat>& src, const std::vector<Size>& sizes,
+               std::vector<Mat>& dst) const;
+
+private:
+    Size chromaSize(Size size) const;
+
+    int  depth_;       // CV_8U or CV_16U
+    bool mono_;
+    bool planar_;
+    int  chromaShiftX_;
+    int  chromaShiftY_;
+};
+
+} // namespace vcucodec
+} // namespace cv
+
+#endif // OPENCV_VCUCODEC_VCUSCALER_HPP
@@ -0,0 +1,148 @@
+/*
+   Copyright (c) 2025-2026  Advanced Micro Devices, Inc. (AMD)
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+*/
+#include "vcusoftcodec.hpp"
+
+extern "C" {
+#include "config.h"
+#include "lib_common/FourCC.h"
+#include "lib_common/PixMapBuffer.h"
+}
+
+#include <cstring>
+#include <stdexcept>
+#include <vector>
+
+namespace cv {
+namespace vcucodec {
+
+namespace { // anonymous
+
+const char softMagic[8] = { 'V', 'C', 'U', 'S', 'O', 'F', 'T', '\0' };
+
+// A plane of a packed payload: rowBytes bytes on each of the rows rows.
+struct SoftPlane
+{
+    AL_EPlaneId id;
+    size_t rowBytes;
+    int rows;
+};
+
+std::vector<SoftPlane> softPlanes(TFourCC fourcc, int width, int height)
+{
+    AL_TPicFormat tPicFormat;
+    if (!AL_GetPicFormat(fourcc, &tPicFormat) || tPicFormat.eStorageMode != AL_FB_RASTER)
+        throw std::runtime_error("Software codec: unsupported picture format");
+#ifdef HAVE_VCU_CTRLSW
+    if (fourcc == FOURCC(XV15) || fourcc == FOURCC(XV20))
+        throw std::runtime_error("Software codec: unsupported picture format");
+#endif
+
+    size_t const sampleBytes = tPicFormat.uBitDepth > 8 ? 2 : 1;
+    std::vector<SoftPlane> planes { { AL_PLANE_Y, width * sampleBytes, height } };
+
+    if (tPicFormat.eChromaMode == AL_CHROMA_MONO)
+        return planes;
+
+    int chromaWidth = tPicFormat.eChromaMode == AL_CHROMA_4_4_4 ? width : (width + 1) / 2;
+    int chromaHeight = tPicFormat.eChromaMode == AL_CHROMA_4_2_0 ? (height + 1) / 2 : height;
+
+    switch (AL_GetPlaneMode(fourcc))
+    {
+    case AL_PLANE_MODE_SEMIPLANAR:
+        planes.push_back({ AL_PLANE_UV, 2 * chromaWidth * sampleBytes, chromaHeight });
+        break;
+    case AL_PLANE_MODE_PLANAR:
+        planes.push_back({ AL_PLANE_U, chromaWidth * sampleBytes, chromaHeight });
+        planes.push_back({ AL_PLANE_V, chromaWidth * sampleBytes, chromaHeight });
+        break;
+    default:
+        throw std::runtime_error("Software codec: unsupported picture format");
+    }
+    return planes;
+}
+
+} // anonymous namespace
+
+SoftStreamHeader SoftCodec::streamHeader(int fourcc, int width, int height, int fpsNum,
+                                         int fpsDen)
+{
+    SoftStreamHeader header {};
+    std::memcpy(header.magic, softMagic, sizeof(header.magic));
+    header.fourcc = fourcc;
+    header.width = width;
+    header.height = height;
+    header.fpsNum = fpsNum;
+    header.fpsDen = fpsDen;
+    return header;
+}
+
+bool SoftCodec::isStreamHeader(SoftStreamHeader const& header)
+{
+    return std::memcmp(header.magic, softMagic, sizeof(header.magic)) == 0;
+}
+
+size_t SoftCodec::pictureSize(int fourcc, int width, int height)
+{
+    size_t size = 0;
+    for (auto const& plane : softPlanes(fourcc, width, height))
+        size += plane.rowBytes * plane.rows;
+    return size;
+}
+
+uint64_t SoftCodec::pack(AL_TBuffer const* pBuf, std::string& out)
+{
+    TFourCC const fourcc = AL_PixMapBuffer_GetFourCC(pBuf);
+    AL_TDimension const tDim = AL_PixMapBuffer_GetDimension(pBuf);
+    size_t const start = out.size();
+
+    out.resize(start + pictureSize(fourcc, tDim.iWidth, tDim.iHeight));
+    char* pDst = &out[start];
+
+    for (auto const& plane : softPlanes(fourcc, tDim.iWidth, tDim.iHeight))
+    {
+        uint8_t const* pSrc = AL_PixMapBuffer_GetPlaneAddress(pBuf, plane.id);
+        int32_t const pitch = AL_PixMapBuffer_GetPlanePitch(pBuf, plane.id);
+        for (int row = 0; row < plane.rows; ++row, pDst += plane.rowBytes)
+            std::memcpy(pDst, pSrc + (size_t)row * pitch, plane.rowBytes);
+    }
+
+    return checksum(reinterpret_cast<uint8_t const*>(out.data()) + start, out.size() - start);
+}
+
+void SoftCodec::unpack(uint8_t const* pData, AL_TBuffer* pBuf)
+{
+    TFourCC const fourcc = AL_PixMapBuffer_GetFourCC(pBuf);
+    AL_TDimension const tDim = AL_PixMapBuffer_GetDimension(pBuf);
+
+    for (auto const& plane : softPlanes(fourcc, tDim.iWidth, tDim.iHeight))
+    {
+        uint8_t* pDst = AL_PixMapBuffer_GetPlaneAddress(pBuf, plane.id);
+        int32_t const pitch = AL_PixMapBuffer_GetPlanePitch(pBuf, plane.id);
+        for (int row = 0; row < plane.rows; ++row, pData += plane.rowBytes)
+            std::memcpy(pDst + (size_t)row * pitch, pData, plane.rowBytes);
+    }
+}
+
+uint64_t SoftCodec::checksum(uint8_t const* pData, size_t size)
+{
+    uint64_t hash = 0xcbf29ce484222325ULL;
+    for (size_t i = 0; i < size; ++i)
+        hash = (hash ^ pData[i]) * 0x100000001b3ULL;
+    return hash;
+}
+
+} // namespace vcucodec
+} // namespace cv
@@ -0,0 +1,81 @@
+/*
+   Copyright (c) 2025-2026  Advanced Micro Devices, Inc. (AMD)
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+*/
+#ifndef OPENCV_VCUCODEC_VCUSOFTCODEC_HPP
+#define OPENCV_VCUCODEC_VCUSOFTCODEC_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+extern "C" {
+typedef struct AL_TBuffer AL_TBuffer;
+}
+
+namespace cv {
+namespace vcucodec {
+
+/// Stream of the software device (Device::isSoftware()): raw pictures in a trivial container.
+///
+/// A SoftStreamHeader, then for each picture a SoftPictureHeader followed by the picture planes
+/// (Y, then UV or U and V) tightly packed, like in a raw YUV file. The software encoder writes
+/// it and the software decoder reads it back; only raster planar and semi-planar formats are
+/// supported. All fields are little-endian.
+struct SoftStreamHeader
+{
+    char     magic[8];  ///< "VCUSOFT\0"
+    uint32_t fourcc;    ///< picture format of every payload
+    uint32_t width;     ///< first picture width, pictures carry their own size
+    uint32_t height;
+    uint32_t fpsNum;
+    uint32_t fpsDen;
+    uint32_t reserved;
+};
+
+struct SoftPictureHeader
+{
+    uint32_t size;      ///< payload bytes following this header
+    uint32_t index;     ///< picture number, from 0
+    uint32_t width;
+    uint32_t height;
+    uint64_t checksum;  ///< FNV-1a of the payload
+};
+
+static_assert(sizeof(SoftStreamHeader) == 32, "software stream header layout");
+static_assert(sizeof(SoftPictureHeader) == 24, "software picture header layout");
+
+class SoftCodec
+{
+public:
+    static SoftStreamHeader streamHeader(int fourcc, int width, int height, int fpsNum,
+                                         int fpsDen);
+    static bool isStreamHeader(SoftStreamHeader const& header);
+
+    /// Payload bytes of a @p width x @p height picture; throws for unsupported formats.
+    static size_t pictureSize(int fourcc, int width, int height);
+
+    /// Append the visible area of the planes of @p pBuf to @p out and return their checksum.
+    static uint64_t pack(AL_TBuffer const* pBuf, std::string& out);
+
+    /// Fill the planes of @p pBuf, whose dimension is already set, from a packed payload.
+    static void unpack(uint8_t const* pData, AL_TBuffer* pBuf);
+
+    static uint64_t checksum(uint8_t const* pData, size_t size);
+};
+
+} // namespace vcucodec
+} // namespace cv
+
+#endif // OPENCV_VCUCODEC_VCUSOFTCODEC_HPP
@@ -15,6 +15,11 @@
 */
 #include "vcuutils.hpp"
 
+extern "C" {
+#include "lib_common/PixMapBuffer.h"
+#include "lib_fpga/DmaAllocLinux.h"
+}
+
 #ifdef HAVE_VCU2_CTRLSW
 extern "C" {
 #include "config.h"
@@ -547,5 +552,101 @@ String FormatInfo::getFourCCs(bool decoder)
     return result;
 }
 
+// Values of DRM_FORMAT_MOD_LINEAR and DRM_FORMAT_MOD_INVALID (drm_fourcc.h).
+const int64 drmFormatModLinear  = 0;
+const int64 drmFormatModInvalid = 0x00ffffffffffffffLL;
+
+// Planes of the pictures of @p fourcc in the order of DmaBufFrame::planes().
+static std::vector<AL_EPlaneId> dmaBufPlaneIds(TFourCC fourcc)
+{
+    std::vector<AL_EPlaneId> planeIds = { AL_PLANE_Y };
+    if (AL_GetChromaMode(fourcc) != AL_CHROMA_MONO)
+    {
+        switch (AL_GetPlaneMode(fourcc))
+        {
+        case AL_PLANE_MODE_SEMIPLANAR:
+            planeIds.push_back(AL_PLANE_UV);
+            break;
+        case AL_PLANE_MODE_PLANAR:
+            planeIds.push_back(AL_PLANE_U);
+            planeIds.push_back(AL_PLANE_V);
+            break;
+        default: // interleaved: single plane
+            break;
+        }
+    }
+    return planeIds;
+}
+
+std::vector<DmaBufPlane> dmaBufPlanes(AL_TBuffer* pBuf, int cropLeft, int cropTop)
+{
+    TFourCC fourcc = AL_PixMapBuffer_GetFourCC(pBuf);
+    // A tile or a packed 10-bit word holds several columns: there is no byte to start at
+    bool packed = fourcc == FOURCC(XV15) || fourcc == FOURCC(XV20);
+    if ((cropLeft || cropTop) && (AL_IsTiled(fourcc) || packed))
+        CV_Error(Error::StsNotImplemented,
+                 "A picture cropped at the left or top cannot be exported as tiled or packed "
+                 "dmabuf planes");
+
+    AL_EChromaMode chromaMode = AL_GetChromaMode(fourcc);
+    int bytesPerSample = AL_GetBitDepth(fourcc) > 8 ? 2 : 1;
+
+    auto* pAllocator = (AL_TLinuxDmaAllocator*)(pBuf->pAllocator);
+    std::vector<DmaBufPlane> planes;
+    for (AL_EPlaneId planeId : dmaBufPlaneIds(fourcc))
+    {
+        int chunk = AL_PixMapBuffer_GetPlaneChunkIdx(pBuf, planeId);
+        if (chunk < 0)
+            CV_Error(Error::StsError, "Decoded buffer has no chunk for a plane");
+        DmaBufPlane plane;
+        plane.fd = AL_LinuxDmaAllocator_GetFd(pAllocator, pBuf->hBufs[chunk]);
+        plane.offset = (int)(AL_PixMapBuffer_GetPlaneAddress(pBuf, planeId)
+                             - AL_Buffer_GetDataChunk(pBuf, chunk));
+        plane.pitch = AL_PixMapBuffer_GetPlanePitch(pBuf, planeId);
+
+        // Start at the first visible sample: chroma planes are subsampled, and the UV plane
+        // interleaves two samples per chroma column.
+        int left = cropLeft, top = cropTop, samples = 1;
+        if (planeId != AL_PLANE_Y)
+        {
+            if (chromaMode == AL_CHROMA_4_2_0 || chromaMode == AL_CHROMA_4_2_2)
+                left /= 2;
+            if (chromaMode == AL_CHROMA_4_2_0)
+                top /= 2;
+            if (planeId == AL_PLANE_UV)
+                samples = 2;
+        }
+        plane.offset += top * plane.pitch + left * samples * bytesPerSample;
+        planes.push_back(plane);
+    }
+    return planes;
+}
+
+void checkDmaBufLayout(AL_TBuffer* pBuf, std::vector<DmaBufPlane> const& planes)
+{
+    std::vector<AL_EPlaneId> planeIds = dmaBufPlaneIds(AL_PixMapBuffer_GetFourCC(pBuf));
+    if (planes.size() != planeIds.size())
+        CV_Error(Error::StsBadArg, cv::format("DmaBufFrame has %zu planes, the encoder source %zu",
+                                              planes.size(), planeIds.size()));
+
+    for (size_t i = 0; i < planes.size(); ++i)
+    {
+        if (AL_PixMapBuffer_GetPlaneChunkIdx(pBuf, planeIds[i]) != 0)
+            CV_Error(Error::StsBadArg, "The encoder source buffers have planes outside chunk 0");
+        int offset = (int)(AL_PixMapBuffer_GetPlaneAddress(pBuf, planeIds[i])
+                           - AL_Buffer_GetData(pBuf));
+        int pitch = AL_PixMapBuffer_GetPlanePitch(pBuf, planeIds[i]);
+        if (planes[i].offset != offset || planes[i].pitch != pitch)
+            CV_Error(Error::StsBadArg, cv::format(
+                "DmaBufFrame plane %zu has offset %d and pitch %d, the encoder source buffers "
+                "offset %d and pitch %d", i, planes[i].offset, planes[i].pitch, offset, pitch));
+    }
+}
+
+int64 dmaBufModifier(int fourcc)
+{
+    return AL_IsTiled(fourcc) ? drmFormatModInvalid : drmFormatModLinear;
+}
+
 } // namespace vcucodec
 } // namespace cv
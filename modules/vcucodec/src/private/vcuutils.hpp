@@ -20,6 +20,7 @@
 #include "opencv2/vcucodec.hpp"
 
 extern "C" {
+#include "lib_common/BufferAPI.h"
 #include "lib_common/Error.h"
 #include "lib_common/FourCC.h"
 #include "lib_common/HDR.h"
@@ -120,6 +121,21 @@ template <> void convert(AL_THDRSEIs& to, const HDRSEIs& from);
 // Template specialization for AL_TPicFormat toString
 template<> String toString<AL_TPicFormat>(AL_TPicFormat const& format);
 
+/// Describe the planes of the HW buffer @p pBuf as dmabuf fd/offset/pitch triplets, in the
+/// order of DmaBufFrame::planes(). Planes are looked up in their own chunk, so multi-chunk buffers
+/// get one fd per chunk; the fds stay owned by the Linux DMA allocator of the buffer.
+/// The offsets point at the picture cropped by @p cropLeft and @p cropTop luma samples; a left or
+/// top crop of a tiled or packed 10-bit picture raises StsNotImplemented.
+std::vector<DmaBufPlane> dmaBufPlanes(AL_TBuffer* pBuf, int cropLeft = 0, int cropTop = 0);
+
+/// Raise StsBadArg unless @p planes, from DmaBufFrame::planes(), have the offsets and pitches of
+/// the planes of @p pBuf, all in its chunk 0: the layout the encoder reads the imported dmabuf with.
+void checkDmaBufLayout(AL_TBuffer* pBuf, std::vector<DmaBufPlane> const& planes);
+
+/// DRM format modifier of the pictures of @p fourcc: DRM_FORMAT_MOD_LINEAR for raster formats,
+/// DRM_FORMAT_MOD_INVALID for the tiled ones, which have no DRM modifier.
+int64 dmaBufModifier(int fourcc);
+
 struct FormatInfo
 {
     FormatInfo(int fourcc);
@@ -17,6 +17,8 @@
 
 #include "vcudec.hpp"
 #include "vcuenc.hpp"
+#include "vcusimulcast.hpp"
+#include "vcutranscoder.hpp"
 
 #include "opencv2/core/utils/logger.hpp"
 
@@ -59,5 +61,44 @@ Ptr<Encoder> createEncoder(const String& filename, const EncoderInitParams& para
     }
 }
 
+Ptr<SimulcastEncoder> createSimulcastEncoder(const EncoderInitParams& params,
+    const std::vector<SimulcastRendition>& renditions)
+{
+    return createSimulcastEncoder(params, renditions, std::vector<Ptr<EncoderCallback>>());
+}
+
+Ptr<SimulcastEncoder> createSimulcastEncoder(const EncoderInitParams& params,
+    const std::vector<SimulcastRendition>& renditions,
+    const std::vector<Ptr<EncoderCallback>>& callbacks)
+{
+    try
+    {
+        return makePtr<VCUSimulcastEncoder>(params, renditions, callbacks);
+    }
+    catch (const cv::Exception& e) {
+        throw;
+    }
+    catch (const std::exception& e) {
+        CV_Error(Error::StsError, std::string("Error creating VCUSimulcastEncoder: ") + e.what());
+    }
+    return {};
+}
+
+Ptr<Transcoder> createTranscoder(const String& input, const DecoderInitParams& decoderParams,
+    const String& output, const EncoderInitParams& encoderParams, const TranscoderParams& params)
+{
+    try
+    {
+        return makePtr<VCUTranscoder>(input, decoderParams, output, encoderParams, params);
+    }
+    catch (const cv::Exception& e) {
+        throw;
+    }
+    catch (const std::exception& e) {
+        CV_Error(Error::StsError, std::string("Error creating VCUTranscoder: ") + e.what());
+    }
+    return {};
+}
+
 }  // namespace vcucodec
 }  // namespace cv
\ No newline at end of file
@@ -18,6 +18,8 @@
 
 extern "C" {
 #include "config.h"
+#include "lib_common/BufferAPI.h"
+#include "lib_common/FourCC.h"
 #include "lib_common/PicFormat.h"
 #include "lib_common/PixMapBuffer.h"
 
@@ -239,14 +241,26 @@ std::vector<Mat> buildSrcPlanes(AL_TBuffer* pFrame, const RawInfo& info)
 
 VCUDecoder::VCUDecoder(const String& filename, const DecoderInitParams& params,
                        Ptr<DecoderCallback> callback)
-    : filename_(filename), params_(params), rawOutput_(RawOutput::create())
+    : filename_(filename), params_(params), callback_(callback), rawOutput_(RawOutput::create())
 {
     if (!validateParams(params))
         return;
 
+    decodeCtx_ = DecContext::create(createConfig(), rawOutput_, wCfg);
+    initialized_ = decodeCtx_ != nullptr;
+    if (!initialized_)
+    {
+        CV_Error(cv::Error::StsError, "VCU2 decoder initialization failed");
+    }
+    setCaptureProperty(CAP_PROP_FPS, (double)params_.fpsNum / (double)params_.fpsDen, false);
+    updateFramePosition();
+}
+
+Ptr<DecContext::Config> VCUDecoder::createConfig()
+{
     std::shared_ptr<DecContext::Config> pDecConfig
             = std::shared_ptr<DecContext::Config>(new DecContext::Config());
-    pDecConfig->sIn = (std::string)filename;
+    pDecConfig->sIn = (std::string)filename_;
     pDecConfig->iExtraBuffers = std::max(1, params_.extraFrames);
 #ifdef HAVE_VCU2_CTRLSW
     pDecConfig->tDecSettings.uNumBuffersHeldByNextComponent = pDecConfig->iExtraBuffers;
@@ -271,13 +285,13 @@ VCUDecoder::VCUDecoder(const String& filename, const DecoderInitParams& params,
         CV_Error(cv::Error::StsBadArg, "Unsupported codec type");
     }
 
-    if (params.fourcc == 0 || params.fourcc == FOURCC(AUTO))
+    if (params_.fourcc == 0 || params_.fourcc == FOURCC(AUTO))
     {
         pDecConfig->tOutputFourCC = FOURCC(NULL);
     }
     else
     {
-        pDecConfig->tOutputFourCC = params.fourcc;
+        pDecConfig->tOutputFourCC = params_.fourcc;
     }
 
     if (params_.maxFrames > 0)
@@ -285,20 +299,34 @@ VCUDecoder::VCUDecoder(const String& filename, const DecoderInitParams& params,
 
     pDecConfig->iOutputBitDepth = static_cast<int>(params_.bitDepth);
 
-    pDecConfig->decoderCallback = callback;
+    pDecConfig->decoderCallback = callback_;
 
     // Set frame rate from init params (used when stream doesn't contain timing info)
     pDecConfig->tDecSettings.uFrameRate = params_.fpsNum;
     pDecConfig->tDecSettings.uClkRatio = params_.fpsDen;
     pDecConfig->tDecSettings.bForceFrameRate = params_.forceFps;
 
-    decodeCtx_ = DecContext::create(pDecConfig, rawOutput_, wCfg);
-    initialized_ = decodeCtx_ != nullptr;
-    if (!initialized_)
+    return pDecConfig;
+}
+
+void VCUDecoder::reset(const String& filename)
+{
+    if (!initialized_ || !decodeCtx_)
+        CV_Error(cv::Error::StsError, "Decoder not initialized");
+
+    // Stop the current stream; frames the application still holds are revoked as in cleanup().
+    decodeCtx_->finish();
+    rawOutput_->flush();
+    pinRegistry_->revokeAll();
+
+    filename_ = filename;
+    decodeCtx_->reset(createConfig(), wCfg);
+
     {
-        CV_Error(cv::Error::StsError, "VCU2 decoder initialization failed");
+        std::lock_guard<std::mutex> lock(rawInfoMutex_);
+        rawInfoInitialized_ = false;
     }
-    setCaptureProperty(CAP_PROP_FPS, (double)params_.fpsNum / (double)params_.fpsDen, false);
+    frameIndex_ = 0;
     updateFramePosition();
 }
 
@@ -350,45 +378,56 @@ bool VCUDecoder::validateParams(const DecoderInitParams& params)
 // New single API entry point
 DecodeStatus VCUDecoder::nextFrame(Ptr<VideoFrame>& frame) /* override */
 {
-    if (!initialized_ || !decodeCtx_)
-        CV_Error(cv::Error::StsError, "Decoder not initialized");
-
-    if (!decodeCtx_->running() && !decodeCtx_->eos())
-        decodeCtx_->start(wCfg);
-
-    Ptr<Frame> pFrame;
-    if (decodeCtx_->eos())
-        pFrame = rawOutput_->dequeue(std::chrono::milliseconds::zero());
-    else
-        pFrame = rawOutput_->dequeue(std::chrono::milliseconds(100));
-
+    RawInfo fi;
+    Ptr<Frame> pFrame = dequeueFrame(fi);
     if (pFrame)
     {
-        RawInfo fi;
-        pFrame->rawInfo(fi);
-        fi.width  -= fi.cropLeft + fi.cropRight;
-        fi.height -= fi.cropTop  + fi.cropBottom;
-        fi.fourcc  = pFrame->getFourCC();
-        updateRawInfo(fi);
-
         frame = makePtr<VideoFrameImpl>(pFrame, fi,
                                         buildSrcPlanes(pFrame->getBuffer(), fi),
                                         pinRegistry_);
-        ++frameIndex_;
-        updateFramePosition();
         return DECODE_FRAME;
     }
 
     frame.reset();
-    if (decodeCtx_->eos())
+    return noFrameStatus();
+}
+
+DecodeStatus VCUDecoder::nextFrameFd(int& fd, RawInfo& frame_info)
+{
+    if (wCfg.device && wCfg.device->isSoftware())
+        CV_Error(cv::Error::StsError, "nextFrameFd() is not available on the software device");
+
+    Ptr<Frame> pFrame = dequeueFrame(frame_info);
+    if (pFrame)
     {
-        decodeCtx_->finish();
-        return DECODE_EOS;
+        AL_TBuffer* pBuf = pFrame->getBuffer();
+        AL_HANDLE hChunk = pBuf->hBufs[0];  // use chunk 0, not for bMultiChunk case
+        fd = AL_LinuxDmaAllocator_GetFd((AL_TLinuxDmaAllocator*)(pBuf->pAllocator), hChunk);
+        return DECODE_FRAME;
     }
-    return DECODE_TIMEOUT;
+    return noFrameStatus();
 }
 
-DecodeStatus VCUDecoder::nextFrameFd(int& fd, RawInfo& frame_info)
+DecodeStatus VCUDecoder::nextFrameDmaBuf(Ptr<DmaBufFrame>& frame)
+{
+    if (wCfg.device && wCfg.device->isSoftware())
+        CV_Error(cv::Error::StsError, "nextFrameDmaBuf() is not available on the software device");
+
+    RawInfo fi;
+    Ptr<Frame> pFrame = dequeueFrame(fi);
+    if (pFrame)
+    {
+        AL_TBuffer* pBuf = pFrame->getBuffer();
+        frame = makePtr<DmaBufFrameImpl>(pFrame, fi, dmaBufPlanes(pBuf, fi.cropLeft, fi.cropTop),
+                                         dmaBufModifier(fi.fourcc), pinRegistry_);
+        return DECODE_FRAME;
+    }
+
+    frame.reset();
+    return noFrameStatus();
+}
+
+Ptr<Frame> VCUDecoder::dequeueFrame(RawInfo& fi)
 {
     if (!initialized_ || !decodeCtx_)
         CV_Error(cv::Error::StsError, "Decoder not initialized");
@@ -404,15 +443,20 @@ DecodeStatus VCUDecoder::nextFrameFd(int& fd, RawInfo& frame_info)
 
     if (pFrame)
     {
-        AL_TBuffer* pBuf = pFrame->getBuffer();
-        AL_HANDLE hChunk = pBuf->hBufs[0];  // use chunk 0, not for bMultiChunk case
-        fd = AL_LinuxDmaAllocator_GetFd((AL_TLinuxDmaAllocator*)(pBuf->pAllocator), hChunk);
+        pFrame->rawInfo(fi);
+        fi.width  -= fi.cropLeft + fi.cropRight;
+        fi.height -= fi.cropTop  + fi.cropBottom;
+        fi.fourcc  = pFrame->getFourCC();
+        updateRawInfo(fi);
 
         ++frameIndex_;
         updateFramePosition();
-        return DECODE_FRAME;
     }
+    return pFrame;
+}
 
+DecodeStatus VCUDecoder::noFrameStatus()
+{
     if (decodeCtx_->eos())
     {
         decodeCtx_->finish();
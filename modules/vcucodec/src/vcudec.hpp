@@ -34,21 +34,29 @@ public:
     // Implementation of the pure virtual functions from base class
     virtual DecodeStatus nextFrame(Ptr<VideoFrame>& frame) override;
     virtual DecodeStatus nextFrameFd(int& fd, RawInfo& frame_info) override;
+    virtual DecodeStatus nextFrameDmaBuf(Ptr<DmaBufFrame>& frame) override;
     virtual bool   set(int propId, double value) override;
     virtual double get(int propId) const override;
     virtual String streamInfo() const override;
     virtual String statistics() const override;
+    virtual void   reset(const String& filename) override;
 
 private:
     bool   validateParams(const DecoderInitParams& params);
+    Ptr<DecContext::Config> createConfig();
     void   cleanup();
     void   updateRawInfo(const RawInfo& frame_info);
     bool   setCaptureProperty(int propId, double value, bool external);
     double getCaptureProperty(int propId) const;
     void   updateFramePosition();
+    /// Dequeue the next decoded frame, nullptr if none is ready; fi gets its post-crop info.
+    Ptr<Frame> dequeueFrame(RawInfo& fi);
+    /// Status when dequeueFrame() returned nothing: DECODE_EOS once drained, else DECODE_TIMEOUT.
+    DecodeStatus noFrameStatus();
 
     String filename_;
     DecoderInitParams params_;
+    Ptr<DecoderCallback> callback_;
     bool vcu_available_ = false;
     bool initialized_ = false;
     bool rawInfoInitialized_ = false;
@@ -21,6 +21,10 @@
 #include "vcuenccontext.hpp"
 #include "vcuframe.hpp"
 #include "vcuroimanager.hpp"
+#include "vcuvideoframe.hpp"
+#include "TwoPassMngr.h"
+
+#include "opencv2/imgproc.hpp"
 
 extern "C" {
 #include "lib_common/PixMapBuffer.h"
@@ -29,6 +33,7 @@ extern "C" {
 
 #include <array>
 #include <cstring>
+#include <fstream>
 #include <map>
 #include <iostream>
 #include <unistd.h>
@@ -228,6 +233,10 @@ private:
 
 VCUEncoder::~VCUEncoder()
 {
+    // A background flush from eosAsync() still references this encoder.
+    if (eosResult_.valid())
+        eosResult_.wait();
+
     auto pAllocator = device_->getAllocator();
 
     // Safety net in case eos() was never called: release imported dmabuf
@@ -242,11 +251,53 @@ VCUEncoder::VCUEncoder(const String& filename, const EncoderInitParams& params,
                        Ptr<EncoderCallback> callback)
 : filename_(filename), params_(params), callback_(callback), currentFrameIndex_(0), hEnc_(nullptr)
 {
-    if (!callback_)
+    defaultCallback_ = !callback_;
+    if (defaultCallback_)
         callback_.reset(new DefaultEncoderCallback(filename_));
     init(params, callback_);
 }
 
+void VCUEncoder::reset(const EncoderInitParams& params, const String& filename)
+{
+    // Finish the current stream so the channel is idle before it is re-created.
+    std::shared_future<bool> pending;
+    {
+        std::lock_guard<std::mutex> lock(eosMutex_);
+        pending = eosResult_;
+    }
+    if (pending.valid())
+        pending.get();
+    else if (!eosSent_ && (inputMode_ != InputMode::NONE || !importedHandles_.empty()))
+        eos();
+
+    // eos() gives up after drainTimeout, the old channel may then still read the imported
+    // handles and the RC DMA context: they are only torn down once the sink has completed.
+    if (eosSent_ && enc_ && !enc_->waitForCompletion(std::chrono::milliseconds(params_.drainTimeout)))
+        CV_Error(Error::StsError, cv::format("Encoder::reset(): the previous stream did not drain "
+                                             "within %d ms", params_.drainTimeout));
+    reclaimImportedBuffers();
+
+    AL_Allocator_Free(device_->getAllocator(), cfg_->Settings.hRcPluginDmaContext);
+
+    {
+        std::lock_guard<std::mutex> lock(eosMutex_);
+        eosResult_ = std::shared_future<bool>();
+    }
+    eosSent_ = false;
+    commandQueue_.clear();
+    currentFrameIndex_ = 0;
+    firstPassFrames_ = 0;
+    inputMode_ = InputMode::NONE;
+
+    if (!filename.empty())
+        filename_ = filename;
+    if (defaultCallback_)
+        callback_.reset(new DefaultEncoderCallback(filename_));
+
+    params_ = params;
+    init(params_, callback_);
+}
+
 void VCUEncoder::init(const EncoderInitParams& params, Ptr<EncoderCallback> callback)
 {
     callback_ = callback;
@@ -402,6 +453,19 @@ void VCUEncoder::init(const EncoderInitParams& params, Ptr<EncoderCallback> call
     cfg.MainInput.FileInfo.PictHeight = currentSettings_.pic_.height;
     cfg.MainInput.FileInfo.PictWidth = currentSettings_.pic_.width;
 
+    // A downscaled first pass encodes the input scaled down by VCUEncoder before submission.
+    firstPassScaler_.reset();
+    if (currentSettings_.rc_.twoPass == 1 && currentSettings_.rc_.twoPassDownscale > 1)
+    {
+        int factor = currentSettings_.rc_.twoPassDownscale;
+        firstPassSize_ = Size((currentSettings_.pic_.width / factor) & ~1,
+                              (currentSettings_.pic_.height / factor) & ~1);
+        firstPassScaler_.reset(new YuvScaler(currentSettings_.pic_.fourcc));
+        firstPassFrame_ = firstPassScaler_->createStacked(firstPassSize_);
+        cfg.MainInput.FileInfo.PictWidth = firstPassSize_.width;
+        cfg.MainInput.FileInfo.PictHeight = firstPassSize_.height;
+    }
+
     // Set picture format based on FourCC
     switch(cfg.MainInput.FileInfo.FourCC)
     {
@@ -546,6 +610,12 @@ void VCUEncoder::init(const EncoderInitParams& params, Ptr<EncoderCallback> call
 
     // LookAhead: frames analyzed by a first pass before the real encode. 0 disables it.
     cfg.Settings.LookAhead = currentSettings_.rc_.lookAhead;
+    cfg.iFileReadAhead = params.fileReadAhead;
+
+    // TwoPass: pass 1 writes the statistics log that pass 2 allocates its bits from.
+    cfg.Settings.TwoPass = currentSettings_.rc_.twoPass;
+    cfg.sTwoPassFileName = currentSettings_.rc_.twoPassLog;
+    cfg.bTwoPassGlobal = currentSettings_.rc_.twoPassGlobal;
 
     // GOP settings from currentSettings_.gop_
     chn.tGopParam.uGopLength = currentSettings_.gop_.gopLength;
@@ -658,11 +728,28 @@ void VCUEncoder::init(const EncoderInitParams& params, Ptr<EncoderCallback> call
                                             chn.uLog2MaxCuSize, /*background MEDIUM*/ 0,
                                             RoiOrder::QUALITY);
 
-    enc_ = EncContext::create(cfg_, device_,
-        [this](std::vector<std::string_view>& data)
-        {
-            callback_->onEncoded(data);
-        });
+    // Adaptive bitrate: the previous controller goes first so its UDP port is free again.
+    abr_.reset();
+    if (params.abrSettings.enable)
+        abr_ = AbrController::create(params.abrSettings, currentSettings_.rc_.bitrate,
+                                     currentSettings_.rc_.maxBitrate,
+                                     currentSettings_.pic_.framerate, commandQueue_);
+
+    if (enc_)
+        enc_->reset(cfg_); // reset(): keep the device (and pools when compatible)
+    else
+        enc_ = EncContext::create(cfg_, device_,
+            [this](std::vector<std::string_view>& data)
+            {
+                if (abr_)
+                {
+                    size_t bytes = 0;
+                    for (auto& chunk : data)
+                        bytes += chunk.size();
+                    abr_->onEncoded(bytes);
+                }
+                callback_->onEncoded(data);
+            });
     if (enc_)
     {
         hEnc_ = enc_->hEnc();
@@ -672,7 +759,24 @@ void VCUEncoder::init(const EncoderInitParams& params, Ptr<EncoderCallback> call
         // In frame mode (write()) the queue is drained inline; in file mode (writeFile()) the
         // worker thread calls this hook before submitting each frame.
         enc_->setFrameCommandHook([this](int32_t frameIndex){
-            commandQueue_.execute(frameIndex);
+            if (abr_)
+                abr_->onFrame(frameIndex);
+            commandQueue_.execute(frameIndex, *this);
+        });
+
+        // A downscaled first pass scales the writeFile() frames on the file worker.
+        if (firstPassScaler_)
+            enc_->setFileFrameReader([this](std::istream& file, const PictureEncSettings& pic,
+                                            int64_t frameIdx,
+                                            const std::shared_ptr<AL_TBuffer>& dst){
+                return readFrameDownscaled(file, pic, frameIdx, dst);
+            });
+        else
+            enc_->setFileFrameReader(nullptr);
+
+        // Give the decoder buffers lent by writeFrameDmaBuf() back as soon as they are encoded.
+        enc_->setSourceReleasedHook([this](AL_TBuffer const* pSrc){
+            leases_.release(pSrc);
         });
 
         // Cache the configured input format (e.g. I420). write(Mat) receives frames
@@ -696,10 +800,23 @@ void VCUEncoder::write(InputArray frame)
     }
     inputMode_ = InputMode::FRAME;
 
+    submitFrame(frame.getMat(), Size(currentSettings_.pic_.width, currentSettings_.pic_.height));
+}
+
+void VCUEncoder::submitFrame(const Mat& frame, Size size)
+{
     // Execute any pending commands for this frame
-    commandQueue_.execute(currentFrameIndex_);
+    if (abr_)
+        abr_->onFrame(currentFrameIndex_);
+    commandQueue_.execute(currentFrameIndex_, *this);
+
+    cv::Mat mat = frame;
+    if (firstPassScaler_)
+    {
+        scaleFirstPassFrame(frame, size);
+        mat = firstPassFrame_;
+    }
 
-    cv::Mat mat = frame.getMat();
     AL_TDimension tUpdatedDim = AL_TDimension { AL_GetSrcWidth(cfg_->Settings.tChParam[0]),
                                                 AL_GetSrcHeight(cfg_->Settings.tChParam[0]) };
     auto sourceBuffer = enc_->getSharedBuffer();
@@ -726,19 +843,94 @@ void VCUEncoder::writeFile(const String& filename, int startFrame, int numFrames
         effectiveSettings = makePtr<PictureEncSettings>(currentSettings_.pic_);
     }
 
+    if (firstPassScaler_ && effectiveSettings->fourcc != currentSettings_.pic_.fourcc)
+        CV_Error(Error::StsBadArg, "A downscaled first pass reads files in the encoder FourCC");
+
     // Queue the file for processing. Dynamic commands scheduled via the set*(frameIdx, ...)
     // API are applied by the file worker through the frame-command hook installed at
     // construction (see commandQueue_ wiring), so no per-frame draining is needed here.
     enc_->writeFile(filename, startFrame, numFrames, effectiveSettings);
 }
 
+void VCUEncoder::scaleFirstPassFrame(const Mat& frame, Size size)
+{
+    std::vector<Mat> srcPlanes, dstPlanes;
+    firstPassScaler_->planes(frame, size, srcPlanes);
+    firstPassScaler_->planes(firstPassFrame_, firstPassSize_, dstPlanes);
+    firstPassScaler_->scale(srcPlanes, dstPlanes);
+    firstPassFrames_++;
+}
+
+// A downscaled first pass scales every frame on the CPU before it reaches the encoder: the file
+// worker reads the writeFile() frames through this rather than through the ctrl-sw reader. It
+// runs on the file worker thread only, which write() and the fd paths never share.
+bool VCUEncoder::readFrameDownscaled(std::istream& file, const PictureEncSettings& pic,
+                                     int64_t frameIdx, const std::shared_ptr<AL_TBuffer>& dst)
+{
+    Size size(pic.width, pic.height);
+    if (fileFrame_.empty() || fileFrameSize_ != size)
+    {
+        fileFrame_ = firstPassScaler_->createStacked(size);
+        fileFrameSize_ = size;
+    }
+
+    std::streamsize frameSize = fileFrame_.total() * fileFrame_.elemSize();
+    if (!file.seekg(std::streamoff(frameIdx) * frameSize)
+        || !file.read(reinterpret_cast<char*>(fileFrame_.data), frameSize))
+        return false;
+
+    scaleFirstPassFrame(fileFrame_, size);
+    AL_TDimension tDim = AL_TDimension { firstPassSize_.width, firstPassSize_.height };
+    Frame::createFromMat(dst, firstPassFrame_, tDim, *srcFormatInfo_);
+    return true;
+}
+
 void VCUEncoder::writeFrameFd(int fd)
 {
     if (fd < 0)
         CV_Error(Error::StsBadArg, "Invalid fd passed to writeFrameFd");
+    writeImportedFd(fd, nullptr, {});
+}
+
+void VCUEncoder::writeFrameDmaBuf(const Ptr<DmaBufFrame>& frame)
+{
+    auto* impl = dynamic_cast<DmaBufFrameImpl*>(frame.get());
+    if (!impl)
+        CV_Error(Error::StsBadArg, "writeFrameDmaBuf() expects a frame from Decoder::nextFrameDmaBuf()");
+
+    std::vector<DmaBufPlane> planes = impl->planes();
+    for (const DmaBufPlane& plane : planes)
+        if (plane.fd != planes[0].fd)
+            CV_Error(Error::StsBadArg, "writeFrameDmaBuf() does not support frames in several buffer chunks");
+
+    std::shared_ptr<DmaBufLease> lease = impl->lease();
+    if (!lease)
+        CV_Error(Error::StsBadArg, "writeFrameDmaBuf() was passed a released frame");
+    writeImportedFd(planes[0].fd, std::move(lease), planes);
+}
+
+void VCUEncoder::writeImportedFd(int fd, std::shared_ptr<DmaBufLease> lease,
+                                 std::vector<DmaBufPlane> const& planes)
+{
+    if (firstPassScaler_)
+        CV_Error(Error::StsError, "writeFrameFd() / writeFrameDmaBuf() do not support a downscaled first pass");
+    if (device_->isSoftware())
+        CV_Error(Error::StsError, "writeFrameFd() / writeFrameDmaBuf() are not available on the software device");
 
     auto* pAllocator = device_->getAllocator();
 
+    // getSharedBuffer() blocks until a pooled source buffer is free, i.e. the
+    // encoder has finished with whatever it previously held in that buffer.
+    // Any import we attached to this buffer for an earlier frame is therefore
+    // now safe to release.
+    auto sourceBuffer = enc_->getSharedBuffer();
+    AL_TBuffer* key = sourceBuffer.get();
+
+    // The imported dmabuf replaces chunk 0 but keeps the plane layout of the pooled buffer,
+    // so a frame that describes its planes must match it.
+    if (!planes.empty())
+        checkDmaBufLayout(sourceBuffer.get(), planes);
+
     // Import the decoder-exported dmabuf. This takes a reference on the
     // underlying dma_buf; the matching AL_Allocator_Free() releases it.
     auto dmaHandle = AL_LinuxDmaAllocator_ImportFromFd((AL_TLinuxDmaAllocator*)pAllocator, fd);
@@ -748,13 +940,6 @@ void VCUEncoder::writeFrameFd(int fd)
         return;
     }
 
-    // getSharedBuffer() blocks until a pooled source buffer is free, i.e. the
-    // encoder has finished with whatever it previously held in that buffer.
-    // Any import we attached to this buffer for an earlier frame is therefore
-    // now safe to release.
-    auto sourceBuffer = enc_->getSharedBuffer();
-    AL_TBuffer* key = sourceBuffer.get();
-
     auto prev = importedHandles_.find(key);
     if (prev != importedHandles_.end())
     {
@@ -772,6 +957,11 @@ void VCUEncoder::writeFrameFd(int fd)
     sourceBuffer->hBufs[0] = dmaHandle; // zero-copy: encode directly from the imported dmabuf, chunk 0
     importedHandles_[key] = dmaHandle;
 
+    // The decoder buffer stays out of its pool until this picture is encoded, see the
+    // source released hook in init(). Registered before submission: EndEncoding may come at once.
+    if (lease)
+        leases_.hold(key, std::move(lease));
+
     enc_->writeBuf(sourceBuffer.get());
 
     // Do NOT close(fd): AL_LinuxDmaAllocator_GetFd() (decoder side) returns the
@@ -781,6 +971,8 @@ void VCUEncoder::writeFrameFd(int fd)
 
 void VCUEncoder::reclaimImportedBuffers()
 {
+    // The encoder no longer reads the decoder buffers still lent to it
+    leases_.releaseAll();
     if (importedHandles_.empty() && origChunks_.empty())
         return;
 
@@ -799,6 +991,29 @@ void VCUEncoder::reclaimImportedBuffers()
 
 bool VCUEncoder::eos()
 {
+    std::shared_future<bool> pending;
+    {
+        std::lock_guard<std::mutex> lock(eosMutex_);
+        pending = eosResult_;
+    }
+    // A flush is already running in the background: wait on it rather than sending EOS twice.
+    if (pending.valid())
+        return pending.get();
+    return flush();
+}
+
+std::shared_future<bool> VCUEncoder::eosAsync()
+{
+    std::lock_guard<std::mutex> lock(eosMutex_);
+    if (!eosResult_.valid())
+        eosResult_ = std::async(std::launch::async, &VCUEncoder::flush, this).share();
+    return eosResult_;
+}
+
+bool VCUEncoder::flush()
+{
+    eosSent_ = true;
+
     // Handle file mode - signal eos to the context which will join the worker thread
     if (inputMode_ == InputMode::FILE) {
         enc_->eos();
@@ -807,16 +1022,40 @@ bool VCUEncoder::eos()
         enc_->writeFrame(nullptr);
     }
 
-    // Wait for encoding to complete (max 1 second)
-    bool completed = enc_->waitForCompletion();
+    // Wait for encoding to complete (bounded by drainTimeout, unbounded when 0)
+    bool completed = enc_->waitForCompletion(std::chrono::milliseconds(params_.drainTimeout));
 
     // Encoder is now idle; release any imported dmabuf handles used by the
     // zero-copy writeFrameFd() path and restore the pool buffers' own memory.
-    reclaimImportedBuffers();
+    if (completed)
+    {
+        reclaimImportedBuffers();
+        callback_->onFinished();
+        checkFirstPassLog();
+    }
 
     return completed;
 }
 
+void VCUEncoder::checkFirstPassLog()
+{
+    // The second pass reads one log record per full-resolution frame it encodes: a downscaled
+    // first pass that lost or duplicated frames would shift every later allocation. All of its
+    // frames go through scaleFirstPassFrame(), which counts them. The stream itself is complete,
+    // so a mismatch is reported in statistics() rather than failing the drain.
+    if (!firstPassScaler_)
+        return;
+
+    int logged = AL_TwoPassMngr_CountLogFrames(currentSettings_.rc_.twoPassLog);
+    if (logged == firstPassFrames_)
+        return;
+
+    std::lock_guard<std::mutex> lock(eosMutex_);
+    firstPassLogError_ = cv::format("First pass log mismatch: %d frames logged for %d submitted to %s\n",
+                                    logged, (int)firstPassFrames_,
+                                    currentSettings_.rc_.twoPassLog.c_str());
+}
+
 String VCUEncoder::settings() const
 {
     return settingsString_;
@@ -824,7 +1063,9 @@ String VCUEncoder::settings() const
 
 String VCUEncoder::statistics() const
 {
-    return enc_? enc_->statistics() : String();
+    String stats = enc_? enc_->statistics() : String();
+    std::lock_guard<std::mutex> lock(eosMutex_);
+    return stats + firstPassLogError_;
 }
 
 bool VCUEncoder::set(int propId, double value)
@@ -950,30 +1191,205 @@ void VCUEncoder::get(SliceSettings& sliceSettings) const
 // Dynamic commands
 //
 
+namespace { // anonymous
+
+struct HDRPayload : CommandPayload
+{
+    explicit HDRPayload(const HDRSEIs& seis) : hdrSeis(seis) {}
+    HDRSEIs hdrSeis;
+};
+
+struct DynamicUpdatePayload : CommandPayload
+{
+    explicit DynamicUpdatePayload(const EncoderDynamicUpdate& u) : update(u) {}
+    EncoderDynamicUpdate update;
+};
+
+#ifdef HAVE_VCU2_CTRLSW
+struct AutoQPPayload : CommandPayload
+{
+    AL_TAutoQPCtrl tAutoQPCtrl;
+};
+#endif
+
+} // anonymous namespace
+
+void VCUEncoder::pushCommand(int32_t frameIdx, CommandType type, int32_t arg0, int32_t arg1,
+                             int32_t arg2, std::unique_ptr<CommandPayload> payload)
+{
+    Command cmd;
+    cmd.frameIndex = frameIdx;
+    cmd.type = type;
+    cmd.arg[0] = arg0;
+    cmd.arg[1] = arg1;
+    cmd.arg[2] = arg2;
+    cmd.payload = std::move(payload);
+    commandQueue_.push(std::move(cmd));
+}
+
+void VCUEncoder::executeCommand(const Command& cmd)
+{
+    // The software device has no encoder channel to apply the commands to.
+    if (!hEnc_)
+        return;
+
+    const int32_t* arg = cmd.arg;
+    switch (cmd.type)
+    {
+    case CommandType::SCENE_CHANGE:
+        AL_Encoder_NotifySceneChange(hEnc_, arg[0]);
+        break;
+    case CommandType::IS_LONG_TERM:
+        AL_Encoder_NotifyIsLongTerm(hEnc_);
+        break;
+    case CommandType::USE_LONG_TERM:
+        AL_Encoder_NotifyUseLongTerm(hEnc_);
+        break;
+#ifdef HAVE_VCU2_CTRLSW
+    case CommandType::IS_SKIP:
+        AL_Encoder_NotifyIsSkip(hEnc_);
+        break;
+    case CommandType::SAO:
+        CHECK(AL_Encoder_SetSAO(hEnc_, arg[0] != 0));
+        break;
+    case CommandType::AUTO_QP_THRESHOLD_AND_DELTA:
+    {
+        auto& payload = static_cast<AutoQPPayload&>(*cmd.payload);
+        CHECK(AL_Encoder_SetAutoQPThresholdAndDelta(hEnc_, arg[0] != 0, &payload.tAutoQPCtrl));
+        break;
+    }
+#endif
+    case CommandType::RESTART_GOP:
+        CHECK(AL_Encoder_RestartGop(hEnc_));
+        break;
+    case CommandType::RESTART_GOP_RECOVERY_POINT:
+        CHECK(AL_Encoder_RestartGopRecoveryPoint(hEnc_));
+        break;
+    case CommandType::GOP_LENGTH:
+        CHECK(AL_Encoder_SetGopLength(hEnc_, arg[0]));
+        break;
+    case CommandType::NUM_B:
+        CHECK(AL_Encoder_SetGopNumB(hEnc_, arg[0]));
+        break;
+    case CommandType::FREQ_IDR:
+        CHECK(AL_Encoder_SetFreqIDR(hEnc_, arg[0]));
+        break;
+    case CommandType::FRAME_RATE:
+        CHECK(AL_Encoder_SetFrameRate(hEnc_, arg[0], arg[1]));
+        break;
+    case CommandType::BIT_RATE:
+        CHECK(AL_Encoder_SetBitRate(hEnc_, arg[0]));
+        break;
+    case CommandType::MAX_BIT_RATE:
+        CHECK(AL_Encoder_SetMaxBitRate(hEnc_, arg[0], arg[1]));
+        break;
+    case CommandType::QP:
+        CHECK(AL_Encoder_SetQP(hEnc_, arg[0]));
+        break;
+    case CommandType::QP_OFFSET:
+        CHECK(AL_Encoder_SetQPOffset(hEnc_, arg[0]));
+        break;
+    case CommandType::QP_BOUNDS:
+        CHECK(AL_Encoder_SetQPBounds(hEnc_, arg[0], arg[1]));
+        break;
+    case CommandType::QP_BOUNDS_PER_FRAME_TYPE:
+        CHECK(AL_Encoder_SetQPBoundsPerFrameType(hEnc_, arg[0], arg[1],
+                                                 static_cast<AL_ESliceType>(arg[2])));
+        break;
+    case CommandType::QP_IP_DELTA:
+        CHECK(AL_Encoder_SetQPIPDelta(hEnc_, arg[0]));
+        break;
+    case CommandType::QP_PB_DELTA:
+        CHECK(AL_Encoder_SetQPPBDelta(hEnc_, arg[0]));
+        break;
+    case CommandType::LF_MODE:
+        CHECK(AL_Encoder_SetLoopFilterMode(hEnc_, arg[0]));
+        break;
+    case CommandType::LF_BETA_OFFSET:
+        CHECK(AL_Encoder_SetLoopFilterBetaOffset(hEnc_, arg[0]));
+        break;
+    case CommandType::LF_TC_OFFSET:
+        CHECK(AL_Encoder_SetLoopFilterTcOffset(hEnc_, arg[0]));
+        break;
+    case CommandType::COST_MODE:
+        CHECK(AL_Encoder_SetCostMode(hEnc_, arg[0] != 0));
+        break;
+    case CommandType::MAX_PICTURE_SIZE:
+        CHECK(AL_Encoder_SetMaxPictureSize(hEnc_, arg[0]));
+        break;
+    case CommandType::MAX_PICTURE_SIZE_PER_FRAME_TYPE:
+        CHECK(AL_Encoder_SetMaxPictureSizePerFrameType(hEnc_, arg[0],
+                                                       static_cast<AL_ESliceType>(arg[1])));
+        break;
+    case CommandType::QP_CHROMA_OFFSETS:
+        CHECK(AL_Encoder_SetQPChromaOffsets(hEnc_, arg[0], arg[1]));
+        break;
+    case CommandType::AUTO_QP:
+        CHECK(AL_Encoder_SetAutoQP(hEnc_, arg[0] != 0));
+        break;
+    case CommandType::HDR_SEIS:
+        CHECK(enc_->setHDRSEIs(static_cast<HDRPayload&>(*cmd.payload).hdrSeis));
+        break;
+    case CommandType::DYNAMIC_UPDATE:
+        applyDynamicUpdate(static_cast<DynamicUpdatePayload&>(*cmd.payload).update);
+        break;
+    default:
+        break;
+    }
+}
+
+// GOP structure first, then rate, then the QP controls; a GOP restart comes last so the new
+// GOP starts with the new settings.
+void VCUEncoder::applyDynamicUpdate(const EncoderDynamicUpdate& update)
+{
+    const int32_t KEEP = DYNAMIC_UPDATE_KEEP;
+    if (update.gopLength != KEEP)
+        CHECK(AL_Encoder_SetGopLength(hEnc_, update.gopLength));
+    if (update.numB != KEEP)
+        CHECK(AL_Encoder_SetGopNumB(hEnc_, update.numB));
+    if (update.freqIDR != KEEP)
+        CHECK(AL_Encoder_SetFreqIDR(hEnc_, update.freqIDR));
+    if (update.frameRate != KEEP)
+        CHECK(AL_Encoder_SetFrameRate(hEnc_, update.frameRate,
+                                      update.clockRatio != KEEP ? update.clockRatio : 1000));
+    if (update.maxBitRate != KEEP) {
+        CHECK(AL_Encoder_SetMaxBitRate(hEnc_, update.bitRate, update.maxBitRate));
+    } else if (update.bitRate != KEEP) {
+        CHECK(AL_Encoder_SetBitRate(hEnc_, update.bitRate));
+    }
+    if (update.minQP != KEEP)
+        CHECK(AL_Encoder_SetQPBounds(hEnc_, update.minQP, update.maxQP));
+    if (update.qp != KEEP)
+        CHECK(AL_Encoder_SetQP(hEnc_, update.qp));
+    if (update.qpIPDelta != KEEP)
+        CHECK(AL_Encoder_SetQPIPDelta(hEnc_, update.qpIPDelta));
+    if (update.qpPBDelta != KEEP)
+        CHECK(AL_Encoder_SetQPPBDelta(hEnc_, update.qpPBDelta));
+    if (update.maxPictureSize != KEEP)
+        CHECK(AL_Encoder_SetMaxPictureSize(hEnc_, update.maxPictureSize));
+    if (update.restartGop)
+        CHECK(AL_Encoder_RestartGop(hEnc_));
+}
+
 void VCUEncoder::setSceneChange(int32_t frameIdx, int32_t lookAhead)
 {
-    Command cmd = { frameIdx, false,
-        [this, lookAhead](){ AL_Encoder_NotifySceneChange(hEnc_, lookAhead); }};
-    commandQueue_.push(cmd);
+    pushCommand(frameIdx, CommandType::SCENE_CHANGE, lookAhead);
 }
 
 void VCUEncoder::setIsLongTerm(int32_t frameIdx)
 {
-    Command cmd = { frameIdx, false, [this](){ AL_Encoder_NotifyIsLongTerm(hEnc_); }};
-    commandQueue_.push(cmd);
+    pushCommand(frameIdx, CommandType::IS_LONG_TERM);
 }
 
 void VCUEncoder::setUseLongTerm(int32_t frameIdx)
 {
-    Command cmd = { frameIdx, false, [this](){ AL_Encoder_NotifyUseLongTerm(hEnc_); }};
-    commandQueue_.push(cmd);
+    pushCommand(frameIdx, CommandType::USE_LONG_TERM);
 }
 
 #ifdef HAVE_VCU2_CTRLSW
 void VCUEncoder::setIsSkip(int32_t frameIdx)
 {
-    Command cmd = { frameIdx, false, [this](){ AL_Encoder_NotifyIsSkip(hEnc_); }};
-    commandQueue_.push(cmd);
+    pushCommand(frameIdx, CommandType::IS_SKIP);
 }
 #else
 void VCUEncoder::setIsSkip(int32_t frameIdx)
@@ -986,9 +1402,7 @@ void VCUEncoder::setIsSkip(int32_t frameIdx)
 #ifdef HAVE_VCU2_CTRLSW
 void VCUEncoder::setSAO(int32_t frameIdx, bool bSAOEnabled)
 {
-    Command cmd = { frameIdx, false,
-                    [this, bSAOEnabled](){ CHECK(AL_Encoder_SetSAO(hEnc_, bSAOEnabled)); }};
-    commandQueue_.push(cmd);
+    pushCommand(frameIdx, CommandType::SAO, bSAOEnabled);
 }
 #else
 void VCUEncoder::setSAO(int32_t frameIdx, bool bSAOEnabled)
@@ -1002,234 +1416,158 @@ void VCUEncoder::setSAO(int32_t frameIdx, bool bSAOEnabled)
 
 void VCUEncoder::restartGop(int32_t frameIdx)
 {
-    Command cmd = { frameIdx, false, [this](){ CHECK(AL_Encoder_RestartGop(hEnc_)); }};
-    commandQueue_.push(cmd);
+    pushCommand(frameIdx, CommandType::RESTART_GOP);
 }
 
 void VCUEncoder::restartGopRecoveryPoint(int32_t frameIdx)
 {
-    Command cmd = { frameIdx, false, [this](){ CHECK(AL_Encoder_RestartGopRecoveryPoint(hEnc_)); }};
-    commandQueue_.push(cmd);
+    pushCommand(frameIdx, CommandType::RESTART_GOP_RECOVERY_POINT);
 }
 
 void VCUEncoder::setGopLength(int32_t frameIdx, int32_t gopLength)
 {
-    Command cmd = { frameIdx, false,
-                    [this, gopLength](){ CHECK(AL_Encoder_SetGopLength(hEnc_, gopLength)); }};
-    commandQueue_.push(cmd);
+    pushCommand(frameIdx, CommandType::GOP_LENGTH, gopLength);
 }
 
 void VCUEncoder::setNumB(int32_t frameIdx, int32_t numB)
 {
-    Command cmd = { frameIdx, false, [this, numB](){ CHECK(AL_Encoder_SetGopNumB(hEnc_, numB)); }};
-    commandQueue_.push(cmd);
+    pushCommand(frameIdx, CommandType::NUM_B, numB);
 }
 
 void VCUEncoder::setFreqIDR(int32_t frameIdx, int32_t freqIDR)
 {
-    Command cmd = { frameIdx, false,
-                    [this, freqIDR](){ CHECK(AL_Encoder_SetFreqIDR(hEnc_, freqIDR)); }};
-    commandQueue_.push(cmd);
+    pushCommand(frameIdx, CommandType::FREQ_IDR, freqIDR);
 }
 
 void VCUEncoder::setFrameRate(int32_t frameIdx, int32_t frameRate, int32_t clockRatio)
 {
-    Command cmd = { frameIdx, false,
-        [this, frameRate, clockRatio]()
-        {
-            CHECK(AL_Encoder_SetFrameRate(hEnc_, frameRate, clockRatio));
-        }};
-    commandQueue_.push(cmd);
+    pushCommand(frameIdx, CommandType::FRAME_RATE, frameRate, clockRatio);
 }
 
 void VCUEncoder::setBitRate(int32_t frameIdx, int32_t bitRate)
 {
-    Command cmd = { frameIdx, false,
-                    [this, bitRate](){ CHECK(AL_Encoder_SetBitRate(hEnc_, bitRate)); }};
-    commandQueue_.push(cmd);
+    pushCommand(frameIdx, CommandType::BIT_RATE, bitRate);
 }
 
 void VCUEncoder::setMaxBitRate(int32_t frameIdx, int32_t iTargetBitRate, int32_t iMaxBitRate)
 {
-    Command cmd = { frameIdx, false,
-        [this, iTargetBitRate, iMaxBitRate]()
-        {
-            CHECK(AL_Encoder_SetMaxBitRate(hEnc_, iTargetBitRate, iMaxBitRate));
-        }};
-    commandQueue_.push(cmd);
+    pushCommand(frameIdx, CommandType::MAX_BIT_RATE, iTargetBitRate, iMaxBitRate);
 }
 
 void VCUEncoder::setQP(int32_t frameIdx, int32_t qp)
 {
-    Command cmd = { frameIdx, false, [this, qp](){ CHECK(AL_Encoder_SetQP(hEnc_, qp)); }};
-    commandQueue_.push(cmd);
+    pushCommand(frameIdx, CommandType::QP, qp);
 }
 
 void VCUEncoder::setQPOffset(int32_t frameIdx, int32_t iQpOffset)
 {
-    Command cmd = { frameIdx, false,
-        [this, iQpOffset]()
-        {
-            CHECK(AL_Encoder_SetQPOffset(hEnc_, iQpOffset));
-        }};
-    commandQueue_.push(cmd);
+    pushCommand(frameIdx, CommandType::QP_OFFSET, iQpOffset);
 }
 
 void VCUEncoder::setQPBounds(int32_t frameIdx, int32_t iMinQP, int32_t iMaxQP)
 {
-    Command cmd = { frameIdx, false,
-        [this, iMinQP, iMaxQP](){ CHECK(AL_Encoder_SetQPBounds(hEnc_, iMinQP, iMaxQP)); }};
-    commandQueue_.push(cmd);
+    pushCommand(frameIdx, CommandType::QP_BOUNDS, iMinQP, iMaxQP);
 }
 
 void VCUEncoder::setQPBoundsI(int32_t frameIdx, int32_t iMinQP_I, int32_t iMaxQP_I)
 {
-    Command cmd = { frameIdx, false,
-        [this, iMinQP_I, iMaxQP_I]()
-        {
-            CHECK(AL_Encoder_SetQPBoundsPerFrameType(hEnc_, iMinQP_I, iMaxQP_I, AL_SLICE_I));
-        }};
-    commandQueue_.push(cmd);
+    pushCommand(frameIdx, CommandType::QP_BOUNDS_PER_FRAME_TYPE, iMinQP_I, iMaxQP_I, AL_SLICE_I);
 }
 
 void VCUEncoder::setQPBoundsP(int32_t frameIdx, int32_t iMinQP_P, int32_t iMaxQP_P)
 {
-    Command cmd = { frameIdx, false,
-        [this, iMinQP_P, iMaxQP_P]()
-        {
-            CHECK(AL_Encoder_SetQPBoundsPerFrameType(hEnc_, iMinQP_P, iMaxQP_P, AL_SLICE_P));
-        }};
-    commandQueue_.push(cmd);
+    pushCommand(frameIdx, CommandType::QP_BOUNDS_PER_FRAME_TYPE, iMinQP_P, iMaxQP_P, AL_SLICE_P);
 }
 
 void VCUEncoder::setQPBoundsB(int32_t frameIdx, int32_t iMinQP_B, int32_t iMaxQP_B)
 {
-    Command cmd = { frameIdx, false,
-        [this, iMinQP_B, iMaxQP_B]()
-        {
-            CHECK(AL_Encoder_SetQPBoundsPerFrameType(hEnc_, iMinQP_B, iMaxQP_B, AL_SLICE_B));
-        }};
-    commandQueue_.push(cmd);
+    pushCommand(frameIdx, CommandType::QP_BOUNDS_PER_FRAME_TYPE, iMinQP_B, iMaxQP_B, AL_SLICE_B);
 }
 
 void VCUEncoder::setQPIPDelta(int32_t frameIdx, int32_t iQPDelta)
 {
-    Command cmd = { frameIdx, false,
-                    [this, iQPDelta](){ CHECK(AL_Encoder_SetQPIPDelta(hEnc_, iQPDelta)); }};
-    commandQueue_.push(cmd);
+    pushCommand(frameIdx, CommandType::QP_IP_DELTA, iQPDelta);
 }
 
 void VCUEncoder::setQPPBDelta(int32_t frameIdx, int32_t iQPDelta)
 {
-    Command cmd = { frameIdx, false,
-                    [this, iQPDelta](){ CHECK(AL_Encoder_SetQPPBDelta(hEnc_, iQPDelta)); }};
-    commandQueue_.push(cmd);
+    pushCommand(frameIdx, CommandType::QP_PB_DELTA, iQPDelta);
 }
 
 void VCUEncoder::setLFMode(int32_t frameIdx, int32_t iMode)
 {
-    Command cmd = { frameIdx, false,
-                    [this, iMode](){ CHECK(AL_Encoder_SetLoopFilterMode(hEnc_, iMode)); }};
-    commandQueue_.push(cmd);
+    pushCommand(frameIdx, CommandType::LF_MODE, iMode);
 }
 
 void VCUEncoder::setLFBetaOffset(int32_t frameIdx, int32_t iBetaOffset)
 {
-    Command cmd = { frameIdx, false,
-        [this, iBetaOffset](){ CHECK(AL_Encoder_SetLoopFilterBetaOffset(hEnc_, iBetaOffset)); }};
-    commandQueue_.push(cmd);
+    pushCommand(frameIdx, CommandType::LF_BETA_OFFSET, iBetaOffset);
 }
 
 void VCUEncoder::setLFTcOffset(int32_t frameIdx, int32_t iTcOffset)
 {
-    Command cmd = { frameIdx, false,
-        [this, iTcOffset](){ CHECK(AL_Encoder_SetLoopFilterTcOffset(hEnc_, iTcOffset)); }};
-    commandQueue_.push(cmd);
+    pushCommand(frameIdx, CommandType::LF_TC_OFFSET, iTcOffset);
 }
 
 void VCUEncoder::setCostMode(int32_t frameIdx, bool bCostMode)
 {
-    Command cmd = { frameIdx, false,
-                    [this, bCostMode](){ CHECK(AL_Encoder_SetCostMode(hEnc_, bCostMode)); }};
-    commandQueue_.push(cmd);
+    pushCommand(frameIdx, CommandType::COST_MODE, bCostMode);
 }
 
 void VCUEncoder::setMaxPictureSize(int32_t frameIdx, int32_t iMaxPictureSize)
 {
-    Command cmd = { frameIdx, false,
-        [this, iMaxPictureSize](){ CHECK(AL_Encoder_SetMaxPictureSize(hEnc_, iMaxPictureSize)); }};
-    commandQueue_.push(cmd);
+    pushCommand(frameIdx, CommandType::MAX_PICTURE_SIZE, iMaxPictureSize);
 }
 
 void VCUEncoder::setMaxPictureSizeI(int32_t frameIdx, int32_t iMaxPictureSize_I)
 {
-    Command cmd = { frameIdx, false,
-        [this, iMaxPictureSize_I]()
-        {
-            CHECK(AL_Encoder_SetMaxPictureSizePerFrameType(hEnc_, iMaxPictureSize_I, AL_SLICE_I));
-        }};
-    commandQueue_.push(cmd);
+    pushCommand(frameIdx, CommandType::MAX_PICTURE_SIZE_PER_FRAME_TYPE, iMaxPictureSize_I,
+                AL_SLICE_I);
 }
 
 void VCUEncoder::setMaxPictureSizeP(int32_t frameIdx, int32_t iMaxPictureSize_P)
 {
-    Command cmd = { frameIdx, false,
-        [this, iMaxPictureSize_P]()
-        {
-            CHECK(AL_Encoder_SetMaxPictureSizePerFrameType(hEnc_, iMaxPictureSize_P, AL_SLICE_P));
-        }};
-    commandQueue_.push(cmd);
+    pushCommand(frameIdx, CommandType::MAX_PICTURE_SIZE_PER_FRAME_TYPE, iMaxPictureSize_P,
+                AL_SLICE_P);
 }
 
 void VCUEncoder::setMaxPictureSizeB(int32_t frameIdx, int32_t iMaxPictureSize_B)
 {
-    Command cmd = { frameIdx, false,
-        [this, iMaxPictureSize_B]()
-        {
-            CHECK(AL_Encoder_SetMaxPictureSizePerFrameType(hEnc_, iMaxPictureSize_B, AL_SLICE_B));
-        }};
-    commandQueue_.push(cmd);
+    pushCommand(frameIdx, CommandType::MAX_PICTURE_SIZE_PER_FRAME_TYPE, iMaxPictureSize_B,
+                AL_SLICE_B);
 }
 
 void VCUEncoder::setQPChromaOffsets(int32_t frameIdx, int32_t iQp1Offset, int32_t iQp2Offset)
 {
-    Command cmd = { frameIdx, false,
-        [this, iQp1Offset, iQp2Offset]()
-        {
-            CHECK(AL_Encoder_SetQPChromaOffsets(hEnc_, iQp1Offset, iQp2Offset));
-        }};
-    commandQueue_.push(cmd);
+    pushCommand(frameIdx, CommandType::QP_CHROMA_OFFSETS, iQp1Offset, iQp2Offset);
 }
 
 void VCUEncoder::setAutoQP(int32_t frameIdx, bool bUseAutoQP)
 {
-    Command cmd = { frameIdx, false,
-                    [this, bUseAutoQP](){ CHECK(AL_Encoder_SetAutoQP(hEnc_, bUseAutoQP)); }};
-    commandQueue_.push(cmd);
+    pushCommand(frameIdx, CommandType::AUTO_QP, bUseAutoQP);
 }
 
 #ifdef HAVE_VCU2_CTRLSW
 void VCUEncoder::setAutoQPThresholdQPAndDeltaQP(int32_t frameIdx, bool bEnableUserAutoQPValues,
         std::vector<int> thresholdQP, std::vector<int> deltaQP)
 {
-    Command cmd = { frameIdx, false, [this, bEnableUserAutoQPValues, thresholdQP, deltaQP](){
-        AL_TAutoQPCtrl tAutoQPCtrl;
-        if (bEnableUserAutoQPValues) {
-            for (int32_t i = 0; i < AL_QP_CTRL_MAX_NUM_THRESHOLDS
-                                && i < static_cast<int32_t>(thresholdQP.size()); i++) {
-                tAutoQPCtrl.thresholdQP[i] = thresholdQP[i];
-            }
-            for (int32_t i = 0; i < AL_QP_CTRL_MAX_NUM_THRESHOLDS
-                                && i < static_cast<int32_t>(deltaQP.size()); i++) {
-                tAutoQPCtrl.deltaQP[i] = deltaQP[i];
-            }
-            if (!deltaQP.empty()) {
-                tAutoQPCtrl.deltaQP[AL_QP_CTRL_MAX_NUM_THRESHOLDS] = deltaQP.back();
-            }
+    auto payload = std::make_unique<AutoQPPayload>();
+    AL_TAutoQPCtrl& tAutoQPCtrl = payload->tAutoQPCtrl;
+    if (bEnableUserAutoQPValues) {
+        for (int32_t i = 0; i < AL_QP_CTRL_MAX_NUM_THRESHOLDS
+                            && i < static_cast<int32_t>(thresholdQP.size()); i++) {
+            tAutoQPCtrl.thresholdQP[i] = thresholdQP[i];
+        }
+        for (int32_t i = 0; i < AL_QP_CTRL_MAX_NUM_THRESHOLDS
+                            && i < static_cast<int32_t>(deltaQP.size()); i++) {
+            tAutoQPCtrl.deltaQP[i] = deltaQP[i];
+        }
+        if (!deltaQP.empty()) {
+            tAutoQPCtrl.deltaQP[AL_QP_CTRL_MAX_NUM_THRESHOLDS] = deltaQP.back();
         }
-        CHECK(AL_Encoder_SetAutoQPThresholdAndDelta(hEnc_, bEnableUserAutoQPValues, &tAutoQPCtrl));
-    }};
-    commandQueue_.push(cmd);
+    }
+    pushCommand(frameIdx, CommandType::AUTO_QP_THRESHOLD_AND_DELTA, bEnableUserAutoQPValues,
+                0, 0, std::move(payload));
 }
 #else
 void VCUEncoder::setAutoQPThresholdQPAndDeltaQP(int32_t frameIdx, bool bEnableUserAutoQPValues,
@@ -1245,12 +1583,31 @@ void VCUEncoder::setAutoQPThresholdQPAndDeltaQP(int32_t frameIdx, bool bEnableUs
 }
 #endif
 
+void VCUEncoder::setDynamicUpdate(int32_t frameIdx, const EncoderDynamicUpdate& update)
+{
+    const int32_t KEEP = DYNAMIC_UPDATE_KEEP;
+    if (update.maxBitRate != KEEP && update.bitRate == KEEP)
+        CV_Error(cv::Error::StsBadArg, "EncoderDynamicUpdate: maxBitRate requires bitRate");
+    if (update.clockRatio != KEEP && update.frameRate == KEEP)
+        CV_Error(cv::Error::StsBadArg, "EncoderDynamicUpdate: clockRatio requires frameRate");
+    if ((update.minQP == KEEP) != (update.maxQP == KEEP))
+        CV_Error(cv::Error::StsBadArg, "EncoderDynamicUpdate: minQP and maxQP go together");
+    pushCommand(frameIdx, CommandType::DYNAMIC_UPDATE, 0, 0, 0,
+                std::make_unique<DynamicUpdatePayload>(update));
+}
+
+void VCUEncoder::setBandwidthEstimate(int kbps)
+{
+    if (!abr_)
+        CV_Error(cv::Error::StsError, "setBandwidthEstimate() requires AbrSettings::enable");
+    if (kbps <= 0)
+        CV_Error(cv::Error::StsBadArg, "Bandwidth estimate must be greater than 0");
+    abr_->setBandwidthEstimate(kbps);
+}
+
 void VCUEncoder::setHDR(int32_t frameIdx, const HDRSEIs& hdrSeis)
 {
-    Command cmd = { frameIdx, false, [this, hdrSeis](){
-        CHECK(enc_->setHDRSEIs(hdrSeis));
-    }};
-    commandQueue_.push(cmd);
+    pushCommand(frameIdx, CommandType::HDR_SEIS, 0, 0, 0, std::make_unique<HDRPayload>(hdrSeis));
 }
 
 bool VCUEncoder::validateSettings()
@@ -1284,8 +1641,46 @@ bool VCUEncoder::validateSettings()
     if (!valid) CV_Error(Error::StsBadArg, "Width must be in the range [1, 8192]");
     valid = pic.height > 0 && pic.height <= 2160; // Max height 4K
     if (!valid) CV_Error(Error::StsBadArg, "Height must be in the range [1, 2160]");
+    valid = params_.drainTimeout >= 0;
+    if (!valid) CV_Error(Error::StsBadArg, "drainTimeout must be >= 0");
+    valid = params_.fileReadAhead >= 0 && params_.fileReadAhead <= 16;
+    if (!valid) CV_Error(Error::StsBadArg, "fileReadAhead must be in the range [0, 16]");
     valid = rc.maxQualityTarget >= 0 && rc.maxQualityTarget <= 20;
     if (!valid) CV_Error(Error::StsBadArg, "maxQualityTarget must be in the range [0, 20]");
+    const AbrSettings& abr = params_.abrSettings;
+    if (abr.enable)
+    {
+        valid = rc.mode == RCMode::CBR || rc.mode == RCMode::VBR || rc.mode == RCMode::LOW_LATENCY
+             || rc.mode == RCMode::CAPPED_VBR;
+        if (!valid) CV_Error(Error::StsBadArg, "ABR requires a bitrate rate-control mode");
+        valid = abr.aggressiveness > 0 && abr.aggressiveness <= 1
+             && abr.headroom > 0 && abr.headroom <= 1;
+        if (!valid) CV_Error(Error::StsBadArg, "ABR aggressiveness and headroom must be in (0, 1]");
+        valid = abr.minBitrate > 0 && (abr.maxBitrate == 0 || abr.maxBitrate >= abr.minBitrate);
+        if (!valid) CV_Error(Error::StsBadArg, "ABR bitrate range is invalid");
+        valid = abr.updateInterval >= 1 && abr.udpPort >= 0 && abr.udpPort <= 65535;
+        if (!valid) CV_Error(Error::StsBadArg, "ABR updateInterval must be >= 1, udpPort a port");
+    }
+    valid = rc.twoPass >= 0 && rc.twoPass <= 2;
+    if (!valid) CV_Error(Error::StsBadArg, "twoPass must be 0, 1 or 2");
+    if (rc.twoPass != 0)
+    {
+        valid = rc.lookAhead == 0 && !slice.subframeLatency;
+        if (!valid) CV_Error(Error::StsBadArg,
+            "Two-pass encoding is exclusive with lookAhead and subframe latency");
+        valid = !rc.twoPassLog.empty();
+        if (!valid) CV_Error(Error::StsBadArg, "Two-pass encoding needs twoPassLog");
+        valid = rc.twoPass == 1 || std::ifstream(rc.twoPassLog).good();
+        if (!valid) CV_Error(Error::StsBadArg, "Cannot open twoPassLog " + rc.twoPassLog);
+        valid = rc.twoPass == 1 || rc.mode == RCMode::CBR || rc.mode == RCMode::VBR
+             || rc.mode == RCMode::CAPPED_VBR;
+        if (!valid) CV_Error(Error::StsBadArg, "The second pass requires CBR, VBR or CAPPED_VBR");
+        valid = rc.twoPassDownscale == 1 || rc.twoPassDownscale == 2 || rc.twoPassDownscale == 4;
+        if (!valid) CV_Error(Error::StsBadArg, "twoPassDownscale must be 1, 2 or 4");
+        valid = rc.twoPass == 2 || rc.twoPassDownscale == 1 || YuvScaler::supported(pic.fourcc);
+        if (!valid) CV_Error(Error::StsBadArg,
+            "twoPassDownscale is not supported for the input FourCC (packed or tiled)");
+    }
     // Slice count limits: AVC supports 1-256, HEVC supports 1-128
     int maxSlices = (pic.codec == Codec::AVC) ? 256 : 128;
     valid = slice.numSlices >= 1 && slice.numSlices <= maxSlices;
@@ -1377,7 +1772,8 @@ int qualityToCode(ROIQuality quality)
 
 /// RegionOfInterest handle backed by a region registered in the shared RoiManager.
 /// enable/disable/setOrder forward to the manager (which is queried per frame while
-/// encoding); the immutable region/quality/deltaQP are cached for the getters.
+/// encoding); the immutable region/quality/deltaQP are cached for the getters. Releasing
+/// the handle removes the region from the manager.
 class VCURegionOfInterest : public RegionOfInterest
 {
 public:
@@ -1385,6 +1781,11 @@ public:
                         ROIQuality quality, int deltaQP)
         : mgr_(std::move(mgr)), id_(id), region_(region), quality_(quality), deltaQP_(deltaQP) {}
 
+    ~VCURegionOfInterest()
+    {
+        if (auto m = mgr_.lock()) m->removeRegion(id_);
+    }
+
     void enable(int32_t frameIdx) override
     {
         if (auto m = mgr_.lock()) m->enableRegion(id_, frameIdx);
@@ -1457,6 +1858,26 @@ Ptr<RegionOfInterest> VCUEncoder::createROIBackgroundByValue(int deltaQP, ROIOrd
     return makePtr<VCURegionOfInterest>(roiMngr_, id, full, ROIQuality::MEDIUM, deltaQP);
 }
 
+void VCUEncoder::setRegions(int32_t frameIdx, const std::vector<Rect>& regions,
+                            const std::vector<int>& deltaQP)
+{
+    if (regions.size() != deltaQP.size())
+        CV_Error(Error::StsBadArg, "setRegions: regions and deltaQP must have the same size");
+
+    auto& chn = cfg_->Settings.tChParam[0];
+    Rect full(0, 0, AL_GetSrcWidth(chn), AL_GetSrcHeight(chn));
+    std::vector<RoiManager::FrameRegion> frameRegions;
+    frameRegions.reserve(regions.size());
+    for (size_t i = 0; i < regions.size(); ++i)
+    {
+        Rect r = regions[i] & full;
+        if (r.empty())
+            continue;
+        frameRegions.push_back(RoiManager::FrameRegion{r.x, r.y, r.width, r.height, deltaQP[i]});
+    }
+    roiMngr_->setFrameRegions(frameIdx, frameRegions);
+}
+
 //
 // QP table (per-block quantization control)
 //
@@ -1488,6 +1909,47 @@ size_t VCUEncoder::qpTableBufferSize() const
     return (sz + 127) & ~static_cast<size_t>(127);   // 128-byte aligned (EP2 QP-by-MB region)
 }
 
+namespace { // anonymous
+
+/// QpTableBuffer over a buffer of the encoder context's QP-table pool. The buffer keeps its pool
+/// alive, so it may outlive the channel; commit() only schedules it on the channel it came from.
+class VCUQpTableBuffer : public QpTableBuffer
+{
+public:
+    VCUQpTableBuffer(Ptr<EncContext> enc, std::shared_ptr<AL_TBuffer> buffer, size_t size)
+        : enc_(std::move(enc)), generation_(enc_->channelGeneration()),
+          buffer_(std::move(buffer)),
+          data_(1, static_cast<int>(size), CV_8UC1,
+                AL_Buffer_GetData(buffer_.get()) + EP2_BUF_QP_BY_MB.Offset) {}
+
+    Mat data() override { return data_; }
+
+    void commit(int32_t frameIdx) override
+    {
+        if (!buffer_)
+            CV_Error(cv::Error::StsError, "QpTableBuffer::commit: already committed");
+        if (enc_->channelGeneration() == generation_)
+            enc_->commitQpTable(frameIdx, std::move(buffer_));
+        buffer_.reset(); // the encoder was reset since: the table is dropped
+    }
+
+private:
+    Ptr<EncContext> enc_;
+    uint64_t generation_;
+    std::shared_ptr<AL_TBuffer> buffer_;
+    Mat data_;
+};
+
+} // anonymous namespace
+
+Ptr<QpTableBuffer> VCUEncoder::newQpTableBuffer()
+{
+    std::shared_ptr<AL_TBuffer> buffer = enc_ ? enc_->getQpTableBuffer() : nullptr;
+    if (!buffer)
+        return nullptr;
+    return makePtr<VCUQpTableBuffer>(enc_, std::move(buffer), qpTableBufferSize());
+}
+
 void VCUEncoder::setQpTable(int32_t frameIdx, InputArray qpTable, QpTableMode mode)
 {
     const AL_EQpTableMode armed = cfg_->Settings.eQpTableMode;
@@ -1506,9 +1968,89 @@ void VCUEncoder::setQpTable(int32_t frameIdx, InputArray qpTable, QpTableMode mo
             "setQpTable: qpTable must be a continuous CV_8U buffer of exactly %zu bytes "
             "(qpTableBufferSize())", expected));
 
-    const uint8_t* p = t.ptr<uint8_t>(0);
-    if (enc_)
-        enc_->setQpTable(frameIdx, std::vector<uint8_t>(p, p + expected));
+    // Written straight into a pool buffer when one is free, scheduled as a copy otherwise.
+    Ptr<QpTableBuffer> buffer = newQpTableBuffer();
+    if (buffer)
+    {
+        std::memcpy(buffer->data().ptr(), t.ptr<uint8_t>(0), expected);
+        buffer->commit(frameIdx);
+    }
+    else if (enc_)
+        enc_->setQpTable(frameIdx, std::vector<uint8_t>(t.ptr<uint8_t>(0),
+                                                        t.ptr<uint8_t>(0) + expected));
+}
+
+void VCUEncoder::setQpTableFromSaliency(int32_t frameIdx, InputArray saliency, int qpSpread)
+{
+    if (cfg_->Settings.eQpTableMode != AL_QP_TABLE_RELATIVE)
+        CV_Error(cv::Error::StsBadArg,
+                 "setQpTableFromSaliency: requires the RELATIVE QP-table mode "
+                 "(EncoderInitParams::qpTableMode).");
+    bool valid = qpSpread >= 0 && qpSpread <= 51;
+    if (!valid)
+        CV_Error(cv::Error::StsBadArg, "setQpTableFromSaliency: qpSpread must be in range [0, 51]");
+    Mat map = saliency.getMat();
+    if (map.empty() || map.channels() != 1)
+        CV_Error(cv::Error::StsBadArg,
+                 "setQpTableFromSaliency: saliency must be a non-empty single-channel map");
+
+    // One importance value per LCU.
+    const Size grid = qpTableGridSize();
+    Mat importance;
+    map.convertTo(importance, CV_32F);
+    resize(importance, importance, grid, 0, 0, INTER_AREA);
+
+    // dQP = qpSpread * (mean - importance) / (max - min), rounded and clamped.
+    double minVal = 0, maxVal = 0;
+    minMaxLoc(importance, &minVal, &maxVal);
+    const double scale = (maxVal > minVal) ? -qpSpread / (maxVal - minVal) : 0.0;
+    const double mean = cv::mean(importance)[0];
+    Mat dqp;
+    importance.convertTo(dqp, CV_32S, scale, -scale * mean);
+    cv::min(dqp, 31, dqp);
+    cv::max(dqp, -32, dqp);
+
+    // Pack one record per LCU: the CTB-level dQP, no force flags or size constraints, lambda
+    // factor 1.0 and zero sub-block deltas (see RoiManager::fillBuffer()).
+    const int bytesPerLCU = qpTableBytesPerLCU();
+    Ptr<QpTableBuffer> buffer = newQpTableBuffer();
+    std::vector<uint8_t> copy;
+    if (!buffer)
+        copy.resize(qpTableBufferSize());
+    uint8_t* table = buffer ? buffer->data().ptr() : copy.data();
+    const int32_t* d = dqp.ptr<int32_t>(0);
+    for (int i = 0; i < grid.area(); ++i)
+    {
+        uint8_t* record = table + static_cast<size_t>(i) * bytesPerLCU;
+        if (bytesPerLCU == 1)
+        {
+            record[0] = static_cast<uint8_t>(d[i]) & MASK_QP;
+        }
+        else
+        {
+            record[0] = static_cast<uint8_t>(d[i]);
+            record[3] = DEFAULT_LAMBDA_FACT;
+        }
+    }
+
+    if (buffer)
+        buffer->commit(frameIdx);
+    else if (enc_)
+        enc_->setQpTable(frameIdx, std::move(copy));
+}
+
+Ptr<QpTableBuffer> VCUEncoder::acquireQpTableBuffer()
+{
+    if (device_->isSoftware())
+        CV_Error(cv::Error::StsError, "acquireQpTableBuffer() is not available on the software device");
+    if (!AL_IS_QP_TABLE_REQUIRED(cfg_->Settings.eQpTableMode))
+        CV_Error(cv::Error::StsError, "acquireQpTableBuffer: the encoder has no QP-table path");
+    Ptr<QpTableBuffer> buffer = newQpTableBuffer();
+    if (!buffer)
+        CV_Error(cv::Error::StsError,
+                 "acquireQpTableBuffer: no free QP-table buffer (too many tables held or "
+                 "scheduled); setQpTable() has no such limit");
+    return buffer;
 }
 
 // Static functions
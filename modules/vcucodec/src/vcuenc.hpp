@@ -15,11 +15,17 @@
 */
 #include "opencv2/vcucodec.hpp"
 
+#include "vcuabrcontroller.hpp"
 #include "vcuenccontext.hpp"
 #include "vcucommand.hpp"
+#include "vcuscaler.hpp"
 #include "vcuutils.hpp"
+#include "vcuvideoframe.hpp"
 
+#include <atomic>
+#include <future>
 #include <map>
+#include <mutex>
 
 extern "C"
 {
@@ -34,7 +40,7 @@ namespace cv {
 namespace vcucodec {
 class Device;
 class RoiManager;
-class VCUEncoder : public Encoder
+class VCUEncoder : public Encoder, private CommandExecutor
 {
 public:
     // Input mode tracking - write() and writeFile() are mutually exclusive
@@ -61,7 +67,10 @@ public:
     virtual void writeFile(const String& filename, int startFrame = 0, int numFrames = 0,
                            Ptr<PictureEncSettings> picSettings = nullptr) override;
     virtual void writeFrameFd(int fd) override;
+    virtual void writeFrameDmaBuf(const Ptr<DmaBufFrame>& frame) override;
     virtual bool eos() override;
+    virtual std::shared_future<bool> eosAsync() override;
+    virtual void reset(const EncoderInitParams& params, const String& filename = String()) override;
     virtual String settings() const override;
     virtual String statistics() const override;
 
@@ -115,6 +124,8 @@ public:
     virtual void setHDR(int32_t frameIdx, const HDRSEIs& hdrSeis) override;
     virtual void setAutoQPThresholdQPAndDeltaQP(int32_t frameIdx, bool bEnableUserAutoQPValues,
             std::vector<int> thresholdQP, std::vector<int> deltaQP) override;
+    virtual void setDynamicUpdate(int32_t frameIdx, const EncoderDynamicUpdate& update) override;
+    virtual void setBandwidthEstimate(int kbps) override;
     virtual void setIsSkip(int32_t frameIdx) override;
     virtual void setSAO(int32_t frameIdx, bool bSAOEnabled) override;
 
@@ -128,6 +139,8 @@ public:
             ROIOrder order = ROIOrder::QUALITY) override;
     virtual Ptr<RegionOfInterest> createROIBackgroundByValue(int deltaQP,
             ROIOrder order = ROIOrder::QUALITY) override;
+    virtual void setRegions(int32_t frameIdx, const std::vector<Rect>& regions,
+            const std::vector<int>& deltaQP) override;
 
     //
     // QP table (per-block quantization control)
@@ -138,11 +151,25 @@ public:
     virtual size_t qpTableBufferSize() const override;
     virtual void setQpTable(int32_t frameIdx, InputArray qpTable,
             QpTableMode mode = QpTableMode::RELATIVE) override;
+    virtual void setQpTableFromSaliency(int32_t frameIdx, InputArray saliency,
+            int qpSpread) override;
+    virtual Ptr<QpTableBuffer> acquireQpTableBuffer() override;
 
 private:
     bool validateSettings();
     void initSettings(const EncoderInitParams& params);
     String currentSettingsString() const;
+    bool flush();
+    void pushCommand(int32_t frameIdx, CommandType type, int32_t arg0 = 0, int32_t arg1 = 0,
+                     int32_t arg2 = 0, std::unique_ptr<CommandPayload> payload = nullptr);
+    virtual void executeCommand(const Command& cmd) override;
+    void applyDynamicUpdate(const EncoderDynamicUpdate& update);
+    void submitFrame(const Mat& frame, Size size);
+    Ptr<QpTableBuffer> newQpTableBuffer(); // nullptr when no QP-table pool buffer is free
+    void scaleFirstPassFrame(const Mat& frame, Size size);
+    bool readFrameDownscaled(std::istream& file, const PictureEncSettings& pic, int64_t frameIdx,
+                             const std::shared_ptr<AL_TBuffer>& dst);
+    void checkFirstPassLog();
 
     String filename_;
     EncoderInitParams params_;
@@ -160,11 +187,36 @@ private:
     InputMode inputMode_{InputMode::NONE};
 
     // Zero-copy fd path (writeFrameFd): imported DMA handles must be released,
-    // and the pooled source buffer's own chunk restored, before teardown.
+    // and the pooled source buffer's own chunk restored, before teardown. The planes of a
+    // writeFrameDmaBuf() frame are checked against the layout of the pooled buffer.
+    void writeImportedFd(int fd, std::shared_ptr<DmaBufLease> lease,
+                         std::vector<DmaBufPlane> const& planes);
     void reclaimImportedBuffers();
     std::map<AL_TBuffer*, AL_HANDLE> importedHandles_;
     std::map<AL_TBuffer*, AL_HANDLE> origChunks_;
+
+    // Decoder buffers lent by writeFrameDmaBuf(), per pooled source buffer; each lease is
+    // dropped from the encoder callback thread once the encoder releases the source buffer.
+    DmaBufLeases leases_;
     std::shared_ptr<RoiManager> roiMngr_;
+    std::unique_ptr<AbrController> abr_;
+
+    // Downscaled two-pass first pass: frames are scaled to firstPassSize_ before encoding.
+    // writeFile() frames are read into fileFrame_ by the file worker.
+    std::unique_ptr<YuvScaler> firstPassScaler_;
+    Size firstPassSize_;
+    Mat firstPassFrame_;
+    Mat fileFrame_;
+    Size fileFrameSize_;
+    std::atomic<int32_t> firstPassFrames_{0};
+
+    // End of stream: the pending flush started by eosAsync(), shared with a later eos() call.
+    // A first pass whose log does not match its frames is reported in statistics().
+    mutable std::mutex eosMutex_;
+    std::shared_future<bool> eosResult_;
+    String firstPassLogError_;
+    bool eosSent_ = false;
+    bool defaultCallback_ = false;
 };
 
 }  // namespace vcucodec
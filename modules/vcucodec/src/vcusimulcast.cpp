@@ -0,0 +1,338 @@
+/*
+   Copyright (c) 2025-2026  Advanced Micro Devices, Inc. (AMD)
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+*/
+#include "vcusimulcast.hpp"
+
+#include <algorithm>
+#include <future>
+#include <sstream>
+
+#include <linux/dma-buf.h>
+#include <sys/ioctl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+
+namespace cv {
+namespace vcucodec {
+
+namespace {
+
+// CPU read access to a DMA buffer for the duration of a scaling pass.
+class DmaBufReadMapping
+{
+public:
+    explicit DmaBufReadMapping(int fd) : fd_(fd)
+    {
+        off_t size = lseek(fd_, 0, SEEK_END);
+        lseek(fd_, 0, SEEK_SET);
+        if (size <= 0)
+            CV_Error(Error::StsBadArg, "Cannot determine the size of the DMA buffer");
+        size_ = static_cast<size_t>(size);
+        data_ = mmap(nullptr, size_, PROT_READ, MAP_SHARED, fd_, 0);
+        if (data_ == MAP_FAILED)
+            CV_Error(Error::StsError, "Failed to map the DMA buffer");
+        sync(DMA_BUF_SYNC_START);
+    }
+
+    ~DmaBufReadMapping()
+    {
+        sync(DMA_BUF_SYNC_END);
+        munmap(data_, size_);
+    }
+
+    uint8_t* data() const { return static_cast<uint8_t*>(data_); }
+    size_t size() const { return size_; }
+
+private:
+    void sync(uint64_t flags)
+    {
+        struct dma_buf_sync sync = { flags | DMA_BUF_SYNC_READ };
+        ioctl(fd_, DMA_BUF_IOCTL_SYNC, &sync);
+    }
+
+    int fd_;
+    size_t size_ = 0;
+    void* data_ = nullptr;
+};
+
+} // anonymous namespace
+
+VCUSimulcastEncoder::VCUSimulcastEncoder(const EncoderInitParams& params,
+                                         const std::vector<SimulcastRendition>& renditions,
+                                         const std::vector<Ptr<EncoderCallback>>& callbacks)
+: params_(params),
+  inputSize_(params.pictureEncSettings.width, params.pictureEncSettings.height)
+{
+    validateSettings(renditions, callbacks);
+
+    const RCSettings& baseRc = params_.rcSettings;
+    for (size_t i = 0; i < renditions.size(); ++i)
+    {
+        const SimulcastRendition& desc = renditions[i];
+        Size size(desc.width, desc.height);
+
+        EncoderInitParams renditionParams = params_;
+        renditionParams.pictureEncSettings.width = desc.width;
+        renditionParams.pictureEncSettings.height = desc.height;
+        if (desc.bitrate > 0)
+        {
+            RCSettings& rc = renditionParams.rcSettings;
+            rc.bitrate = desc.bitrate;
+            rc.maxBitrate = desc.maxBitrate > 0 ? desc.maxBitrate
+                : static_cast<int>((int64_t)baseRc.maxBitrate * desc.bitrate /
+                                   std::max(baseRc.bitrate, 1));
+        }
+        else if (desc.maxBitrate > 0)
+        {
+            renditionParams.rcSettings.maxBitrate = desc.maxBitrate;
+        }
+
+        int scaledIndex = -1;
+        if (size != inputSize_)
+        {
+            auto it = std::find(scaledSizes_.begin(), scaledSizes_.end(), size);
+            scaledIndex = static_cast<int>(it - scaledSizes_.begin());
+            if (it == scaledSizes_.end())
+                scaledSizes_.push_back(size);
+        }
+
+        Ptr<EncoderCallback> callback = callbacks.empty() ? nullptr : callbacks[i];
+        Ptr<Encoder> encoder = createEncoder(desc.filename, renditionParams, callback);
+        renditions_.push_back(Rendition{desc, encoder, scaledIndex});
+    }
+
+    if (!scaledSizes_.empty())
+        scaler_.reset(new YuvScaler(params_.pictureEncSettings.fourcc));
+}
+
+VCUSimulcastEncoder::~VCUSimulcastEncoder()
+{
+}
+
+void VCUSimulcastEncoder::validateSettings(const std::vector<SimulcastRendition>& renditions,
+                                           const std::vector<Ptr<EncoderCallback>>& callbacks) const
+{
+    if (renditions.empty())
+        CV_Error(Error::StsBadArg, "SimulcastEncoder needs at least one rendition");
+    if (!callbacks.empty() && callbacks.size() != renditions.size())
+        CV_Error(Error::StsBadArg, "SimulcastEncoder needs one callback per rendition");
+
+    // Both let every encoder decide on its own where to put I-frames, which breaks the
+    // alignment of segment boundaries across the ladder.
+    if (params_.gopSettings.mode == GOPMode::ADAPTIVE)
+        CV_Error(Error::StsBadArg, "SimulcastEncoder does not support the adaptive GOP mode");
+    if (params_.rcSettings.lookAhead != 0)
+        CV_Error(Error::StsBadArg, "SimulcastEncoder does not support lookahead");
+    if (params_.rcSettings.twoPass != 0)
+        CV_Error(Error::StsBadArg, "SimulcastEncoder does not support two-pass encoding");
+
+    bool scaled = false;
+    for (size_t i = 0; i < renditions.size(); ++i)
+    {
+        const SimulcastRendition& desc = renditions[i];
+        bool valid = desc.width > 0 && desc.height > 0 &&
+                     desc.width <= inputSize_.width && desc.height <= inputSize_.height;
+        if (!valid)
+            CV_Error(Error::StsBadArg, "Rendition " + std::to_string(i) +
+                     " must have a size between 1x1 and the input size");
+        if (desc.bitrate < 0 || desc.maxBitrate < 0)
+            CV_Error(Error::StsBadArg, "Rendition " + std::to_string(i) +
+                     " has a negative bitrate");
+        scaled = scaled || Size(desc.width, desc.height) != inputSize_;
+    }
+
+    if (scaled && !YuvScaler::supported(params_.pictureEncSettings.fourcc))
+        CV_Error(Error::StsBadArg,
+                 "Scaled renditions are not supported for the input FourCC (packed or tiled)");
+
+    // A subsampled chroma plane has no sample for an odd last luma column or row.
+    if (YuvScaler::supported(params_.pictureEncSettings.fourcc))
+    {
+        Size alignment = YuvScaler(params_.pictureEncSettings.fourcc).alignment();
+        for (size_t i = 0; i < renditions.size(); ++i)
+        {
+            const SimulcastRendition& desc = renditions[i];
+            if (desc.width % alignment.width != 0 || desc.height % alignment.height != 0)
+                CV_Error(Error::StsBadArg, "Rendition " + std::to_string(i) + " size must be a "
+                         "multiple of " + std::to_string(alignment.width) + "x" +
+                         std::to_string(alignment.height) + " for the chroma subsampling");
+        }
+    }
+}
+
+void VCUSimulcastEncoder::scaleInput(const std::vector<Mat>& srcPlanes)
+{
+    if (scaler_)
+        scaler_->scale(srcPlanes, scaledSizes_, scaled_);
+}
+
+void VCUSimulcastEncoder::write(InputArray frame)
+{
+    if (!frame.isMat())
+        return;
+
+    Mat mat = frame.getMat();
+    if (scaler_)
+    {
+        scaler_->planes(mat, inputSize_, srcPlanes_);
+        scaleInput(srcPlanes_);
+    }
+
+    // Each write() copies into its own encoder's source buffer, so renditions proceed in
+    // parallel; the scaled pictures are only reused once all of them have returned.
+    parallel_for_(Range(0, static_cast<int>(renditions_.size())), [this, &mat](const Range& range)
+    {
+        for (int i = range.start; i < range.end; ++i)
+        {
+            const Rendition& r = renditions_[i];
+            r.encoder->write(r.scaledIndex < 0 ? mat : scaled_[r.scaledIndex]);
+        }
+    });
+}
+
+void VCUSimulcastEncoder::writeFrameFd(int fd, const RawInfo& frameInfo, int chromaOffset)
+{
+    if (fd < 0)
+        CV_Error(Error::StsBadArg, "Invalid fd passed to writeFrameFd");
+    if (frameInfo.width != inputSize_.width || frameInfo.height != inputSize_.height)
+        CV_Error(Error::StsBadArg, "writeFrameFd: frame size does not match the input size");
+
+    if (scaler_)
+    {
+        // The layout comes from the caller: nothing is assumed about how the buffer was allocated.
+        DmaBufReadMapping mapping(fd);
+        size_t lumaBytes = (size_t)frameInfo.stride * (size_t)frameInfo.height;
+        size_t chromaRows = (size_t)(scaler_->stackedRows(inputSize_) - inputSize_.height);
+        bool valid = frameInfo.stride > 0 && lumaBytes <= mapping.size();
+        if (valid && chromaRows > 0)
+            valid = chromaOffset >= 0 && (size_t)chromaOffset >= lumaBytes &&
+                    frameInfo.strideChroma > 0 &&
+                    (size_t)chromaOffset + chromaRows * frameInfo.strideChroma <= mapping.size();
+        if (!valid)
+            CV_Error(Error::StsBadArg, "writeFrameFd: the planes do not fit in the DMA buffer");
+        scaler_->planes(mapping.data(), inputSize_, frameInfo.stride, chromaOffset,
+                        frameInfo.strideChroma, srcPlanes_);
+        scaleInput(srcPlanes_);
+    }
+
+    for (const Rendition& r : renditions_)
+    {
+        if (r.scaledIndex < 0)
+            r.encoder->writeFrameFd(fd); // zero-copy
+        else
+            r.encoder->write(scaled_[r.scaledIndex]);
+    }
+}
+
+void VCUSimulcastEncoder::writeFrameDmaBuf(const Ptr<DmaBufFrame>& frame)
+{
+    if (!frame || frame->released())
+        CV_Error(Error::StsBadArg, "writeFrameDmaBuf: invalid or released frame");
+    const RawInfo& frameInfo = frame->info();
+    if (frameInfo.width != inputSize_.width || frameInfo.height != inputSize_.height)
+        CV_Error(Error::StsBadArg, "writeFrameDmaBuf: frame size does not match the input size");
+
+    if (scaler_)
+    {
+        // The planes are read where the frame describes them, no layout is assumed.
+        std::vector<DmaBufPlane> planes = frame->planes();
+        DmaBufReadMapping mapping(planes[0].fd);
+        for (const DmaBufPlane& plane : planes)
+            if (plane.fd != planes[0].fd || plane.offset < planes[0].offset
+                || (size_t)plane.offset >= mapping.size())
+                CV_Error(Error::StsBadArg, "writeFrameDmaBuf: frame planes are not in one DMA buffer");
+
+        size_t chromaOffset = planes.size() > 1 ? planes[1].offset - planes[0].offset : 0;
+        size_t chromaPitch = planes.size() > 1 ? planes[1].pitch : planes[0].pitch;
+        scaler_->planes(mapping.data() + planes[0].offset, inputSize_, planes[0].pitch,
+                        chromaOffset, chromaPitch, srcPlanes_);
+        if (planes.size() > 2 && srcPlanes_.size() > 2)
+            srcPlanes_[2] = Mat(srcPlanes_[2].size(), srcPlanes_[2].type(),
+                                mapping.data() + planes[2].offset, planes[2].pitch);
+        scaleInput(srcPlanes_);
+    }
+
+    for (const Rendition& r : renditions_)
+    {
+        if (r.scaledIndex < 0)
+            r.encoder->writeFrameDmaBuf(frame); // zero-copy, held until encoded
+        else
+            r.encoder->write(scaled_[r.scaledIndex]);
+    }
+}
+
+bool VCUSimulcastEncoder::eos()
+{
+    // Drain all renditions in parallel.
+    std::vector<std::shared_future<bool>> pending;
+    for (const Rendition& r : renditions_)
+        pending.push_back(r.encoder->eosAsync());
+
+    bool completed = true;
+    for (auto& result : pending)
+        completed = result.get() && completed;
+    return completed;
+}
+
+int VCUSimulcastEncoder::numRenditions() const
+{
+    return static_cast<int>(renditions_.size());
+}
+
+Ptr<Encoder> VCUSimulcastEncoder::rendition(int index) const
+{
+    if (index < 0 || index >= numRenditions())
+        CV_Error(Error::StsOutOfRange, "Rendition index out of range");
+    return renditions_[index].encoder;
+}
+
+void VCUSimulcastEncoder::restartGop(int32_t frameIdx)
+{
+    for (const Rendition& r : renditions_)
+        r.encoder->restartGop(frameIdx);
+}
+
+void VCUSimulcastEncoder::setGopLength(int32_t frameIdx, int32_t gopLength)
+{
+    for (const Rendition& r : renditions_)
+        r.encoder->setGopLength(frameIdx, gopLength);
+}
+
+void VCUSimulcastEncoder::setFreqIDR(int32_t frameIdx, int32_t freqIDR)
+{
+    for (const Rendition& r : renditions_)
+        r.encoder->setFreqIDR(frameIdx, freqIDR);
+}
+
+void VCUSimulcastEncoder::setSceneChange(int32_t frameIdx, int32_t lookAhead)
+{
+    for (const Rendition& r : renditions_)
+        r.encoder->setSceneChange(frameIdx, lookAhead);
+}
+
+String VCUSimulcastEncoder::statistics() const
+{
+    std::stringstream ss;
+    for (size_t i = 0; i < renditions_.size(); ++i)
+    {
+        const SimulcastRendition& desc = renditions_[i].desc;
+        ss << "Rendition " << i << " (" << desc.width << "x" << desc.height << "): "
+           << renditions_[i].encoder->statistics() << std::endl;
+    }
+    return ss.str();
+}
+
+}  // namespace vcucodec
+}  // namespace cv
@@ -0,0 +1,68 @@
+/*
+   Copyright (c) 2025-2026  Advanced Micro Devices, Inc. (AMD)
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+*/
+#include "opencv2/vcucodec.hpp"
+
+#include "vcuscaler.hpp"
+
+#include <memory>
+#include <vector>
+
+namespace cv {
+namespace vcucodec {
+
+class VCUSimulcastEncoder : public SimulcastEncoder
+{
+public:
+    VCUSimulcastEncoder(const EncoderInitParams& params,
+                        const std::vector<SimulcastRendition>& renditions,
+                        const std::vector<Ptr<EncoderCallback>>& callbacks);
+    virtual ~VCUSimulcastEncoder();
+
+    virtual void write(InputArray frame) override;
+    virtual void writeFrameFd(int fd, const RawInfo& frameInfo, int chromaOffset) override;
+    virtual void writeFrameDmaBuf(const Ptr<DmaBufFrame>& frame) override;
+    virtual bool eos() override;
+    virtual int numRenditions() const override;
+    virtual Ptr<Encoder> rendition(int index) const override;
+    virtual void restartGop(int32_t frameIdx) override;
+    virtual void setGopLength(int32_t frameIdx, int32_t gopLength) override;
+    virtual void setFreqIDR(int32_t frameIdx, int32_t freqIDR) override;
+    virtual void setSceneChange(int32_t frameIdx, int32_t lookAhead) override;
+    virtual String statistics() const override;
+
+private:
+    struct Rendition
+    {
+        SimulcastRendition desc;
+        Ptr<Encoder> encoder;
+        int scaledIndex; // index into scaledSizes_/scaled_, -1 when encoded at the input size
+    };
+
+    void validateSettings(const std::vector<SimulcastRendition>& renditions,
+                          const std::vector<Ptr<EncoderCallback>>& callbacks) const;
+    void scaleInput(const std::vector<Mat>& srcPlanes);
+
+    EncoderInitParams params_;
+    Size inputSize_;
+    std::vector<Rendition> renditions_;
+    std::unique_ptr<YuvScaler> scaler_;
+    std::vector<Size> scaledSizes_;  // distinct rendition sizes below the input size
+    std::vector<Mat> scaled_;        // stacked pictures, reused from frame to frame
+    std::vector<Mat> srcPlanes_;
+};
+
+}  // namespace vcucodec
+}  // namespace cv
@@ -0,0 +1,328 @@
+/*
+   Copyright (c) 2025-2026  Advanced Micro Devices, Inc. (AMD)
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+*/
+#include "vcutranscoder.hpp"
+
+#include <algorithm>
+#include <sstream>
+
+namespace cv {
+namespace vcucodec {
+namespace { // anonymous
+
+// zeroCopy: decoder buffers in flight between nextFrameDmaBuf() and the encoder, on top of the
+// ones the encoder keeps for reordering and LookAhead.
+const int zeroCopyMargin = 3;
+
+} // anonymous namespace
+
+VCUTranscoder::VCUTranscoder(const String& input, const DecoderInitParams& decoderParams,
+                             const String& output, const EncoderInitParams& encoderParams,
+                             const TranscoderParams& params)
+: params_(params),
+  outputSize_(encoderParams.pictureEncSettings.width, encoderParams.pictureEncSettings.height)
+{
+    validateParams(encoderParams);
+
+    // Frames waiting for or inside the scale stage still hold their decoder buffer. With zeroCopy
+    // there is no scale stage, the encoder holds them until encoded: its reorder and LookAhead depth.
+    DecoderInitParams decParams = decoderParams;
+    if (params_.zeroCopy)
+        decParams.extraFrames += zeroCopyMargin + encoderParams.gopSettings.nrBFrames
+                               + encoderParams.rcSettings.lookAhead;
+    else
+        decParams.extraFrames += params_.queueDepth + params_.scaleThreads;
+
+    decoder_ = createDecoder(input, decParams);
+    encoder_ = createEncoder(output, encoderParams);
+    if (!params_.zeroCopy)
+        scaler_.reset(new YuvScaler(encoderParams.pictureEncSettings.fourcc));
+}
+
+VCUTranscoder::~VCUTranscoder()
+{
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        aborted_ = true;
+    }
+    cv_.notify_all();
+    joinStages();
+}
+
+void VCUTranscoder::validateParams(const EncoderInitParams& encoderParams) const
+{
+    bool valid = params_.scaleThreads >= 1 && params_.scaleThreads <= 16;
+    if (!valid)
+        CV_Error(Error::StsBadArg, "scaleThreads must be in range [1, 16]");
+    valid = params_.queueDepth >= 1 && params_.queueDepth <= 32;
+    if (!valid)
+        CV_Error(Error::StsBadArg, "queueDepth must be in range [1, 32]");
+    valid = params_.zeroCopy || YuvScaler::supported(encoderParams.pictureEncSettings.fourcc);
+    if (!valid)
+        CV_Error(Error::StsBadArg,
+                 "Transcoder cannot scale the encoder input FourCC (packed or tiled)");
+}
+
+bool VCUTranscoder::run()
+{
+    if (ran_)
+        CV_Error(Error::StsError, "Transcoder::run() can only be called once");
+    ran_ = true;
+
+    if (params_.zeroCopy)
+        runZeroCopy();
+    else
+        runPipeline();
+
+    return encoder_->eos();
+}
+
+void VCUTranscoder::runZeroCopy()
+{
+    // Same-size path: the decoder and the encoder already run asynchronously in hardware, so
+    // a straight loop keeps both busy and there is nothing to scale. Each decoder buffer goes
+    // back to the decoder when the encoder has encoded it.
+    for (;;)
+    {
+        Ptr<DmaBufFrame> frame;
+        DecodeStatus status = decoder_->nextFrameDmaBuf(frame);
+        if (status == DECODE_TIMEOUT)
+            continue;
+        if (status == DECODE_EOS)
+            break;
+
+        const RawInfo& info = frame->info();
+        if (info.width != outputSize_.width || info.height != outputSize_.height)
+            CV_Error(Error::StsBadArg, "zeroCopy requires the encoder size to match the stream ("
+                     + std::to_string(info.width) + "x" + std::to_string(info.height) + ")");
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            ++stats_.framesDecoded;
+        }
+        encoder_->writeFrameDmaBuf(frame);
+        frame->release();
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            ++stats_.framesEncoded;
+        }
+    }
+}
+
+void VCUTranscoder::runPipeline()
+{
+    for (int i = 0; i < params_.scaleThreads; ++i)
+        scaleThreads_.emplace_back(&VCUTranscoder::scaleStage, this);
+    encodeThread_ = std::thread(&VCUTranscoder::encodeStage, this);
+
+    try
+    {
+        decodeStage();
+    }
+    catch (...)
+    {
+        fail(std::current_exception());
+    }
+    joinStages();
+
+    if (error_)
+        std::rethrow_exception(error_);
+}
+
+void VCUTranscoder::decodeStage()
+{
+    int64_t seq = 0;
+    for (;;)
+    {
+        Ptr<VideoFrame> frame;
+        DecodeStatus status = decoder_->nextFrame(frame);
+        if (status == DECODE_TIMEOUT)
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            if (aborted_)
+                return;
+            continue;
+        }
+
+        std::unique_lock<std::mutex> lock(mutex_);
+        if (status == DECODE_EOS)
+        {
+            endSeq_ = seq;
+            scaleQueue_.push_back(ScaleJob{seq, nullptr});
+            cv_.notify_all();
+            return;
+        }
+
+        cv_.wait(lock, [this]()
+            { return aborted_ || (int)scaleQueue_.size() < params_.queueDepth; });
+        if (aborted_)
+            return;
+        scaleQueue_.push_back(ScaleJob{seq++, frame});
+        ++stats_.framesDecoded;
+        stats_.scaleQueueDepth = (int)scaleQueue_.size();
+        stats_.scaleQueueMaxDepth = std::max(stats_.scaleQueueMaxDepth, stats_.scaleQueueDepth);
+        scaleDepthSum_ += stats_.scaleQueueDepth;
+        cv_.notify_all();
+    }
+}
+
+void VCUTranscoder::scaleStage()
+{
+    try
+    {
+        std::vector<Mat> dstPlanes;
+        for (;;)
+        {
+            ScaleJob job;
+            Mat out;
+            {
+                std::unique_lock<std::mutex> lock(mutex_);
+                cv_.wait(lock, [this]() { return aborted_ || !scaleQueue_.empty(); });
+                if (aborted_)
+                    return;
+                job = scaleQueue_.front();
+                if (!job.frame)
+                    return; // the end marker stays queued for the other workers
+                scaleQueue_.pop_front();
+                stats_.scaleQueueDepth = (int)scaleQueue_.size();
+                if (!freeOutputs_.empty())
+                {
+                    out = freeOutputs_.back();
+                    freeOutputs_.pop_back();
+                }
+                cv_.notify_all();
+            }
+
+            if (out.empty())
+                out = scaler_->createStacked(outputSize_);
+            scaler_->planes(out, outputSize_, dstPlanes);
+            scaler_->scale(job.frame->planes(), dstPlanes);
+            job.frame.release(); // hand the buffer back to the decoder before queueing
+
+            std::unique_lock<std::mutex> lock(mutex_);
+            cv_.wait(lock, [this, &job]()
+                { return aborted_ || job.seq < nextEncode_ + params_.queueDepth; });
+            if (aborted_)
+                return;
+            encodeQueue_[job.seq] = out;
+            ++stats_.framesScaled;
+            stats_.encodeQueueDepth = (int)encodeQueue_.size();
+            stats_.encodeQueueMaxDepth = std::max(stats_.encodeQueueMaxDepth,
+                                                  stats_.encodeQueueDepth);
+            encodeDepthSum_ += stats_.encodeQueueDepth;
+            cv_.notify_all();
+        }
+    }
+    catch (...)
+    {
+        fail(std::current_exception());
+    }
+}
+
+void VCUTranscoder::encodeStage()
+{
+    try
+    {
+        for (;;)
+        {
+            Mat out;
+            {
+                std::unique_lock<std::mutex> lock(mutex_);
+                cv_.wait(lock, [this]()
+                    { return aborted_ || nextEncode_ == endSeq_ || encodeQueue_.count(nextEncode_); });
+                if (aborted_ || nextEncode_ == endSeq_)
+                    return;
+                auto it = encodeQueue_.find(nextEncode_);
+                out = it->second;
+                encodeQueue_.erase(it);
+                stats_.encodeQueueDepth = (int)encodeQueue_.size();
+            }
+
+            encoder_->write(out);
+
+            std::lock_guard<std::mutex> lock(mutex_);
+            freeOutputs_.push_back(out);
+            ++nextEncode_;
+            ++stats_.framesEncoded;
+            cv_.notify_all();
+        }
+    }
+    catch (...)
+    {
+        fail(std::current_exception());
+    }
+}
+
+void VCUTranscoder::fail(std::exception_ptr error)
+{
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (!error_)
+            error_ = error;
+        aborted_ = true;
+    }
+    cv_.notify_all();
+}
+
+void VCUTranscoder::joinStages()
+{
+    for (auto& thread : scaleThreads_)
+        if (thread.joinable())
+            thread.join();
+    scaleThreads_.clear();
+    if (encodeThread_.joinable())
+        encodeThread_.join();
+}
+
+TranscoderStats VCUTranscoder::stats() const
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    TranscoderStats stats = stats_;
+    if (stats.framesDecoded > 0)
+        stats.scaleQueueAvgDepth = (double)scaleDepthSum_ / stats.framesDecoded;
+    if (stats.framesScaled > 0)
+        stats.encodeQueueAvgDepth = (double)encodeDepthSum_ / stats.framesScaled;
+    return stats;
+}
+
+String VCUTranscoder::statistics() const
+{
+    TranscoderStats s = stats();
+    std::stringstream ss;
+    ss << "Decoder: " << decoder_->statistics() << std::endl;
+    ss << "Encoder: " << encoder_->statistics() << std::endl;
+    ss << "Frames decoded/scaled/encoded: " << s.framesDecoded << "/" << s.framesScaled << "/"
+       << s.framesEncoded << std::endl;
+    if (!params_.zeroCopy)
+    {
+        ss << "Scale queue depth avg/max: " << s.scaleQueueAvgDepth << "/"
+           << s.scaleQueueMaxDepth << " of " << params_.queueDepth << std::endl;
+        ss << "Encode queue depth avg/max: " << s.encodeQueueAvgDepth << "/"
+           << s.encodeQueueMaxDepth << " of " << params_.queueDepth << std::endl;
+    }
+    return ss.str();
+}
+
+Ptr<Decoder> VCUTranscoder::decoder() const
+{
+    return decoder_;
+}
+
+Ptr<Encoder> VCUTranscoder::encoder() const
+{
+    return encoder_;
+}
+
+}  // namespace vcucodec
+}  // namespace cv
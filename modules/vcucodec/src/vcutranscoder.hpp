@@ -0,0 +1,91 @@
+/*
+   Copyright (c) 2025-2026  Advanced Micro Devices, Inc. (AMD)
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+*/
+#include "opencv2/vcucodec.hpp"
+
+#include "vcuscaler.hpp"
+
+#include <condition_variable>
+#include <deque>
+#include <exception>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace cv {
+namespace vcucodec {
+
+/// Decoder -> scale worker pool -> encoder pipeline. The decoder runs on the thread calling
+/// run(), the scale workers and the encoder on their own threads. Scaled frames are handed to
+/// the encoder in decode order through a reorder map.
+class VCUTranscoder : public Transcoder
+{
+public:
+    VCUTranscoder(const String& input, const DecoderInitParams& decoderParams,
+                  const String& output, const EncoderInitParams& encoderParams,
+                  const TranscoderParams& params);
+    virtual ~VCUTranscoder();
+
+    virtual bool run() override;
+    virtual TranscoderStats stats() const override;
+    virtual String statistics() const override;
+    virtual Ptr<Decoder> decoder() const override;
+    virtual Ptr<Encoder> encoder() const override;
+
+private:
+    struct ScaleJob
+    {
+        int64_t seq;
+        Ptr<VideoFrame> frame; // nullptr marks the end of the stream
+    };
+
+    void validateParams(const EncoderInitParams& encoderParams) const;
+    void runZeroCopy();
+    void runPipeline();
+    void decodeStage();
+    void scaleStage();
+    void encodeStage();
+    void fail(std::exception_ptr error);
+    void joinStages();
+
+    TranscoderParams params_;
+    Ptr<Decoder> decoder_;
+    Ptr<Encoder> encoder_;
+    Size outputSize_;
+    std::unique_ptr<YuvScaler> scaler_;
+    bool ran_ = false;
+
+    std::vector<std::thread> scaleThreads_;
+    std::thread encodeThread_;
+
+    mutable std::mutex mutex_;
+    std::condition_variable cv_;
+    std::deque<ScaleJob> scaleQueue_;
+    std::map<int64_t, Mat> encodeQueue_;  // scaled frames by sequence number
+    std::vector<Mat> freeOutputs_;        // stacked pictures returned by the encode stage
+    int64_t nextEncode_ = 0;
+    int64_t endSeq_ = -1;                 // frame count, known once the decoder reached EOS
+    bool aborted_ = false;
+    std::exception_ptr error_;
+
+    TranscoderStats stats_;
+    int64_t scaleDepthSum_ = 0;
+    int64_t encodeDepthSum_ = 0;
+};
+
+}  // namespace vcucodec
+}  // namespace cv
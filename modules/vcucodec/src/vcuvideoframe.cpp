@@ -129,5 +129,82 @@ void VideoFrameImpl::convertColor(Mat& dst, int targetFourcc) const
     conv->convert(srcS, dstS);
 }
 
+// ---- DmaBufFrameImpl method definitions ----
+
+DmaBufFrameImpl::DmaBufFrameImpl(Ptr<Frame> frame, const RawInfo& info,
+                                 std::vector<DmaBufPlane> planes, int64 modifier,
+                                 const std::shared_ptr<PinRegistry>& registry)
+    : anchor_(std::make_shared<PinAnchor>(std::move(frame))),
+      lease_(std::make_shared<DmaBufLease>(anchor_)), info_(info),
+      planes_(std::move(planes)), modifier_(modifier)
+{
+    if (registry) registry->track(anchor_);
+}
+
+const RawInfo& DmaBufFrameImpl::info() const { return info_; }
+std::vector<DmaBufPlane> DmaBufFrameImpl::planes() const { return planes_; }
+int64 DmaBufFrameImpl::modifier() const { return modifier_; }
+
+void DmaBufFrameImpl::release()
+{
+    // The buffer is only given back when no encoder still holds a lease on it.
+    std::shared_ptr<DmaBufLease> lease;
+    {
+        std::lock_guard<std::mutex> lk(leaseMutex_);
+        lease.swap(lease_);
+    }
+}
+
+bool DmaBufFrameImpl::released() const
+{
+    return anchor_->revoked();
+}
+
+std::shared_ptr<DmaBufLease> DmaBufFrameImpl::lease() const
+{
+    std::lock_guard<std::mutex> lk(leaseMutex_);
+    return lease_;
+}
+
+// ---- DmaBufLeases method definitions ----
+
+void DmaBufLeases::hold(void const* source, std::shared_ptr<DmaBufLease> lease)
+{
+    {
+        std::lock_guard<std::mutex> lk(mutex_);
+        lease.swap(leases_[source]);
+    }
+    // lease now holds whatever was left for this source buffer, dropped here
+}
+
+bool DmaBufLeases::release(void const* source)
+{
+    std::shared_ptr<DmaBufLease> lease;
+    {
+        std::lock_guard<std::mutex> lk(mutex_);
+        auto it = leases_.find(source);
+        if (it == leases_.end())
+            return false;
+        lease = std::move(it->second);
+        leases_.erase(it);
+    }
+    return true;
+}
+
+void DmaBufLeases::releaseAll()
+{
+    std::map<void const*, std::shared_ptr<DmaBufLease>> leases;
+    {
+        std::lock_guard<std::mutex> lk(mutex_);
+        leases.swap(leases_);
+    }
+}
+
+size_t DmaBufLeases::size() const
+{
+    std::lock_guard<std::mutex> lk(mutex_);
+    return leases_.size();
+}
+
 } // namespace vcucodec
 } // namespace cv
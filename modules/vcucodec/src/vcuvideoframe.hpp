@@ -31,6 +31,7 @@
 #define OPENCV_VCUCODEC_VCUVIDEOFRAME_HPP
 
 #include <opencv2/vcucodec.hpp>
+#include <map>
 #include <memory>
 #include <mutex>
 #include <vector>
@@ -46,11 +47,28 @@ class Frame;
 /// Created by VideoFrameImpl; held alive by the PyCapsule returned from pin().
 /// PinRegistry::revokeAll() clears the inner Ptr<Frame>, releasing the buffer
 /// even if the PyCapsule (and thus the PinAnchor shared_ptr) still exists.
+/// revoke() may race with an explicit DmaBufFrame::release(), hence the mutex; the
+/// Frame is dropped outside of it since that hands the buffer back to the decoder.
 struct PinAnchor
 {
     Ptr<Frame> frame;
     explicit PinAnchor(Ptr<Frame> f) : frame(std::move(f)) {}
-    void revoke() { frame.reset(); }
+    void revoke()
+    {
+        Ptr<Frame> released;
+        {
+            std::lock_guard<std::mutex> lk(mu);
+            released.swap(frame);
+        }
+    }
+    bool revoked()
+    {
+        std::lock_guard<std::mutex> lk(mu);
+        return !frame;
+    }
+
+private:
+    std::mutex mu;
 };
 
 /// Tracks every PinAnchor created by a decoder.
@@ -123,6 +141,70 @@ private:
     std::vector<Mat> srcPlanes_;          ///< Mat headers wrapping HW buffer planes (no data copy).
 };
 
+/// Hold on the buffer of a DmaBufFrame: the buffer goes back to the decoder when the
+/// last lease is dropped. The DmaBufFrame holds one until release(); an encoder fed
+/// with the frame (VCUEncoder::writeFrameDmaBuf) holds another until its EndEncoding.
+struct DmaBufLease
+{
+    std::shared_ptr<PinAnchor> anchor;
+    explicit DmaBufLease(std::shared_ptr<PinAnchor> a) : anchor(std::move(a)) {}
+    ~DmaBufLease() { anchor->revoke(); }
+};
+
+/// Leases an encoder holds on the decoder buffers it encodes from (VCUEncoder::writeFrameDmaBuf),
+/// per pooled source buffer. A lease is dropped when its source buffer is released by the
+/// encoder, or with all the others when the encoder reclaims its imported buffers. Leases are
+/// dropped outside the lock, since that hands the buffers back to the decoder.
+class DmaBufLeases
+{
+public:
+    /// Hold @p lease until the source buffer @p source is released.
+    void hold(void const* source, std::shared_ptr<DmaBufLease> lease);
+
+    /// Drop the lease held for @p source, if any; returns whether there was one.
+    bool release(void const* source);
+
+    /// Drop every lease.
+    void releaseAll();
+
+    size_t size() const;
+
+private:
+    mutable std::mutex mutex_;
+    std::map<void const*, std::shared_ptr<DmaBufLease>> leases_;
+};
+
+/// Concrete DmaBufFrame backed by a hardware decoder Frame.
+///
+/// Constructed by VCUDecoder::nextFrameDmaBuf() in vcudec.cpp, which fills in the
+/// plane descriptors. The buffer is held through a PinAnchor, so the last lease and
+/// PinRegistry::revokeAll() give it back the same way.
+class DmaBufFrameImpl : public DmaBufFrame
+{
+public:
+    DmaBufFrameImpl(Ptr<Frame> frame, const RawInfo& info,
+                    std::vector<DmaBufPlane> planes, int64 modifier,
+                    const std::shared_ptr<PinRegistry>& registry = nullptr);
+
+    // -- DmaBufFrame overrides --
+    const RawInfo& info() const override;
+    std::vector<DmaBufPlane> planes() const override;
+    int64 modifier() const override;
+    void release() override;
+    bool released() const override;
+
+    /// Take another hold on the buffer, nullptr once release() was called.
+    std::shared_ptr<DmaBufLease> lease() const;
+
+private:
+    std::shared_ptr<PinAnchor> anchor_; ///< Holds the HW buffer until the last lease; revocable by PinRegistry.
+    std::shared_ptr<DmaBufLease> lease_; ///< This frame's own lease, dropped by release().
+    mutable std::mutex leaseMutex_;     ///< Guards lease_.
+    RawInfo info_;                      ///< Frame metadata (post-crop).
+    std::vector<DmaBufPlane> planes_;   ///< Per-plane fd, offset and pitch.
+    int64 modifier_;                    ///< DRM format modifier of the planes.
+};
+
 } // namespace vcucodec
 } // namespace cv
 
@@ -0,0 +1,220 @@
+/*
+   Copyright (c) 2025-2026  Advanced Micro Devices, Inc. (AMD)
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+*/
+#include "test_precomp.hpp"
+
+#if defined(HAVE_VCU_CTRLSW) || defined(HAVE_VCU2_CTRLSW)
+
+#include "vcuabrcontroller.hpp"
+
+#include <climits>
+#include <cstdio>
+#include <fstream>
+#include <functional>
+
+namespace opencv_test { namespace {
+
+const int32_t frameRate = 30;
+const int32_t bitrate = 4000;
+const int32_t maxBitrate = 12000;
+
+/// Encoder stand-in: applies the MAX_BIT_RATE commands and produces @p overshoot times its
+/// target bitrate.
+class RateFollower : public CommandExecutor
+{
+public:
+    explicit RateFollower(double overshoot = 1.0) : overshoot_(overshoot) {}
+
+    void executeCommand(const Command& cmd) override
+    {
+        ASSERT_EQ(CommandType::MAX_BIT_RATE, cmd.type);
+        EXPECT_NEAR(3.0 * cmd.arg[0], cmd.arg[1], 3.0) << "peak keeps the configured ratio";
+        targetKbps = cmd.arg[0] / 1000.0;
+        commands++;
+    }
+
+    size_t frameBytes() const { return size_t(overshoot_ * targetKbps * 1000 / 8 / frameRate); }
+
+    double targetKbps = bitrate;
+    int commands = 0;
+
+private:
+    double overshoot_;
+};
+
+/// Runs frames [@p first, @p last) through @p abr as the encoder does, with @p estimate (when
+/// positive) set before each frame. Returns the target of each frame.
+std::vector<double> run(AbrController& abr, CommandQueue& commands, RateFollower& encoder,
+                        int first, int last, std::function<int32_t(int)> estimate = nullptr)
+{
+    std::vector<double> targets;
+    for (int frame = first; frame < last; ++frame)
+    {
+        if (estimate)
+            abr.setBandwidthEstimate(estimate(frame));
+        abr.onFrame(frame);
+        commands.execute(frame, encoder);
+        abr.onEncoded(encoder.frameBytes());
+        targets.push_back(encoder.targetKbps);
+    }
+    return targets;
+}
+
+/// Frames after @p start until the target is within @p fraction of the gap from @p from to @p to.
+int settlingFrames(const std::vector<double>& targets, int start, double from, double to,
+                   double fraction)
+{
+    for (int frame = start; frame < (int)targets.size(); ++frame)
+        if (std::abs(targets[frame] - to) <= fraction * std::abs(from - to))
+            return frame - start;
+    return INT_MAX;
+}
+
+std::string writeTrace(const std::string& contents)
+{
+    std::string path = cv::tempfile(".txt");
+    std::ofstream(path) << contents;
+    return path;
+}
+
+TEST(VCU_AbrController, trace_step_down_and_up)
+{
+    std::string trace = writeTrace("# frame kbps\n"
+                                   "0 8000\n"
+                                   "\n"
+                                   "300 10000\n"
+                                   "150 2000\n");  // sorted on load
+    AbrSettings settings;
+    settings.traceFile = trace;
+    CommandQueue commands;
+    RateFollower encoder;
+    auto abr = AbrController::create(settings, bitrate, maxBitrate, frameRate, commands);
+    std::vector<double> targets = run(*abr, commands, encoder, 0, 450);
+    std::remove(trace.c_str());
+
+    // The ramp up stops once a step is below the dead band: 2% of the target for a gain of
+    // aggressiveness / 2, the step down a quarter of the way from its desired bitrate.
+    const double headroom = settings.headroom;
+    EXPECT_GE(targets[149], 0.85 * headroom * 8000);
+    EXPECT_LE(targets[149], headroom * 8000);
+    EXPECT_GE(targets[299], headroom * 2000);
+    EXPECT_LE(targets[299], 1.07 * headroom * 2000);
+    EXPECT_GE(targets[449], 0.85 * headroom * 10000);
+    EXPECT_LE(targets[449], headroom * 10000);
+
+    for (int frame = 151; frame < 300; ++frame)
+        ASSERT_LE(targets[frame], targets[frame - 1]) << "frame " << frame;
+    for (int frame = 301; frame < 450; ++frame)
+        ASSERT_GE(targets[frame], targets[frame - 1]) << "frame " << frame;
+
+    // Backs off at the full rate, ramps up at half of it
+    int down = settlingFrames(targets, 150, targets[149], headroom * 2000, 0.25);
+    int up = settlingFrames(targets, 300, targets[299], headroom * 10000, 0.25);
+    EXPECT_LE(down, 5);
+    EXPECT_LE(up, 10);
+    EXPECT_LT(down, up);
+}
+
+TEST(VCU_AbrController, hysteresis_on_a_jittering_estimate)
+{
+    AbrSettings settings;
+    CommandQueue commands;
+    RateFollower encoder;
+    auto abr = AbrController::create(settings, bitrate, maxBitrate, frameRate, commands);
+
+    run(*abr, commands, encoder, 0, 200, [](int) { return 7000; });
+    int settled = encoder.commands;
+    EXPECT_GT(settled, 0);
+
+    // +-1% around the estimate: no new target
+    std::vector<double> targets = run(*abr, commands, encoder, 200, 400,
+                                      [](int frame) { return frame % 2 ? 7070 : 6930; });
+    EXPECT_EQ(settled, encoder.commands);
+
+    // A 30% drop is followed
+    run(*abr, commands, encoder, 400, 420, [](int) { return 4900; });
+    EXPECT_GT(encoder.commands, settled);
+    EXPECT_LT(encoder.targetKbps, targets.back());
+}
+
+TEST(VCU_AbrController, update_interval)
+{
+    AbrSettings settings;
+    settings.updateInterval = 10;
+    CommandQueue commands;
+    RateFollower encoder;
+    auto abr = AbrController::create(settings, bitrate, maxBitrate, frameRate, commands);
+
+    std::vector<double> targets = run(*abr, commands, encoder, 0, 100,
+                                      [](int) { return 1000; });
+    for (int frame = 1; frame < 100; ++frame)
+        if (frame % 10)
+            ASSERT_EQ(targets[frame - 1], targets[frame]) << "frame " << frame;
+    EXPECT_EQ(10, encoder.commands);
+}
+
+TEST(VCU_AbrController, bitrate_bounds)
+{
+    AbrSettings settings;
+    settings.minBitrate = 500;
+    settings.aggressiveness = 1.0;
+    CommandQueue commands;
+    RateFollower encoder;
+    auto abr = AbrController::create(settings, bitrate, maxBitrate, frameRate, commands);
+
+    run(*abr, commands, encoder, 0, 50, [](int) { return 100; });
+    EXPECT_EQ(500, encoder.targetKbps);
+    run(*abr, commands, encoder, 50, 150, [](int) { return 100000; });
+    EXPECT_EQ(maxBitrate, encoder.targetKbps);
+
+    settings.maxBitrate = 6000;
+    CommandQueue commands2;
+    RateFollower encoder2;
+    abr = AbrController::create(settings, bitrate, maxBitrate, frameRate, commands2);
+    run(*abr, commands2, encoder2, 0, 100, [](int) { return 100000; });
+    EXPECT_EQ(6000, encoder2.targetKbps);
+}
+
+TEST(VCU_AbrController, encoder_overshoot_is_corrected)
+{
+    AbrSettings settings;
+    CommandQueue commands;
+    RateFollower encoder(1.4);
+    auto abr = AbrController::create(settings, bitrate, maxBitrate, frameRate, commands);
+
+    run(*abr, commands, encoder, 0, 300, [](int) { return 5000; });
+    double output = 1.4 * encoder.targetKbps;  // a step down stops within the dead band
+    EXPECT_LE(output, 1.07 * settings.headroom * 5000);
+    EXPECT_GE(output, 0.85 * settings.headroom * 5000);
+}
+
+TEST(VCU_AbrController, malformed_trace)
+{
+    std::string trace = writeTrace("0 8000\n100 fast\n");
+    AbrSettings settings;
+    settings.traceFile = trace;
+    CommandQueue commands;
+    EXPECT_THROW(AbrController::create(settings, bitrate, maxBitrate, frameRate, commands),
+                 std::runtime_error);
+    std::remove(trace.c_str());
+
+    settings.traceFile = trace;  // removed
+    EXPECT_THROW(AbrController::create(settings, bitrate, maxBitrate, frameRate, commands),
+                 std::runtime_error);
+}
+
+}} // namespace
+
+#endif
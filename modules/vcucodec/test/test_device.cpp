@@ -0,0 +1,199 @@
+/*
+   Copyright (c) 2025-2026  Advanced Micro Devices, Inc. (AMD)
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+*/
+#include "test_precomp.hpp"
+
+#if defined(HAVE_VCU_CTRLSW) || defined(HAVE_VCU2_CTRLSW)
+
+#include "vcudevice.hpp"
+
+#include <map>
+
+namespace opencv_test { namespace {
+
+/// Devices created and destroyed per core by a FakeDevices table.
+struct DeviceCount
+{
+    int created = 0;
+    int destroyed = 0;
+    int alive() const { return created - destroyed; }
+};
+
+/// Stand-in for the device of a core: getCtx() identifies the instance.
+class FakeDevice : public Device
+{
+public:
+    FakeDevice(DeviceCount& count) : count_(count) { count_.created++; }
+    ~FakeDevice() override { count_.destroyed++; }
+
+    void* getScheduler() override { return nullptr; }
+    void* getCtx() override { return this; }
+    AL_TAllocator* getAllocator() override { return nullptr; }
+    AL_ITimer* getTimer() override { return nullptr; }
+
+private:
+    DeviceCount& count_;
+};
+
+/// Core table of fake devices; the factory of a core in @p broken throws.
+struct FakeDevices
+{
+    std::map<int, DeviceCount> counts;
+    int broken = 0;
+
+    std::vector<DeviceRegistry::Core> table(std::initializer_list<Device::ID> ids)
+    {
+        std::vector<DeviceRegistry::Core> cores;
+        for (Device::ID id : ids)
+            cores.push_back({id, [this](Device::ID core) -> Ptr<Device> {
+                if (core & broken)
+                    throw std::runtime_error(cv::format("core %d broken", (int)core));
+                return Ptr<Device>(new FakeDevice(counts[core]));
+            }});
+        return cores;
+    }
+};
+
+TEST(VCU_DeviceRegistry, channels_of_a_core_share_its_device)
+{
+    FakeDevices fake;
+    DeviceRegistry registry(fake.table({Device::DECODER0, Device::DECODER1}));
+
+    Ptr<Device> a = registry.acquire(Device::DECODER0, 30.0);
+    Ptr<Device> b = registry.acquire(Device::DECODER0, 60.0);
+    EXPECT_EQ(a->getCtx(), b->getCtx());
+    EXPECT_EQ(1, fake.counts[Device::DECODER0].created);
+    EXPECT_EQ(0, fake.counts[Device::DECODER1].created);
+    EXPECT_EQ(2, registry.channels(Device::DECODER0));
+    EXPECT_DOUBLE_EQ(90.0, registry.load(Device::DECODER0));
+}
+
+TEST(VCU_DeviceRegistry, last_channel_destroys_the_device)
+{
+    FakeDevices fake;
+    DeviceRegistry registry(fake.table({Device::ENCODER0}));
+    const DeviceCount& count = fake.counts[Device::ENCODER0];
+
+    Ptr<Device> a = registry.acquire(Device::ENCODER, 30.0);
+    Ptr<Device> b = registry.acquire(Device::ENCODER, 25.0);
+    a.reset();
+    EXPECT_EQ(1, count.alive());
+    EXPECT_EQ(1, registry.channels(Device::ENCODER0));
+    EXPECT_DOUBLE_EQ(25.0, registry.load(Device::ENCODER0));
+
+    b.reset();
+    EXPECT_EQ(0, count.alive());
+    EXPECT_EQ(0, registry.channels(Device::ENCODER0));
+    EXPECT_DOUBLE_EQ(0.0, registry.load(Device::ENCODER0));
+
+    // The next channel gets a new device
+    Ptr<Device> c = registry.acquire(Device::ENCODER, 30.0);
+    EXPECT_EQ(2, count.created);
+    EXPECT_EQ(1, count.alive());
+}
+
+TEST(VCU_DeviceRegistry, channel_outlives_the_registry)
+{
+    FakeDevices fake;
+    Ptr<Device> channel;
+    {
+        DeviceRegistry registry(fake.table({Device::DECODER0}));
+        channel = registry.acquire(Device::DECODER, 30.0);
+    }
+    EXPECT_EQ(1, fake.counts[Device::DECODER0].alive());
+    channel.reset();
+    EXPECT_EQ(0, fake.counts[Device::DECODER0].alive());
+}
+
+TEST(VCU_DeviceRegistry, lookup_by_type)
+{
+    FakeDevices fake;
+    DeviceRegistry registry(fake.table({Device::DECODER0, Device::DECODER1, Device::ENCODER0}));
+
+    Ptr<Device> enc = registry.acquire(Device::ENCODER, 30.0);
+    EXPECT_EQ(1, registry.channels(Device::ENCODER0));
+    EXPECT_EQ(0, registry.channels(Device::DECODER0) + registry.channels(Device::DECODER1));
+
+    // A single core is honoured even when it is the most loaded one
+    Ptr<Device> d1 = registry.acquire(Device::DECODER1, 60.0);
+    Ptr<Device> d1b = registry.acquire(Device::DECODER1, 60.0);
+    EXPECT_EQ(2, registry.channels(Device::DECODER1));
+    EXPECT_EQ(0, registry.channels(Device::DECODER0));
+
+    EXPECT_THROW(registry.acquire(Device::ENCODER1, 30.0), std::runtime_error);
+    EXPECT_EQ(0, fake.counts[Device::ENCODER1].created);
+}
+
+TEST(VCU_DeviceRegistry, least_loaded_core_first)
+{
+    FakeDevices fake;
+    DeviceRegistry registry(fake.table({Device::DECODER0, Device::DECODER1}));
+
+    // Same load and channel count: lowest ID
+    Ptr<Device> a = registry.acquire(Device::DECODER, 60.0);
+    EXPECT_EQ(1, registry.channels(Device::DECODER0));
+
+    Ptr<Device> b = registry.acquire(Device::DECODER, 30.0);
+    EXPECT_EQ(1, registry.channels(Device::DECODER1));
+    EXPECT_NE(a->getCtx(), b->getCtx());
+
+    Ptr<Device> c = registry.acquire(Device::DECODER, 30.0);
+    EXPECT_EQ(2, registry.channels(Device::DECODER1));
+    EXPECT_EQ(b->getCtx(), c->getCtx());
+
+    // Same load: fewest channels
+    Ptr<Device> d = registry.acquire(Device::DECODER, 10.0);
+    EXPECT_EQ(2, registry.channels(Device::DECODER0));
+    EXPECT_DOUBLE_EQ(70.0, registry.load(Device::DECODER0));
+
+    // Load released by a channel is available again
+    b.reset();
+    c.reset();
+    Ptr<Device> e = registry.acquire(Device::DECODER, 10.0);
+    EXPECT_EQ(1, registry.channels(Device::DECODER1));
+}
+
+TEST(VCU_DeviceRegistry, falls_back_when_a_core_fails)
+{
+    FakeDevices fake;
+    fake.broken = Device::DECODER0;
+    DeviceRegistry registry(fake.table({Device::DECODER0, Device::DECODER1}));
+
+    Ptr<Device> a = registry.acquire(Device::DECODER, 30.0);
+    EXPECT_EQ(0, registry.channels(Device::DECODER0));
+    EXPECT_EQ(1, registry.channels(Device::DECODER1));
+
+    fake.broken = Device::DECODER;
+    Ptr<Device> b = registry.acquire(Device::DECODER, 30.0);  // DECODER1 already has a device
+    EXPECT_EQ(a->getCtx(), b->getCtx());
+
+    a.reset();
+    b.reset();
+    try
+    {
+        registry.acquire(Device::DECODER, 30.0);
+        ADD_FAILURE() << "no core could be opened";
+    }
+    catch (const std::runtime_error& e)
+    {
+        EXPECT_NE(std::string::npos, std::string(e.what()).find("core 1 broken"));
+        EXPECT_NE(std::string::npos, std::string(e.what()).find("core 2 broken"));
+    }
+    EXPECT_EQ(0, registry.channels(Device::DECODER0) + registry.channels(Device::DECODER1));
+}
+
+}} // namespace
+
+#endif
@@ -0,0 +1,190 @@
+/*
+   Copyright (c) 2025-2026  Advanced Micro Devices, Inc. (AMD)
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+*/
+#include "test_precomp.hpp"
+
+#if defined(HAVE_VCU_CTRLSW) || defined(HAVE_VCU2_CTRLSW)
+
+#include "vcuframe.hpp"
+#include "vcuvideoframe.hpp"
+
+#include <atomic>
+#include <thread>
+
+namespace opencv_test { namespace {
+
+/// A decoded frame as nextFrameDmaBuf() returns it, and a watch on its decoder buffer.
+struct LentFrame
+{
+    explicit LentFrame(const std::shared_ptr<PinRegistry>& registry = nullptr)
+    {
+        int fourcc = VideoWriter::fourcc('N', 'V', '1', '2');
+        Ptr<Frame> buffer = Frame::createYuvIO(Size(64, 64), fourcc);
+        watch = buffer;
+        frame = makePtr<DmaBufFrameImpl>(buffer, RawInfo(), std::vector<DmaBufPlane>(), 0,
+                                         registry);
+    }
+
+    /// True once the buffer went back to the decoder.
+    bool returned() const { return watch.expired(); }
+
+    Ptr<DmaBufFrameImpl> frame;
+    std::weak_ptr<Frame> watch;
+};
+
+// Source buffers of the encoder pool, only their addresses matter
+const int sourceBuffers[4] = {};
+
+TEST(VCU_DmaBufLease, release_without_encoder)
+{
+    LentFrame lent;
+    EXPECT_FALSE(lent.frame->released());
+    lent.frame->release();
+    EXPECT_TRUE(lent.frame->released());
+    EXPECT_TRUE(lent.returned());
+    EXPECT_FALSE(lent.frame->lease());
+    lent.frame->release(); // twice is harmless
+}
+
+TEST(VCU_DmaBufLease, dropped_frame_returns_its_buffer)
+{
+    LentFrame lent;
+    lent.frame.reset();
+    EXPECT_TRUE(lent.returned());
+}
+
+TEST(VCU_DmaBufLease, source_released_after_frame)
+{
+    // writeFrameDmaBuf() then release(): the buffer goes back on the source released hook
+    LentFrame lent;
+    DmaBufLeases leases;
+    leases.hold(&sourceBuffers[0], lent.frame->lease());
+    lent.frame->release();
+    EXPECT_FALSE(lent.frame->released());
+    EXPECT_FALSE(lent.returned());
+
+    EXPECT_FALSE(leases.release(&sourceBuffers[1]));
+    EXPECT_FALSE(lent.returned());
+    EXPECT_TRUE(leases.release(&sourceBuffers[0]));
+    EXPECT_TRUE(lent.frame->released());
+    EXPECT_TRUE(lent.returned());
+    EXPECT_FALSE(leases.release(&sourceBuffers[0]));
+    EXPECT_EQ(0u, leases.size());
+}
+
+TEST(VCU_DmaBufLease, source_released_before_frame)
+{
+    // The picture is encoded before the caller is done with the frame
+    LentFrame lent;
+    DmaBufLeases leases;
+    leases.hold(&sourceBuffers[0], lent.frame->lease());
+    EXPECT_TRUE(leases.release(&sourceBuffers[0]));
+    EXPECT_FALSE(lent.frame->released());
+    EXPECT_FALSE(lent.returned());
+    lent.frame.reset();
+    EXPECT_TRUE(lent.returned());
+}
+
+TEST(VCU_DmaBufLease, frame_lent_twice)
+{
+    // The same frame encoded twice: the buffer goes back after both pictures
+    LentFrame lent;
+    DmaBufLeases leases;
+    leases.hold(&sourceBuffers[0], lent.frame->lease());
+    leases.hold(&sourceBuffers[1], lent.frame->lease());
+    lent.frame->release();
+    EXPECT_TRUE(leases.release(&sourceBuffers[1]));
+    EXPECT_FALSE(lent.returned());
+    EXPECT_TRUE(leases.release(&sourceBuffers[0]));
+    EXPECT_TRUE(lent.returned());
+}
+
+TEST(VCU_DmaBufLease, hold_replaces_the_lease_of_a_source)
+{
+    // A source buffer reused before its release was seen gives the former frame back
+    LentFrame first, second;
+    DmaBufLeases leases;
+    leases.hold(&sourceBuffers[0], first.frame->lease());
+    first.frame.reset();
+    EXPECT_FALSE(first.returned());
+    leases.hold(&sourceBuffers[0], second.frame->lease());
+    EXPECT_TRUE(first.returned());
+    EXPECT_EQ(1u, leases.size());
+}
+
+TEST(VCU_DmaBufLease, reclaim_returns_every_buffer)
+{
+    // reclaimImportedBuffers(): the encoder is idle or gone, nothing reads the buffers anymore
+    std::vector<LentFrame> lent(3);
+    DmaBufLeases leases;
+    for (size_t i = 0; i < lent.size(); ++i)
+    {
+        leases.hold(&sourceBuffers[i], lent[i].frame->lease());
+        lent[i].frame->release();
+    }
+    EXPECT_EQ(3u, leases.size());
+    leases.releaseAll();
+    EXPECT_EQ(0u, leases.size());
+    for (const LentFrame& frame : lent)
+        EXPECT_TRUE(frame.returned());
+    EXPECT_FALSE(leases.release(&sourceBuffers[0]));
+}
+
+TEST(VCU_DmaBufLease, decoder_teardown_revokes_leases)
+{
+    // PinRegistry::revokeAll() takes the buffer back even while the encoder holds a lease
+    std::shared_ptr<PinRegistry> registry = std::make_shared<PinRegistry>();
+    LentFrame lent(registry);
+    DmaBufLeases leases;
+    leases.hold(&sourceBuffers[0], lent.frame->lease());
+    registry->revokeAll();
+    EXPECT_TRUE(lent.returned());
+    EXPECT_TRUE(lent.frame->released());
+    EXPECT_TRUE(leases.release(&sourceBuffers[0]));
+    lent.frame->release();
+}
+
+TEST(VCU_DmaBufLease, source_released_concurrently)
+{
+    // The source released hook runs on the encoder callback thread, racing release()
+    const int numFrames = 2000;
+    std::vector<LentFrame> lent(numFrames);
+    std::vector<int> sources(numFrames);
+    DmaBufLeases leases;
+    for (int i = 0; i < numFrames; ++i)
+        leases.hold(&sources[i], lent[i].frame->lease());
+
+    std::atomic<bool> go(false);
+    std::thread callbackThread([&] {
+        while (!go) {}
+        for (int i = 0; i < numFrames; ++i)
+            leases.release(&sources[i]);
+    });
+    go = true;
+    for (int i = 0; i < numFrames; ++i)
+        lent[i].frame->release();
+    callbackThread.join();
+
+    for (int i = 0; i < numFrames; ++i)
+    {
+        SCOPED_TRACE(cv::format("frame %d", i));
+        EXPECT_TRUE(lent[i].frame->released());
+        EXPECT_TRUE(lent[i].returned());
+    }
+}
+
+}} // namespace
+
+#endif
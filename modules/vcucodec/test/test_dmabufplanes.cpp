@@ -0,0 +1,308 @@
+/*
+   Copyright (c) 2025-2026  Advanced Micro Devices, Inc. (AMD)
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+*/
+#include "test_precomp.hpp"
+
+#if defined(HAVE_VCU_CTRLSW) || defined(HAVE_VCU2_CTRLSW)
+
+#include "vcuutils.hpp"
+
+extern "C" {
+#include "lib_common/BufferAPI.h"
+#include "lib_common/FourCC.h"
+#include "lib_common/PixMapBuffer.h"
+#include "lib_fpga/DmaAllocLinux.h"
+}
+
+#include <algorithm>
+#include <map>
+#include <memory>
+
+namespace opencv_test { namespace {
+
+/// Stand-in for the DMA allocator of the decoder: heap chunks, the n-th one has fd 100 + n.
+class FakeDmaAllocator
+{
+public:
+    FakeDmaAllocator()
+    {
+        vtable_.base.pfnDestroy = [](AL_TAllocator*) { return true; };
+        vtable_.base.pfnAlloc = [](AL_TAllocator* a, size_t zSize) {
+            return self(a)->alloc(zSize);
+        };
+        vtable_.base.pfnAllocNamed = [](AL_TAllocator* a, size_t zSize, char const*) {
+            return self(a)->alloc(zSize);
+        };
+        vtable_.base.pfnFree = [](AL_TAllocator* a, AL_HANDLE hBuf) {
+            return self(a)->chunks_.erase(hBuf) == 1;
+        };
+        vtable_.base.pfnGetVirtualAddr = [](AL_TAllocator* a, AL_HANDLE hBuf) {
+            return (AL_VADDR)self(a)->chunks_.at(hBuf).data.get();
+        };
+        vtable_.base.pfnGetPhysicalAddr = [](AL_TAllocator*, AL_HANDLE hBuf) {
+            return (AL_PADDR)(uintptr_t)hBuf;
+        };
+        vtable_.pfnGetFd = [](AL_TLinuxDmaAllocator* a, AL_HANDLE hBuf) {
+            return self((AL_TAllocator*)a)->chunks_.at(hBuf).fd;
+        };
+        vtable_.pfnImportFromFd = [](AL_TLinuxDmaAllocator*, int) { return AL_HANDLE(nullptr); };
+        handle_.base.vtable = &vtable_;
+        handle_.self = this;
+    }
+
+    AL_TAllocator* get() { return reinterpret_cast<AL_TAllocator*>(&handle_); }
+
+private:
+    struct Chunk
+    {
+        int fd;
+        std::unique_ptr<uint8_t[]> data;
+    };
+
+    struct Handle
+    {
+        AL_TLinuxDmaAllocator base;
+        FakeDmaAllocator* self;
+    };
+
+    static FakeDmaAllocator* self(AL_TAllocator* a) { return reinterpret_cast<Handle*>(a)->self; }
+
+    AL_HANDLE alloc(size_t zSize)
+    {
+        Chunk chunk { 100 + allocated_++, std::unique_ptr<uint8_t[]>(new uint8_t[zSize]) };
+        AL_HANDLE hBuf = chunk.data.get();
+        chunks_[hBuf] = std::move(chunk);
+        return hBuf;
+    }
+
+    int allocated_ = 0;
+    std::map<AL_HANDLE, Chunk> chunks_;
+    Handle handle_;
+    AL_DmaAllocLinuxVtable vtable_ {};
+};
+
+/// A plane as the test lays it out and expects it back.
+struct PlaneLayout
+{
+    AL_EPlaneId id;
+    int chunk;
+    int offset;
+    int pitch;
+};
+
+const AL_TDimension dimension = { 1920, 1080 };
+const int pitchY = 2048;
+const int planeGap = 4096; ///< between the planes of a chunk, as alignment would leave
+
+/// Planes of @p fourcc in the order of DmaBufFrame::planes(), laid out one after the other in
+/// @p numChunks chunks (the luma in chunk 0, the chroma in the last one).
+std::vector<PlaneLayout> layoutPlanes(TFourCC fourcc, int numChunks)
+{
+    bool tiled = AL_IsTiled(fourcc);
+    int bytes = AL_GetBitDepth(fourcc) > 8 ? 2 : 1;
+    // Tiled formats store 4 rows per tile row
+    int rowsY = tiled ? dimension.iHeight / 4 : dimension.iHeight;
+    int pitch = tiled ? 4 * pitchY * bytes : pitchY * bytes;
+
+    std::vector<PlaneLayout> planes = { { AL_PLANE_Y, 0, 0, pitch } };
+    int offset = pitch * rowsY + planeGap;
+    int chunk = numChunks - 1;
+    if (chunk != 0)
+        offset = 0;
+
+    AL_EChromaMode chroma = AL_GetChromaMode(fourcc);
+    int rowsC = chroma == AL_CHROMA_4_2_0 ? rowsY / 2 : rowsY;
+    if (chroma == AL_CHROMA_MONO)
+        return planes;
+    if (AL_GetPlaneMode(fourcc) == AL_PLANE_MODE_SEMIPLANAR)
+    {
+        planes.push_back({ AL_PLANE_UV, chunk, offset, pitch });
+    }
+    else if (AL_GetPlaneMode(fourcc) == AL_PLANE_MODE_PLANAR)
+    {
+        int pitchC = chroma == AL_CHROMA_4_4_4 ? pitch : pitch / 2;
+        planes.push_back({ AL_PLANE_U, chunk, offset, pitchC });
+        planes.push_back({ AL_PLANE_V, chunk, offset + pitchC * rowsC + planeGap, pitchC });
+    }
+    return planes;
+}
+
+/// Picture buffer of @p fourcc allocated from @p allocator with the planes of @p planes.
+std::shared_ptr<AL_TBuffer> createPicture(FakeDmaAllocator& allocator, TFourCC fourcc,
+                                          const std::vector<PlaneLayout>& planes)
+{
+    AL_TBuffer* pBuf = AL_PixMapBuffer_Create(allocator.get(), nullptr, dimension, fourcc);
+    std::shared_ptr<AL_TBuffer> buffer(pBuf, &AL_Buffer_Destroy);
+    for (int chunk = 0; chunk <= planes.back().chunk; ++chunk)
+    {
+        std::vector<AL_TPlaneDescription> descriptions;
+        size_t zSize = 0;
+        for (const PlaneLayout& plane : planes)
+        {
+            if (plane.chunk != chunk)
+                continue;
+            descriptions.push_back(AL_TPlaneDescription { plane.id, plane.offset, plane.pitch });
+            zSize = std::max(zSize, (size_t)plane.offset + (size_t)plane.pitch * dimension.iHeight);
+        }
+        EXPECT_TRUE(AL_PixMapBuffer_Allocate_And_AddPlanes(pBuf, zSize, descriptions.data(),
+                                                           (int)descriptions.size(), "picture"));
+    }
+    return buffer;
+}
+
+struct PlaneFormat
+{
+    TFourCC fourcc;
+    const char* name;
+    size_t numPlanes;
+    bool tiled;
+};
+
+const PlaneFormat planeFormats[] = {
+    { FOURCC(Y800), "Y800", 1, false },
+    { FOURCC(NV12), "NV12", 2, false },
+    { FOURCC(NV16), "NV16", 2, false },
+    { FOURCC(I420), "I420", 3, false },
+    { FOURCC(I422), "I422", 3, false },
+    { FOURCC(I444), "I444", 3, false },
+    { FOURCC(P010), "P010", 2, false },
+    { FOURCC(T608), "T608", 2, true },
+    { FOURCC(T628), "T628", 2, true },
+    { FOURCC(T60A), "T60A", 2, true },
+};
+
+TEST(VCU_DmaBufPlanes, offset_and_pitch_per_fourcc)
+{
+    for (const PlaneFormat& format : planeFormats)
+    {
+        for (int numChunks : { 1, 2 })
+        {
+            if (format.numPlanes == 1 && numChunks > 1)
+                continue;
+            SCOPED_TRACE(cv::format("%s in %d chunk(s)", format.name, numChunks));
+            FakeDmaAllocator allocator;
+            std::vector<PlaneLayout> layout = layoutPlanes(format.fourcc, numChunks);
+            ASSERT_EQ(format.numPlanes, layout.size());
+            std::shared_ptr<AL_TBuffer> buffer = createPicture(allocator, format.fourcc, layout);
+
+            std::vector<DmaBufPlane> planes = dmaBufPlanes(buffer.get());
+            ASSERT_EQ(format.numPlanes, planes.size());
+            for (size_t i = 0; i < planes.size(); ++i)
+            {
+                SCOPED_TRACE(cv::format("plane %d", (int)i));
+                EXPECT_EQ(100 + layout[i].chunk, planes[i].fd);
+                EXPECT_EQ(layout[i].offset, planes[i].offset);
+                EXPECT_EQ(layout[i].pitch, planes[i].pitch);
+            }
+        }
+    }
+}
+
+TEST(VCU_DmaBufPlanes, offset_past_left_and_top_crop)
+{
+    const int cropLeft = 16, cropTop = 8;
+    for (const PlaneFormat& format : planeFormats)
+    {
+        SCOPED_TRACE(format.name);
+        FakeDmaAllocator allocator;
+        std::vector<PlaneLayout> layout = layoutPlanes(format.fourcc, 1);
+        std::shared_ptr<AL_TBuffer> buffer = createPicture(allocator, format.fourcc, layout);
+        if (format.tiled)
+        {
+            // A right or bottom crop leaves the origin where it is
+            EXPECT_THROW(dmaBufPlanes(buffer.get(), cropLeft, cropTop), cv::Exception);
+            EXPECT_NO_THROW(dmaBufPlanes(buffer.get(), 0, 0));
+            continue;
+        }
+
+        int bytes = AL_GetBitDepth(format.fourcc) > 8 ? 2 : 1;
+        AL_EChromaMode chroma = AL_GetChromaMode(format.fourcc);
+        std::vector<DmaBufPlane> planes = dmaBufPlanes(buffer.get(), cropLeft, cropTop);
+        ASSERT_EQ(layout.size(), planes.size());
+        for (size_t i = 0; i < planes.size(); ++i)
+        {
+            SCOPED_TRACE(cv::format("plane %d", (int)i));
+            // Subsampled chroma skips half the rows or columns; UV has two samples per column
+            bool luma = layout[i].id == AL_PLANE_Y;
+            int rows = luma || chroma != AL_CHROMA_4_2_0 ? cropTop : cropTop / 2;
+            int columns = luma || chroma == AL_CHROMA_4_4_4 ? cropLeft : cropLeft / 2;
+            int samples = layout[i].id == AL_PLANE_UV ? 2 : 1;
+            EXPECT_EQ(layout[i].offset + rows * layout[i].pitch + columns * samples * bytes,
+                      planes[i].offset);
+            EXPECT_EQ(layout[i].pitch, planes[i].pitch);
+        }
+    }
+
+    // Three packed 10-bit samples share a 32-bit word
+    FakeDmaAllocator allocator;
+    TFourCC packed = FOURCC(XV15);
+    std::shared_ptr<AL_TBuffer> buffer =
+        createPicture(allocator, packed, layoutPlanes(packed, 1));
+    EXPECT_THROW(dmaBufPlanes(buffer.get(), 0, cropTop), cv::Exception);
+}
+
+TEST(VCU_DmaBufPlanes, missing_plane)
+{
+    // An NV12 picture without its chroma plane
+    FakeDmaAllocator allocator;
+    TFourCC fourcc = FOURCC(NV12);
+    std::vector<PlaneLayout> layout = layoutPlanes(fourcc, 1);
+    layout.pop_back();
+    std::shared_ptr<AL_TBuffer> buffer = createPicture(allocator, fourcc, layout);
+    EXPECT_THROW(dmaBufPlanes(buffer.get()), cv::Exception);
+}
+
+TEST(VCU_DmaBufPlanes, layout_check_against_the_encoder_source)
+{
+    FakeDmaAllocator allocator;
+    TFourCC fourcc = FOURCC(NV12);
+    std::vector<PlaneLayout> layout = layoutPlanes(fourcc, 1);
+    std::shared_ptr<AL_TBuffer> source = createPicture(allocator, fourcc, layout);
+    std::vector<DmaBufPlane> planes = dmaBufPlanes(source.get());
+    EXPECT_NO_THROW(checkDmaBufLayout(source.get(), planes));
+
+    // Chroma further down, as with a taller height alignment
+    std::vector<DmaBufPlane> moved = planes;
+    moved[1].offset += 8 * moved[1].pitch;
+    EXPECT_THROW(checkDmaBufLayout(source.get(), moved), cv::Exception);
+
+    std::vector<DmaBufPlane> wider = planes;
+    wider[0].pitch += 256;
+    EXPECT_THROW(checkDmaBufLayout(source.get(), wider), cv::Exception);
+
+    std::vector<DmaBufPlane> lumaOnly(planes.begin(), planes.begin() + 1);
+    EXPECT_THROW(checkDmaBufLayout(source.get(), lumaOnly), cv::Exception);
+
+    // Only chunk 0 of the source is replaced by the imported dmabuf
+    std::shared_ptr<AL_TBuffer> twoChunks =
+        createPicture(allocator, fourcc, layoutPlanes(fourcc, 2));
+    EXPECT_THROW(checkDmaBufLayout(twoChunks.get(), dmaBufPlanes(twoChunks.get())),
+                 cv::Exception);
+}
+
+TEST(VCU_DmaBufPlanes, modifier_per_fourcc)
+{
+    // DRM_FORMAT_MOD_LINEAR for raster formats, DRM_FORMAT_MOD_INVALID for the tiled ones
+    const int64 linear = 0, invalid = 0x00ffffffffffffffLL;
+    for (const PlaneFormat& format : planeFormats)
+    {
+        SCOPED_TRACE(format.name);
+        EXPECT_EQ(format.tiled ? invalid : linear, dmaBufModifier((int)format.fourcc));
+    }
+}
+
+}} // namespace
+
+#endif
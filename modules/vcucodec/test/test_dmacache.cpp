@@ -0,0 +1,271 @@
+/*
+   Copyright (c) 2025-2026  Advanced Micro Devices, Inc. (AMD)
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+*/
+#include "test_precomp.hpp"
+
+#if defined(HAVE_VCU_CTRLSW) || defined(HAVE_VCU2_CTRLSW)
+
+#include "vcudmacache.hpp"
+
+#include <map>
+#include <memory>
+#include <set>
+
+namespace opencv_test { namespace {
+
+const size_t page = 4096;
+
+/// Stand-in for the DMA allocator of a device: heap buffers, with every call counted.
+class FakeDmaAllocator
+{
+public:
+    FakeDmaAllocator()
+    {
+        vtable_.base.pfnDestroy = [](AL_TAllocator*) { return true; };
+        vtable_.base.pfnAlloc = [](AL_TAllocator* a, size_t zSize) {
+            return self(a)->alloc(zSize, false);
+        };
+        vtable_.base.pfnAllocNamed = [](AL_TAllocator* a, size_t zSize, char const*) {
+            self(a)->named++;
+            return self(a)->alloc(zSize, false);
+        };
+        vtable_.base.pfnFree = [](AL_TAllocator* a, AL_HANDLE hBuf) { return self(a)->free(hBuf); };
+        vtable_.base.pfnGetVirtualAddr = [](AL_TAllocator* a, AL_HANDLE hBuf) {
+            return (AL_VADDR)self(a)->live.at(hBuf).data.get();
+        };
+        vtable_.base.pfnGetPhysicalAddr = [](AL_TAllocator*, AL_HANDLE hBuf) {
+            return (AL_PADDR)(uintptr_t)hBuf;
+        };
+        vtable_.pfnGetFd = [](AL_TLinuxDmaAllocator* a, AL_HANDLE hBuf) {
+            return self((AL_TAllocator*)a)->live.count(hBuf) ? 100 : -1;
+        };
+        vtable_.pfnImportFromFd = [](AL_TLinuxDmaAllocator* a, int) {
+            return self((AL_TAllocator*)a)->alloc(page, true);
+        };
+        handle_.base.vtable = &vtable_;
+        handle_.self = this;
+    }
+
+    AL_TAllocator* get() { return reinterpret_cast<AL_TAllocator*>(&handle_); }
+
+    struct Buffer
+    {
+        size_t size;
+        bool imported;
+        std::unique_ptr<uint8_t[]> data;
+    };
+
+    std::map<AL_HANDLE, Buffer> live;   ///< buffers allocated and not freed yet
+    int allocs = 0;                     ///< allocations, imports included
+    int frees = 0;
+    int named = 0;                      ///< allocations through AllocNamed
+    size_t lastSize = 0;                ///< size of the last allocation
+
+private:
+    struct Handle
+    {
+        AL_TLinuxDmaAllocator base;
+        FakeDmaAllocator* self;
+    };
+
+    static FakeDmaAllocator* self(AL_TAllocator* a) { return reinterpret_cast<Handle*>(a)->self; }
+
+    AL_HANDLE alloc(size_t zSize, bool imported)
+    {
+        allocs++;
+        lastSize = zSize;
+        Buffer buffer { zSize, imported, std::unique_ptr<uint8_t[]>(new uint8_t[zSize]) };
+        AL_HANDLE hBuf = buffer.data.get();
+        live[hBuf] = std::move(buffer);
+        return hBuf;
+    }
+
+    bool free(AL_HANDLE hBuf)
+    {
+        frees++;
+        return live.erase(hBuf) == 1;
+    }
+
+    Handle handle_;
+    AL_DmaAllocLinuxVtable vtable_ {};
+};
+
+TEST(VCU_CachingDmaAllocator, size_classes)
+{
+    EXPECT_EQ(page, CachingDmaAllocator::sizeClass(1));
+    EXPECT_EQ(page, CachingDmaAllocator::sizeClass(page));
+    EXPECT_EQ(2 * page, CachingDmaAllocator::sizeClass(page + 1));
+
+    size_t previous = 0;
+    for (size_t zSize = 1; zSize <= (size_t(64) << 20); zSize += zSize / 7 + 1)
+    {
+        SCOPED_TRACE(cv::format("size %zu", zSize));
+        size_t zClass = CachingDmaAllocator::sizeClass(zSize);
+        EXPECT_GE(zClass, zSize);
+        EXPECT_EQ(0u, zClass % page);
+        EXPECT_EQ(zClass, CachingDmaAllocator::sizeClass(zClass));
+        EXPECT_GE(zClass, previous);
+        previous = zClass;
+    }
+
+    // 8 classes per power of two above 8 pages, so a buffer wastes at most 1/8 of its size
+    for (size_t power = 8 * page; power <= (size_t(64) << 20); power *= 2)
+    {
+        SCOPED_TRACE(cv::format("power %zu", power));
+        std::set<size_t> classes;
+        for (size_t zSize = power + 1; zSize <= 2 * power; zSize += page / 2)
+            classes.insert(CachingDmaAllocator::sizeClass(zSize));
+        EXPECT_EQ(8u, classes.size());
+        EXPECT_EQ(power + power / 8, *classes.begin());
+        EXPECT_EQ(2 * power, *classes.rbegin());
+    }
+}
+
+TEST(VCU_CachingDmaAllocator, freed_buffer_is_reused)
+{
+    FakeDmaAllocator device;
+    CachingDmaAllocator cache(device.get(), size_t(1) << 20);
+    AL_TAllocator* pAllocator = cache.get();
+
+    AL_HANDLE hFirst = AL_Allocator_Alloc(pAllocator, 10000);
+    ASSERT_TRUE(hFirst);
+    EXPECT_EQ(CachingDmaAllocator::sizeClass(10000), device.lastSize);
+    EXPECT_TRUE(AL_Allocator_Free(pAllocator, hFirst));
+    EXPECT_EQ(0, device.frees);
+
+    // Same class: served from the cache, no new device allocation
+    AL_HANDLE hSecond = AL_Allocator_Alloc(pAllocator, 11000);
+    EXPECT_EQ(hFirst, hSecond);
+    EXPECT_EQ(1, device.allocs);
+
+    // Another class: a new device allocation, even though a buffer of it is cached now
+    EXPECT_TRUE(AL_Allocator_Free(pAllocator, hSecond));
+    AL_HANDLE hLarger = AL_Allocator_AllocNamed(pAllocator, 100000, "larger");
+    EXPECT_NE(hFirst, hLarger);
+    EXPECT_EQ(2, device.allocs);
+    EXPECT_EQ(1, device.named);
+
+    CachingDmaAllocator::Stats stats = cache.stats();
+    EXPECT_EQ(1u, stats.hits);
+    EXPECT_EQ(2u, stats.misses);
+    EXPECT_EQ(1u, stats.buffersCached);
+    EXPECT_EQ(CachingDmaAllocator::sizeClass(10000), stats.bytesCached);
+
+    // Calls on a cached allocator buffer reach the device
+    EXPECT_EQ(AL_Allocator_GetVirtualAddr(device.get(), hLarger),
+              AL_Allocator_GetVirtualAddr(pAllocator, hLarger));
+    EXPECT_EQ(100, AL_LinuxDmaAllocator_GetFd((AL_TLinuxDmaAllocator*)pAllocator, hLarger));
+    EXPECT_TRUE(AL_Allocator_Free(pAllocator, hLarger));
+}
+
+TEST(VCU_CachingDmaAllocator, capacity_evicts_to_the_device)
+{
+    FakeDmaAllocator device;
+    CachingDmaAllocator cache(device.get(), 3 * page);
+    AL_TAllocator* pAllocator = cache.get();
+
+    std::vector<AL_HANDLE> buffers;
+    for (int i = 0; i < 4; ++i)
+        buffers.push_back(AL_Allocator_Alloc(pAllocator, page));
+    for (AL_HANDLE hBuf : buffers)
+        EXPECT_TRUE(AL_Allocator_Free(pAllocator, hBuf));
+
+    // The fourth buffer would exceed the capacity and goes back to the device
+    EXPECT_EQ(1, device.frees);
+    EXPECT_EQ(3u, device.live.size());
+    CachingDmaAllocator::Stats stats = cache.stats();
+    EXPECT_EQ(3u, stats.buffersCached);
+    EXPECT_EQ(3 * page, stats.bytesCached);
+    EXPECT_EQ(3 * page, stats.highWater);
+
+    // Two pages do not fit in the page left once a buffer is taken back
+    AL_HANDLE hReused = AL_Allocator_Alloc(pAllocator, page);
+    AL_HANDLE hTwoPages = AL_Allocator_Alloc(pAllocator, 2 * page);
+    EXPECT_TRUE(AL_Allocator_Free(pAllocator, hTwoPages));
+    EXPECT_EQ(2, device.frees);
+    EXPECT_EQ(2 * page, cache.stats().bytesCached);
+    EXPECT_TRUE(AL_Allocator_Free(pAllocator, hReused));
+
+    stats = cache.stats();
+    EXPECT_EQ(3 * page, stats.bytesCached);
+    EXPECT_EQ(3 * page, stats.highWater);
+    EXPECT_EQ(1u, stats.hits);
+    EXPECT_EQ(5u, stats.misses);
+
+    cache.trim();
+    EXPECT_TRUE(device.live.empty());
+    EXPECT_EQ(0u, cache.stats().bytesCached);
+    EXPECT_EQ(0u, cache.stats().buffersCached);
+    EXPECT_EQ(3 * page, cache.stats().highWater);
+
+    // The high water mark stays at the peak
+    EXPECT_TRUE(AL_Allocator_Free(pAllocator, AL_Allocator_Alloc(pAllocator, page)));
+    EXPECT_EQ(page, cache.stats().bytesCached);
+    EXPECT_EQ(3 * page, cache.stats().highWater);
+}
+
+TEST(VCU_CachingDmaAllocator, zero_capacity_caches_nothing)
+{
+    FakeDmaAllocator device;
+    CachingDmaAllocator cache(device.get(), 0);
+    for (int i = 0; i < 3; ++i)
+        EXPECT_TRUE(AL_Allocator_Free(cache.get(), AL_Allocator_Alloc(cache.get(), page)));
+    EXPECT_EQ(3, device.allocs);
+    EXPECT_EQ(3, device.frees);
+    EXPECT_EQ(0u, cache.stats().hits);
+    EXPECT_EQ(0u, cache.stats().highWater);
+}
+
+TEST(VCU_CachingDmaAllocator, imported_buffers_are_never_cached)
+{
+    FakeDmaAllocator device;
+    CachingDmaAllocator cache(device.get(), size_t(1) << 20);
+    AL_TLinuxDmaAllocator* pAllocator = reinterpret_cast<AL_TLinuxDmaAllocator*>(cache.get());
+
+    AL_HANDLE hImported = AL_LinuxDmaAllocator_ImportFromFd(pAllocator, 42);
+    ASSERT_TRUE(hImported);
+    EXPECT_TRUE(device.live.at(hImported).imported);
+    EXPECT_TRUE(AL_Allocator_Free(cache.get(), hImported));
+    EXPECT_EQ(1, device.frees);
+    EXPECT_TRUE(device.live.empty());
+
+    // A page allocation does not get the imported buffer back
+    AL_HANDLE hBuf = AL_Allocator_Alloc(cache.get(), page);
+    EXPECT_FALSE(device.live.at(hBuf).imported);
+    EXPECT_EQ(0u, cache.stats().hits);
+    EXPECT_EQ(0u, cache.stats().buffersCached);
+    EXPECT_TRUE(AL_Allocator_Free(cache.get(), hBuf));
+}
+
+TEST(VCU_CachingDmaAllocator, destructor_returns_the_cached_buffers)
+{
+    FakeDmaAllocator device;
+    AL_HANDLE hHeld;
+    {
+        CachingDmaAllocator cache(device.get(), size_t(1) << 20);
+        for (size_t zSize : {page, 3 * page, 100 * page})
+            EXPECT_TRUE(AL_Allocator_Free(cache.get(), AL_Allocator_Alloc(cache.get(), zSize)));
+        hHeld = AL_Allocator_Alloc(cache.get(), 50 * page);
+        EXPECT_EQ(3u, cache.stats().buffersCached);
+    }
+    // Only the buffer still in use is left on the device
+    ASSERT_EQ(1u, device.live.size());
+    EXPECT_EQ(hHeld, device.live.begin()->first);
+    AL_Allocator_Free(device.get(), hHeld);
+}
+
+}} // namespace
+
+#endif
@@ -0,0 +1,395 @@
+/*
+   Copyright (c) 2025-2026  Advanced Micro Devices, Inc. (AMD)
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+*/
+#include "test_precomp.hpp"
+
+#if defined(HAVE_VCU_CTRLSW) || defined(HAVE_VCU2_CTRLSW)
+
+#include "TwoPassMngr.h"
+
+#include <deque>
+#include <memory>
+
+extern "C" {
+#include "lib_common/Allocator.h"
+#include "lib_common/BufferAPI.h"
+#include "lib_common/BufferLookAheadMeta.h"
+}
+
+namespace opencv_test { namespace {
+
+//------------------------------------------------------------------------------------------------
+// LumaSceneCutDetector
+
+const Size pictureSize(320, 180);
+
+/// 8-bit luma of frame @p frame: scenes start at frames 0, 30, 70 and 100, each with its own
+/// luma range, panning by one pixel per frame with a little noise. The third scene fades in.
+Mat syntheticLuma(int frame, RNG& rng)
+{
+    static const int sceneStarts[] = { 0, 30, 70, 100 };
+    static const int lows[] = { 16, 150, 40, 90 };
+    static const int highs[] = { 90, 235, 120, 110 };
+    int scene = 3;
+    while (frame < sceneStarts[scene])
+        scene--;
+    int fade = scene == 2 ? 2 * (frame - sceneStarts[scene]) : 0;
+
+    Mat luma(pictureSize, CV_8UC1);
+    for (int y = 0; y < luma.rows; ++y)
+    {
+        for (int x = 0; x < luma.cols; ++x)
+        {
+            int pos = (x + y + frame) % (luma.cols + luma.rows);
+            int value = lows[scene] + (highs[scene] - lows[scene]) * pos / (luma.cols + luma.rows);
+            luma.at<uint8_t>(y, x) = saturate_cast<uint8_t>(value + fade + rng.uniform(-3, 4));
+        }
+    }
+    return luma;
+}
+
+TEST(VCU_LumaSceneCutDetector, cuts_on_synthetic_pictures)
+{
+    RNG rng(0x4001);
+    LumaSceneCutDetector detector;
+    LumaSceneCutDetector::THistogram prev, hist;
+    std::vector<int> cuts;
+
+    for (int frame = 0; frame < 130; ++frame)
+    {
+        Mat luma = syntheticLuma(frame, rng);
+        LumaSceneCutDetector::ComputeHistogram(luma.data, (int)luma.step, luma.cols, luma.rows, 8,
+                                               hist);
+        if (frame > 0 && detector.IsSceneCut(prev, hist))
+            cuts.push_back(frame);
+        std::copy(hist, hist + LumaSceneCutDetector::HIST_BINS, prev);
+    }
+
+    EXPECT_EQ(std::vector<int>({ 30, 70, 100 }), cuts);
+}
+
+/// Histogram with @p moved of 1000 samples moved from bin 10 to bin 50: at distance
+/// 2 * moved / 1000 of the histogram with none moved.
+void movedHistogram(int moved, LumaSceneCutDetector::THistogram& hist)
+{
+    std::fill(hist, hist + LumaSceneCutDetector::HIST_BINS, 0u);
+    hist[10] = 1000 - moved;
+    hist[50] = moved;
+}
+
+TEST(VCU_LumaSceneCutDetector, cut_stands_out_of_recent_distances)
+{
+    LumaSceneCutDetector detector;
+    LumaSceneCutDetector::THistogram still, busy, jump, cut;
+    movedHistogram(0, still);
+    movedHistogram(200, busy);  // distance 0.4
+    movedHistogram(300, jump);  // distance 0.6
+    movedHistogram(900, cut);   // distance 1.8
+    EXPECT_DOUBLE_EQ(0.6, LumaSceneCutDetector::Distance(still, jump));
+
+    // Still scene: anything above the threshold is a cut
+    for (int i = 0; i < 30; ++i)
+        ASSERT_FALSE(detector.IsSceneCut(still, still));
+    EXPECT_TRUE(detector.IsSceneCut(still, jump));
+
+    // Busy scene: the same distance is motion, a larger one is still a cut
+    LumaSceneCutDetector busyDetector;
+    for (int i = 0; i < 30; ++i)
+        ASSERT_FALSE(busyDetector.IsSceneCut(still, busy));
+    EXPECT_FALSE(busyDetector.IsSceneCut(still, jump));
+    EXPECT_TRUE(busyDetector.IsSceneCut(still, cut));
+
+    // Cuts do not raise the mean distance
+    for (int i = 0; i < 30; ++i)
+        ASSERT_TRUE(detector.IsSceneCut(still, cut));
+    EXPECT_TRUE(detector.IsSceneCut(still, jump));
+}
+
+TEST(VCU_LumaSceneCutDetector, high_bit_depth_histogram)
+{
+    RNG rng(0x4002);
+    Mat luma8 = syntheticLuma(0, rng);
+    Mat luma10;
+    luma8.convertTo(luma10, CV_16U, 4);
+
+    LumaSceneCutDetector::THistogram hist8, hist10;
+    LumaSceneCutDetector::ComputeHistogram(luma8.data, (int)luma8.step, luma8.cols, luma8.rows, 8,
+                                           hist8);
+    LumaSceneCutDetector::ComputeHistogram(luma10.data, (int)luma10.step, luma10.cols,
+                                           luma10.rows, 10, hist10);
+
+    int samples = 0;
+    for (int i = 0; i < LumaSceneCutDetector::HIST_BINS; ++i)
+    {
+        EXPECT_EQ(hist8[i], hist10[i]) << "bin " << i;
+        samples += hist8[i];
+    }
+    int sub = LumaSceneCutDetector::SUBSAMPLING;
+    EXPECT_EQ(((luma8.cols + sub - 1) / sub) * ((luma8.rows + sub - 1) / sub), samples);
+    EXPECT_DOUBLE_EQ(0.0, LumaSceneCutDetector::Distance(hist8, hist10));
+}
+
+//------------------------------------------------------------------------------------------------
+// LookAheadMngr
+
+/// First-pass metadata of a synthetic stream: low intra percentages with a cut now and then,
+/// where most of the five areas go intra.
+std::vector<AL_TLookAheadMetaData> syntheticMetaData(int numFrames, RNG& rng,
+                                                     std::vector<int>* cuts = nullptr)
+{
+    std::vector<AL_TLookAheadMetaData> frames(numFrames);
+    bool prevCut = true;
+    for (int i = 0; i < numFrames; ++i)
+    {
+        AL_TLookAheadMetaData& meta = frames[i];
+        bool cut = !prevCut && rng.uniform(0, 12) == 0;  // no cut right after a cut
+        prevCut = cut;
+        meta.iPictureSize = cut ? rng.uniform(200000, 400000) : rng.uniform(1000, 120000);
+        for (int area = 0; area < 5; ++area)
+            meta.iPercentIntra[area] = (int8_t)(cut ? rng.uniform(96, 101) : rng.uniform(0, 40));
+        meta.iIPRatio = 1000;
+        meta.iComplexity = 1000;
+        meta.iTargetLevel = 0;
+        meta.eSceneChange = AL_SC_NONE;
+        if (cut && cuts)
+            cuts->push_back(i);
+    }
+    return frames;
+}
+
+/// Reference LookAhead: the window statistics recomputed from scratch for every frame, as
+/// LookAheadMngr did before they were kept up to date by Push() and Pop().
+class BatchLookAhead
+{
+public:
+    BatchLookAhead(int lookAhead, bool firstPassSceneChange)
+        : lookAhead_(lookAhead), firstPassSceneChange_(firstPassSceneChange),
+          useComplexity_(lookAhead >= 10 && !firstPassSceneChange) {}
+
+    /// Metadata of the frames in encoding order, as ProcessLookAheadParams() sets them.
+    std::vector<AL_TLookAheadMetaData> run(const std::vector<AL_TLookAheadMetaData>& frames)
+    {
+        std::vector<AL_TLookAheadMetaData> out;
+        for (const AL_TLookAheadMetaData& meta : frames)
+        {
+            window_.push_back(meta);
+            if ((int)window_.size() > lookAhead_)
+                forward(out);
+        }
+        while (!window_.empty())
+            forward(out);
+        return out;
+    }
+
+private:
+    bool sceneChange(const AL_TLookAheadMetaData& prev, const AL_TLookAheadMetaData& cur) const
+    {
+        auto areaChange = [&](int area) {
+            int percent = 100 * cur.iPercentIntra[area];
+            int ratio = prev.iPercentIntra[area] ? percent / prev.iPercentIntra[area] : percent;
+            return (cur.iPercentIntra[area] >= 95 && ratio > 135)
+                || (cur.iPercentIntra[area] >= 80 && ratio > 200);
+        };
+        if (!firstPassSceneChange_)
+            return areaChange(0);
+
+        int ok = 0, ko = 0;
+        for (int area = 0; area < 5; ++area)
+        {
+            if (areaChange(area))
+                ok++;
+            else if (cur.iPercentIntra[area] < 40)
+                ko++;
+        }
+        return ok >= 3 && ko == 0;
+    }
+
+    static int32_t ipRatio(const AL_TLookAheadMetaData& cur, const AL_TLookAheadMetaData& next)
+    {
+        if (!next.iPictureSize)
+            return 1000;
+        return (int32_t)std::max<int64_t>(100, 1000 * (int64_t)cur.iPictureSize / next.iPictureSize);
+    }
+
+    int nextSceneChange() const
+    {
+        int size = (int)window_.size();
+        int index = 0;
+        while (index + 1 < size && !sceneChange(window_[index], window_[index + 1]))
+            index++;
+        return (size < 2 || index + 1 == size) ? size : index + 1;
+    }
+
+    void forward(std::vector<AL_TLookAheadMetaData>& out)
+    {
+        AL_TLookAheadMetaData meta = window_.front();
+        int size = (int)window_.size();
+
+        if (useComplexity_)
+        {
+            if (frameCount_ % 5 == 0)
+            {
+                frameCount_ = 0;
+                complexity_ = 1000;
+                if (size >= 5)
+                {
+                    int64_t head = 0, all = 0;
+                    for (int i = 0; i < size; ++i)
+                    {
+                        all += window_[i].iPictureSize;
+                        if (i < 5)
+                            head += window_[i].iPictureSize;
+                    }
+                    complexity_ = (int)(((1000 * size / 5) + complexityDiff_) * head / all);
+                    complexity_ = std::min(3000, std::max(100, complexity_));
+                    complexityDiff_ += 1000 - complexity_;
+                }
+            }
+            frameCount_++;
+            if (size >= 2 && sceneChange(window_[0], window_[1]))
+                frameCount_ = 0;
+            meta.iComplexity = complexity_;
+        }
+
+        if (size >= 2)
+        {
+            meta.eSceneChange = sceneChange(window_[0], window_[1]) ? AL_SC_NEXT : AL_SC_NONE;
+            if (firstPassSceneChange_)
+            {
+                meta.iPictureSize = 0;
+            }
+            else
+            {
+                meta.iIPRatio = ipRatio(window_[0], window_[1]);
+                for (int i = 2; i < std::min(nextSceneChange(), 4); ++i)
+                    meta.iIPRatio = std::min(meta.iIPRatio, ipRatio(window_[0], window_[i]));
+            }
+        }
+
+        out.push_back(meta);
+        window_.pop_front();
+    }
+
+    int lookAhead_;
+    bool firstPassSceneChange_;
+    bool useComplexity_;
+    int complexity_ = 1000;
+    int complexityDiff_ = 0;
+    int frameCount_ = 0;
+    std::deque<AL_TLookAheadMetaData> window_;
+};
+
+typedef std::shared_ptr<AL_TBuffer> BufferPtr;
+
+BufferPtr createSource(const AL_TLookAheadMetaData& meta)
+{
+    AL_TBuffer* pSrc = AL_Buffer_Create_And_Allocate(AL_GetDefaultAllocator(), 16,
+                                                     AL_Buffer_Destroy);
+    CV_Assert(pSrc);
+    BufferPtr src(pSrc, &AL_Buffer_Destroy);
+    AL_TLookAheadMetaData* pMeta = AL_LookAheadMetaData_Create();
+    CV_Assert(pMeta && AL_Buffer_AddMetaData(pSrc, (AL_TMetaData*)pMeta));
+    pMeta->iPictureSize = meta.iPictureSize;
+    for (int area = 0; area < 5; ++area)
+        pMeta->iPercentIntra[area] = meta.iPercentIntra[area];
+    pMeta->iIPRatio = meta.iIPRatio;
+    pMeta->iComplexity = meta.iComplexity;
+    pMeta->iTargetLevel = meta.iTargetLevel;
+    pMeta->eSceneChange = meta.eSceneChange;
+    return src;
+}
+
+/// Feed @p frames through a LookAheadMngr the way the LookAhead sink does, returns the metadata
+/// of the frames in encoding order.
+std::vector<AL_TLookAheadMetaData> runLookAhead(int lookAhead, bool firstPassSceneChange,
+                                                const std::vector<AL_TLookAheadMetaData>& frames)
+{
+    std::vector<BufferPtr> sources;
+    for (const AL_TLookAheadMetaData& meta : frames)
+        sources.push_back(createSource(meta));
+
+    LookAheadMngr mngr(lookAhead, firstPassSceneChange);
+    std::vector<AL_TLookAheadMetaData> out;
+    auto forward = [&]() {
+        mngr.ProcessLookAheadParams();
+        AL_TBuffer* pSrc = mngr.m_fifo.front();
+        mngr.Pop();
+        out.push_back(*(AL_TLookAheadMetaData*)AL_Buffer_GetMetaData(pSrc, AL_META_TYPE_LOOKAHEAD));
+    };
+
+    for (const BufferPtr& src : sources)
+    {
+        mngr.Push(src.get());
+        if (mngr.m_fifo.size() > mngr.uLookAheadSize)
+            forward();
+    }
+    while (!mngr.m_fifo.empty())
+        forward();
+    return out;
+}
+
+TEST(VCU_LookAheadMngr, scene_changes_on_synthetic_metadata)
+{
+    RNG rng(0x4003);
+    std::vector<int> cuts;
+    std::vector<AL_TLookAheadMetaData> frames = syntheticMetaData(300, rng, &cuts);
+    ASSERT_GT(cuts.size(), 10u);
+
+    for (int lookAhead : { 2, 8, 30 })
+    {
+        SCOPED_TRACE(cv::format("lookAhead %d", lookAhead));
+        std::vector<AL_TLookAheadMetaData> out = runLookAhead(lookAhead, false, frames);
+        ASSERT_EQ(frames.size(), out.size());
+
+        std::vector<int> detected;
+        for (int i = 0; i < (int)out.size(); ++i)
+            if (out[i].eSceneChange == AL_SC_NEXT)
+                detected.push_back(i + 1);
+        EXPECT_EQ(cuts, detected);
+    }
+}
+
+TEST(VCU_LookAheadMngr, incremental_equals_batch)
+{
+    RNG rng(0x4004);
+    std::vector<AL_TLookAheadMetaData> frames = syntheticMetaData(600, rng);
+
+    for (bool firstPassSceneChange : { false, true })
+    {
+        for (int lookAhead : { 2, 3, 5, 10, 16, 40 })
+        {
+            SCOPED_TRACE(cv::format("lookAhead %d, first pass scene change %d", lookAhead,
+                                    firstPassSceneChange));
+            std::vector<AL_TLookAheadMetaData> expected =
+                BatchLookAhead(lookAhead, firstPassSceneChange).run(frames);
+            std::vector<AL_TLookAheadMetaData> out =
+                runLookAhead(lookAhead, firstPassSceneChange, frames);
+            ASSERT_EQ(expected.size(), out.size());
+
+            for (size_t i = 0; i < out.size(); ++i)
+            {
+                SCOPED_TRACE(cv::format("frame %d", (int)i));
+                ASSERT_EQ(expected[i].iComplexity, out[i].iComplexity);
+                ASSERT_EQ(expected[i].eSceneChange, out[i].eSceneChange);
+                ASSERT_EQ(expected[i].iIPRatio, out[i].iIPRatio);
+                ASSERT_EQ(expected[i].iPictureSize, out[i].iPictureSize);
+            }
+        }
+    }
+}
+
+}} // namespace
+
+#endif
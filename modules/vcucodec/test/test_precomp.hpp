@@ -0,0 +1,26 @@
+/*
+   Copyright (c) 2025-2026  Advanced Micro Devices, Inc. (AMD)
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+*/
+#ifndef OPENCV_VCUCODEC_TEST_PRECOMP_HPP
+#define OPENCV_VCUCODEC_TEST_PRECOMP_HPP
+
+#include "opencv2/ts.hpp"
+#include "opencv2/vcucodec.hpp"
+
+namespace opencv_test {
+using namespace cv::vcucodec;
+} // namespace opencv_test
+
+#endif // OPENCV_VCUCODEC_TEST_PRECOMP_HPP
@@ -0,0 +1,319 @@
+/*
+   Copyright (c) 2025-2026  Advanced Micro Devices, Inc. (AMD)
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+*/
+#include "test_precomp.hpp"
+
+#if defined(HAVE_VCU_CTRLSW) || defined(HAVE_VCU2_CTRLSW)
+
+#include "vcuroimanager.hpp"
+
+namespace opencv_test { namespace {
+
+struct QpTableLayout
+{
+    const char* name;
+    AL_EProfile profile;
+    uint8_t log2MaxCuSize;
+    int32_t numQpPerLcu;
+    int32_t numBytesPerLcu;
+    int32_t lcuQpOffset;
+};
+
+// The layouts with a fillSpan<N> kernel: 1, 4, 8 and 32 bytes per LCU.
+const QpTableLayout layouts[] = {
+    { "AVC 16x16 V1",   AL_PROFILE_AVC_HIGH,  4,  1,  1, 0 },
+    { "HEVC 16x16 V2",  AL_PROFILE_HEVC_MAIN, 4,  4,  4, 4 },
+    { "HEVC 32x32 V2",  AL_PROFILE_HEVC_MAIN, 5,  8,  8, 4 },
+    { "HEVC 64x64 V2",  AL_PROFILE_HEVC_MAIN, 6, 24, 32, 4 },
+};
+
+struct Region
+{
+    Rect rect;
+    int quality;
+};
+
+int numLcus(const QpTableLayout& layout, Size size)
+{
+    int lcu = 1 << layout.log2MaxCuSize;
+    return ((size.width + lcu - 1) / lcu) * ((size.height + lcu - 1) / lcu);
+}
+
+/// QP table of @p regions, built from scratch by a new manager, filled through the SIMD span
+/// kernels or, when @p optimized is false, through the per-LCU setLCUQuality() loop.
+std::vector<uint8_t> fillTable(const QpTableLayout& layout, Size size,
+                               const std::vector<Region>& regions, RoiOrder order, bool optimized,
+                               int bkgQuality = 0)
+{
+    RoiManager roi(size.width, size.height, layout.profile, layout.log2MaxCuSize, bkgQuality,
+                   order);
+    for (const Region& r : regions)
+        roi.enableRegion(roi.addRegion(r.rect.x, r.rect.y, r.rect.width, r.rect.height,
+                                       r.quality, false), 0);
+
+    std::vector<uint8_t> table(numLcus(layout, size) * layout.numBytesPerLcu, 0xcd);
+    bool wasOptimized = cv::useOptimized();
+    cv::setUseOptimized(optimized);
+    roi.fillBuffer(0, layout.numQpPerLcu, layout.numBytesPerLcu, table.data(), layout.lcuQpOffset);
+    cv::setUseOptimized(wasOptimized);
+    return table;
+}
+
+void expectSameTables(Size size, const std::vector<Region>& regions,
+                      RoiOrder order = RoiOrder::QUALITY)
+{
+    for (const QpTableLayout& layout : layouts)
+    {
+        SCOPED_TRACE(layout.name);
+        std::vector<uint8_t> reference = fillTable(layout, size, regions, order, false);
+        std::vector<uint8_t> table = fillTable(layout, size, regions, order, true);
+        ASSERT_EQ(reference.size(), table.size());
+        for (size_t i = 0; i < table.size(); ++i)
+            ASSERT_EQ(reference[i], table[i]) << "byte " << i << " of LCU "
+                                              << i / layout.numBytesPerLcu;
+    }
+}
+
+TEST(VCU_RoiManager, fillSpan_partial_spans)
+{
+    // Spans of 1 to 40 LCUs: the vector loop covers the multiples of 16 bytes (or of the LCU
+    // size), the scalar tail the rest.
+    const Size size(2560, 1600);
+    for (int lcuLog2 = 4; lcuLog2 <= 6; ++lcuLog2)
+    {
+        int lcu = 1 << lcuLog2;
+        for (int width = 1; width <= 40 && width * lcu <= size.width; ++width)
+        {
+            SCOPED_TRACE(cv::format("LCU %d, span of %d LCUs", lcu, width));
+            expectSameTables(size, { { Rect(lcu, 2 * lcu, width * lcu, 3 * lcu), -7 } });
+            expectSameTables(size, { { Rect(size.width - width * lcu, 0, width * lcu, lcu), 5 } });
+        }
+    }
+}
+
+TEST(VCU_RoiManager, fillSpan_region_edges)
+{
+    // A picture size that is not a multiple of any LCU size, with regions on every border,
+    // unaligned to the LCU grid and clipped by the picture.
+    const Size size(1000, 562);
+    expectSameTables(size, { { Rect(0, 0, size.width, size.height), -3 } });
+    expectSameTables(size, {
+        { Rect(0, 0, 100, 70), -10 },
+        { Rect(size.width - 130, 0, 130, 90), 8 },
+        { Rect(0, size.height - 40, 250, 40), -4 },
+        { Rect(size.width - 17, size.height - 33, 17, 33), 12 },
+        { Rect(333, 201, 77, 45), -1 },
+    });
+}
+
+TEST(VCU_RoiManager, fillSpan_force_flags_and_overlaps)
+{
+    // The force-intra and force-MV0 codes keep or replace the QP bits of what is below them.
+    const Size size(1920, 1080);
+    const std::vector<Region> regions = {
+        { Rect(64, 64, 640, 320), roiquality::INTRA },
+        { Rect(320, 128, 640, 320), -6 },
+        { Rect(256, 256, 256, 512), roiquality::STATIC },
+        { Rect(900, 300, 700, 500), 9 },
+        { Rect(1000, 400, 300, 200), roiquality::INTRA },
+        { Rect(1100, 350, 500, 100), -12 },
+    };
+    expectSameTables(size, regions, RoiOrder::QUALITY);
+    expectSameTables(size, regions, RoiOrder::INCOMING);
+}
+
+TEST(VCU_RoiManager, fillSpan_random_regions)
+{
+    RNG rng(0x3201);
+    for (int iter = 0; iter < 50; ++iter)
+    {
+        Size size(rng.uniform(64, 1920), rng.uniform(64, 1088));
+        std::vector<Region> regions(rng.uniform(1, 12));
+        for (Region& r : regions)
+        {
+            r.rect.width = rng.uniform(1, size.width + 1);
+            r.rect.height = rng.uniform(1, size.height + 1);
+            r.rect.x = rng.uniform(0, size.width - r.rect.width + 1);
+            r.rect.y = rng.uniform(0, size.height - r.rect.height + 1);
+            int code = rng.uniform(0, 10);
+            r.quality = code == 0 ? roiquality::INTRA : code == 1 ? roiquality::STATIC
+                                                                  : rng.uniform(-16, 16);
+        }
+        SCOPED_TRACE(cv::format("iteration %d", iter));
+        expectSameTables(size, regions, iter % 2 ? RoiOrder::INCOMING : RoiOrder::QUALITY);
+    }
+}
+
+/// A region of RoiManagerModel, with the window set by enableRegion()/disableRegion().
+struct ModelRegion
+{
+    Region region;
+    bool background;
+    int32_t enableFrame;
+    int32_t disableFrame;
+};
+
+/// Drives a RoiManager with random schedule changes and tracks what is active at each frame.
+class RoiManagerModel
+{
+public:
+    RoiManagerModel(const QpTableLayout& layout, Size size, uint64 seed)
+        : layout_(layout), size_(size), rng_(seed),
+          roi_(size.width, size.height, layout.profile, layout.log2MaxCuSize, 0, RoiOrder::QUALITY)
+    {}
+
+    /// Random changes scheduled at @p frameIdx: new, disabled, re-enabled and removed regions,
+    /// one-shot regions, background and order changes.
+    void change(int32_t frameIdx)
+    {
+        if (regions_.size() < 150 && rng_.uniform(0, 3) == 0)
+            add(frameIdx + rng_.uniform(0, 3), false);
+        if (!regions_.empty() && rng_.uniform(0, 4) == 0)
+        {
+            auto it = std::next(regions_.begin(), rng_.uniform(0, (int)regions_.size()));
+            if (rng_.uniform(0, 2))
+            {
+                int32_t disableFrame = frameIdx + rng_.uniform(0, 3);
+                roi_.disableRegion(it->first, disableFrame);
+                it->second.disableFrame = disableFrame;
+            }
+            else
+            {
+                roi_.enableRegion(it->first, frameIdx);
+                it->second.enableFrame = frameIdx;
+                it->second.disableFrame = INT32_MAX;
+            }
+        }
+        if (!regions_.empty() && rng_.uniform(0, 20) == 0)
+        {
+            auto it = std::next(regions_.begin(), rng_.uniform(0, (int)regions_.size()));
+            roi_.removeRegion(it->first);
+            regions_.erase(it);
+        }
+        if (rng_.uniform(0, 25) == 0)
+            add(frameIdx, true);
+        if (rng_.uniform(0, 30) == 0)
+        {
+            order_ = rng_.uniform(0, 2) ? RoiOrder::QUALITY : RoiOrder::INCOMING;
+            roi_.setOrder(frameIdx, order_);
+        }
+
+        std::vector<RoiManager::FrameRegion> frameRegions;
+        for (int i = rng_.uniform(0, 6) == 0 ? rng_.uniform(1, 4) : 0; i > 0; --i)
+        {
+            Region r = randomRegion();
+            frameRegions.push_back({ r.rect.x, r.rect.y, r.rect.width, r.rect.height, r.quality });
+        }
+        roi_.setFrameRegions(frameIdx, frameRegions);
+        // setFrameRegions() takes the ids that follow the regions added so far.
+        oneShot_.clear();
+        for (const auto& fr : frameRegions)
+            oneShot_[nextId_++] = { Rect(fr.posX, fr.posY, fr.width, fr.height), fr.qualityCode };
+    }
+
+    std::vector<uint8_t> fill(int32_t frameIdx)
+    {
+        std::vector<uint8_t> table(numLcus(layout_, size_) * layout_.numBytesPerLcu, 0xcd);
+        roi_.fillBuffer(frameIdx, layout_.numQpPerLcu, layout_.numBytesPerLcu, table.data(),
+                        layout_.lcuQpOffset);
+        return table;
+    }
+
+    /// The table of @p frameIdx generated from scratch.
+    std::vector<uint8_t> rebuild(int32_t frameIdx)
+    {
+        std::map<int32_t, Region> active(oneShot_);
+        int bkgQuality = 0;
+        int32_t bkgFrame = INT32_MIN;
+        for (const auto& entry : regions_)
+        {
+            const ModelRegion& r = entry.second;
+            if (frameIdx < r.enableFrame || frameIdx >= r.disableFrame)
+                continue;
+            if (!r.background)
+                active[entry.first] = r.region;
+            else if (r.enableFrame >= bkgFrame)
+            {
+                bkgFrame = r.enableFrame;
+                bkgQuality = r.region.quality;
+            }
+        }
+
+        std::vector<Region> ordered;
+        for (const auto& entry : active)
+            ordered.push_back(entry.second);
+        return fillTable(layout_, size_, ordered, order_, true, bkgQuality);
+    }
+
+private:
+    Region randomRegion()
+    {
+        Region r;
+        r.rect.width = rng_.uniform(16, size_.width / 3);
+        r.rect.height = rng_.uniform(16, size_.height / 3);
+        r.rect.x = rng_.uniform(0, size_.width - r.rect.width + 1);
+        r.rect.y = rng_.uniform(0, size_.height - r.rect.height + 1);
+        int code = rng_.uniform(0, 12);
+        r.quality = code == 0 ? roiquality::INTRA : code == 1 ? roiquality::STATIC
+                                                              : rng_.uniform(-16, 16);
+        return r;
+    }
+
+    void add(int32_t enableFrame, bool background)
+    {
+        Region r = background ? Region{ Rect(0, 0, size_.width, size_.height), rng_.uniform(-8, 8) }
+                              : randomRegion();
+        int32_t id = roi_.addRegion(r.rect.x, r.rect.y, r.rect.width, r.rect.height, r.quality,
+                                    background);
+        CV_Assert(id == nextId_);
+        ++nextId_;
+        roi_.enableRegion(id, enableFrame);
+        regions_[id] = { r, background, enableFrame, INT32_MAX };
+    }
+
+    const QpTableLayout& layout_;
+    Size size_;
+    RNG rng_;
+    RoiManager roi_;
+    std::map<int32_t, ModelRegion> regions_;
+    std::map<int32_t, Region> oneShot_;
+    RoiOrder order_ = RoiOrder::QUALITY;
+    int32_t nextId_ = 0;
+};
+
+TEST(VCU_RoiManager, fillBuffer_cached_equals_rebuild)
+{
+    // The cached table, the dirty-row refill and fillBackground() on row ranges must give the
+    // table a full regeneration gives, whatever changes between two frames.
+    for (const QpTableLayout& layout : layouts)
+    {
+        RoiManagerModel model(layout, Size(1920, 1080), 0x3101);
+        for (int32_t frameIdx = 0; frameIdx < 300; ++frameIdx)
+        {
+            SCOPED_TRACE(cv::format("%s, frame %d", layout.name, frameIdx));
+            model.change(frameIdx);
+            std::vector<uint8_t> table = model.fill(frameIdx);
+            std::vector<uint8_t> reference = model.rebuild(frameIdx);
+            ASSERT_EQ(reference.size(), table.size());
+            for (size_t i = 0; i < table.size(); ++i)
+                ASSERT_EQ(reference[i], table[i]) << "byte " << i << " of LCU "
+                                                  << i / layout.numBytesPerLcu;
+        }
+    }
+}
+
+}} // namespace
+
+#endif
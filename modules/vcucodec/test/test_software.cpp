@@ -0,0 +1,330 @@
+/*
+   Copyright (c) 2025-2026  Advanced Micro Devices, Inc. (AMD)
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+*/
+#include "test_precomp.hpp"
+
+#if defined(HAVE_VCU_CTRLSW) || defined(HAVE_VCU2_CTRLSW)
+
+#include "TwoPassMngr.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+
+namespace opencv_test { namespace {
+
+const Size pictureSize(320, 240);
+const int numPictures = 12;
+
+/// Runs a test on the software device (OPENCV_VCUCODEC_DEVICE=software), so that it needs
+/// no VCU: the encoder stores the pictures losslessly and the decoder gives them back.
+class VCU_SoftwareDevice : public testing::Test
+{
+protected:
+    void SetUp() override
+    {
+        const char* device = std::getenv("OPENCV_VCUCODEC_DEVICE");
+        hadDevice_ = device != nullptr;
+        if (hadDevice_)
+            savedDevice_ = device;
+        setenv("OPENCV_VCUCODEC_DEVICE", "software", 1);
+    }
+
+    void TearDown() override
+    {
+        if (hadDevice_)
+            setenv("OPENCV_VCUCODEC_DEVICE", savedDevice_.c_str(), 1);
+        else
+            unsetenv("OPENCV_VCUCODEC_DEVICE");
+    }
+
+private:
+    bool hadDevice_ = false;
+    std::string savedDevice_;
+};
+
+int fourccOf(const char* name)
+{
+    return VideoWriter::fourcc(name[0], name[1], name[2], name[3]);
+}
+
+/// Random 8-bit picture as write() takes it: the planes follow each other with the luma pitch.
+Mat randomPicture(int fourcc, RNG& rng)
+{
+    int rows = pictureSize.height;
+    if (fourcc == fourccOf("NV12"))
+        rows += pictureSize.height / 2;
+    else if (fourcc == fourccOf("NV16"))
+        rows += pictureSize.height;
+    Mat picture(rows, pictureSize.width, CV_8UC1);
+    rng.fill(picture, RNG::UNIFORM, 0, 256);
+    return picture;
+}
+
+std::vector<Mat> randomPictures(int fourcc, uint64 seed)
+{
+    RNG rng(seed);
+    std::vector<Mat> pictures;
+    for (int i = 0; i < numPictures; ++i)
+        pictures.push_back(randomPicture(fourcc, rng));
+    return pictures;
+}
+
+EncoderInitParams encoderParams(int fourcc)
+{
+    EncoderInitParams params;
+    params.pictureEncSettings = PictureEncSettings(Codec::HEVC, fourcc,
+                                                   pictureSize.width, pictureSize.height);
+    return params;
+}
+
+void encode(const String& filename, int fourcc, const std::vector<Mat>& pictures,
+            Ptr<EncoderCallback> callback = nullptr)
+{
+    Ptr<Encoder> encoder = createEncoder(filename, encoderParams(fourcc), callback);
+    ASSERT_TRUE(encoder);
+    for (const Mat& picture : pictures)
+        encoder->write(picture);
+    EXPECT_TRUE(encoder->eos());
+}
+
+/// Decode every picture of the stream and check it against @p pictures, in order.
+/// Returns the number of pictures decoded.
+int decodeAndCompare(Ptr<Decoder> decoder, int fourcc, const std::vector<Mat>& pictures)
+{
+    int decoded = 0;
+    for (;;)
+    {
+        Ptr<VideoFrame> frame;
+        DecodeStatus status = decoder->nextFrame(frame);
+        if (status == DECODE_EOS)
+            break;
+        if (status == DECODE_TIMEOUT)
+            continue;
+
+        SCOPED_TRACE(cv::format("picture %d", decoded));
+        const RawInfo& info = frame->info();
+        EXPECT_EQ(pictureSize.width, info.width);
+        EXPECT_EQ(pictureSize.height, info.height);
+        EXPECT_EQ(fourcc, info.fourcc);
+        EXPECT_EQ(8, info.bitsPerLuma);
+
+        Mat copy;
+        frame->copyTo(copy);
+        if (decoded < (int)pictures.size())
+        {
+            const Mat& picture = pictures[decoded];
+            EXPECT_EQ(picture.size(), copy.size());
+            if (picture.size() == copy.size())
+                EXPECT_EQ(0, cvtest::norm(picture, copy, NORM_INF));
+        }
+        ++decoded;
+    }
+    return decoded;
+}
+
+/// Serves an encoded stream to the decoder in chunks of at most @p chunk bytes.
+class MemorySource : public DecoderCallback
+{
+public:
+    MemorySource(const std::string& stream, size_t chunk) : stream_(stream), chunk_(chunk) {}
+
+    size_t onData(uint8_t* buffer, size_t maxSize) override
+    {
+        size_t n = std::min({maxSize, chunk_, stream_.size() - offset_});
+        std::memcpy(buffer, stream_.data() + offset_, n);
+        offset_ += n;
+        return n;
+    }
+    void onFinished() override { finished = true; }
+
+    bool finished = false;
+
+private:
+    const std::string& stream_;
+    size_t chunk_;
+    size_t offset_ = 0;
+};
+
+/// Collects the encoded stream in memory.
+class MemorySink : public EncoderCallback
+{
+public:
+    void onEncoded(std::vector<std::string_view>& encodedData) override
+    {
+        for (const std::string_view& data : encodedData)
+            stream.append(data.data(), data.size());
+    }
+    void onFinished() override { finished = true; }
+
+    std::string stream;
+    bool finished = false;
+};
+
+std::string readFile(const String& filename)
+{
+    std::ifstream file(filename, std::ios::binary);
+    return std::string(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+}
+
+TEST_F(VCU_SoftwareDevice, encode_decode_file)
+{
+    for (const char* name : {"NV12", "NV16", "Y800"})
+    {
+        SCOPED_TRACE(name);
+        int fourcc = fourccOf(name);
+        std::vector<Mat> pictures = randomPictures(fourcc, 0x5eed + fourcc);
+        String filename = cv::tempfile(".hevc");
+        encode(filename, fourcc, pictures);
+
+        Ptr<Decoder> decoder = createDecoder(filename, DecoderInitParams(Codec::HEVC));
+        ASSERT_TRUE(decoder);
+        EXPECT_EQ(numPictures, decodeAndCompare(decoder, fourcc, pictures));
+        decoder.reset();
+        std::remove(filename.c_str());
+    }
+}
+
+TEST_F(VCU_SoftwareDevice, encode_decode_callbacks)
+{
+    int fourcc = fourccOf("NV12");
+    std::vector<Mat> pictures = randomPictures(fourcc, 0xca11);
+    Ptr<MemorySink> sink = makePtr<MemorySink>();
+    encode(String(), fourcc, pictures, sink);
+    EXPECT_TRUE(sink->finished);
+    ASSERT_FALSE(sink->stream.empty());
+
+    // A chunk smaller than the headers makes every read of the decoder a short one
+    for (size_t chunk : {size_t(7), size_t(4096), sink->stream.size()})
+    {
+        SCOPED_TRACE(cv::format("chunk %zu", chunk));
+        Ptr<MemorySource> source = makePtr<MemorySource>(sink->stream, chunk);
+        Ptr<Decoder> decoder = createDecoder(String(), DecoderInitParams(Codec::HEVC), source);
+        ASSERT_TRUE(decoder);
+        EXPECT_EQ(numPictures, decodeAndCompare(decoder, fourcc, pictures));
+        EXPECT_TRUE(source->finished);
+    }
+}
+
+TEST_F(VCU_SoftwareDevice, file_and_callback_streams_match)
+{
+    int fourcc = fourccOf("NV16");
+    std::vector<Mat> pictures = randomPictures(fourcc, 0xf11e);
+    String filename = cv::tempfile(".hevc");
+    encode(filename, fourcc, pictures);
+    Ptr<MemorySink> sink = makePtr<MemorySink>();
+    encode(String(), fourcc, pictures, sink);
+
+    std::string fromFile = readFile(filename);
+    EXPECT_FALSE(fromFile.empty());
+    EXPECT_TRUE(fromFile == sink->stream);
+    std::remove(filename.c_str());
+}
+
+TEST_F(VCU_SoftwareDevice, corrupted_picture_ends_the_stream)
+{
+    int fourcc = fourccOf("NV12");
+    std::vector<Mat> pictures = randomPictures(fourcc, 0xbad);
+    Ptr<MemorySink> sink = makePtr<MemorySink>();
+    encode(String(), fourcc, pictures, sink);
+
+    // Stream header, then per picture a header and its payload
+    const size_t streamHeader = 32, pictureHeader = 24;
+    const size_t payload = pictures[0].total();
+    ASSERT_EQ(streamHeader + numPictures * (pictureHeader + payload), sink->stream.size());
+
+    // The checksum of picture 5 no longer matches: pictures 0..4 come out, then EOS
+    const int corrupted = 5;
+    std::string stream = sink->stream;
+    stream[streamHeader + corrupted * (pictureHeader + payload) + pictureHeader + payload / 2] ^= 1;
+    Ptr<MemorySource> source = makePtr<MemorySource>(stream, stream.size());
+    Ptr<Decoder> decoder = createDecoder(String(), DecoderInitParams(Codec::HEVC), source);
+    ASSERT_TRUE(decoder);
+    EXPECT_EQ(corrupted, decodeAndCompare(decoder, fourcc, pictures));
+}
+
+TEST_F(VCU_SoftwareDevice, downscaled_first_pass_logs_every_frame)
+{
+    // The second pass reads one record per full-resolution frame, whatever the first pass encoded
+    int fourcc = fourccOf("NV12");
+    std::vector<Mat> pictures = randomPictures(fourcc, 0x1095);
+    String yuv = cv::tempfile(".nv12");
+    {
+        std::ofstream file(yuv, std::ios::binary);
+        for (const Mat& picture : pictures)
+            file.write(reinterpret_cast<const char*>(picture.data), picture.total());
+    }
+
+    for (int downscale : {1, 2, 4})
+    {
+        for (int startFrame : {0, 5})
+        {
+            for (int readAhead : {0, 3})
+            {
+                SCOPED_TRACE(cv::format("downscale %d from frame %d, read-ahead %d",
+                                        downscale, startFrame, readAhead));
+                String log = cv::tempfile(".log");
+                String stream = cv::tempfile(".hevc");
+                EncoderInitParams params = encoderParams(fourcc);
+                params.fileReadAhead = readAhead;
+                params.rcSettings.twoPass = 1;
+                params.rcSettings.twoPassLog = log;
+                params.rcSettings.twoPassDownscale = downscale;
+
+                Ptr<Encoder> encoder = createEncoder(stream, params);
+                ASSERT_TRUE(encoder);
+                encoder->writeFile(yuv, startFrame);
+                EXPECT_TRUE(encoder->eos());
+                EXPECT_EQ(String::npos, encoder->statistics().find("First pass log mismatch"));
+                encoder.reset();
+                EXPECT_EQ(numPictures - startFrame, AL_TwoPassMngr_CountLogFrames(log));
+
+                std::remove(log.c_str());
+                std::remove(stream.c_str());
+            }
+        }
+    }
+    std::remove(yuv.c_str());
+}
+
+TEST_F(VCU_SoftwareDevice, downscaled_first_pass_logs_written_frames)
+{
+    int fourcc = fourccOf("NV12");
+    std::vector<Mat> pictures = randomPictures(fourcc, 0x1096);
+    String log = cv::tempfile(".log");
+    String stream = cv::tempfile(".hevc");
+    EncoderInitParams params = encoderParams(fourcc);
+    params.rcSettings.twoPass = 1;
+    params.rcSettings.twoPassLog = log;
+    params.rcSettings.twoPassDownscale = 2;
+
+    Ptr<Encoder> encoder = createEncoder(stream, params);
+    ASSERT_TRUE(encoder);
+    for (const Mat& picture : pictures)
+        encoder->write(picture);
+    EXPECT_TRUE(encoder->eos());
+    encoder.reset();
+    EXPECT_EQ(numPictures, AL_TwoPassMngr_CountLogFrames(log));
+
+    std::remove(log.c_str());
+    std::remove(stream.c_str());
+}
+
+}} // namespace
+
+#endif
@@ -0,0 +1,153 @@
+/*
+   Copyright (c) 2025-2026  Advanced Micro Devices, Inc. (AMD)
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+*/
+#include "test_precomp.hpp"
+
+#if defined(HAVE_VCU_CTRLSW) || defined(HAVE_VCU2_CTRLSW)
+
+#include "TwoPassMngr.h"
+
+#include <cstdio>
+#include <fstream>
+
+namespace opencv_test { namespace {
+
+const int gopSize = 30;
+const int cpbLevel = 3000;     // ms
+const int initialLevel = 1500; // ms
+const int frameRate = 30;
+
+/// Pass-1 text log of @p numFrames frames: simple scenes of 400 frames followed by complex
+/// scenes of 900, each scene starting with an intra frame.
+std::string writeTextLog(int numFrames, uint64 seed)
+{
+    RNG rng(seed);
+    std::string path = cv::tempfile(".log");
+    std::ofstream log(path);
+    int sceneStart = 0;
+    bool complex = false;
+    for (int frame = 0; frame < numFrames; ++frame)
+    {
+        if (frame - sceneStart == (complex ? 900 : 400))
+        {
+            sceneStart = frame;
+            complex = !complex;
+        }
+        bool intra = frame == sceneStart;
+        int size = (complex ? 150000 : 15000) * (intra ? 4 : 1) + rng.uniform(-5000, 5000);
+        log << size << " " << (intra ? 100 : rng.uniform(2, 20)) << "\n";
+    }
+    return path;
+}
+
+/// CPB levels of the frames, replayed here from the pass-2 complexities.
+std::vector<double> replayLevels(const std::string& path, int numFrames, bool globalAllocation)
+{
+    TwoPassMngr mngr(path, 2, false, gopSize, cpbLevel, initialLevel, frameRate, false,
+                     globalAllocation);
+    std::vector<double> levels;
+    double level = initialLevel;
+    for (int frame = 0; frame < numFrames; ++frame)
+    {
+        AL_TLookAheadMetaData meta {};
+        mngr.GetFrame(&meta);
+        level -= (meta.iComplexity - 1000) / double(frameRate);
+        levels.push_back(level);
+    }
+    return levels;
+}
+
+void expectReportOf(const std::vector<double>& levels, const TwoPassCpbReport& report)
+{
+    int underflows = 0, overflows = 0;
+    for (double level : levels)
+    {
+        underflows += level < 0;
+        overflows += level > cpbLevel;
+    }
+    EXPECT_EQ((int)levels.size(), report.iNumFrames);
+    EXPECT_EQ(underflows, report.iNumUnderflows);
+    EXPECT_EQ(overflows, report.iNumOverflows);
+    EXPECT_EQ(underflows == 0 && overflows == 0, report.IsCompliant());
+    EXPECT_DOUBLE_EQ(std::min((double)initialLevel, *std::min_element(levels.begin(), levels.end())),
+                     report.fMinLevel);
+    EXPECT_DOUBLE_EQ(std::max((double)initialLevel, *std::max_element(levels.begin(), levels.end())),
+                     report.fMaxLevel);
+}
+
+TEST(VCU_TwoPass, simulateCpb_windowed_allocation_overflows)
+{
+    const int numFrames = 5840;
+    std::string path = writeTextLog(numFrames, 0x4201);
+
+    TwoPassCpbReport report = AL_TwoPassMngr_SimulateCpb(path, gopSize, cpbLevel, initialLevel,
+                                                         frameRate, false);
+    EXPECT_FALSE(report.IsCompliant());
+    EXPECT_GT(report.iNumOverflows, 0);
+    EXPECT_GT(report.fMaxLevel, cpbLevel);
+    expectReportOf(replayLevels(path, numFrames, false), report);
+    std::remove(path.c_str());
+}
+
+TEST(VCU_TwoPass, simulateCpb_global_allocation_compliant)
+{
+    const int numFrames = 5840;
+    std::string path = writeTextLog(numFrames, 0x4201);
+
+    TwoPassCpbReport report = AL_TwoPassMngr_SimulateCpb(path, gopSize, cpbLevel, initialLevel,
+                                                         frameRate, true);
+    EXPECT_TRUE(report.IsCompliant());
+    EXPECT_GE(report.fMinLevel, 0);
+    EXPECT_LE(report.fMaxLevel, cpbLevel);
+    expectReportOf(replayLevels(path, numFrames, true), report);
+    std::remove(path.c_str());
+}
+
+TEST(VCU_TwoPass, simulateCpb_binary_log)
+{
+    const int numFrames = 2500;
+    std::string textPath = writeTextLog(numFrames, 0x4202);
+    std::string binaryPath = cv::tempfile(".bin");
+    ASSERT_EQ(numFrames, AL_TwoPassMngr_ConvertTextLog(textPath, binaryPath));
+
+    for (bool globalAllocation : { false, true })
+    {
+        TwoPassCpbReport text = AL_TwoPassMngr_SimulateCpb(textPath, gopSize, cpbLevel,
+                                                           initialLevel, frameRate,
+                                                           globalAllocation);
+        TwoPassCpbReport binary = AL_TwoPassMngr_SimulateCpb(binaryPath, gopSize, cpbLevel,
+                                                             initialLevel, frameRate,
+                                                             globalAllocation);
+        EXPECT_EQ(numFrames, binary.iNumFrames);
+        EXPECT_EQ(text.iNumUnderflows, binary.iNumUnderflows);
+        EXPECT_EQ(text.iNumOverflows, binary.iNumOverflows);
+        EXPECT_DOUBLE_EQ(text.fMinLevel, binary.fMinLevel);
+        EXPECT_DOUBLE_EQ(text.fMaxLevel, binary.fMaxLevel);
+    }
+    std::remove(textPath.c_str());
+    std::remove(binaryPath.c_str());
+}
+
+TEST(VCU_TwoPass, simulateCpb_missing_log)
+{
+    std::string path = cv::tempfile(".log");
+    EXPECT_THROW(AL_TwoPassMngr_SimulateCpb(path, gopSize, cpbLevel, initialLevel, frameRate,
+                                            false),
+                 std::runtime_error);
+}
+
+}} // namespace
+
+#endif
@@ -21,8 +21,15 @@ parser.add_argument("--dmabuf", "-dmabuf", action="store_true",
     help="Transfer frames from decoder to encoder using dmabuf fd (zero-copy) instead of copying frame buffers")
 parser.add_argument("--cfg", default=None,
     help="Input encoder configuration file path. If provided, encoder parameters are built from this file instead of the defaults")
+parser.add_argument("--native", action="store_true",
+    help="Run the decode/scale/encode loop in the native Transcoder instead of in Python; frames are scaled to the encoder size")
+parser.add_argument("--size", type=str, default=None,
+    help="Encoder size as WIDTHxHEIGHT, e.g. 1280x720 (requires --native)")
+parser.add_argument("--scale-threads", type=int, default=2, help="Worker threads of the native scale stage")
 
 args = parser.parse_args()
+if args.size and not args.native:
+    parser.error("--size requires --native")
 
 user_bitdepth = bitdepth_str_to_enum(args.bitdepth)
 
@@ -32,29 +39,48 @@ decoderInitParams = cv2.vcucodec.DecoderInitParams(
     maxFrames=args.max_frames,
     bitDepth=user_bitdepth)
 
-if args.dmabuf:
-    decoderInitParams.extraFrames = 20
-
-dec = cv2.vcucodec.createDecoder(args.input, decoderInitParams)
 if args.cfg:
     config = vcu_config_parser.VCUConfigParser()
     config.parse(args.cfg)
     params = config.create_encoder_params()
 else:
     params = cv2.vcucodec.EncoderInitParams()
-enc = cv2.vcucodec.createEncoder(args.output, params)
+if args.size:
+    width, height = (int(v) for v in args.size.lower().split("x"))
+    params.pictureEncSettings.width = width
+    params.pictureEncSettings.height = height
 print(members_str(params))
+
+if args.native:
+    transcoderParams = cv2.vcucodec.TranscoderParams()
+    transcoderParams.scaleThreads = args.scale_threads
+    transcoderParams.zeroCopy = args.dmabuf
+    transcoder = cv2.vcucodec.createTranscoder(args.input, decoderInitParams, args.output, params,
+                                               transcoderParams)
+    transcoder.run()
+    print(transcoder.statistics())
+    print(f'Output written to "{args.output}"')
+    raise SystemExit(0)
+
+if args.dmabuf:
+    # The encoder gives each decoder buffer back once encoded: cover the frames it keeps for
+    # reordering and LookAhead, plus a small margin (the native Transcoder does the same)
+    decoderInitParams.extraFrames = 3 + params.gopSettings.nrBFrames + params.rcSettings.lookAhead
+
+dec = cv2.vcucodec.createDecoder(args.input, decoderInitParams)
+enc = cv2.vcucodec.createEncoder(args.output, params)
 frame_idx = 1;
 if args.dmabuf:
     while True:
-        status, fd, info = dec.nextFrameFd()
+        status, frame = dec.nextFrameDmaBuf()
         if status == cv2.vcucodec.DECODE_TIMEOUT:
             continue
         elif status == cv2.vcucodec.DECODE_EOS:
             print(f"\nEnd of stream")
             break
         elif status == cv2.vcucodec.DECODE_FRAME:
-            enc.writeFrameFd(fd)
+            enc.writeFrameDmaBuf(frame)
+            frame.release()
             print(f"\rEncoded frame {frame_idx}", end='')
             frame_idx += 1
 else:
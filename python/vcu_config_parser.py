@@ -196,6 +196,10 @@ class VCUConfigParser:
                 ]
             if 'lookahead' in settings_data:
                 rc_settings.lookAhead = int(settings_data['lookahead'])
+            if 'twopass' in settings_data:
+                rc_settings.twoPass = int(settings_data['twopass'])
+            if 'twopassfile' in settings_data:
+                rc_settings.twoPassLog = settings_data['twopassfile']
             # VUI colour description (SPS). Key names match exe_encoder/CfgParser.cpp.
             if 'colourdescription' in settings_data:
                 color_config.colourDescription = self._parse_colour_description(
@@ -465,7 +469,7 @@ class VCUConfigParser:
                            'EnableSkip', 'MaxConsecutiveSkip'],
             'SETTINGS': ['Profile', 'Level', 'Tier', 'EntropyMode', 'ChromaMode', 'BitDepth', 'EnableFillerData',
                          'NumSlices', 'DependentSlice', 'SubframeLatency', 'Alignment',
-                         'LambdaCtrlMode', 'LambdaFactors', 'LookAhead',
+                         'LambdaCtrlMode', 'LambdaFactors', 'LookAhead', 'TwoPass', 'TwoPassFile',
                          'ColourDescription', 'TransferCharac', 'ColourMatrix', 'VideoFullRange'],
             'RUN': ['Loop', 'FirstPicture', 'MaxPicture']
         }